@@ -0,0 +1,419 @@
+#include <string.h>
+
+#include "bindless.h"
+#include "gpu_buffer.h"
+#include "logger.h"
+#include "vk_context.h"
+
+struct bindless_table
+{
+    VkDescriptorSetLayout  layout;
+
+    // descriptor indexing: a single set that lives as long as the table
+    VkDescriptorPool       pool;
+    VkDescriptorSet        set;
+
+    // fallback: the sets are recycled per frame
+    VkDescriptorPool       frame_pools[BINDLESS_FRAME_COUNT];
+
+    // fills the unused slots of the fallback sets, every descriptor has to be valid without partial binding
+    struct gpu_buffer      null_buffer;
+
+    VkDescriptorBufferInfo buffers[BINDLESS_MAX_BUFFERS];
+    uint32_t               buffer_count;
+
+    VkSampler              sampler;
+
+    // slots below texture_count are either registered or waiting in the free list for their point
+    VkDescriptorImageInfo  textures[BINDLESS_MAX_TEXTURES];
+    uint32_t               texture_count;
+
+    uint32_t               free_textures[BINDLESS_MAX_TEXTURES];
+    struct queue_point     free_points[BINDLESS_MAX_TEXTURES];
+    uint32_t               free_texture_count;
+} g_bindless_table;
+
+static bool create_bindless_pool(VkDescriptorPoolCreateFlags flags, VkDescriptorPool* pool)
+{
+    bool status = true;
+
+    VkDescriptorPoolSize pool_sizes[2];
+    pool_sizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    pool_sizes[0].descriptorCount = BINDLESS_MAX_BUFFERS;
+    pool_sizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    pool_sizes[1].descriptorCount = BINDLESS_MAX_TEXTURES;
+
+    VkDescriptorPoolCreateInfo info;
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    info.pNext = NULL;
+    info.flags = flags;
+    info.maxSets = 1;
+    info.poolSizeCount = 2;
+    info.pPoolSizes = pool_sizes;
+
+    if(vk_ctx->create_descriptor_pool(vk_ctx->device, &info, vk_ctx->allocation_callbacks, pool) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create bindless descriptor pool\n");
+        status = false;
+    }
+
+    return status;
+}
+
+static bool allocate_bindless_set(VkDescriptorPool pool, VkDescriptorSet* set)
+{
+    bool status = true;
+
+    VkDescriptorSetAllocateInfo info;
+    info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    info.pNext = NULL;
+    info.descriptorPool = pool;
+    info.descriptorSetCount = 1;
+    info.pSetLayouts = &g_bindless_table.layout;
+
+    if(vk_ctx->allocate_descriptor_sets(vk_ctx->device, &info, set) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to allocate bindless descriptor set\n");
+        status = false;
+    }
+
+    return status;
+}
+
+static void write_bindless_buffers(VkDescriptorSet set, uint32_t first, uint32_t count)
+{
+    VkWriteDescriptorSet write;
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.pNext = NULL;
+    write.dstSet = set;
+    write.dstBinding = 0;
+    write.dstArrayElement = first;
+    write.descriptorCount = count;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    write.pImageInfo = NULL;
+    write.pBufferInfo = &g_bindless_table.buffers[first];
+    write.pTexelBufferView = NULL;
+
+    vk_ctx->update_descriptor_sets(vk_ctx->device, 1, &write, 0, NULL);
+}
+
+static void write_bindless_textures(VkDescriptorSet set, uint32_t first, uint32_t count)
+{
+    VkWriteDescriptorSet write;
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.pNext = NULL;
+    write.dstSet = set;
+    write.dstBinding = 1;
+    write.dstArrayElement = first;
+    write.descriptorCount = count;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.pImageInfo = &g_bindless_table.textures[first];
+    write.pBufferInfo = NULL;
+    write.pTexelBufferView = NULL;
+
+    vk_ctx->update_descriptor_sets(vk_ctx->device, 1, &write, 0, NULL);
+}
+
+bool initialize_bindless_table(void)
+{
+    bool status = true;
+
+    memset(&g_bindless_table, 0, sizeof(struct bindless_table));
+
+    if(!vk_ctx->storage_buffer_array_dynamic_indexing_supported)
+    {
+        LOG_ERROR("Storage buffer array dynamic indexing not supported\n");
+        status = false;
+    }
+
+    if(status && !vk_ctx->sampled_image_array_dynamic_indexing_supported)
+    {
+        LOG_ERROR("Sampled image array dynamic indexing not supported\n");
+        status = false;
+    }
+
+    if(status && !vk_ctx->descriptor_indexing_supported)
+    {
+        VkPhysicalDeviceProperties properties;
+
+        vk_ctx->get_physical_device_properties(vk_ctx->physical_device, &properties);
+
+        if(properties.limits.maxPerStageDescriptorStorageBuffers < BINDLESS_MAX_BUFFERS)
+        {
+            LOG_ERROR("Bindless table needs %u storage buffers per stage, the device supports %u\n", BINDLESS_MAX_BUFFERS, properties.limits.maxPerStageDescriptorStorageBuffers);
+            status = false;
+        }
+
+        if(properties.limits.maxPerStageDescriptorSampledImages < BINDLESS_MAX_TEXTURES)
+        {
+            LOG_ERROR("Bindless table needs %u sampled images per stage, the device supports %u\n", BINDLESS_MAX_TEXTURES, properties.limits.maxPerStageDescriptorSampledImages);
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        VkSamplerCreateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        info.pNext = NULL;
+        info.flags = 0;
+        info.magFilter = VK_FILTER_LINEAR;
+        info.minFilter = VK_FILTER_LINEAR;
+        info.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+        info.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        info.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        info.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        info.mipLodBias = 0.0f;
+        info.anisotropyEnable = VK_FALSE;
+        info.maxAnisotropy = 1.0f;
+        info.compareEnable = VK_FALSE;
+        info.compareOp = VK_COMPARE_OP_ALWAYS;
+        info.minLod = 0.0f;
+        info.maxLod = VK_LOD_CLAMP_NONE;
+        info.borderColor = VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+        info.unnormalizedCoordinates = VK_FALSE;
+
+        if(vk_ctx->create_sampler(vk_ctx->device, &info, vk_ctx->allocation_callbacks, &g_bindless_table.sampler) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create bindless sampler\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        VkDescriptorSetLayoutBinding bindings[2];
+        bindings[0].binding = 0;
+        bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        bindings[0].descriptorCount = BINDLESS_MAX_BUFFERS;
+        bindings[0].stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        bindings[0].pImmutableSamplers = NULL;
+
+        bindings[1].binding = 1;
+        bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        bindings[1].descriptorCount = BINDLESS_MAX_TEXTURES;
+        bindings[1].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+        bindings[1].pImmutableSamplers = NULL;
+
+        // only the slots that are used have to be written, and new slots can be written while the set is in use
+        VkDescriptorBindingFlags binding_flags[2];
+        binding_flags[0] = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+        binding_flags[1] = binding_flags[0];
+
+        VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags_info;
+        binding_flags_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        binding_flags_info.pNext = NULL;
+        binding_flags_info.bindingCount = 2;
+        binding_flags_info.pBindingFlags = binding_flags;
+
+        VkDescriptorSetLayoutCreateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        info.pNext = vk_ctx->descriptor_indexing_supported ? &binding_flags_info : NULL;
+        info.flags = vk_ctx->descriptor_indexing_supported ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT : 0;
+        info.bindingCount = 2;
+        info.pBindings = bindings;
+
+        if(vk_ctx->create_descriptor_set_layout(vk_ctx->device, &info, vk_ctx->allocation_callbacks, &g_bindless_table.layout) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create bindless descriptor set layout\n");
+            status = false;
+        }
+    }
+
+    if(status && vk_ctx->descriptor_indexing_supported)
+    {
+        status = create_bindless_pool(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT, &g_bindless_table.pool);
+
+        if(status)
+        {
+            status = allocate_bindless_set(g_bindless_table.pool, &g_bindless_table.set);
+        }
+    }
+    else if(status)
+    {
+        for(uint32_t i = 0; status && (i < BINDLESS_FRAME_COUNT); i++)
+        {
+            status = create_bindless_pool(0, &g_bindless_table.frame_pools[i]);
+        }
+
+        if(status)
+        {
+            status = create_gpu_buffer(256, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &g_bindless_table.null_buffer);
+        }
+
+        for(uint32_t i = 0; status && (i < BINDLESS_MAX_BUFFERS); i++)
+        {
+            g_bindless_table.buffers[i].buffer = g_bindless_table.null_buffer.handle;
+            g_bindless_table.buffers[i].offset = 0;
+            g_bindless_table.buffers[i].range = VK_WHOLE_SIZE;
+        }
+    }
+
+    if(status)
+    {
+        LOG_INFO("Bindless table: %s\n", vk_ctx->descriptor_indexing_supported ? "descriptor indexing" : "per frame descriptor sets");
+    }
+    else
+    {
+        uninitialize_bindless_table();
+    }
+
+    return status;
+}
+
+void uninitialize_bindless_table(void)
+{
+    for(uint32_t i = 0; i < BINDLESS_FRAME_COUNT; i++)
+    {
+        if(g_bindless_table.frame_pools[i] != NULL)
+        {
+            vk_ctx->destroy_descriptor_pool(vk_ctx->device, g_bindless_table.frame_pools[i], vk_ctx->allocation_callbacks);
+            g_bindless_table.frame_pools[i] = NULL;
+        }
+    }
+
+    if(g_bindless_table.pool != NULL)
+    {
+        vk_ctx->destroy_descriptor_pool(vk_ctx->device, g_bindless_table.pool, vk_ctx->allocation_callbacks);
+        g_bindless_table.pool = NULL;
+        g_bindless_table.set = NULL;
+    }
+
+    if(g_bindless_table.layout != NULL)
+    {
+        vk_ctx->destroy_descriptor_set_layout(vk_ctx->device, g_bindless_table.layout, vk_ctx->allocation_callbacks);
+        g_bindless_table.layout = NULL;
+    }
+
+    if(g_bindless_table.sampler != NULL)
+    {
+        vk_ctx->destroy_sampler(vk_ctx->device, g_bindless_table.sampler, vk_ctx->allocation_callbacks);
+        g_bindless_table.sampler = NULL;
+    }
+
+    destroy_gpu_buffer(&g_bindless_table.null_buffer);
+
+    g_bindless_table.buffer_count = 0;
+    g_bindless_table.texture_count = 0;
+    g_bindless_table.free_texture_count = 0;
+}
+
+VkDescriptorSetLayout get_bindless_set_layout(void)
+{
+    return g_bindless_table.layout;
+}
+
+uint32_t register_bindless_buffer(VkBuffer buffer)
+{
+    uint32_t index = BINDLESS_INVALID_INDEX;
+
+    if(g_bindless_table.buffer_count < BINDLESS_MAX_BUFFERS)
+    {
+        index = g_bindless_table.buffer_count++;
+
+        g_bindless_table.buffers[index].buffer = buffer;
+        g_bindless_table.buffers[index].offset = 0;
+        g_bindless_table.buffers[index].range = VK_WHOLE_SIZE;
+
+        // the fallback writes the whole table into the set of every frame
+        if(g_bindless_table.set != NULL)
+        {
+            write_bindless_buffers(g_bindless_table.set, index, 1);
+        }
+    }
+    else
+    {
+        LOG_ERROR("Bindless table is full\n");
+    }
+
+    return index;
+}
+
+uint32_t register_bindless_texture(VkImageView view)
+{
+    uint32_t index = BINDLESS_INVALID_INDEX;
+
+    // the free list is ordered by release, the oldest entry is the first to be reached
+    if((g_bindless_table.free_texture_count > 0) && is_queue_point_reached(&g_bindless_table.free_points[0]))
+    {
+        index = g_bindless_table.free_textures[0];
+
+        g_bindless_table.free_texture_count--;
+
+        memmove(&g_bindless_table.free_textures[0], &g_bindless_table.free_textures[1], g_bindless_table.free_texture_count * sizeof(uint32_t));
+        memmove(&g_bindless_table.free_points[0], &g_bindless_table.free_points[1], g_bindless_table.free_texture_count * sizeof(struct queue_point));
+    }
+    else if(g_bindless_table.texture_count < BINDLESS_MAX_TEXTURES)
+    {
+        index = g_bindless_table.texture_count++;
+    }
+    else
+    {
+        LOG_ERROR("Bindless texture table is full\n");
+    }
+
+    if(index != BINDLESS_INVALID_INDEX)
+    {
+        g_bindless_table.textures[index].sampler = g_bindless_table.sampler;
+        g_bindless_table.textures[index].imageView = view;
+        g_bindless_table.textures[index].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+        if(g_bindless_table.set != NULL)
+        {
+            write_bindless_textures(g_bindless_table.set, index, 1);
+        }
+        else if(index == 0)
+        {
+            // without partial binding every slot of the per frame sets needs a valid texture
+            for(uint32_t i = 1; i < BINDLESS_MAX_TEXTURES; i++)
+            {
+                g_bindless_table.textures[i] = g_bindless_table.textures[0];
+            }
+        }
+    }
+
+    return index;
+}
+
+void release_bindless_texture(uint32_t index, const struct queue_point* point)
+{
+    if((index != BINDLESS_INVALID_INDEX) && (index < g_bindless_table.texture_count))
+    {
+        // the per frame sets of later frames no longer reference the view, it can be destroyed with the point
+        if(g_bindless_table.set == NULL)
+        {
+            g_bindless_table.textures[index] = g_bindless_table.textures[0];
+        }
+
+        g_bindless_table.free_textures[g_bindless_table.free_texture_count] = index;
+        g_bindless_table.free_points[g_bindless_table.free_texture_count] = *point;
+        g_bindless_table.free_texture_count++;
+    }
+}
+
+void bind_bindless_table(VkCommandBuffer command_buffer, VkPipelineBindPoint bind_point, VkPipelineLayout layout, uint32_t frame_slot)
+{
+    VkDescriptorSet set = g_bindless_table.set;
+
+    if(set == NULL)
+    {
+        VkDescriptorPool pool = g_bindless_table.frame_pools[frame_slot % BINDLESS_FRAME_COUNT];
+
+        vk_ctx->reset_descriptor_pool(vk_ctx->device, pool, 0);
+
+        if(allocate_bindless_set(pool, &set))
+        {
+            write_bindless_buffers(set, 0, BINDLESS_MAX_BUFFERS);
+
+            if(g_bindless_table.texture_count > 0)
+            {
+                write_bindless_textures(set, 0, BINDLESS_MAX_TEXTURES);
+            }
+        }
+    }
+
+    if(set != NULL)
+    {
+        vk_ctx->cmd_bind_descriptor_sets(command_buffer, bind_point, layout, 0, 1, &set, 0, NULL);
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef BINDLESS_H
+#define BINDLESS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include "queue_scheduler.h"
+#include "vk_context.h"
+
+// must match the array sizes of the buffer and texture tables in the shaders
+enum { BINDLESS_MAX_BUFFERS   = 64 };
+enum { BINDLESS_MAX_TEXTURES  = 256 };
+enum { BINDLESS_FRAME_COUNT   = VK_CTX_NUM_FRAMES };
+enum { BINDLESS_INVALID_INDEX = 0xFFFFFFFF };
+
+// one descriptor set (set 0) holding a table of storage buffers (binding 0) and a table of sampled textures
+// (binding 1) that shaders select with indices from push constants. with descriptor indexing the set is written
+// once per buffer and updated while it is bound, otherwise a new set is allocated every frame from a per frame
+// pool that is reset when the frame is reused
+bool initialize_bindless_table(void);
+void uninitialize_bindless_table(void);
+
+VkDescriptorSetLayout get_bindless_set_layout(void);
+
+// returns the table index of the buffer or BINDLESS_INVALID_INDEX when the table is full
+uint32_t register_bindless_buffer(VkBuffer buffer);
+
+// the view must be in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, all textures share one trilinear repeating
+// sampler. returns the table index or BINDLESS_INVALID_INDEX when the table is full. the first registered
+// texture also fills the unused slots of the per frame sets
+uint32_t register_bindless_texture(VkImageView view);
+
+// the slot is reused once point is reached, the frames that may still sample the texture have completed by then
+void release_bindless_texture(uint32_t index, const struct queue_point* point);
+
+// frame_slot cycles through BINDLESS_FRAME_COUNT values, the caller guarantees that the frame that last used
+// the slot has completed
+void bind_bindless_table(VkCommandBuffer command_buffer, VkPipelineBindPoint bind_point, VkPipelineLayout layout, uint32_t frame_slot);
+
+#endif // BINDLESS_H
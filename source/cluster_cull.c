@@ -0,0 +1,334 @@
+#include <math.h>
+#include <string.h>
+
+#include "cluster_cull.h"
+#include "gpu_buffer.h"
+#include "logger.h"
+#include "shader.h"
+#include "vk_context.h"
+
+enum { CLUSTER_CULL_GROUP_SIZE = 64 };
+
+struct cluster_cull_constants
+{
+    float    frustum_planes[6][4];
+    float    camera[4];
+    uint32_t meshlet_count;
+    uint32_t padding[3];
+};
+
+struct cluster_culling
+{
+    uint32_t              meshlet_count;
+
+    struct gpu_buffer     meshlet_buffer;
+    struct gpu_buffer     index_buffer;
+    struct gpu_buffer     draw_buffer;
+    struct gpu_buffer     draw_count_buffer;
+
+    VkShaderModule        shader_module;
+    VkDescriptorSetLayout descriptor_set_layout;
+    VkDescriptorPool      descriptor_pool;
+    VkDescriptorSet       descriptor_set;
+    VkPipelineLayout      pipeline_layout;
+    VkPipeline            pipeline;
+} g_cluster_culling;
+
+bool initialize_cluster_culling(const struct meshlet_list* meshlet_list)
+{
+    bool status = true;
+
+    memset(&g_cluster_culling, 0, sizeof(struct cluster_culling));
+
+    g_cluster_culling.meshlet_count = meshlet_list->meshlet_count;
+
+    if(status)
+    {
+        status = create_gpu_buffer_with_data(meshlet_list->meshlets, meshlet_list->meshlet_count * sizeof(struct meshlet), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, &g_cluster_culling.meshlet_buffer);
+    }
+
+    if(status)
+    {
+        status = create_gpu_buffer_with_data(meshlet_list->indices, meshlet_list->index_count * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, &g_cluster_culling.index_buffer);
+    }
+
+    if(status)
+    {
+        status = create_gpu_buffer(meshlet_list->meshlet_count * sizeof(VkDrawIndexedIndirectCommand), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &g_cluster_culling.draw_buffer);
+    }
+
+    if(status)
+    {
+        status = create_gpu_buffer(sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &g_cluster_culling.draw_count_buffer);
+    }
+
+    if(status)
+    {
+        status = create_shader_module_from_file("c:/workspace/vk-cube/bin/cluster_cull.comp.spv", &g_cluster_culling.shader_module);
+    }
+
+    if(status)
+    {
+        VkDescriptorSetLayoutBinding bindings[3];
+
+        for(uint32_t i = 0; i < 3; i++)
+        {
+            bindings[i].binding = i;
+            bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[i].descriptorCount = 1;
+            bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+            bindings[i].pImmutableSamplers = NULL;
+        }
+
+        VkDescriptorSetLayoutCreateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        info.pNext = NULL;
+        info.flags = 0;
+        info.bindingCount = 3;
+        info.pBindings = bindings;
+
+        if(vk_ctx->create_descriptor_set_layout(vk_ctx->device, &info, vk_ctx->allocation_callbacks, &g_cluster_culling.descriptor_set_layout) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create cluster culling descriptor set layout\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        VkDescriptorPoolSize pool_size;
+        pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        pool_size.descriptorCount = 3;
+
+        VkDescriptorPoolCreateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        info.pNext = NULL;
+        info.flags = 0;
+        info.maxSets = 1;
+        info.poolSizeCount = 1;
+        info.pPoolSizes = &pool_size;
+
+        if(vk_ctx->create_descriptor_pool(vk_ctx->device, &info, vk_ctx->allocation_callbacks, &g_cluster_culling.descriptor_pool) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create cluster culling descriptor pool\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        VkDescriptorSetAllocateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        info.pNext = NULL;
+        info.descriptorPool = g_cluster_culling.descriptor_pool;
+        info.descriptorSetCount = 1;
+        info.pSetLayouts = &g_cluster_culling.descriptor_set_layout;
+
+        if(vk_ctx->allocate_descriptor_sets(vk_ctx->device, &info, &g_cluster_culling.descriptor_set) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to allocate cluster culling descriptor set\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        const struct gpu_buffer* buffers[3] = { &g_cluster_culling.meshlet_buffer, &g_cluster_culling.draw_buffer, &g_cluster_culling.draw_count_buffer };
+
+        VkDescriptorBufferInfo buffer_infos[3];
+        VkWriteDescriptorSet writes[3];
+
+        for(uint32_t i = 0; i < 3; i++)
+        {
+            buffer_infos[i].buffer = buffers[i]->handle;
+            buffer_infos[i].offset = 0;
+            buffer_infos[i].range = VK_WHOLE_SIZE;
+
+            writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[i].pNext = NULL;
+            writes[i].dstSet = g_cluster_culling.descriptor_set;
+            writes[i].dstBinding = i;
+            writes[i].dstArrayElement = 0;
+            writes[i].descriptorCount = 1;
+            writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            writes[i].pImageInfo = NULL;
+            writes[i].pBufferInfo = &buffer_infos[i];
+            writes[i].pTexelBufferView = NULL;
+        }
+
+        vk_ctx->update_descriptor_sets(vk_ctx->device, 3, writes, 0, NULL);
+    }
+
+    if(status)
+    {
+        VkPushConstantRange push_constant_range;
+        push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        push_constant_range.offset = 0;
+        push_constant_range.size = sizeof(struct cluster_cull_constants);
+
+        VkPipelineLayoutCreateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        info.pNext = NULL;
+        info.flags = 0;
+        info.setLayoutCount = 1;
+        info.pSetLayouts = &g_cluster_culling.descriptor_set_layout;
+        info.pushConstantRangeCount = 1;
+        info.pPushConstantRanges = &push_constant_range;
+
+        if(vk_ctx->create_pipeline_layout(vk_ctx->device, &info, vk_ctx->allocation_callbacks, &g_cluster_culling.pipeline_layout) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create cluster culling pipeline layout\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        VkComputePipelineCreateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        info.pNext = NULL;
+        info.flags = 0;
+        info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        info.stage.pNext = NULL;
+        info.stage.flags = 0;
+        info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        info.stage.module = g_cluster_culling.shader_module;
+        info.stage.pName = "main";
+        info.stage.pSpecializationInfo = NULL;
+        info.layout = g_cluster_culling.pipeline_layout;
+        info.basePipelineHandle = NULL;
+        info.basePipelineIndex = -1;
+
+        if(vk_ctx->create_compute_pipelines(vk_ctx->device, NULL, 1, &info, vk_ctx->allocation_callbacks, &g_cluster_culling.pipeline) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create cluster culling pipeline\n");
+            status = false;
+        }
+    }
+
+    if(!status)
+    {
+        uninitialize_cluster_culling();
+    }
+
+    return status;
+}
+
+void uninitialize_cluster_culling(void)
+{
+    if(g_cluster_culling.pipeline != NULL)
+    {
+        vk_ctx->destroy_pipeline(vk_ctx->device, g_cluster_culling.pipeline, vk_ctx->allocation_callbacks);
+        g_cluster_culling.pipeline = NULL;
+    }
+
+    if(g_cluster_culling.pipeline_layout != NULL)
+    {
+        vk_ctx->destroy_pipeline_layout(vk_ctx->device, g_cluster_culling.pipeline_layout, vk_ctx->allocation_callbacks);
+        g_cluster_culling.pipeline_layout = NULL;
+    }
+
+    if(g_cluster_culling.descriptor_pool != NULL)
+    {
+        vk_ctx->destroy_descriptor_pool(vk_ctx->device, g_cluster_culling.descriptor_pool, vk_ctx->allocation_callbacks);
+        g_cluster_culling.descriptor_pool = NULL;
+        g_cluster_culling.descriptor_set = NULL;
+    }
+
+    if(g_cluster_culling.descriptor_set_layout != NULL)
+    {
+        vk_ctx->destroy_descriptor_set_layout(vk_ctx->device, g_cluster_culling.descriptor_set_layout, vk_ctx->allocation_callbacks);
+        g_cluster_culling.descriptor_set_layout = NULL;
+    }
+
+    if(g_cluster_culling.shader_module != NULL)
+    {
+        vk_ctx->destroy_shader_module(vk_ctx->device, g_cluster_culling.shader_module, vk_ctx->allocation_callbacks);
+        g_cluster_culling.shader_module = NULL;
+    }
+
+    destroy_gpu_buffer(&g_cluster_culling.draw_count_buffer);
+    destroy_gpu_buffer(&g_cluster_culling.draw_buffer);
+    destroy_gpu_buffer(&g_cluster_culling.index_buffer);
+    destroy_gpu_buffer(&g_cluster_culling.meshlet_buffer);
+
+    g_cluster_culling.meshlet_count = 0;
+}
+
+void extract_frustum_planes(const float view_projection[16], float planes[6][4])
+{
+    // rows of the column major matrix, clip = m * p
+    float r[4][4];
+
+    for(uint32_t row = 0; row < 4; row++)
+    {
+        for(uint32_t col = 0; col < 4; col++)
+        {
+            r[row][col] = view_projection[col * 4 + row];
+        }
+    }
+
+    for(uint32_t c = 0; c < 4; c++)
+    {
+        planes[0][c] = r[3][c] + r[0][c]; // left
+        planes[1][c] = r[3][c] - r[0][c]; // right
+        planes[2][c] = r[3][c] + r[1][c]; // top
+        planes[3][c] = r[3][c] - r[1][c]; // bottom
+        planes[4][c] = r[2][c];           // near, vulkan depth range is [0, 1]
+        planes[5][c] = r[3][c] - r[2][c]; // far
+    }
+
+    for(uint32_t i = 0; i < 6; i++)
+    {
+        float length = sqrtf(planes[i][0] * planes[i][0] + planes[i][1] * planes[i][1] + planes[i][2] * planes[i][2]);
+
+        if(length > 0.0f)
+        {
+            for(uint32_t c = 0; c < 4; c++)
+            {
+                planes[i][c] /= length;
+            }
+        }
+    }
+}
+
+void record_cluster_culling(VkCommandBuffer command_buffer, const float view_projection[16], const float camera[4])
+{
+    struct cluster_cull_constants constants = { 0 };
+
+    extract_frustum_planes(view_projection, constants.frustum_planes);
+    memcpy(constants.camera, camera, sizeof(constants.camera));
+    constants.meshlet_count = g_cluster_culling.meshlet_count;
+
+    // the previous frame's indirect draws must have consumed the buffers before they are rewritten
+    vk_ctx->cmd_pipeline_barrier(command_buffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, NULL, 0, NULL, 0, NULL);
+
+    vk_ctx->cmd_fill_buffer(command_buffer, g_cluster_culling.draw_count_buffer.handle, 0, sizeof(uint32_t), 0);
+
+    VkMemoryBarrier clear_barrier;
+    clear_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    clear_barrier.pNext = NULL;
+    clear_barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    clear_barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    vk_ctx->cmd_pipeline_barrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &clear_barrier, 0, NULL, 0, NULL);
+
+    vk_ctx->cmd_bind_pipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, g_cluster_culling.pipeline);
+    vk_ctx->cmd_bind_descriptor_sets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, g_cluster_culling.pipeline_layout, 0, 1, &g_cluster_culling.descriptor_set, 0, NULL);
+    vk_ctx->cmd_push_constants(command_buffer, g_cluster_culling.pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(struct cluster_cull_constants), &constants);
+    vk_ctx->cmd_dispatch(command_buffer, (g_cluster_culling.meshlet_count + CLUSTER_CULL_GROUP_SIZE - 1) / CLUSTER_CULL_GROUP_SIZE, 1, 1);
+
+    VkMemoryBarrier draw_barrier;
+    draw_barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    draw_barrier.pNext = NULL;
+    draw_barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    draw_barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+
+    vk_ctx->cmd_pipeline_barrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, 0, 1, &draw_barrier, 0, NULL, 0, NULL);
+}
+
+void record_cluster_draws(VkCommandBuffer command_buffer)
+{
+    vk_ctx->cmd_bind_index_buffer(command_buffer, g_cluster_culling.index_buffer.handle, 0, VK_INDEX_TYPE_UINT32);
+    vk_ctx->cmd_draw_indexed_indirect_count(command_buffer, g_cluster_culling.draw_buffer.handle, 0, g_cluster_culling.draw_count_buffer.handle, 0, g_cluster_culling.meshlet_count, sizeof(VkDrawIndexedIndirectCommand));
+}
@@ -0,0 +1,102 @@
+#version 450
+
+layout(local_size_x = 64) in;
+
+struct meshlet
+{
+    vec4 sphere; // xyz center, w radius
+    vec4 cone;   // xyz axis, w cutoff
+    uint first_index;
+    uint index_count;
+    uint vertex_count;
+    uint triangle_count;
+};
+
+struct draw_command
+{
+    uint index_count;
+    uint instance_count;
+    uint first_index;
+    int  vertex_offset;
+    uint first_instance;
+};
+
+layout(std430, set = 0, binding = 0) readonly buffer meshlet_buffer
+{
+    meshlet meshlets[];
+};
+
+layout(std430, set = 0, binding = 1) writeonly buffer draw_buffer
+{
+    draw_command draws[];
+};
+
+layout(std430, set = 0, binding = 2) buffer draw_count_buffer
+{
+    uint draw_count;
+};
+
+layout(push_constant) uniform constants
+{
+    vec4 frustum_planes[6];
+    vec4 camera; // xyz position (w = 1) or view direction (w = 0)
+    uint meshlet_count;
+};
+
+bool is_visible(meshlet m)
+{
+    vec3 center = m.sphere.xyz;
+    float radius = m.sphere.w;
+
+    for(int i = 0; i < 6; i++)
+    {
+        if(dot(frustum_planes[i].xyz, center) + frustum_planes[i].w < -radius)
+        {
+            return false;
+        }
+    }
+
+    // every triangle in the cluster faces away from the camera
+    if(m.cone.w < 1.0)
+    {
+        if(camera.w == 0.0)
+        {
+            if(dot(camera.xyz, m.cone.xyz) >= m.cone.w)
+            {
+                return false;
+            }
+        }
+        else
+        {
+            vec3 view = center - camera.xyz;
+
+            if(dot(view, m.cone.xyz) >= m.cone.w * length(view) + radius)
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void main()
+{
+    uint index = gl_GlobalInvocationID.x;
+
+    if(index < meshlet_count)
+    {
+        meshlet m = meshlets[index];
+
+        if(is_visible(m))
+        {
+            uint slot = atomicAdd(draw_count, 1);
+
+            draws[slot].index_count = m.index_count;
+            draws[slot].instance_count = 1;
+            draws[slot].first_index = m.first_index;
+            draws[slot].vertex_offset = 0;
+            draws[slot].first_instance = 0;
+        }
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef CLUSTER_CULL_H
+#define CLUSTER_CULL_H
+
+#include <stdbool.h>
+
+#include <vulkan/vulkan.h>
+
+#include "meshlet.h"
+
+// frustum + normal cone culling of meshlets on the gpu, the surviving clusters are written as
+// compacted indexed indirect draws and consumed with vkCmdDrawIndexedIndirectCount
+bool initialize_cluster_culling(const struct meshlet_list* meshlet_list);
+void uninitialize_cluster_culling(void);
+
+// view_projection is column major, camera is a world space position (w = 1) or view direction (w = 0)
+void record_cluster_culling(VkCommandBuffer command_buffer, const float view_projection[16], const float camera[4]);
+
+// expects the vertex buffer of the source mesh to be bound
+void record_cluster_draws(VkCommandBuffer command_buffer);
+
+void extract_frustum_planes(const float view_projection[16], float planes[6][4]);
+
+#endif // CLUSTER_CULL_H
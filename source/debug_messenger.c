@@ -0,0 +1,362 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL2/SDL.h>
+
+#include "debug_messenger.h"
+#include "logger.h"
+
+enum { DEBUG_MESSAGE_MAX_OBJECTS     = 4 };
+enum { DEBUG_MESSAGE_NAME_SIZE       = 64 };
+enum { DEBUG_MESSAGE_OBJECTS_SIZE    = 512 }; // the formatted object lines of one message
+enum { DEBUG_MESSENGER_ID_TABLE_SIZE = 512 }; // message ids tracked for the repeat limit, a power of two
+
+// key is 0 while the entry is free and never changes once set
+struct debug_message_id
+{
+    SDL_atomic_t key;
+    SDL_atomic_t count;
+    char         name[DEBUG_MESSAGE_NAME_SIZE];
+};
+
+struct debug_messenger
+{
+    struct debug_messenger_options options;
+
+    struct debug_message_id        ids[DEBUG_MESSENGER_ID_TABLE_SIZE];
+
+    // start in milliseconds and message count of the current one second window of the rate limit
+    SDL_atomic_t                   window_start;
+    SDL_atomic_t                   window_count;
+
+    SDL_atomic_t                   message_count;
+    SDL_atomic_t                   suppressed_count;
+    SDL_atomic_t                   rate_limited_count;
+};
+
+static const char* get_object_type_name(VkObjectType type)
+{
+    const char* name = NULL;
+
+    switch(type)
+    {
+        case VK_OBJECT_TYPE_INSTANCE:              name = "Instance";            break;
+        case VK_OBJECT_TYPE_PHYSICAL_DEVICE:       name = "PhysicalDevice";      break;
+        case VK_OBJECT_TYPE_DEVICE:                name = "Device";              break;
+        case VK_OBJECT_TYPE_QUEUE:                 name = "Queue";               break;
+        case VK_OBJECT_TYPE_SEMAPHORE:             name = "Semaphore";           break;
+        case VK_OBJECT_TYPE_COMMAND_BUFFER:        name = "CommandBuffer";       break;
+        case VK_OBJECT_TYPE_FENCE:                 name = "Fence";               break;
+        case VK_OBJECT_TYPE_DEVICE_MEMORY:         name = "DeviceMemory";        break;
+        case VK_OBJECT_TYPE_BUFFER:                name = "Buffer";              break;
+        case VK_OBJECT_TYPE_IMAGE:                 name = "Image";               break;
+        case VK_OBJECT_TYPE_EVENT:                 name = "Event";               break;
+        case VK_OBJECT_TYPE_QUERY_POOL:            name = "QueryPool";           break;
+        case VK_OBJECT_TYPE_BUFFER_VIEW:           name = "BufferView";          break;
+        case VK_OBJECT_TYPE_IMAGE_VIEW:            name = "ImageView";           break;
+        case VK_OBJECT_TYPE_SHADER_MODULE:         name = "ShaderModule";        break;
+        case VK_OBJECT_TYPE_PIPELINE_CACHE:        name = "PipelineCache";       break;
+        case VK_OBJECT_TYPE_PIPELINE_LAYOUT:       name = "PipelineLayout";      break;
+        case VK_OBJECT_TYPE_RENDER_PASS:           name = "RenderPass";          break;
+        case VK_OBJECT_TYPE_PIPELINE:              name = "Pipeline";            break;
+        case VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT: name = "DescriptorSetLayout"; break;
+        case VK_OBJECT_TYPE_SAMPLER:               name = "Sampler";             break;
+        case VK_OBJECT_TYPE_DESCRIPTOR_POOL:       name = "DescriptorPool";      break;
+        case VK_OBJECT_TYPE_DESCRIPTOR_SET:        name = "DescriptorSet";       break;
+        case VK_OBJECT_TYPE_FRAMEBUFFER:           name = "Framebuffer";         break;
+        case VK_OBJECT_TYPE_COMMAND_POOL:          name = "CommandPool";         break;
+        case VK_OBJECT_TYPE_SURFACE_KHR:           name = "Surface";             break;
+        case VK_OBJECT_TYPE_SWAPCHAIN_KHR:         name = "Swapchain";           break;
+        default:                                   name = NULL;                  break;
+    }
+
+    return name;
+}
+
+static const char* get_severity_name(VkDebugUtilsMessageSeverityFlagBitsEXT severity)
+{
+    const char* name = "Verbose";
+
+    if(severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
+    {
+        name = "Error";
+    }
+    else if(severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)
+    {
+        name = "Warning";
+    }
+    else if(severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT)
+    {
+        name = "Information";
+    }
+
+    return name;
+}
+
+static const char* get_type_name(VkDebugUtilsMessageTypeFlagsEXT types)
+{
+    const char* name = "General";
+
+    if(types & VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT)
+    {
+        name = "Validation";
+    }
+    else if(types & VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT)
+    {
+        name = "Performance";
+    }
+
+    return name;
+}
+
+static void copy_string(char* destination, uint32_t size, const char* source)
+{
+    if(source != NULL)
+    {
+        strncpy(destination, source, size - 1);
+        destination[size - 1] = '\0';
+    }
+    else
+    {
+        destination[0] = '\0';
+    }
+}
+
+// fnv-1a over the id name and number, 0 is reserved for free entries
+static uint32_t hash_message_id(const VkDebugUtilsMessengerCallbackDataEXT* data)
+{
+    uint32_t hash = 2166136261u;
+
+    for(const char* c = data->pMessageIdName; (c != NULL) && (*c != '\0'); c++)
+    {
+        hash = (hash ^ (uint8_t) *c) * 16777619u;
+    }
+
+    hash = (hash ^ (uint32_t) data->messageIdNumber) * 16777619u;
+
+    return (hash != 0) ? hash : 1;
+}
+
+// the entry of the id, inserted on first sight. NULL when the table is full, the message is then never suppressed
+static struct debug_message_id* find_message_id(struct debug_messenger* messenger, const VkDebugUtilsMessengerCallbackDataEXT* data)
+{
+    struct debug_message_id* entry = NULL;
+
+    uint32_t key = hash_message_id(data);
+
+    for(uint32_t i = 0; (entry == NULL) && (i < DEBUG_MESSENGER_ID_TABLE_SIZE); i++)
+    {
+        struct debug_message_id* candidate = &messenger->ids[(key + i) & (DEBUG_MESSENGER_ID_TABLE_SIZE - 1)];
+
+        int current = SDL_AtomicGet(&candidate->key);
+
+        if((current == 0) && SDL_AtomicCAS(&candidate->key, 0, (int) key))
+        {
+            // only read after the callbacks stopped, no other thread writes the name of a claimed entry
+            copy_string(candidate->name, DEBUG_MESSAGE_NAME_SIZE, data->pMessageIdName);
+            entry = candidate;
+        }
+        else if((uint32_t) SDL_AtomicGet(&candidate->key) == key)
+        {
+            entry = candidate;
+        }
+    }
+
+    return entry;
+}
+
+// true while the current one second window has budget left, errors always pass
+static bool check_rate_limit(struct debug_messenger* messenger, VkDebugUtilsMessageSeverityFlagBitsEXT severity)
+{
+    bool allowed = true;
+
+    if((messenger->options.rate_limit > 0) && !(severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT))
+    {
+        int now = (int) SDL_GetTicks();
+        int start = SDL_AtomicGet(&messenger->window_start);
+
+        // the thread that moves the window resets the count, messages racing with it count towards either window
+        if(((uint32_t) (now - start) >= 1000) && SDL_AtomicCAS(&messenger->window_start, start, now))
+        {
+            SDL_AtomicSet(&messenger->window_count, 0);
+        }
+
+        allowed = ((uint32_t) SDL_AtomicAdd(&messenger->window_count, 1) < messenger->options.rate_limit);
+    }
+
+    return allowed;
+}
+
+// the objects are formatted into one string here, the logger copies it with the text of the message and formats
+// the line on its writer thread. the severity of the message selects the level
+static void log_debug_message(struct debug_messenger* messenger, VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT types, const VkDebugUtilsMessengerCallbackDataEXT* data, uint32_t repeat)
+{
+    char objects[DEBUG_MESSAGE_OBJECTS_SIZE];
+    uint32_t length = 0;
+
+    objects[0] = '\0';
+
+    uint32_t object_count = (data->objectCount < DEBUG_MESSAGE_MAX_OBJECTS) ? data->objectCount : DEBUG_MESSAGE_MAX_OBJECTS;
+
+    for(uint32_t i = 0; i < object_count; i++)
+    {
+        const VkDebugUtilsObjectNameInfoEXT* object = &data->pObjects[i];
+        const char* type_name = get_object_type_name(object->objectType);
+
+        if(type_name != NULL)
+        {
+            length += (uint32_t) snprintf(objects + length, DEBUG_MESSAGE_OBJECTS_SIZE - length, "\n\t%s 0x%llX", type_name, (unsigned long long) object->objectHandle);
+        }
+        else
+        {
+            length += (uint32_t) snprintf(objects + length, DEBUG_MESSAGE_OBJECTS_SIZE - length, "\n\tObjectType:0x%X 0x%llX", object->objectType, (unsigned long long) object->objectHandle);
+        }
+
+        length = (length < DEBUG_MESSAGE_OBJECTS_SIZE) ? length : DEBUG_MESSAGE_OBJECTS_SIZE - 1;
+
+        if((object->pObjectName != NULL) && (object->pObjectName[0] != '\0'))
+        {
+            length += (uint32_t) snprintf(objects + length, DEBUG_MESSAGE_OBJECTS_SIZE - length, " \"%s\"", object->pObjectName);
+            length = (length < DEBUG_MESSAGE_OBJECTS_SIZE) ? length : DEBUG_MESSAGE_OBJECTS_SIZE - 1;
+        }
+    }
+
+    const char* type_name = get_type_name(types);
+    const char* severity_name = get_severity_name(severity);
+    const char* id_name = (data->pMessageIdName != NULL) ? data->pMessageIdName : "";
+    const char* text = (data->pMessage != NULL) ? data->pMessage : "";
+    const char* suppressed = ((messenger->options.repeat_limit > 0) && (repeat == messenger->options.repeat_limit)) ? "\n\tfurther repeats of this message are suppressed" : "";
+
+    if(severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
+    {
+        LOG_ERROR("%s %s: [%s] 0x%08X\n\t%s%s%s\n", type_name, severity_name, id_name, (uint32_t) data->messageIdNumber, text, objects, suppressed);
+    }
+    else if(severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)
+    {
+        LOG_WARNING("%s %s: [%s] 0x%08X\n\t%s%s%s\n", type_name, severity_name, id_name, (uint32_t) data->messageIdNumber, text, objects, suppressed);
+    }
+    else if(severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT)
+    {
+        LOG_INFO("%s %s: [%s] 0x%08X\n\t%s%s%s\n", type_name, severity_name, id_name, (uint32_t) data->messageIdNumber, text, objects, suppressed);
+    }
+    else
+    {
+        LOG_DEBUG("%s %s: [%s] 0x%08X\n\t%s%s%s\n", type_name, severity_name, id_name, (uint32_t) data->messageIdNumber, text, objects, suppressed);
+    }
+}
+
+static VkBool32 debug_messenger_callback(VkDebugUtilsMessageSeverityFlagBitsEXT severity, VkDebugUtilsMessageTypeFlagsEXT types, const VkDebugUtilsMessengerCallbackDataEXT* data, void* user_data)
+{
+    struct debug_messenger* messenger = (struct debug_messenger*) user_data;
+
+    bool status = true;
+
+    uint32_t repeat = 0;
+
+    // the driver filters with the masks of the create info, the messages of the instance creation included
+    SDL_AtomicAdd(&messenger->message_count, 1);
+
+    if(status)
+    {
+        struct debug_message_id* id = find_message_id(messenger, data);
+
+        if(id != NULL)
+        {
+            repeat = (uint32_t) SDL_AtomicAdd(&id->count, 1) + 1;
+        }
+
+        if((messenger->options.repeat_limit > 0) && (repeat > messenger->options.repeat_limit))
+        {
+            SDL_AtomicAdd(&messenger->suppressed_count, 1);
+            status = false;
+        }
+    }
+
+    if(status && !check_rate_limit(messenger, severity))
+    {
+        SDL_AtomicAdd(&messenger->rate_limited_count, 1);
+        status = false;
+    }
+
+    if(status)
+    {
+        log_debug_message(messenger, severity, types, data, repeat);
+    }
+
+    return VK_FALSE;
+}
+
+void init_debug_messenger_options(struct debug_messenger_options* options)
+{
+    options->severities = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+    options->types = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
+    options->repeat_limit = DEBUG_MESSENGER_REPEAT_LIMIT;
+    options->rate_limit = DEBUG_MESSENGER_RATE_LIMIT;
+}
+
+bool initialize_debug_messenger(struct debug_messenger** messenger, const struct debug_messenger_options* options)
+{
+    bool status = true;
+
+    struct debug_messenger* result = (struct debug_messenger*) calloc(1, sizeof(struct debug_messenger));
+
+    if(result == NULL)
+    {
+        LOG_ERROR("Failed to allocate the debug messenger\n");
+        status = false;
+    }
+
+    if(status)
+    {
+        result->options = *options;
+        SDL_AtomicSet(&result->window_start, (int) SDL_GetTicks());
+    }
+
+    *messenger = result;
+
+    return status;
+}
+
+void uninitialize_debug_messenger(struct debug_messenger* messenger)
+{
+    if(messenger != NULL)
+    {
+        struct debug_messenger_stats stats;
+        get_debug_messenger_stats(messenger, &stats);
+
+        LOG_INFO("Debug messenger: %u messages, %u repeats suppressed, %u rate limited\n", stats.message_count, stats.suppressed_count, stats.rate_limited_count);
+
+        for(uint32_t i = 0; i < DEBUG_MESSENGER_ID_TABLE_SIZE; i++)
+        {
+            struct debug_message_id* id = &messenger->ids[i];
+
+            uint32_t count = (uint32_t) SDL_AtomicGet(&id->count);
+
+            if((messenger->options.repeat_limit > 0) && (count > messenger->options.repeat_limit))
+            {
+                LOG_INFO("\t[%s] %u times\n", id->name, count);
+            }
+        }
+
+        free(messenger);
+    }
+}
+
+void get_debug_messenger_create_info(struct debug_messenger* messenger, VkDebugUtilsMessengerCreateInfoEXT* info)
+{
+    info->sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
+    info->pNext = NULL;
+    info->flags = 0;
+    info->messageSeverity = messenger->options.severities;
+    info->messageType = messenger->options.types;
+    info->pfnUserCallback = debug_messenger_callback;
+    info->pUserData = messenger;
+}
+
+void get_debug_messenger_stats(struct debug_messenger* messenger, struct debug_messenger_stats* stats)
+{
+    stats->message_count = (uint32_t) SDL_AtomicGet(&messenger->message_count);
+    stats->suppressed_count = (uint32_t) SDL_AtomicGet(&messenger->suppressed_count);
+    stats->rate_limited_count = (uint32_t) SDL_AtomicGet(&messenger->rate_limited_count);
+}
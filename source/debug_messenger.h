@@ -0,0 +1,44 @@
+#ifndef DEBUG_MESSENGER_H
+#define DEBUG_MESSENGER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+enum { DEBUG_MESSENGER_REPEAT_LIMIT = 4 };   // occurrences of one message id that are printed
+enum { DEBUG_MESSENGER_RATE_LIMIT   = 64 };  // messages per second that are printed, errors are exempt
+
+struct debug_messenger_options
+{
+    VkDebugUtilsMessageSeverityFlagsEXT severities;
+    VkDebugUtilsMessageTypeFlagsEXT     types;
+    uint32_t                            repeat_limit; // 0 prints every repeat
+    uint32_t                            rate_limit;   // 0 disables the limit
+};
+
+struct debug_messenger_stats
+{
+    uint32_t message_count;    // messages that passed the severity and type filter
+    uint32_t suppressed_count; // repeats of a message id beyond the repeat limit
+    uint32_t rate_limited_count;
+};
+
+// private to debug_messenger.c
+struct debug_messenger;
+
+void init_debug_messenger_options(struct debug_messenger_options* options);
+
+// the callback filters the message and hands it to the logger, which formats and prints it on its writer thread.
+// one messenger can serve several threads and instances
+bool initialize_debug_messenger(struct debug_messenger** messenger, const struct debug_messenger_options* options);
+
+// logs the stats. every messenger registered with the create info has to be destroyed before
+void uninitialize_debug_messenger(struct debug_messenger* messenger);
+
+// for vkCreateDebugUtilsMessengerEXT and the pNext chain of VkInstanceCreateInfo
+void get_debug_messenger_create_info(struct debug_messenger* messenger, VkDebugUtilsMessengerCreateInfoEXT* info);
+
+void get_debug_messenger_stats(struct debug_messenger* messenger, struct debug_messenger_stats* stats);
+
+#endif // DEBUG_MESSENGER_H
@@ -0,0 +1,188 @@
+#include <string.h>
+
+#include "framebuffer_cache.h"
+#include "logger.h"
+#include "queue_scheduler.h"
+#include "vk_context.h"
+
+struct framebuffer_key
+{
+    VkRenderPass render_pass;
+    VkImageView  attachments[FRAMEBUFFER_CACHE_MAX_ATTACHMENTS];
+    uint32_t     attachment_count;
+    VkExtent2D   extent;
+};
+
+struct framebuffer_entry
+{
+    struct framebuffer_key key;
+    VkFramebuffer          framebuffer;
+    uint64_t               last_use;
+};
+
+struct framebuffer_cache
+{
+    struct framebuffer_entry entries[FRAMEBUFFER_CACHE_SIZE];
+    uint64_t                 use_counter;
+} g_framebuffer_cache;
+
+static void release_framebuffer_entry(struct framebuffer_entry* entry, VkSemaphore timeline, uint64_t value)
+{
+    if(entry->framebuffer != NULL)
+    {
+        defer_destruction(vk_ctx, VK_OBJECT_TYPE_FRAMEBUFFER, (uint64_t) entry->framebuffer, timeline, value);
+    }
+
+    memset(entry, 0, sizeof(struct framebuffer_entry));
+}
+
+// framebuffers are only used by the frame queue, a released one is destroyed once the frames already
+// submitted have completed
+static void release_framebuffer_entry_after_frames(struct framebuffer_entry* entry)
+{
+    struct queue_point point;
+    get_last_queue_point(QUEUE_CLASS_FRAME, &point);
+
+    release_framebuffer_entry(entry, get_queue_timeline(QUEUE_CLASS_FRAME), point.value);
+}
+
+static struct framebuffer_entry* find_framebuffer_entry(const struct framebuffer_key* key)
+{
+    struct framebuffer_entry* entry = NULL;
+
+    for(uint32_t i = 0; i < FRAMEBUFFER_CACHE_SIZE; i++)
+    {
+        struct framebuffer_entry* candidate = &g_framebuffer_cache.entries[i];
+
+        if((candidate->framebuffer != NULL) && (memcmp(&candidate->key, key, sizeof(struct framebuffer_key)) == 0))
+        {
+            entry = candidate;
+            break;
+        }
+    }
+
+    return entry;
+}
+
+// a free slot if there is one, otherwise the least recently used entry
+static struct framebuffer_entry* find_replaceable_entry(void)
+{
+    struct framebuffer_entry* entry = &g_framebuffer_cache.entries[0];
+
+    for(uint32_t i = 0; (i < FRAMEBUFFER_CACHE_SIZE) && (entry->framebuffer != NULL); i++)
+    {
+        struct framebuffer_entry* candidate = &g_framebuffer_cache.entries[i];
+
+        if((candidate->framebuffer == NULL) || (candidate->last_use < entry->last_use))
+        {
+            entry = candidate;
+        }
+    }
+
+    return entry;
+}
+
+VkFramebuffer get_framebuffer(VkRenderPass render_pass, uint32_t attachment_count, const VkImageView* attachments, VkExtent2D extent)
+{
+    bool status = true;
+
+    struct framebuffer_key key;
+    struct framebuffer_entry* entry = NULL;
+
+    if(attachment_count > FRAMEBUFFER_CACHE_MAX_ATTACHMENTS)
+    {
+        LOG_ERROR("Too many framebuffer attachments %u\n", attachment_count);
+        status = false;
+    }
+
+    if(status)
+    {
+        // zero the whole key so that the unused attachment slots compare equal
+        memset(&key, 0, sizeof(struct framebuffer_key));
+        key.render_pass = render_pass;
+        key.attachment_count = attachment_count;
+        key.extent = extent;
+        memcpy(key.attachments, attachments, attachment_count * sizeof(VkImageView));
+
+        entry = find_framebuffer_entry(&key);
+    }
+
+    if(status && (entry == NULL))
+    {
+        entry = find_replaceable_entry();
+
+        if(entry->framebuffer != NULL)
+        {
+            // only happens when more targets are alive than the cache holds, the evicted framebuffer may still be in flight
+            release_framebuffer_entry_after_frames(entry);
+        }
+
+        VkFramebufferCreateInfo params;
+        params.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+        params.pNext = NULL;
+        params.flags = 0;
+        params.renderPass = render_pass;
+        params.attachmentCount = attachment_count;
+        params.pAttachments = attachments;
+        params.width = extent.width;
+        params.height = extent.height;
+        params.layers = 1;
+
+        if(vk_ctx->create_framebuffer(vk_ctx->device, &params, vk_ctx->allocation_callbacks, &entry->framebuffer) == VK_SUCCESS)
+        {
+            entry->key = key;
+        }
+        else
+        {
+            LOG_ERROR("Failed to create framebuffer\n");
+            release_framebuffer_entry(entry, NULL, 0);
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        entry->last_use = ++g_framebuffer_cache.use_counter;
+    }
+
+    return status ? entry->framebuffer : NULL;
+}
+
+void release_framebuffers_using_view(VkImageView view)
+{
+    for(uint32_t i = 0; i < FRAMEBUFFER_CACHE_SIZE; i++)
+    {
+        struct framebuffer_entry* entry = &g_framebuffer_cache.entries[i];
+
+        for(uint32_t a = 0; a < entry->key.attachment_count; a++)
+        {
+            if(entry->key.attachments[a] == view)
+            {
+                release_framebuffer_entry_after_frames(entry);
+                break;
+            }
+        }
+    }
+}
+
+void release_framebuffers_using_render_pass(VkRenderPass render_pass)
+{
+    for(uint32_t i = 0; i < FRAMEBUFFER_CACHE_SIZE; i++)
+    {
+        if(g_framebuffer_cache.entries[i].key.render_pass == render_pass)
+        {
+            release_framebuffer_entry_after_frames(&g_framebuffer_cache.entries[i]);
+        }
+    }
+}
+
+void uninitialize_framebuffer_cache(void)
+{
+    // the device is idle, the framebuffers go with the next collect
+    for(uint32_t i = 0; i < FRAMEBUFFER_CACHE_SIZE; i++)
+    {
+        release_framebuffer_entry(&g_framebuffer_cache.entries[i], NULL, 0);
+    }
+
+    g_framebuffer_cache.use_counter = 0;
+}
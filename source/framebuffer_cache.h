@@ -0,0 +1,22 @@
+#ifndef FRAMEBUFFER_CACHE_H
+#define FRAMEBUFFER_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+enum { FRAMEBUFFER_CACHE_MAX_ATTACHMENTS = 4 };
+enum { FRAMEBUFFER_CACHE_SIZE            = 8 };
+
+// returns the framebuffer for (render pass, attachments, extent), creating it on first use. returns NULL on failure
+VkFramebuffer get_framebuffer(VkRenderPass render_pass, uint32_t attachment_count, const VkImageView* attachments, VkExtent2D extent);
+
+// releases every cached framebuffer that references the view, call before destroying the view. the
+// framebuffers are destroyed once the frames submitted so far have completed
+void release_framebuffers_using_view(VkImageView view);
+void release_framebuffers_using_render_pass(VkRenderPass render_pass);
+
+void uninitialize_framebuffer_cache(void);
+
+#endif // FRAMEBUFFER_CACHE_H
@@ -0,0 +1,147 @@
+#include <string.h>
+
+#include "gpu_buffer.h"
+#include "logger.h"
+#include "vk_context.h"
+
+uint32_t find_memory_type(uint32_t memory_type_bits, VkMemoryPropertyFlags required_properties)
+{
+    uint32_t index = INVALID_MEMORY_TYPE;
+
+    for(uint32_t i = 0; i < vk_ctx->memory_properties.memoryTypeCount; i++)
+    {
+        if((memory_type_bits & (1u << i)) && ((vk_ctx->memory_properties.memoryTypes[i].propertyFlags & required_properties) == required_properties))
+        {
+            index = i;
+            break;
+        }
+    }
+
+    return index;
+}
+
+bool create_gpu_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memory_properties, struct gpu_buffer* buffer)
+{
+    return create_shared_gpu_buffer(size, usage, memory_properties, 0, NULL, buffer);
+}
+
+bool create_shared_gpu_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memory_properties, uint32_t queue_family_count, const uint32_t* queue_families, struct gpu_buffer* buffer)
+{
+    bool status = true;
+
+    uint32_t memory_type = INVALID_MEMORY_TYPE;
+    VkMemoryRequirements memory_requirements = { 0 };
+
+    memset(buffer, 0, sizeof(struct gpu_buffer));
+
+    if(status)
+    {
+        VkBufferCreateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        info.pNext = NULL;
+        info.flags = 0;
+        info.size = size;
+        info.usage = usage;
+        info.sharingMode = (queue_family_count > 1) ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE;
+        info.queueFamilyIndexCount = (queue_family_count > 1) ? queue_family_count : 0;
+        info.pQueueFamilyIndices = (queue_family_count > 1) ? queue_families : NULL;
+
+        if(vk_ctx->create_buffer(vk_ctx->device, &info, vk_ctx->allocation_callbacks, &buffer->handle) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create buffer\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        vk_ctx->get_buffer_memory_requirements(vk_ctx->device, buffer->handle, &memory_requirements);
+
+        memory_type = find_memory_type(memory_requirements.memoryTypeBits, memory_properties);
+
+        if(memory_type == INVALID_MEMORY_TYPE)
+        {
+            LOG_ERROR("Could not find memory type for buffer\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        VkMemoryAllocateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        info.pNext = NULL;
+        info.allocationSize = memory_requirements.size;
+        info.memoryTypeIndex = memory_type;
+
+        if(vk_ctx->allocate_memory(vk_ctx->device, &info, vk_ctx->allocation_callbacks, &buffer->memory) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to allocate buffer memory\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        if(vk_ctx->bind_buffer_memory(vk_ctx->device, buffer->handle, buffer->memory, 0) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to bind buffer memory\n");
+            status = false;
+        }
+    }
+
+    if(status && (memory_properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+    {
+        if(vk_ctx->map_memory(vk_ctx->device, buffer->memory, 0, VK_WHOLE_SIZE, 0, &buffer->mapped) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to map buffer memory\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        buffer->size = size;
+    }
+    else
+    {
+        destroy_gpu_buffer(buffer);
+    }
+
+    return status;
+}
+
+bool create_gpu_buffer_with_data(const void* data, VkDeviceSize size, VkBufferUsageFlags usage, struct gpu_buffer* buffer)
+{
+    bool status = create_gpu_buffer(size, usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, buffer);
+
+    if(status)
+    {
+        memcpy(buffer->mapped, data, size);
+    }
+
+    return status;
+}
+
+void destroy_gpu_buffer(struct gpu_buffer* buffer)
+{
+    if(buffer->mapped != NULL)
+    {
+        vk_ctx->unmap_memory(vk_ctx->device, buffer->memory);
+        buffer->mapped = NULL;
+    }
+
+    if(buffer->handle != NULL)
+    {
+        vk_ctx->destroy_buffer(vk_ctx->device, buffer->handle, vk_ctx->allocation_callbacks);
+        buffer->handle = NULL;
+    }
+
+    if(buffer->memory != NULL)
+    {
+        vk_ctx->free_memory(vk_ctx->device, buffer->memory, vk_ctx->allocation_callbacks);
+        buffer->memory = NULL;
+    }
+
+    buffer->size = 0;
+}
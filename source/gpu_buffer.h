@@ -0,0 +1,29 @@
+#ifndef GPU_BUFFER_H
+#define GPU_BUFFER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+enum { INVALID_MEMORY_TYPE = 0xFFFFFFFF };
+
+struct gpu_buffer
+{
+    VkBuffer       handle;
+    VkDeviceMemory memory;
+    VkDeviceSize   size;
+
+    void*          mapped; // persistently mapped when the memory is host visible, NULL otherwise
+};
+
+uint32_t find_memory_type(uint32_t memory_type_bits, VkMemoryPropertyFlags required_properties);
+
+bool create_gpu_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memory_properties, struct gpu_buffer* buffer);
+// concurrent sharing between the queue families, without ownership transfers. with fewer than two distinct
+// families the buffer is exclusive
+bool create_shared_gpu_buffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memory_properties, uint32_t queue_family_count, const uint32_t* queue_families, struct gpu_buffer* buffer);
+bool create_gpu_buffer_with_data(const void* data, VkDeviceSize size, VkBufferUsageFlags usage, struct gpu_buffer* buffer);
+void destroy_gpu_buffer(struct gpu_buffer* buffer);
+
+#endif // GPU_BUFFER_H
@@ -0,0 +1,254 @@
+#include <string.h>
+
+#include "gpu_buffer.h"
+#include "gpu_image.h"
+#include "logger.h"
+#include "vk_context.h"
+
+VkFormat find_supported_format(const VkFormat* candidates, uint32_t candidate_count, VkFormatFeatureFlags features)
+{
+    VkFormat format = VK_FORMAT_UNDEFINED;
+
+    for(uint32_t i = 0; i < candidate_count; i++)
+    {
+        VkFormatProperties properties = { 0 };
+
+        vk_ctx->get_physical_device_format_properties(vk_ctx->physical_device, candidates[i], &properties);
+
+        if((properties.optimalTilingFeatures & features) == features)
+        {
+            format = candidates[i];
+            break;
+        }
+    }
+
+    return format;
+}
+
+VkFormat find_depth_format(void)
+{
+    // ordered by preference, a 32 bit float depth gives the best precision and D16 is the only
+    // format that is guaranteed to be supported
+    const VkFormat candidates[] =
+    {
+        VK_FORMAT_D32_SFLOAT,
+        VK_FORMAT_X8_D24_UNORM_PACK32,
+        VK_FORMAT_D24_UNORM_S8_UINT,
+        VK_FORMAT_D32_SFLOAT_S8_UINT,
+        VK_FORMAT_D16_UNORM,
+    };
+
+    return find_supported_format(candidates, sizeof(candidates) / sizeof(candidates[0]), VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+}
+
+VkImageAspectFlags get_format_aspect(VkFormat format)
+{
+    VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+
+    switch(format)
+    {
+        case VK_FORMAT_D16_UNORM:
+        case VK_FORMAT_X8_D24_UNORM_PACK32:
+        case VK_FORMAT_D32_SFLOAT:
+            aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+            break;
+        case VK_FORMAT_D16_UNORM_S8_UINT:
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            aspect = VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+            break;
+        default:
+            break;
+    }
+
+    return aspect;
+}
+
+static bool create_image(VkExtent2D extent, VkFormat format, uint32_t mip_count, VkImageUsageFlags usage, VkSampleCountFlagBits samples, struct gpu_image* image)
+{
+    bool status = true;
+
+    uint32_t memory_type = INVALID_MEMORY_TYPE;
+    VkMemoryRequirements memory_requirements = { 0 };
+
+    memset(image, 0, sizeof(struct gpu_image));
+
+    if(status)
+    {
+        VkImageCreateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        info.pNext = NULL;
+        info.flags = 0;
+        info.imageType = VK_IMAGE_TYPE_2D;
+        info.format = format;
+        info.extent.width = extent.width;
+        info.extent.height = extent.height;
+        info.extent.depth = 1;
+        info.mipLevels = mip_count;
+        info.arrayLayers = 1;
+        info.samples = samples;
+        info.tiling = VK_IMAGE_TILING_OPTIMAL;
+        info.usage = usage;
+        info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        info.queueFamilyIndexCount = 0;
+        info.pQueueFamilyIndices = NULL;
+        info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        if(vk_ctx->create_image(vk_ctx->device, &info, vk_ctx->allocation_callbacks, &image->handle) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create image\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        vk_ctx->get_image_memory_requirements(vk_ctx->device, image->handle, &memory_requirements);
+
+        // desktop gpus usually have no lazily allocated memory type, the image then takes regular device memory
+        if(usage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT)
+        {
+            memory_type = find_memory_type(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+        }
+
+        if(memory_type == INVALID_MEMORY_TYPE)
+        {
+            memory_type = find_memory_type(memory_requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        }
+
+        if(memory_type == INVALID_MEMORY_TYPE)
+        {
+            LOG_ERROR("Could not find memory type for image\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        VkMemoryAllocateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        info.pNext = NULL;
+        info.allocationSize = memory_requirements.size;
+        info.memoryTypeIndex = memory_type;
+
+        if(vk_ctx->allocate_memory(vk_ctx->device, &info, vk_ctx->allocation_callbacks, &image->memory) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to allocate image memory\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        if(vk_ctx->bind_image_memory(vk_ctx->device, image->handle, image->memory, 0) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to bind image memory\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        VkImageViewCreateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        info.pNext = NULL;
+        info.flags = 0;
+        info.image = image->handle;
+        info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        info.format = format;
+        info.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+        info.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+        info.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+        info.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+        info.subresourceRange.aspectMask = get_format_aspect(format);
+        info.subresourceRange.baseMipLevel = 0;
+        info.subresourceRange.levelCount = mip_count;
+        info.subresourceRange.baseArrayLayer = 0;
+        info.subresourceRange.layerCount = 1;
+
+        if(vk_ctx->create_image_view(vk_ctx->device, &info, vk_ctx->allocation_callbacks, &image->view) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create image view\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        image->format = format;
+        image->extent = extent;
+        image->samples = samples;
+        image->mip_count = mip_count;
+    }
+    else
+    {
+        destroy_gpu_image(image);
+    }
+
+    return status;
+}
+
+bool create_gpu_image(VkExtent2D extent, VkFormat format, VkImageUsageFlags usage, struct gpu_image* image)
+{
+    return create_image(extent, format, 1, usage, VK_SAMPLE_COUNT_1_BIT, image);
+}
+
+bool create_gpu_attachment(VkExtent2D extent, VkFormat format, VkImageUsageFlags usage, VkSampleCountFlagBits samples, struct gpu_image* image)
+{
+    return create_image(extent, format, 1, usage, samples, image);
+}
+
+bool create_gpu_texture(VkExtent2D extent, VkFormat format, uint32_t mip_count, VkImageUsageFlags usage, struct gpu_image* image)
+{
+    return create_image(extent, format, mip_count, usage, VK_SAMPLE_COUNT_1_BIT, image);
+}
+
+uint32_t get_mip_count(VkExtent2D extent)
+{
+    uint32_t size = (extent.width > extent.height) ? extent.width : extent.height;
+    uint32_t mip_count = 1;
+
+    while(size > 1)
+    {
+        size /= 2;
+        mip_count++;
+    }
+
+    return mip_count;
+}
+
+void destroy_gpu_image(struct gpu_image* image)
+{
+    if(image->view != NULL)
+    {
+        vk_ctx->destroy_image_view(vk_ctx->device, image->view, vk_ctx->allocation_callbacks);
+        image->view = NULL;
+    }
+
+    if(image->handle != NULL)
+    {
+        vk_ctx->destroy_image(vk_ctx->device, image->handle, vk_ctx->allocation_callbacks);
+        image->handle = NULL;
+    }
+
+    if(image->memory != NULL)
+    {
+        vk_ctx->free_memory(vk_ctx->device, image->memory, vk_ctx->allocation_callbacks);
+        image->memory = NULL;
+    }
+
+    image->format = VK_FORMAT_UNDEFINED;
+}
+
+void defer_gpu_image_destruction(struct gpu_image* image, VkSemaphore timeline, uint64_t value)
+{
+    // the view before the image before the memory, as in destroy_gpu_image
+    defer_destruction(vk_ctx, VK_OBJECT_TYPE_IMAGE_VIEW, (uint64_t) image->view, timeline, value);
+    defer_destruction(vk_ctx, VK_OBJECT_TYPE_IMAGE, (uint64_t) image->handle, timeline, value);
+    defer_destruction(vk_ctx, VK_OBJECT_TYPE_DEVICE_MEMORY, (uint64_t) image->memory, timeline, value);
+
+    image->view = NULL;
+    image->handle = NULL;
+    image->memory = NULL;
+    image->format = VK_FORMAT_UNDEFINED;
+}
@@ -0,0 +1,44 @@
+#ifndef GPU_IMAGE_H
+#define GPU_IMAGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+struct gpu_image
+{
+    VkImage               handle;
+    VkImageView           view;
+    VkDeviceMemory        memory;
+    VkFormat              format;
+    VkExtent2D            extent;
+    VkSampleCountFlagBits samples;
+    uint32_t              mip_count;
+};
+
+// returns the first format in the candidate list that supports the requested optimal tiling features,
+// VK_FORMAT_UNDEFINED if none of them do
+VkFormat find_supported_format(const VkFormat* candidates, uint32_t candidate_count, VkFormatFeatureFlags features);
+VkFormat find_depth_format(void);
+
+VkImageAspectFlags get_format_aspect(VkFormat format);
+
+// creates a single mip, single layer 2d image in device local memory with a view covering all aspects of the format
+bool create_gpu_image(VkExtent2D extent, VkFormat format, VkImageUsageFlags usage, struct gpu_image* image);
+
+// same as create_gpu_image with samples per pixel. with VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT in usage the image
+// prefers lazily allocated memory, on tiled gpus it then lives in tile memory only and never gets backing storage
+bool create_gpu_attachment(VkExtent2D extent, VkFormat format, VkImageUsageFlags usage, VkSampleCountFlagBits samples, struct gpu_image* image);
+
+// same as create_gpu_image with a mip chain, the view covers all mips
+bool create_gpu_texture(VkExtent2D extent, VkFormat format, uint32_t mip_count, VkImageUsageFlags usage, struct gpu_image* image);
+
+// the number of mips down to 1x1
+uint32_t get_mip_count(VkExtent2D extent);
+void destroy_gpu_image(struct gpu_image* image);
+
+// hands the image to the deferred destruction of vk_ctx, it is destroyed once timeline reached value
+void defer_gpu_image_destruction(struct gpu_image* image, VkSemaphore timeline, uint64_t value);
+
+#endif // GPU_IMAGE_H
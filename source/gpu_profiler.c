@@ -0,0 +1,238 @@
+#include <string.h>
+
+#include "gpu_profiler.h"
+#include "logger.h"
+#include "vk_context.h"
+
+enum { GPU_PROFILER_MAX_TIMESTAMPS = GPU_PROFILER_MAX_SECTIONS + 1 };
+
+enum { STATISTICS_VERTEX_INVOCATIONS = 0 };
+enum { STATISTICS_FRAGMENT_INVOCATIONS = 1 };
+enum { STATISTICS_COUNT = 2 };
+
+struct gpu_profiler
+{
+    VkQueryPool timestamp_pool;
+    VkQueryPool statistics_pool;
+
+    uint32_t    section_count;
+    const char* section_names[GPU_PROFILER_MAX_SECTIONS];
+
+    // what was recorded into the frame that has not been read back yet
+    uint32_t    written_timestamps;
+    bool        written_statistics;
+    bool        frame_pending;
+
+    uint32_t    frame_count;
+    uint32_t    section_frames[GPU_PROFILER_MAX_SECTIONS];
+    double      section_milliseconds[GPU_PROFILER_MAX_SECTIONS];
+    uint32_t    statistics_frames;
+    uint64_t    statistics[STATISTICS_COUNT];
+} g_gpu_profiler;
+
+static void read_gpu_profiler_frame(void)
+{
+    uint64_t timestamps[GPU_PROFILER_MAX_TIMESTAMPS] = { 0 };
+    uint64_t statistics[STATISTICS_COUNT] = { 0 };
+
+    // the pools are shared by the frames in flight, waiting here keeps the results of the previous submit intact.
+    // only the queries that were written can be waited on, an unwritten query never becomes available
+    for(uint32_t i = 0; i <= g_gpu_profiler.section_count; i++)
+    {
+        if(g_gpu_profiler.written_timestamps & (1u << i))
+        {
+            if(vk_ctx->get_query_pool_results(vk_ctx->device, g_gpu_profiler.timestamp_pool, i, 1, sizeof(uint64_t), &timestamps[i], sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) != VK_SUCCESS)
+            {
+                g_gpu_profiler.written_timestamps &= ~(1u << i);
+            }
+        }
+    }
+
+    for(uint32_t i = 0; i < g_gpu_profiler.section_count; i++)
+    {
+        uint32_t mask = (1u << i) | (1u << (i + 1));
+
+        if((g_gpu_profiler.written_timestamps & mask) == mask)
+        {
+            g_gpu_profiler.section_milliseconds[i] += (double) (timestamps[i + 1] - timestamps[i]) * vk_ctx->timestamp_period * 1e-6;
+            g_gpu_profiler.section_frames[i]++;
+        }
+    }
+
+    if(g_gpu_profiler.written_statistics)
+    {
+        if(vk_ctx->get_query_pool_results(vk_ctx->device, g_gpu_profiler.statistics_pool, 0, 1, sizeof(statistics), statistics, sizeof(statistics), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT) == VK_SUCCESS)
+        {
+            g_gpu_profiler.statistics[STATISTICS_VERTEX_INVOCATIONS] += statistics[STATISTICS_VERTEX_INVOCATIONS];
+            g_gpu_profiler.statistics[STATISTICS_FRAGMENT_INVOCATIONS] += statistics[STATISTICS_FRAGMENT_INVOCATIONS];
+            g_gpu_profiler.statistics_frames++;
+        }
+    }
+
+    g_gpu_profiler.frame_count++;
+
+    if(g_gpu_profiler.frame_count == GPU_PROFILER_REPORT_FRAMES)
+    {
+        LOG_INFO("GPU profile (%u frames):\n", g_gpu_profiler.frame_count);
+
+        for(uint32_t i = 0; i < g_gpu_profiler.section_count; i++)
+        {
+            if(g_gpu_profiler.section_frames[i] > 0)
+            {
+                LOG_INFO("\t%s: %.3f ms\n", g_gpu_profiler.section_names[i], g_gpu_profiler.section_milliseconds[i] / g_gpu_profiler.section_frames[i]);
+            }
+        }
+
+        if(g_gpu_profiler.statistics_frames > 0)
+        {
+            LOG_INFO("\tVertex shader invocations: %llu\n", (unsigned long long) (g_gpu_profiler.statistics[STATISTICS_VERTEX_INVOCATIONS] / g_gpu_profiler.statistics_frames));
+            LOG_INFO("\tFragment shader invocations: %llu\n", (unsigned long long) (g_gpu_profiler.statistics[STATISTICS_FRAGMENT_INVOCATIONS] / g_gpu_profiler.statistics_frames));
+        }
+
+        g_gpu_profiler.frame_count = 0;
+        g_gpu_profiler.statistics_frames = 0;
+        memset(g_gpu_profiler.section_frames, 0, sizeof(g_gpu_profiler.section_frames));
+        memset(g_gpu_profiler.section_milliseconds, 0, sizeof(g_gpu_profiler.section_milliseconds));
+        memset(g_gpu_profiler.statistics, 0, sizeof(g_gpu_profiler.statistics));
+    }
+}
+
+bool initialize_gpu_profiler(uint32_t section_count, const char* const* section_names)
+{
+    bool status = true;
+
+    memset(&g_gpu_profiler, 0, sizeof(struct gpu_profiler));
+
+    if((section_count == 0) || (section_count > GPU_PROFILER_MAX_SECTIONS))
+    {
+        LOG_ERROR("Invalid gpu profiler section count %u\n", section_count);
+        status = false;
+    }
+
+    if(status)
+    {
+        g_gpu_profiler.section_count = section_count;
+
+        for(uint32_t i = 0; i < section_count; i++)
+        {
+            g_gpu_profiler.section_names[i] = section_names[i];
+        }
+    }
+
+    if(status && vk_ctx->timestamps_supported)
+    {
+        VkQueryPoolCreateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        info.pNext = NULL;
+        info.flags = 0;
+        info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        info.queryCount = section_count + 1;
+        info.pipelineStatistics = 0;
+
+        if(vk_ctx->create_query_pool(vk_ctx->device, &info, vk_ctx->allocation_callbacks, &g_gpu_profiler.timestamp_pool) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create timestamp query pool\n");
+            status = false;
+        }
+    }
+    else if(status)
+    {
+        LOG_WARNING("Timestamps not supported, gpu timings disabled\n");
+    }
+
+    if(status && vk_ctx->pipeline_statistics_supported)
+    {
+        VkQueryPoolCreateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        info.pNext = NULL;
+        info.flags = 0;
+        info.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        info.queryCount = 1;
+        info.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT | VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+        if(vk_ctx->create_query_pool(vk_ctx->device, &info, vk_ctx->allocation_callbacks, &g_gpu_profiler.statistics_pool) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create pipeline statistics query pool\n");
+            status = false;
+        }
+    }
+    else if(status)
+    {
+        LOG_WARNING("Pipeline statistics not supported, shader invocation counts disabled\n");
+    }
+
+    if(!status)
+    {
+        uninitialize_gpu_profiler();
+    }
+
+    return status;
+}
+
+void uninitialize_gpu_profiler(void)
+{
+    if(g_gpu_profiler.statistics_pool != NULL)
+    {
+        vk_ctx->destroy_query_pool(vk_ctx->device, g_gpu_profiler.statistics_pool, vk_ctx->allocation_callbacks);
+        g_gpu_profiler.statistics_pool = NULL;
+    }
+
+    if(g_gpu_profiler.timestamp_pool != NULL)
+    {
+        vk_ctx->destroy_query_pool(vk_ctx->device, g_gpu_profiler.timestamp_pool, vk_ctx->allocation_callbacks);
+        g_gpu_profiler.timestamp_pool = NULL;
+    }
+
+    g_gpu_profiler.section_count = 0;
+}
+
+void begin_gpu_profiler_frame(VkCommandBuffer command_buffer)
+{
+    if(g_gpu_profiler.section_count > 0)
+    {
+        if(g_gpu_profiler.frame_pending)
+        {
+            read_gpu_profiler_frame();
+        }
+
+        if(g_gpu_profiler.timestamp_pool != NULL)
+        {
+            vk_ctx->cmd_reset_query_pool(command_buffer, g_gpu_profiler.timestamp_pool, 0, g_gpu_profiler.section_count + 1);
+        }
+
+        if(g_gpu_profiler.statistics_pool != NULL)
+        {
+            vk_ctx->cmd_reset_query_pool(command_buffer, g_gpu_profiler.statistics_pool, 0, 1);
+        }
+
+        g_gpu_profiler.written_timestamps = 0;
+        g_gpu_profiler.written_statistics = false;
+        g_gpu_profiler.frame_pending = true;
+    }
+}
+
+void write_gpu_profiler_timestamp(VkCommandBuffer command_buffer, uint32_t index)
+{
+    if((g_gpu_profiler.timestamp_pool != NULL) && (index <= g_gpu_profiler.section_count))
+    {
+        vk_ctx->cmd_write_timestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, g_gpu_profiler.timestamp_pool, index);
+        g_gpu_profiler.written_timestamps |= (1u << index);
+    }
+}
+
+void begin_gpu_profiler_statistics(VkCommandBuffer command_buffer)
+{
+    if(g_gpu_profiler.statistics_pool != NULL)
+    {
+        vk_ctx->cmd_begin_query(command_buffer, g_gpu_profiler.statistics_pool, 0, 0);
+    }
+}
+
+void end_gpu_profiler_statistics(VkCommandBuffer command_buffer)
+{
+    if(g_gpu_profiler.statistics_pool != NULL)
+    {
+        vk_ctx->cmd_end_query(command_buffer, g_gpu_profiler.statistics_pool, 0);
+        g_gpu_profiler.written_statistics = true;
+    }
+}
@@ -0,0 +1,25 @@
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+enum { GPU_PROFILER_MAX_SECTIONS  = 8 };
+enum { GPU_PROFILER_REPORT_FRAMES = 256 };
+
+// section i of a frame spans timestamp i to timestamp i + 1, the averages are printed every
+// GPU_PROFILER_REPORT_FRAMES frames together with the shader invocation counts
+bool initialize_gpu_profiler(uint32_t section_count, const char* const* section_names);
+void uninitialize_gpu_profiler(void);
+
+// reads back the previous frame and resets the queries, must be recorded outside of a render pass
+void begin_gpu_profiler_frame(VkCommandBuffer command_buffer);
+void write_gpu_profiler_timestamp(VkCommandBuffer command_buffer, uint32_t index);
+
+// counts the vertex and fragment shader invocations in between, both must be recorded in the same subpass
+void begin_gpu_profiler_statistics(VkCommandBuffer command_buffer);
+void end_gpu_profiler_statistics(VkCommandBuffer command_buffer);
+
+#endif // GPU_PROFILER_H
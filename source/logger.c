@@ -0,0 +1,1002 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL2/SDL.h>
+
+#include "logger.h"
+
+enum { LOGGER_FLUSH_INTERVAL = 10 };   // milliseconds the writer sleeps while nothing urgent is queued
+enum { LOGGER_MAX_FORMATS    = 4096 }; // distinct formats written to a binary log, a power of two
+enum { LOGGER_TEXT_SIZE      = 8192 }; // bytes of one formatted message
+
+static const char logger_file_magic[8] = { 'V', 'K', 'C', 'L', 'O', 'G', '0', '1' };
+
+enum log_file_record
+{
+    LOG_FILE_RECORD_FORMAT,  // id, length and the characters of a format
+    LOG_FILE_RECORD_MESSAGE  // level, thread, format id, time, size and the arguments
+};
+
+// a queued message, followed by the arguments. records start at multiples of 8 bytes, the level LOG_LEVEL_COUNT
+// marks the unused end of the ring before a record that wrapped around
+struct log_record
+{
+    uint32_t    size; // of the record and the arguments, without the padding
+    uint32_t    level;
+    uint64_t    time;
+    const char* format;
+};
+
+// written by the thread that owns it and read by the writer. head and tail are byte positions that only grow,
+// the owner moves tail and the writer moves head
+struct log_ring
+{
+    SDL_atomic_t owned;
+    SDL_atomic_t head;
+    SDL_atomic_t tail;
+
+    uint32_t     message_count; // only touched by the owner, read after the writer stopped
+    uint32_t     dropped_count;
+
+    uint8_t*     data;
+};
+
+struct logger
+{
+    SDL_atomic_t    running;
+    SDL_atomic_t    level;
+    SDL_atomic_t    quit;
+    SDL_atomic_t    unowned_dropped_count; // messages of threads that found no free ring
+
+    struct log_ring rings[LOGGER_MAX_THREADS];
+    uint8_t*        ring_data;
+    SDL_TLSID       ring_tls;
+
+    SDL_Thread*     thread;
+    SDL_sem*        wake;
+
+    // only used by the writer thread
+    FILE*           file;
+    const char*     format_keys[LOGGER_MAX_FORMATS];
+    uint32_t        format_ids[LOGGER_MAX_FORMATS];
+    uint32_t        format_count;
+    char            text[LOGGER_TEXT_SIZE];
+} g_logger;
+
+// the arguments of a record, one value per conversion and one per * width or precision. integers and pointers
+// are 8 bytes, floating point values are doubles and strings are a 4 byte length followed by the characters
+struct argument_writer
+{
+    uint8_t* data;
+    uint32_t size;
+    uint32_t capacity;
+    bool     truncated;
+};
+
+struct argument_reader
+{
+    const uint8_t* data;
+    uint32_t       size;
+    uint32_t       offset;
+};
+
+static void write_argument(struct argument_writer* writer, const void* value, uint32_t size)
+{
+    if(!writer->truncated && (writer->size + size <= writer->capacity))
+    {
+        memcpy(writer->data + writer->size, value, size);
+        writer->size += size;
+    }
+    else
+    {
+        writer->truncated = true;
+    }
+}
+
+static void write_integer(struct argument_writer* writer, uint64_t value)
+{
+    write_argument(writer, &value, sizeof(value));
+}
+
+static void write_double(struct argument_writer* writer, double value)
+{
+    write_argument(writer, &value, sizeof(value));
+}
+
+static void write_string(struct argument_writer* writer, const char* value)
+{
+    if(value == NULL)
+    {
+        value = "(null)";
+    }
+
+    uint32_t length = (uint32_t) strlen(value);
+
+    // cut to what is left so that the other arguments still fit
+    if((!writer->truncated) && (writer->size + sizeof(uint32_t) + length > writer->capacity) && (writer->size + sizeof(uint32_t) <= writer->capacity))
+    {
+        length = writer->capacity - writer->size - sizeof(uint32_t);
+    }
+
+    write_argument(writer, &length, sizeof(length));
+    write_argument(writer, value, length);
+}
+
+static bool read_argument(struct argument_reader* reader, void* value, uint32_t size)
+{
+    bool status = (reader->offset + size <= reader->size);
+
+    if(status)
+    {
+        memcpy(value, reader->data + reader->offset, size);
+        reader->offset += size;
+    }
+
+    return status;
+}
+
+static bool is_flag(char c)
+{
+    return (c == '-') || (c == '+') || (c == ' ') || (c == '#') || (c == '0');
+}
+
+static bool is_digit(char c)
+{
+    return (c >= '0') && (c <= '9');
+}
+
+// walks the conversions of format the way printf does and copies the arguments they consume
+static void write_arguments(struct argument_writer* writer, const char* format, va_list args)
+{
+    const char* c = format;
+
+    while(*c != '\0')
+    {
+        if(*c != '%')
+        {
+            c++;
+            continue;
+        }
+
+        c++;
+
+        while(is_flag(*c)) { c++; }
+
+        if(*c == '*') { write_integer(writer, (uint64_t) (int64_t) va_arg(args, int)); c++; }
+
+        while(is_digit(*c)) { c++; }
+
+        if(*c == '.')
+        {
+            c++;
+
+            if(*c == '*') { write_integer(writer, (uint64_t) (int64_t) va_arg(args, int)); c++; }
+
+            while(is_digit(*c)) { c++; }
+        }
+
+        // the length only decides how the value is taken from the arguments, it is always stored as 64 bits
+        char length = 0;
+
+        if((c[0] == 'h') && (c[1] == 'h'))      { length = 'H'; c += 2; }
+        else if((c[0] == 'l') && (c[1] == 'l')) { length = 'q'; c += 2; }
+        else if((*c == 'h') || (*c == 'l') || (*c == 'j') || (*c == 'z') || (*c == 't') || (*c == 'L')) { length = *c; c++; }
+
+        switch(*c)
+        {
+            case 'd':
+            case 'i':
+                switch(length)
+                {
+                    case 'l': write_integer(writer, (uint64_t) (int64_t) va_arg(args, long));      break;
+                    case 'q': write_integer(writer, (uint64_t) (int64_t) va_arg(args, long long)); break;
+                    case 'j': write_integer(writer, (uint64_t) (int64_t) va_arg(args, intmax_t));  break;
+                    case 'z': write_integer(writer, (uint64_t) va_arg(args, size_t));              break;
+                    case 't': write_integer(writer, (uint64_t) (int64_t) va_arg(args, ptrdiff_t)); break;
+                    default:  write_integer(writer, (uint64_t) (int64_t) va_arg(args, int));       break;
+                }
+                break;
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X':
+                switch(length)
+                {
+                    case 'l': write_integer(writer, (uint64_t) va_arg(args, unsigned long));      break;
+                    case 'q': write_integer(writer, (uint64_t) va_arg(args, unsigned long long)); break;
+                    case 'j': write_integer(writer, (uint64_t) va_arg(args, uintmax_t));          break;
+                    case 'z': write_integer(writer, (uint64_t) va_arg(args, size_t));             break;
+                    case 't': write_integer(writer, (uint64_t) va_arg(args, ptrdiff_t));          break;
+                    case 'H': write_integer(writer, (uint64_t) (uint8_t) va_arg(args, unsigned int)); break;
+                    case 'h': write_integer(writer, (uint64_t) (uint16_t) va_arg(args, unsigned int)); break;
+                    default:  write_integer(writer, (uint64_t) va_arg(args, unsigned int));       break;
+                }
+                break;
+            case 'c':
+                write_integer(writer, (uint64_t) (int64_t) va_arg(args, int));
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                if(length == 'L')
+                {
+                    write_double(writer, (double) va_arg(args, long double));
+                }
+                else
+                {
+                    write_double(writer, va_arg(args, double));
+                }
+                break;
+            case 's':
+                write_string(writer, va_arg(args, const char*));
+                break;
+            case 'p':
+                write_integer(writer, (uint64_t) (uintptr_t) va_arg(args, void*));
+                break;
+            case 'n':
+                (void) va_arg(args, void*);
+                break;
+            default:
+                break;
+        }
+
+        if(*c != '\0')
+        {
+            c++;
+        }
+    }
+}
+
+static void append_text(char* text, uint32_t capacity, uint32_t* length, int written)
+{
+    if(written > 0)
+    {
+        *length += (uint32_t) written;
+
+        if(*length >= capacity)
+        {
+            *length = capacity - 1;
+        }
+    }
+}
+
+// the counterpart of write_arguments: formats one conversion at a time from the stored values. returns the length
+// of the text, which is cut to capacity
+static uint32_t format_arguments(const char* format, struct argument_reader* reader, char* text, uint32_t capacity)
+{
+    enum { spec_size = 64 };
+
+    uint32_t length = 0;
+    bool status = true;
+
+    const char* c = format;
+
+    text[0] = '\0';
+
+    while(status && (*c != '\0') && (length + 1 < capacity))
+    {
+        if(*c != '%')
+        {
+            text[length++] = *c++;
+            text[length] = '\0';
+            continue;
+        }
+
+        if(c[1] == '%')
+        {
+            text[length++] = '%';
+            text[length] = '\0';
+            c += 2;
+            continue;
+        }
+
+        char spec[spec_size];
+        uint32_t spec_length = 0;
+
+        spec[spec_length++] = *c++;
+
+        while(is_flag(*c) && (spec_length < spec_size / 2)) { spec[spec_length++] = *c++; }
+
+        if(*c == '*')
+        {
+            int64_t width = 0;
+            status = read_argument(reader, &width, sizeof(width));
+            spec_length += (uint32_t) snprintf(spec + spec_length, spec_size - spec_length, "%d", (int) width);
+            c++;
+        }
+
+        while(is_digit(*c) && (spec_length < spec_size / 2)) { spec[spec_length++] = *c++; }
+
+        if(*c == '.')
+        {
+            c++;
+
+            if(*c == '*')
+            {
+                int64_t precision = 0;
+                status = status && read_argument(reader, &precision, sizeof(precision));
+
+                // a negative precision is taken as if it was omitted
+                if(precision >= 0)
+                {
+                    spec_length += (uint32_t) snprintf(spec + spec_length, spec_size - spec_length, ".%d", (int) precision);
+                }
+
+                c++;
+            }
+            else
+            {
+                spec[spec_length++] = '.';
+
+                while(is_digit(*c) && (spec_length < spec_size - 8)) { spec[spec_length++] = *c++; }
+            }
+        }
+
+        while((*c == 'h') || (*c == 'l') || (*c == 'j') || (*c == 'z') || (*c == 't') || (*c == 'L')) { c++; }
+
+        char conversion = *c;
+
+        if(conversion != '\0')
+        {
+            c++;
+        }
+
+        uint64_t integer = 0;
+        double real = 0.0;
+
+        switch(conversion)
+        {
+            case 'd':
+            case 'i':
+                spec[spec_length++] = 'l';
+                spec[spec_length++] = 'l';
+                spec[spec_length++] = 'd';
+                spec[spec_length] = '\0';
+                status = status && read_argument(reader, &integer, sizeof(integer));
+                if(status) { append_text(text, capacity, &length, snprintf(text + length, capacity - length, spec, (long long) (int64_t) integer)); }
+                break;
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X':
+                spec[spec_length++] = 'l';
+                spec[spec_length++] = 'l';
+                spec[spec_length++] = conversion;
+                spec[spec_length] = '\0';
+                status = status && read_argument(reader, &integer, sizeof(integer));
+                if(status) { append_text(text, capacity, &length, snprintf(text + length, capacity - length, spec, (unsigned long long) integer)); }
+                break;
+            case 'c':
+                spec[spec_length++] = 'c';
+                spec[spec_length] = '\0';
+                status = status && read_argument(reader, &integer, sizeof(integer));
+                if(status) { append_text(text, capacity, &length, snprintf(text + length, capacity - length, spec, (int) (int64_t) integer)); }
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                spec[spec_length++] = conversion;
+                spec[spec_length] = '\0';
+                status = status && read_argument(reader, &real, sizeof(real));
+                if(status) { append_text(text, capacity, &length, snprintf(text + length, capacity - length, spec, real)); }
+                break;
+            case 's':
+            {
+                uint32_t string_length = 0;
+                status = status && read_argument(reader, &string_length, sizeof(string_length));
+                status = status && (reader->offset + string_length <= reader->size);
+
+                if(status)
+                {
+                    // the stored string is not terminated
+                    char string[LOGGER_MAX_RECORD + 1];
+                    uint32_t copy_length = (string_length < LOGGER_MAX_RECORD) ? string_length : LOGGER_MAX_RECORD;
+                    memcpy(string, reader->data + reader->offset, copy_length);
+                    string[copy_length] = '\0';
+
+                    spec[spec_length++] = 's';
+                    spec[spec_length] = '\0';
+                    append_text(text, capacity, &length, snprintf(text + length, capacity - length, spec, string));
+
+                    reader->offset += string_length;
+                }
+                break;
+            }
+            case 'p':
+                spec[spec_length++] = 'p';
+                spec[spec_length] = '\0';
+                status = status && read_argument(reader, &integer, sizeof(integer));
+                if(status) { append_text(text, capacity, &length, snprintf(text + length, capacity - length, spec, (void*) (uintptr_t) integer)); }
+                break;
+            default:
+                break;
+        }
+    }
+
+    if(!status)
+    {
+        append_text(text, capacity, &length, snprintf(text + length, capacity - length, "<truncated>\n"));
+    }
+
+    return length;
+}
+
+static void release_thread_ring(void* data)
+{
+    struct log_ring* ring = (struct log_ring*) data;
+
+    // the next thread continues behind the messages that are still queued
+    SDL_AtomicSet(&ring->owned, 0);
+}
+
+static struct log_ring* get_thread_ring(void)
+{
+    struct log_ring* ring = (struct log_ring*) SDL_TLSGet(g_logger.ring_tls);
+
+    for(uint32_t i = 0; (ring == NULL) && (i < LOGGER_MAX_THREADS); i++)
+    {
+        if(SDL_AtomicCAS(&g_logger.rings[i].owned, 0, 1))
+        {
+            ring = &g_logger.rings[i];
+            SDL_TLSSet(g_logger.ring_tls, ring, release_thread_ring);
+        }
+    }
+
+    return ring;
+}
+
+void log_message(enum log_level level, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+
+    if((int) level < SDL_AtomicGet(&g_logger.level))
+    {
+        // filtered at runtime
+    }
+    else if(SDL_AtomicGet(&g_logger.running) == 0)
+    {
+        vprintf(format, args);
+    }
+    else
+    {
+        struct log_ring* ring = get_thread_ring();
+
+        if(ring != NULL)
+        {
+            uint8_t record_data[sizeof(struct log_record) + LOGGER_MAX_RECORD];
+
+            struct argument_writer writer;
+            writer.data = record_data + sizeof(struct log_record);
+            writer.size = 0;
+            writer.capacity = LOGGER_MAX_RECORD;
+            writer.truncated = false;
+
+            write_arguments(&writer, format, args);
+
+            struct log_record record;
+            record.size = (uint32_t) (sizeof(struct log_record) + writer.size);
+            record.level = level;
+            record.time = SDL_GetPerformanceCounter();
+            record.format = format;
+
+            memcpy(record_data, &record, sizeof(record));
+
+            uint32_t aligned_size = (record.size + 7) & ~7u;
+
+            uint32_t tail = (uint32_t) SDL_AtomicGet(&ring->tail);
+            uint32_t head = (uint32_t) SDL_AtomicGet(&ring->head);
+            uint32_t offset = tail & (LOGGER_RING_SIZE - 1);
+            uint32_t contiguous = LOGGER_RING_SIZE - offset;
+
+            // a record never wraps, the end of the ring is skipped instead
+            uint32_t skipped = (aligned_size > contiguous) ? contiguous : 0;
+
+            if((tail + skipped + aligned_size) - head <= LOGGER_RING_SIZE)
+            {
+                if(skipped > 0)
+                {
+                    if(skipped >= sizeof(struct log_record))
+                    {
+                        struct log_record padding;
+                        padding.size = skipped;
+                        padding.level = LOG_LEVEL_COUNT;
+                        padding.time = 0;
+                        padding.format = NULL;
+
+                        memcpy(ring->data + offset, &padding, sizeof(padding));
+                    }
+
+                    tail += skipped;
+                    offset = 0;
+                }
+
+                memcpy(ring->data + offset, record_data, record.size);
+
+                // publishes the record to the writer
+                SDL_AtomicSet(&ring->tail, (int) (tail + aligned_size));
+                ring->message_count++;
+
+                // the writer polls, errors and a ring that fills up wake it early
+                if((level >= LOG_LEVEL_ERROR) || ((tail + aligned_size - head) > LOGGER_RING_SIZE / 2))
+                {
+                    SDL_SemPost(g_logger.wake);
+                }
+            }
+            else
+            {
+                ring->dropped_count++;
+            }
+        }
+        else
+        {
+            SDL_AtomicAdd(&g_logger.unowned_dropped_count, 1);
+        }
+    }
+
+    va_end(args);
+}
+
+// the next record of the ring without consuming it, skips the unused end of the ring. NULL when it is empty
+static const struct log_record* peek_record(struct log_ring* ring)
+{
+    const struct log_record* record = NULL;
+
+    uint32_t head = (uint32_t) SDL_AtomicGet(&ring->head);
+    uint32_t tail = (uint32_t) SDL_AtomicGet(&ring->tail);
+
+    while((record == NULL) && (head != tail))
+    {
+        uint32_t offset = head & (LOGGER_RING_SIZE - 1);
+        uint32_t contiguous = LOGGER_RING_SIZE - offset;
+
+        const struct log_record* candidate = (const struct log_record*) (ring->data + offset);
+
+        if((contiguous < sizeof(struct log_record)) || (candidate->level == LOG_LEVEL_COUNT))
+        {
+            head += contiguous;
+            SDL_AtomicSet(&ring->head, (int) head);
+        }
+        else
+        {
+            record = candidate;
+        }
+    }
+
+    return record;
+}
+
+static void write_file_bytes(const void* data, uint32_t size)
+{
+    if(g_logger.file != NULL)
+    {
+        if(fwrite(data, 1, size, g_logger.file) != size)
+        {
+            printf("Failed to write the binary log, switching to text\n");
+            fclose(g_logger.file);
+            g_logger.file = NULL;
+        }
+    }
+}
+
+// the id of the format in the binary log, the format is written the first time it is seen
+static uint32_t get_format_id(const char* format)
+{
+    uint32_t id = 0;
+    bool found = false;
+
+    uint32_t hash = (uint32_t) (((uintptr_t) format >> 3) * 2654435761u);
+
+    for(uint32_t i = 0; !found && (i < LOGGER_MAX_FORMATS); i++)
+    {
+        uint32_t slot = (hash + i) & (LOGGER_MAX_FORMATS - 1);
+
+        if(g_logger.format_keys[slot] == format)
+        {
+            id = g_logger.format_ids[slot];
+            found = true;
+        }
+        else if(g_logger.format_keys[slot] == NULL)
+        {
+            g_logger.format_keys[slot] = format;
+            g_logger.format_ids[slot] = g_logger.format_count;
+            break;
+        }
+    }
+
+    // new formats, and all formats once the table is full, get the next id
+    if(!found)
+    {
+        id = g_logger.format_count++;
+
+        uint8_t kind = LOG_FILE_RECORD_FORMAT;
+        uint32_t length = (uint32_t) strlen(format);
+
+        write_file_bytes(&kind, sizeof(kind));
+        write_file_bytes(&id, sizeof(id));
+        write_file_bytes(&length, sizeof(length));
+        write_file_bytes(format, length);
+    }
+
+    return id;
+}
+
+static void write_record(uint32_t ring_index, const struct log_record* record)
+{
+    const uint8_t* arguments = (const uint8_t*) record + sizeof(struct log_record);
+    uint32_t arguments_size = record->size - sizeof(struct log_record);
+
+    if(g_logger.file != NULL)
+    {
+        uint32_t id = get_format_id(record->format);
+
+        uint8_t kind = LOG_FILE_RECORD_MESSAGE;
+        uint8_t level = (uint8_t) record->level;
+        uint8_t thread = (uint8_t) ring_index;
+
+        write_file_bytes(&kind, sizeof(kind));
+        write_file_bytes(&level, sizeof(level));
+        write_file_bytes(&thread, sizeof(thread));
+        write_file_bytes(&id, sizeof(id));
+        write_file_bytes(&record->time, sizeof(record->time));
+        write_file_bytes(&arguments_size, sizeof(arguments_size));
+        write_file_bytes(arguments, arguments_size);
+    }
+    else
+    {
+        struct argument_reader reader;
+        reader.data = arguments;
+        reader.size = arguments_size;
+        reader.offset = 0;
+
+        uint32_t length = format_arguments(record->format, &reader, g_logger.text, LOGGER_TEXT_SIZE);
+
+        fwrite(g_logger.text, 1, length, stdout);
+    }
+}
+
+// writes the queued records of all rings, oldest first
+static void write_records(void)
+{
+    bool written = false;
+    bool empty = false;
+
+    while(!empty)
+    {
+        const struct log_record* oldest = NULL;
+        uint32_t oldest_index = 0;
+
+        for(uint32_t i = 0; i < LOGGER_MAX_THREADS; i++)
+        {
+            const struct log_record* record = peek_record(&g_logger.rings[i]);
+
+            if((record != NULL) && ((oldest == NULL) || (record->time < oldest->time)))
+            {
+                oldest = record;
+                oldest_index = i;
+            }
+        }
+
+        if(oldest != NULL)
+        {
+            write_record(oldest_index, oldest);
+
+            // frees the space for the owner
+            struct log_ring* ring = &g_logger.rings[oldest_index];
+            SDL_AtomicSet(&ring->head, SDL_AtomicGet(&ring->head) + (int) ((oldest->size + 7) & ~7u));
+
+            written = true;
+        }
+        else
+        {
+            empty = true;
+        }
+    }
+
+    if(written)
+    {
+        fflush((g_logger.file != NULL) ? g_logger.file : stdout);
+    }
+}
+
+static int writer_thread(void* data)
+{
+    while(SDL_AtomicGet(&g_logger.quit) == 0)
+    {
+        SDL_SemWaitTimeout(g_logger.wake, LOGGER_FLUSH_INTERVAL);
+        write_records();
+    }
+
+    return 0;
+}
+
+bool initialize_logger(const char* binary_path)
+{
+    bool status = true;
+
+    memset(&g_logger, 0, sizeof(g_logger));
+
+    g_logger.ring_data = (uint8_t*) malloc(LOGGER_MAX_THREADS * LOGGER_RING_SIZE);
+
+    if(g_logger.ring_data == NULL)
+    {
+        printf("Failed to allocate the log rings\n");
+        status = false;
+    }
+
+    if(status)
+    {
+        for(uint32_t i = 0; i < LOGGER_MAX_THREADS; i++)
+        {
+            g_logger.rings[i].data = g_logger.ring_data + i * LOGGER_RING_SIZE;
+        }
+
+        g_logger.ring_tls = SDL_TLSCreate();
+
+        if(g_logger.ring_tls == 0)
+        {
+            printf("Failed to create the log ring slot: %s\n", SDL_GetError());
+            status = false;
+        }
+    }
+
+    if(status && (binary_path != NULL))
+    {
+        g_logger.file = fopen(binary_path, "wb");
+
+        if(g_logger.file == NULL)
+        {
+            printf("Failed to open the binary log %s\n", binary_path);
+            status = false;
+        }
+        else
+        {
+            uint64_t frequency = SDL_GetPerformanceFrequency();
+
+            write_file_bytes(logger_file_magic, sizeof(logger_file_magic));
+            write_file_bytes(&frequency, sizeof(frequency));
+        }
+    }
+
+    if(status)
+    {
+        g_logger.wake = SDL_CreateSemaphore(0);
+
+        if(g_logger.wake == NULL)
+        {
+            printf("Failed to create the logger semaphore: %s\n", SDL_GetError());
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        g_logger.thread = SDL_CreateThread(writer_thread, "logger", NULL);
+
+        if(g_logger.thread == NULL)
+        {
+            printf("Failed to create the logger thread: %s\n", SDL_GetError());
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        SDL_AtomicSet(&g_logger.running, 1);
+    }
+    else
+    {
+        uninitialize_logger();
+    }
+
+    return status;
+}
+
+void uninitialize_logger(void)
+{
+    // later messages are printed directly
+    SDL_AtomicSet(&g_logger.running, 0);
+
+    if(g_logger.thread != NULL)
+    {
+        SDL_AtomicSet(&g_logger.quit, 1);
+        SDL_SemPost(g_logger.wake);
+        SDL_WaitThread(g_logger.thread, NULL);
+        g_logger.thread = NULL;
+
+        write_records();
+    }
+
+    uint32_t message_count = 0;
+    uint32_t dropped_count = (uint32_t) SDL_AtomicGet(&g_logger.unowned_dropped_count);
+
+    for(uint32_t i = 0; i < LOGGER_MAX_THREADS; i++)
+    {
+        message_count += g_logger.rings[i].message_count;
+        dropped_count += g_logger.rings[i].dropped_count;
+    }
+
+    if(dropped_count > 0)
+    {
+        printf("Logger: %u messages, %u dropped\n", message_count, dropped_count);
+    }
+
+    if(g_logger.file != NULL)
+    {
+        fclose(g_logger.file);
+        g_logger.file = NULL;
+    }
+
+    if(g_logger.wake != NULL)
+    {
+        SDL_DestroySemaphore(g_logger.wake);
+        g_logger.wake = NULL;
+    }
+
+    if(g_logger.ring_data != NULL)
+    {
+        free(g_logger.ring_data);
+        g_logger.ring_data = NULL;
+    }
+}
+
+void set_log_level(enum log_level level)
+{
+    SDL_AtomicSet(&g_logger.level, (int) level);
+}
+
+static bool read_file_bytes(FILE* file, void* data, uint32_t size)
+{
+    return (fread(data, 1, size, file) == size);
+}
+
+bool decode_log_file(const char* path)
+{
+    bool status = true;
+
+    static const char* level_names[LOG_LEVEL_COUNT] = { "debug", "info", "warning", "error" };
+
+    FILE* file = fopen(path, "rb");
+
+    char** formats = NULL;
+    uint32_t format_count = 0;
+
+    uint8_t* arguments = NULL;
+    char* text = NULL;
+
+    uint64_t frequency = 1;
+    uint64_t start_time = 0;
+    bool started = false;
+
+    if(file == NULL)
+    {
+        printf("Could not open %s\n", path);
+        status = false;
+    }
+
+    if(status)
+    {
+        char magic[sizeof(logger_file_magic)];
+
+        if(!read_file_bytes(file, magic, sizeof(magic)) || (memcmp(magic, logger_file_magic, sizeof(magic)) != 0) || !read_file_bytes(file, &frequency, sizeof(frequency)) || (frequency == 0))
+        {
+            printf("%s is not a binary log\n", path);
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        arguments = (uint8_t*) malloc(LOGGER_MAX_RECORD + sizeof(struct log_record));
+        text = (char*) malloc(LOGGER_TEXT_SIZE);
+
+        if((arguments == NULL) || (text == NULL))
+        {
+            printf("Failed to allocate memory\n");
+            status = false;
+        }
+    }
+
+    uint8_t kind = 0;
+
+    while(status && read_file_bytes(file, &kind, sizeof(kind)))
+    {
+        if(kind == LOG_FILE_RECORD_FORMAT)
+        {
+            uint32_t id = 0;
+            uint32_t length = 0;
+
+            status = read_file_bytes(file, &id, sizeof(id)) && read_file_bytes(file, &length, sizeof(length)) && (id <= format_count);
+
+            if(status && (id == format_count))
+            {
+                char** grown = (char**) realloc(formats, (format_count + 1) * sizeof(char*));
+                status = (grown != NULL);
+
+                if(status)
+                {
+                    formats = grown;
+                    formats[format_count] = (char*) malloc(length + 1);
+                    status = (formats[format_count] != NULL);
+                }
+
+                if(status)
+                {
+                    format_count++;
+                    status = read_file_bytes(file, formats[id], length);
+                    formats[id][length] = '\0';
+                }
+            }
+        }
+        else if(kind == LOG_FILE_RECORD_MESSAGE)
+        {
+            uint8_t level = 0;
+            uint8_t thread = 0;
+            uint32_t id = 0;
+            uint64_t time = 0;
+            uint32_t size = 0;
+
+            status = read_file_bytes(file, &level, sizeof(level)) && read_file_bytes(file, &thread, sizeof(thread)) && read_file_bytes(file, &id, sizeof(id)) &&
+                     read_file_bytes(file, &time, sizeof(time)) && read_file_bytes(file, &size, sizeof(size));
+
+            status = status && (id < format_count) && (level < LOG_LEVEL_COUNT) && (size <= LOGGER_MAX_RECORD + sizeof(struct log_record));
+            status = status && read_file_bytes(file, arguments, size);
+
+            if(status)
+            {
+                if(!started)
+                {
+                    start_time = time;
+                    started = true;
+                }
+
+                struct argument_reader reader;
+                reader.data = arguments;
+                reader.size = size;
+                reader.offset = 0;
+
+                format_arguments(formats[id], &reader, text, LOGGER_TEXT_SIZE);
+
+                printf("%12.3f ms %-7s thread %2u: %s", (double) (time - start_time) * 1000.0 / (double) frequency, level_names[level], thread, text);
+            }
+        }
+        else
+        {
+            status = false;
+        }
+
+        if(!status)
+        {
+            printf("%s is corrupt\n", path);
+        }
+    }
+
+    if(file != NULL)
+    {
+        fclose(file);
+    }
+
+    for(uint32_t i = 0; i < format_count; i++)
+    {
+        free(formats[i]);
+    }
+
+    free(formats);
+    free(arguments);
+    free(text);
+
+    return status;
+}
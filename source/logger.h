@@ -0,0 +1,55 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+enum log_level
+{
+    LOG_LEVEL_DEBUG,   // dumps of capabilities and enumerations
+    LOG_LEVEL_INFO,    // what was selected and measured
+    LOG_LEVEL_WARNING, // a feature is unavailable and a fallback is used
+    LOG_LEVEL_ERROR,   // the operation failed
+    LOG_LEVEL_COUNT
+};
+
+// messages below this level are compiled out, their arguments are not evaluated
+#ifndef LOG_COMPILED_LEVEL
+#ifdef DEBUG
+#define LOG_COMPILED_LEVEL LOG_LEVEL_DEBUG
+#else
+#define LOG_COMPILED_LEVEL LOG_LEVEL_INFO
+#endif
+#endif
+
+enum { LOGGER_RING_SIZE   = 64 * 1024 }; // bytes per thread, a power of two
+enum { LOGGER_MAX_THREADS = 16 };        // threads that log at the same time
+enum { LOGGER_MAX_RECORD  = 4096 };      // bytes of arguments per message, string arguments are cut to fit
+
+// the format has to be a string literal, only its address is queued. the arguments are copied and formatted
+// later on the writer thread, strings included
+#define LOG_MESSAGE(level, ...) do { if((level) >= LOG_COMPILED_LEVEL) { log_message((level), __VA_ARGS__); } } while(0)
+
+#define LOG_DEBUG(...)   LOG_MESSAGE(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...)    LOG_MESSAGE(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARNING(...) LOG_MESSAGE(LOG_LEVEL_WARNING, __VA_ARGS__)
+#define LOG_ERROR(...)   LOG_MESSAGE(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+// every thread that logs gets its own single producer ring on its first message, a writer thread drains the
+// rings in timestamp order. with a binary_path the writer stores the raw arguments and each format once instead
+// of formatting them, decode_log_file turns the file into text. NULL prints to stdout. messages logged while the
+// logger is not running are printed directly
+bool initialize_logger(const char* binary_path);
+
+// writes everything that was queued and stops the writer thread
+void uninitialize_logger(void);
+
+// filters at runtime, on top of LOG_COMPILED_LEVEL
+void set_log_level(enum log_level level);
+
+// never blocks, a message that does not fit into the ring of the thread is dropped and counted
+void log_message(enum log_level level, const char* format, ...);
+
+bool decode_log_file(const char* path);
+
+#endif // LOGGER_H
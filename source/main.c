@@ -1,613 +1,1497 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_vulkan.h>
 
+#include "bindless.h"
+#include "cluster_cull.h"
+#include "framebuffer_cache.h"
+#include "gpu_buffer.h"
+#include "gpu_image.h"
+#include "gpu_profiler.h"
+#include "logger.h"
+#include "mesh.h"
+#include "meshlet.h"
+#include "pipeline_registry.h"
+#include "queue_scheduler.h"
+#include "shader.h"
+#include "simulation.h"
+#include "texture_streaming.h"
 #include "vk_context.h"
 
 const char* window_title = "vk-cube";
 const uint32_t window_width = 1024;
 const uint32_t window_height = 768;
 
+const uint32_t cube_subdivisions = 64;
+
+// the mesh is specified in clip space, the camera looks down +z
+const float view_projection[16] = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f };
+const float camera[4] = { 0.0f, 0.0f, 1.0f, 0.0f };
+
+enum { PROFILE_CLUSTER_CULLING, PROFILE_DEPTH_PREPASS, PROFILE_MAIN_PASS, PROFILE_SECTION_COUNT };
+
+const char* profile_section_names[PROFILE_SECTION_COUNT] = { "Cluster culling", "Depth pre-pass", "Main pass" };
+
+// shader feature toggles, must match the constant ids and values in shader.frag.glsl
+enum { SHADER_CONSTANT_SPECIALIZED, SHADER_CONSTANT_COLOR_MODE, SHADER_CONSTANT_LIGHTING_MODEL };
+
+enum { COLOR_MODE_VERTEX, COLOR_MODE_FLAT, COLOR_MODE_TEXTURE };
+enum { LIGHTING_MODEL_UNLIT, LIGHTING_MODEL_LAMBERT };
+
+struct shader_features
+{
+    uint32_t color_mode;
+    uint32_t lighting_model;
+};
+
+// the only per draw state, indices into the bindless table followed by the features read by the pipeline that
+// branches at runtime. must match the push constant blocks of the shaders
+struct draw_constants
+{
+    uint32_t draw_buffer;
+    uint32_t draw_index;
+    uint32_t color_mode;
+    uint32_t lighting_model;
+    uint32_t texture_index;
+};
+
+struct draw_data
+{
+    float transform[16];
+};
+
+enum { MAX_DRAWS = 16 };
+enum { MAX_SAMPLE_COUNTS = 7 }; // 1 to 64 samples
+
 SDL_Window* g_window = NULL;
 
+struct vk_context  g_vk_context;
+struct vk_context* vk_ctx = &g_vk_context;
+
 VkRenderPass     g_render_pass = NULL;
-VkImageView      g_image_views[VK_CTX_NUM_SWAPCHAIN_BUFFERS];
-VkFramebuffer    g_framebuffer = NULL;
+VkImageView      g_image_views[VK_CTX_MAX_SWAPCHAIN_IMAGES];
 VkShaderModule   g_vertex_shader_module = NULL;
 VkShaderModule   g_fragment_shader_module = NULL;
 VkPipelineLayout g_pipeline_layout = NULL;
 VkPipeline       g_graphics_pipeline = NULL;
+VkPipeline       g_depth_prepass_pipeline = NULL;
+VkPipeline       g_uniform_branching_pipeline = NULL;
 
-bool initialize(void)
+// one render pass per sample count. the registry keys the pipelines by the render pass, switching back to a
+// sample count reuses its render pass and with it the pipelines that were compiled for it
+VkRenderPass     g_render_passes[MAX_SAMPLE_COUNTS];
+
+// the pipelines are owned by the registry, the wireframe variant is compiled in the background and the
+// solid pipeline is drawn until it is ready
+struct pipeline_desc g_wireframe_pipeline_desc;
+
+// depth and the multisampled color are only needed within a frame, they are transient and shared by all frames.
+// the color image only exists with more than one sample, it is resolved into the swapchain image
+struct gpu_image   g_depth_image;
+struct gpu_image   g_msaa_color_image;
+VkFormat           g_depth_format = VK_FORMAT_UNDEFINED;
+
+struct mesh        g_mesh;
+struct gpu_buffer  g_vertex_buffer;
+struct gpu_buffer  g_index_buffer;
+
+// written by the cpu every frame, one buffer per frame slot so that a frame in flight is never overwritten
+struct gpu_buffer  g_draw_buffers[VK_CTX_NUM_FRAMES];
+uint32_t           g_draw_buffer_indices[VK_CTX_NUM_FRAMES];
+
+uint32_t           g_frame_index = 0;
+
+// the frame queue point of the last submit of each frame slot, reached when the slot can be recorded again
+struct queue_point g_frame_points[VK_CTX_NUM_FRAMES];
+
+bool g_cluster_culling_requested = true;
+bool g_cluster_culling = false;
+
+bool g_dynamic_rendering_requested = true;
+bool g_dynamic_rendering = false;
+
+struct vk_context_options g_vk_context_options;
+
+// runs the queue priority test instead of rendering
+uint32_t g_queue_priority_test_iterations = 0;
+
+// records this many draws through each dispatch path instead of rendering
+uint32_t g_dispatch_benchmark_draws = 0;
+
+// creates this many additional headless contexts on their own threads instead of rendering
+uint32_t g_context_test_count = 0;
+
+// the binary log is written instead of printing, decoding prints a binary log instead of rendering
+const char*    g_binary_log_path = NULL;
+const char*    g_decode_log_path = NULL;
+enum log_level g_log_level = LOG_LEVEL_DEBUG;
+
+enum { MAX_TEST_CONTEXTS = 8 };
+
+struct context_test
 {
-    bool status = true;
+    uint32_t     index;
+    uint32_t     ext_count;
+    const char** ext_array;
+    bool         status;
+};
 
-    uint32_t ext_count = 0;
-    const char** ext_array = NULL;
+bool     g_swapchain_changed = false;
 
-    VkSurfaceKHR surface = NULL;
+bool     g_depth_prepass = false;
+bool     g_benchmark = false;
+bool     g_wireframe = false;
 
-    if(SDL_Init(SDL_INIT_EVERYTHING) != 0)
-    {
-        printf("Could not initialize SDL\n");
-        status = false;
-    }
+struct shader_features g_shader_features = { COLOR_MODE_VERTEX, LIGHTING_MODEL_UNLIT };
 
-    if(status)
-    {
-        if(SDL_Vulkan_LoadLibrary(NULL) != 0)
-        {
-            printf("Could not load the vulkan library\n");
-            status = false;
-        }
-    }
+bool     g_uniform_branching = false;
+bool     g_compare_shader_variants = false;
+uint32_t g_overdraw_layers = 1;
 
-    if(status)
-    {
-        g_window = SDL_CreateWindow(window_title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, window_width, window_height, SDL_WINDOW_VULKAN | SDL_WINDOW_SHOWN);
+// the requested count is clamped to what the device supports, the benchmark cycles through 1, 2, 4 and 8 samples
+uint32_t              g_msaa_requested = 1;
+VkSampleCountFlagBits g_msaa_samples = VK_SAMPLE_COUNT_1_BIT;
+bool                  g_msaa_benchmark = false;
 
-        if (g_window == NULL)
-        {
-            status = false;
-            printf("Could not create SDL window\n");
-        }
-    }
+// number of simulated cube instances, 0 draws the mesh once with the static transform
+uint32_t                g_simulation_instances = 0;
+struct simulation_frame g_simulation_frame;
 
-    if(status)
+// number of generated textures, the instances are split into one draw per texture. the textures shift to the
+// next instances every TEXTURE_SWITCH_FRAMES so that the streaming keeps evicting and uploading
+enum { TEXTURE_SWITCH_FRAMES = 120 };
+
+uint32_t     g_texture_count = 0;
+VkDeviceSize g_texture_budget = 64 * 1024 * 1024;
+bool         g_texture_compression = true;
+
+// the size of the window in pixels, the swapchain takes it when the surface leaves the size to the application
+VkExtent2D get_drawable_extent(void)
+{
+    int width = 0;
+    int height = 0;
+
+    SDL_Vulkan_GetDrawableSize(g_window, &width, &height);
+
+    VkExtent2D extent;
+    extent.width = (uint32_t) width;
+    extent.height = (uint32_t) height;
+
+    return extent;
+}
+
+bool create_swapchain_image_views(void)
+{
+    bool status = true;
+
+    for(uint32_t i = 0; status && (i < vk_ctx->swapchain_image_count); i++)
     {
-        if(SDL_Vulkan_GetInstanceExtensions(g_window, &ext_count, NULL) != SDL_TRUE)
+        VkImageViewCreateInfo params;
+        params.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        params.pNext = NULL;
+        params.flags = 0;
+        params.image = vk_ctx->swapchain_images[i];
+        params.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        params.format = vk_ctx->surface_format;
+        params.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
+        params.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
+        params.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
+        params.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
+        params.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        params.subresourceRange.baseMipLevel = 0;
+        params.subresourceRange.levelCount = 1;
+        params.subresourceRange.baseArrayLayer = 0;
+        params.subresourceRange.layerCount = 1;
+
+        if(vk_ctx->create_image_view(vk_ctx->device, &params, vk_ctx->allocation_callbacks, &g_image_views[i]) != VK_SUCCESS)
         {
+            LOG_ERROR("Failed to create swapchain image view\n");
             status = false;
-            printf("Could not get required SDL extension count\n");
+        }
+        else
+        {
+            VK_CTX_NAME(vk_ctx, VK_OBJECT_TYPE_IMAGE_VIEW, g_image_views[i], "swapchain image view %u", i);
         }
     }
 
-    if(status)
-    {
-        ext_array = malloc(ext_count * sizeof(char*));
+    return status;
+}
 
-        if(ext_array == NULL)
+// the views are destroyed once timeline reached value
+void destroy_swapchain_image_views(VkSemaphore timeline, uint64_t value)
+{
+    for(uint32_t i = 0; i < VK_CTX_MAX_SWAPCHAIN_IMAGES; i++)
+    {
+        if(g_image_views[i] != NULL)
         {
-            status = false;
-            printf("Failed to allocate memory\n");
+            release_framebuffers_using_view(g_image_views[i]);
+
+            defer_destruction(vk_ctx, VK_OBJECT_TYPE_IMAGE_VIEW, (uint64_t) g_image_views[i], timeline, value);
+            g_image_views[i] = NULL;
         }
     }
+}
 
-    if(status)
+// highest sample count up to requested that the device supports for color and depth, 1 is always supported
+VkSampleCountFlagBits get_supported_sample_count(uint32_t requested)
+{
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+
+    for(uint32_t count = 2; count <= requested; count *= 2)
     {
-        if(SDL_Vulkan_GetInstanceExtensions(g_window, &ext_count, ext_array) != SDL_TRUE)
+        if(vk_ctx->framebuffer_sample_counts & count)
         {
-            status = false;
-            printf("Could not get required SDL extension count\n");
+            samples = (VkSampleCountFlagBits) count;
         }
     }
 
-    if(status && (ext_count > 0))
+    return samples;
+}
+
+uint32_t get_sample_count_index(VkSampleCountFlagBits samples)
+{
+    uint32_t index = 0;
+
+    while((index + 1 < MAX_SAMPLE_COUNTS) && ((1u << index) < (uint32_t) samples))
     {
-        printf("Required SDL extensions:\n");
-        for(uint32_t i = 0; i < ext_count; i++)
-        {
-            printf("\t%s\n", ext_array[i]);
-        }
+        index++;
     }
 
+    return index;
+}
+
+// depth and, with multisampling, the color attachment for the current swapchain extent and sample count
+bool create_render_targets(void)
+{
+    bool status = true;
+
+    status = create_gpu_attachment(vk_ctx->swapchain_extent, g_depth_format, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT, g_msaa_samples, &g_depth_image);
+
     if(status)
     {
-        status = initialize_vulkan_context(SDL_Vulkan_GetVkGetInstanceProcAddr(), ext_count, ext_array);
+        VK_CTX_NAME(vk_ctx, VK_OBJECT_TYPE_IMAGE, g_depth_image.handle, "depth image");
+        VK_CTX_NAME(vk_ctx, VK_OBJECT_TYPE_IMAGE_VIEW, g_depth_image.view, "depth image view");
     }
 
-    if(status)
+    if(status && (g_msaa_samples != VK_SAMPLE_COUNT_1_BIT))
     {
-        if(SDL_Vulkan_CreateSurface(g_window, vk_ctx->instance, (VkSurfaceKHR*) &surface) != SDL_TRUE)
+        status = create_gpu_attachment(vk_ctx->swapchain_extent, vk_ctx->surface_format, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT, g_msaa_samples, &g_msaa_color_image);
+
+        if(status)
         {
-            printf("Could not create vulkan surface\n");
-            status = false;
+            VK_CTX_NAME(vk_ctx, VK_OBJECT_TYPE_IMAGE, g_msaa_color_image.handle, "msaa color image");
+            VK_CTX_NAME(vk_ctx, VK_OBJECT_TYPE_IMAGE_VIEW, g_msaa_color_image.view, "msaa color image view");
         }
     }
 
-    if(status)
+    return status;
+}
+
+void destroy_render_targets(VkSemaphore timeline, uint64_t value)
+{
+    release_framebuffers_using_view(g_depth_image.view);
+    defer_gpu_image_destruction(&g_depth_image, timeline, value);
+
+    if(g_msaa_color_image.handle != NULL)
     {
-        status = initialize_swapchain(surface);
+        release_framebuffers_using_view(g_msaa_color_image.view);
+        defer_gpu_image_destruction(&g_msaa_color_image, timeline, value);
     }
+}
 
-    if(status)
+// the framebuffer of the render pass path for the swapchain image, the attachments follow create_render_pass
+VkFramebuffer get_frame_framebuffer(uint32_t swapchain_index)
+{
+    VkFramebuffer framebuffer = NULL;
+
+    if(g_msaa_samples != VK_SAMPLE_COUNT_1_BIT)
     {
-        VkAttachmentDescription attachment_description;
-        attachment_description.flags = 0;
-        attachment_description.format = vk_ctx->surface_format;
-        attachment_description.samples = VK_SAMPLE_COUNT_1_BIT;
-        attachment_description.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        attachment_description.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-        attachment_description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-        attachment_description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        attachment_description.initialLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-        attachment_description.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-        VkAttachmentReference attachment_reference;
-        attachment_reference.attachment = 0;
-        attachment_reference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-        VkSubpassDescription subpass_description;
-        subpass_description.flags = 0;
-        subpass_description.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-        subpass_description.inputAttachmentCount = 0;
-        subpass_description.pInputAttachments = NULL;
-        subpass_description.colorAttachmentCount = 1;
-        subpass_description.pColorAttachments = &attachment_reference;
-        subpass_description.pResolveAttachments = NULL;
-        subpass_description.pDepthStencilAttachment = NULL;
-        subpass_description.preserveAttachmentCount = 0;
-        subpass_description.pPreserveAttachments = NULL;
-
-        VkRenderPassCreateInfo render_pass_info;
-        render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-        render_pass_info.pNext = NULL;
-        render_pass_info.flags = 0;
-        render_pass_info.attachmentCount = 1;
-        render_pass_info.pAttachments = &attachment_description;
-        render_pass_info.subpassCount = 1;
-        render_pass_info.pSubpasses = &subpass_description;
-        render_pass_info.dependencyCount = 0;
-        render_pass_info.pDependencies = NULL;
-
-        if(vk_ctx->create_render_pass(vk_ctx->device, &render_pass_info, vk_ctx->allocation_callbacks, &g_render_pass) != VK_SUCCESS)
-        {
-            printf("Failed to create render pass\n");
-            status = false;
-        }
-    }
+        VkImageView attachments[3] = { g_msaa_color_image.view, g_depth_image.view, g_image_views[swapchain_index] };
 
-    if(status)
+        framebuffer = get_framebuffer(g_render_pass, 3, attachments, vk_ctx->swapchain_extent);
+    }
+    else
     {
-        for(uint32_t i = 0; i < VK_CTX_NUM_SWAPCHAIN_BUFFERS; i++)
-        {
-            VkImageViewCreateInfo params;
-            params.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-            params.pNext = NULL;
-            params.flags = 0;
-            params.image = vk_ctx->swapchain_images[i];
-            params.viewType = VK_IMAGE_VIEW_TYPE_2D;
-            params.format = vk_ctx->surface_format;
-            params.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
-            params.components.g = VK_COMPONENT_SWIZZLE_IDENTITY;
-            params.components.b = VK_COMPONENT_SWIZZLE_IDENTITY;
-            params.components.a = VK_COMPONENT_SWIZZLE_IDENTITY;
-            params.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-            params.subresourceRange.baseMipLevel = 0;
-            params.subresourceRange.levelCount = 1;
-            params.subresourceRange.baseArrayLayer = 0;
-            params.subresourceRange.layerCount = 1;
-
-            if(vk_ctx->create_image_view(vk_ctx->device, &params, vk_ctx->allocation_callbacks, &g_image_views[i]) != VK_SUCCESS)
-            {
-                printf("Failed to create swapchain image view\n");
-                status = false;
-            }
-        }
+        VkImageView attachments[2] = { g_image_views[swapchain_index], g_depth_image.view };
+
+        framebuffer = get_framebuffer(g_render_pass, 2, attachments, vk_ctx->swapchain_extent);
     }
 
-    if(status)
+    return framebuffer;
+}
+
+// rebuilds everything that depends on the swapchain images or extent, the framebuffers are recreated lazily
+// by the cache the next time they are requested. the old objects are destroyed once the frames already
+// submitted have completed, the rebuild itself does not wait for the gpu
+bool handle_swapchain_change(void)
+{
+    bool status = true;
+
+    struct queue_point frame_point;
+    get_last_queue_point(QUEUE_CLASS_FRAME, &frame_point);
+
+    VkSemaphore frame_timeline = get_queue_timeline(QUEUE_CLASS_FRAME);
+
+    status = recreate_swapchain(vk_ctx, get_drawable_extent(), frame_timeline, frame_point.value);
+
+    if(status && (vk_ctx->swapchain_extent.width > 0) && (vk_ctx->swapchain_extent.height > 0))
     {
-        VkFramebufferCreateInfo params;
-        params.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        params.pNext = NULL;
-        params.flags = 0;
-        params.renderPass = g_render_pass;
-        params.attachmentCount = 1;
-        params.pAttachments = g_image_views;
-        params.width = window_width;
-        params.height = window_height;
-        params.layers = 1;
+        destroy_swapchain_image_views(frame_timeline, frame_point.value);
+
+        destroy_render_targets(frame_timeline, frame_point.value);
+
+        status = create_swapchain_image_views();
 
-        if(vk_ctx->create_framebuffer(vk_ctx->device, &params, vk_ctx->allocation_callbacks, &g_framebuffer) != VK_SUCCESS)
+        if(status)
         {
-            printf("Failed to create framebuffer\n");
-            status = false;
+            status = create_render_targets();
         }
+
+        g_swapchain_changed = false;
     }
 
+    return status;
+}
+
+// the render pass of the frame for the current sample count, with more than one sample the color is resolved
+// into the swapchain image. it is kept for the sample count until shutdown
+bool create_render_pass(void)
+{
+    bool status = true;
+
+    uint32_t sample_index = get_sample_count_index(g_msaa_samples);
+
+    bool multisampled = (g_msaa_samples != VK_SAMPLE_COUNT_1_BIT);
+
+    // with multisampling the first attachment is the multisampled color image, it is resolved into the swapchain
+    // image at the end of the subpass and its samples are never stored
+    VkAttachmentDescription attachment_descriptions[3];
+    attachment_descriptions[0].flags = 0;
+    attachment_descriptions[0].format = vk_ctx->surface_format;
+    attachment_descriptions[0].samples = g_msaa_samples;
+    attachment_descriptions[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachment_descriptions[0].storeOp = multisampled ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+    attachment_descriptions[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachment_descriptions[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachment_descriptions[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachment_descriptions[0].finalLayout = multisampled ? VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    // depth is only needed within the frame, it is cleared on load and never stored
+    attachment_descriptions[1].flags = 0;
+    attachment_descriptions[1].format = g_depth_format;
+    attachment_descriptions[1].samples = g_msaa_samples;
+    attachment_descriptions[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachment_descriptions[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachment_descriptions[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachment_descriptions[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachment_descriptions[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachment_descriptions[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    // the resolve overwrites every pixel of the swapchain image, its previous contents are not loaded
+    attachment_descriptions[2] = attachment_descriptions[0];
+    attachment_descriptions[2].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachment_descriptions[2].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachment_descriptions[2].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachment_descriptions[2].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    VkAttachmentReference attachment_reference;
+    attachment_reference.attachment = 0;
+    attachment_reference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference resolve_attachment_reference;
+    resolve_attachment_reference.attachment = 2;
+    resolve_attachment_reference.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference depth_attachment_reference;
+    depth_attachment_reference.attachment = 1;
+    depth_attachment_reference.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    // the layout transitions are done by the render pass, these dependencies replace the explicit image barriers
+    VkSubpassDependency dependencies[3];
+
+    // the swapchain image transition waits for the acquire semaphore, which is waited on at the color output stage.
+    // the multisampled color image is shared by all frames, its clear also waits for the writes of the previous frame
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = 0;
+    dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[0].srcAccessMask = multisampled ? VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT : 0;
+    dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[0].dependencyFlags = 0;
+
+    // the single depth image is shared by all frames, the clear must wait for the depth tests of the previous frame
+    dependencies[1].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[1].dstSubpass = 0;
+    dependencies[1].srcStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependencies[1].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependencies[1].dependencyFlags = 0;
+
+    // the transition to present happens after the color writes, presentation itself is ordered by the
+    // rendering finished semaphore
+    dependencies[2].srcSubpass = 0;
+    dependencies[2].dstSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[2].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[2].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+    dependencies[2].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[2].dstAccessMask = 0;
+    dependencies[2].dependencyFlags = 0;
+
+    VkSubpassDescription subpass_description;
+    subpass_description.flags = 0;
+    subpass_description.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass_description.inputAttachmentCount = 0;
+    subpass_description.pInputAttachments = NULL;
+    subpass_description.colorAttachmentCount = 1;
+    subpass_description.pColorAttachments = &attachment_reference;
+    subpass_description.pResolveAttachments = multisampled ? &resolve_attachment_reference : NULL;
+    subpass_description.pDepthStencilAttachment = &depth_attachment_reference;
+    subpass_description.preserveAttachmentCount = 0;
+    subpass_description.pPreserveAttachments = NULL;
+
+    VkRenderPassCreateInfo render_pass_info;
+    render_pass_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    render_pass_info.pNext = NULL;
+    render_pass_info.flags = 0;
+    render_pass_info.attachmentCount = multisampled ? 3 : 2;
+    render_pass_info.pAttachments = attachment_descriptions;
+    render_pass_info.subpassCount = 1;
+    render_pass_info.pSubpasses = &subpass_description;
+    render_pass_info.dependencyCount = 3;
+    render_pass_info.pDependencies = dependencies;
+
+    if(vk_ctx->create_render_pass(vk_ctx->device, &render_pass_info, vk_ctx->allocation_callbacks, &g_render_pass) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to create render pass\n");
+        status = false;
+    }
+    else
+    {
+        VK_CTX_NAME(vk_ctx, VK_OBJECT_TYPE_RENDER_PASS, g_render_pass, "main render pass");
+        g_render_passes[sample_index] = g_render_pass;
+    }
 
-    uint8_t* vertex_shader_code = NULL;
-    uint64_t vertex_shader_code_size = 0;
+    return status;
+}
 
-    uint8_t* fragment_shader_code = NULL;
-    uint64_t fragment_shader_code_size = 0;
+// the main, depth pre-pass and shader variant pipelines for the current render pass and sample count. the
+// registry keeps the pipelines of earlier sample counts and their render passes are kept as well, switching back
+// does not compile them again
+bool create_pipelines(void)
+{
+    bool status = true;
 
-    if(status)
+    struct pipeline_desc desc;
+    init_pipeline_desc(&desc);
+    desc.vertex_shader = g_vertex_shader_module;
+    desc.fragment_shader = g_fragment_shader_module;
+    desc.layout = g_pipeline_layout;
+    desc.render_pass = g_render_pass;
+    desc.color_format = vk_ctx->surface_format;
+    desc.depth_format = g_depth_format;
+    desc.samples = g_msaa_samples;
+
+    // with the pre-pass the depth buffer already holds the closest surface, the main pass only shades fragments
+    // that match it exactly. this relies on the vertex shader declaring gl_Position invariant
+    desc.depth_write = g_depth_prepass ? VK_FALSE : VK_TRUE;
+    desc.depth_compare_op = g_depth_prepass ? VK_COMPARE_OP_EQUAL : VK_COMPARE_OP_LESS;
+
+    // the unused feature paths are removed by the driver when the pipeline is compiled
+    desc.specialization[SHADER_CONSTANT_SPECIALIZED] = VK_TRUE;
+    desc.specialization[SHADER_CONSTANT_COLOR_MODE] = g_shader_features.color_mode;
+    desc.specialization[SHADER_CONSTANT_LIGHTING_MODEL] = g_shader_features.lighting_model;
+
+    if(g_uniform_branching || g_compare_shader_variants)
     {
-        FILE* file = fopen("c:/workspace/vk-cube/bin/shader.vert.spv", "rb");
-        if(file != NULL)
-        {
-            fseek(file, 0, SEEK_END);
-            vertex_shader_code_size = ftell(file);
-            rewind(file);
-            vertex_shader_code = (uint8_t*) malloc(vertex_shader_code_size * sizeof(uint8_t));
-            if(fread(vertex_shader_code, sizeof(uint8_t), vertex_shader_code_size, file) != vertex_shader_code_size)
-            {
-                printf("Error reading vertex shader code\n");
-                status = false;
-            }
-        }
-        else
+        struct pipeline_desc uniform_branching_desc = desc;
+        uniform_branching_desc.specialization[SHADER_CONSTANT_SPECIALIZED] = VK_FALSE;
+
+        g_uniform_branching_pipeline = get_pipeline_blocking(&uniform_branching_desc);
+
+        if(g_uniform_branching_pipeline == NULL)
         {
-            printf("Could not read vertex shader\n");
             status = false;
         }
-
-        if(file != NULL)
+        else
         {
-            fclose(file);
-            file = NULL;
+            VK_CTX_NAME(vk_ctx, VK_OBJECT_TYPE_PIPELINE, g_uniform_branching_pipeline, "uniform branching pipeline");
         }
     }
 
+    g_wireframe_pipeline_desc = desc;
+    g_wireframe_pipeline_desc.polygon_mode = VK_POLYGON_MODE_LINE;
+    g_wireframe_pipeline_desc.cull_mode = VK_CULL_MODE_NONE;
+
+    // the main pipeline is the fallback for its variants, it has to exist before the first frame
     if(status)
     {
-        FILE* file = fopen("c:/workspace/vk-cube/bin/shader.frag.spv", "rb");
-        if(file != NULL)
-        {
-            fseek(file, 0, SEEK_END);
-            fragment_shader_code_size = ftell(file);
-            rewind(file);
-            fragment_shader_code = (uint8_t*) malloc(fragment_shader_code_size * sizeof(uint8_t));
-            if(fread(fragment_shader_code, sizeof(uint8_t), fragment_shader_code_size, file) != fragment_shader_code_size)
-            {
-                printf("Error reading fragment shader code\n");
-                status = false;
-            }
-        }
-        else
-        {
-            printf("Could not read fragment shader\n");
-            status = false;
-        }
+        g_graphics_pipeline = get_pipeline_blocking(&desc);
+    }
 
-        if(file != NULL)
-        {
-            fclose(file);
-            file = NULL;
-        }
+    if(g_graphics_pipeline == NULL)
+    {
+        status = false;
+    }
+    else
+    {
+        VK_CTX_NAME(vk_ctx, VK_OBJECT_TYPE_PIPELINE, g_graphics_pipeline, "main pipeline");
     }
 
-    if(status)
+    if(status && g_depth_prepass)
     {
-        VkShaderModuleCreateInfo vertex_shader_info;
-        vertex_shader_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        vertex_shader_info.pNext = NULL;
-        vertex_shader_info.flags = 0;
-        vertex_shader_info.codeSize = vertex_shader_code_size;
-        vertex_shader_info.pCode = (const uint32_t*) vertex_shader_code;
+        // depth only: no fragment shader and no color writes
+        desc.fragment_shader = NULL;
+        desc.depth_write = VK_TRUE;
+        desc.depth_compare_op = VK_COMPARE_OP_LESS;
+        desc.color_write_mask = 0;
 
-        if(vk_ctx->create_shader_module(vk_ctx->device, &vertex_shader_info, vk_ctx->allocation_callbacks, &g_vertex_shader_module) != VK_SUCCESS)
+        g_depth_prepass_pipeline = get_pipeline_blocking(&desc);
+
+        if(g_depth_prepass_pipeline == NULL)
         {
-            printf("Failed to create vertex shader\n");
+            LOG_ERROR("Could not create depth pre-pass pipeline\n");
             status = false;
         }
+        else
+        {
+            VK_CTX_NAME(vk_ctx, VK_OBJECT_TYPE_PIPELINE, g_depth_prepass_pipeline, "depth pre-pass pipeline");
+        }
     }
 
-    if(status)
+    if(status && g_wireframe)
     {
-        VkShaderModuleCreateInfo fragment_shader_info;
-        fragment_shader_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        fragment_shader_info.pNext = NULL;
-        fragment_shader_info.flags = 0;
-        fragment_shader_info.codeSize = fragment_shader_code_size;
-        fragment_shader_info.pCode = (const uint32_t*) fragment_shader_code;
-
-        if(vk_ctx->create_shader_module(vk_ctx->device, &fragment_shader_info, vk_ctx->allocation_callbacks, &g_fragment_shader_module) != VK_SUCCESS)
+        if(vk_ctx->fill_mode_non_solid_supported)
         {
-            printf("Failed to create fragment shader\n");
-            status = false;
+            // starts compiling now, the solid pipeline is used until it is done
+            get_pipeline(&g_wireframe_pipeline_desc, NULL);
+        }
+        else
+        {
+            LOG_WARNING("Non solid fill modes not supported, wireframe disabled\n");
+            g_wireframe = false;
         }
     }
 
-    if(status)
+    return status;
+}
+
+// switches the sample count between frames, the attachments are rebuilt like on a swapchain change. the render
+// pass and the pipelines of a sample count are created on its first use
+bool set_msaa_samples(VkSampleCountFlagBits samples)
+{
+    bool status = true;
+
+    struct queue_point frame_point;
+    get_last_queue_point(QUEUE_CLASS_FRAME, &frame_point);
+
+    VkSemaphore frame_timeline = get_queue_timeline(QUEUE_CLASS_FRAME);
+
+    destroy_render_targets(frame_timeline, frame_point.value);
+
+    // the framebuffers hold the views of the destroyed attachments, the render pass itself stays for later
+    if(g_render_pass != NULL)
     {
-        VkPipelineShaderStageCreateInfo pipeline_shader_stage_create_info[2];
-
-        pipeline_shader_stage_create_info[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        pipeline_shader_stage_create_info[0].pNext = NULL;
-        pipeline_shader_stage_create_info[0].flags = 0;
-        pipeline_shader_stage_create_info[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-        pipeline_shader_stage_create_info[0].module = g_vertex_shader_module;
-        pipeline_shader_stage_create_info[0].pName = "main";
-        pipeline_shader_stage_create_info[0].pSpecializationInfo = NULL;
-
-        pipeline_shader_stage_create_info[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-        pipeline_shader_stage_create_info[1].pNext = NULL;
-        pipeline_shader_stage_create_info[1].flags = 0;
-        pipeline_shader_stage_create_info[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-        pipeline_shader_stage_create_info[1].module = g_fragment_shader_module;
-        pipeline_shader_stage_create_info[1].pName = "main";
-        pipeline_shader_stage_create_info[1].pSpecializationInfo = NULL;
-
-        VkPipelineVertexInputStateCreateInfo pipeline_vertex_input_state_info;
-        pipeline_vertex_input_state_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        pipeline_vertex_input_state_info.pNext = NULL;
-        pipeline_vertex_input_state_info.flags = 0;
-        pipeline_vertex_input_state_info.vertexBindingDescriptionCount = 0;
-        pipeline_vertex_input_state_info.pVertexBindingDescriptions = NULL;
-        pipeline_vertex_input_state_info.vertexAttributeDescriptionCount = 0;
-        pipeline_vertex_input_state_info.pVertexAttributeDescriptions = NULL;
-
-        VkPipelineInputAssemblyStateCreateInfo pipeline_input_assembly_state_info;
-        pipeline_input_assembly_state_info.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-        pipeline_input_assembly_state_info.pNext = NULL;
-        pipeline_input_assembly_state_info.flags = 0;
-        pipeline_input_assembly_state_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-        pipeline_input_assembly_state_info.primitiveRestartEnable = VK_FALSE;
-
-        VkViewport viewport;
-        viewport.x = 0.0f;
-        viewport.y = 0.0f;
-        viewport.width = (float) window_width;
-        viewport.height = (float) window_height;
-        viewport.minDepth = 0.0f;
-        viewport.maxDepth = 1.0f;
-
-        VkRect2D scissor;
-        scissor.offset.x = 0.0f,
-        scissor.offset.y = 0.0f;
-        scissor.extent.width = window_width;
-        scissor.extent.height = window_height;
-
-        VkPipelineViewportStateCreateInfo pipeline_viewport_state_info;
-        pipeline_viewport_state_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-        pipeline_viewport_state_info.pNext = NULL;
-        pipeline_viewport_state_info.flags = 0;
-        pipeline_viewport_state_info.viewportCount = 1;
-        pipeline_viewport_state_info.pViewports = &viewport;
-        pipeline_viewport_state_info.scissorCount = 1;
-        pipeline_viewport_state_info.pScissors = &scissor;
-
-        VkPipelineRasterizationStateCreateInfo pipeline_rasterization_state_info;
-        pipeline_rasterization_state_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-        pipeline_rasterization_state_info.pNext = NULL;
-        pipeline_rasterization_state_info.flags = 0;
-        pipeline_rasterization_state_info.depthClampEnable = VK_FALSE;
-        pipeline_rasterization_state_info.rasterizerDiscardEnable = VK_FALSE;
-        pipeline_rasterization_state_info.polygonMode = VK_POLYGON_MODE_FILL;
-        pipeline_rasterization_state_info.cullMode = VK_CULL_MODE_BACK_BIT;
-        pipeline_rasterization_state_info.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-        pipeline_rasterization_state_info.depthBiasEnable = VK_FALSE;
-        pipeline_rasterization_state_info.depthBiasConstantFactor = 0.0f;
-        pipeline_rasterization_state_info.depthBiasClamp = 0.0f;
-        pipeline_rasterization_state_info.depthBiasSlopeFactor = 0.0f;
-        pipeline_rasterization_state_info.lineWidth = 1.0f;
-
-        VkPipelineMultisampleStateCreateInfo pipeline_multisample_state_info;
-        pipeline_multisample_state_info.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-        pipeline_multisample_state_info.pNext = NULL;
-        pipeline_multisample_state_info.flags = 0;
-        pipeline_multisample_state_info.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-        pipeline_multisample_state_info.sampleShadingEnable = VK_FALSE;
-        pipeline_multisample_state_info.minSampleShading = 1.0f;
-        pipeline_multisample_state_info.pSampleMask = NULL;
-        pipeline_multisample_state_info.alphaToCoverageEnable = VK_FALSE;
-        pipeline_multisample_state_info.alphaToOneEnable = VK_FALSE;
-
-        VkPipelineColorBlendAttachmentState pipeline_color_blend_attachment_state;
-        pipeline_color_blend_attachment_state.blendEnable = VK_FALSE;
-        pipeline_color_blend_attachment_state.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
-        pipeline_color_blend_attachment_state.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
-        pipeline_color_blend_attachment_state.colorBlendOp = VK_BLEND_OP_ADD;
-        pipeline_color_blend_attachment_state.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-        pipeline_color_blend_attachment_state.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-        pipeline_color_blend_attachment_state.alphaBlendOp = VK_BLEND_OP_ADD;
-        pipeline_color_blend_attachment_state.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-
-        VkPipelineColorBlendStateCreateInfo pipeline_color_blend_state_info;
-        pipeline_color_blend_state_info.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-        pipeline_color_blend_state_info.pNext = NULL;
-        pipeline_color_blend_state_info.flags = 0;
-        pipeline_color_blend_state_info.logicOpEnable = VK_FALSE;
-        pipeline_color_blend_state_info.logicOp = VK_LOGIC_OP_COPY;
-        pipeline_color_blend_state_info.attachmentCount = 1;
-        pipeline_color_blend_state_info.pAttachments = &pipeline_color_blend_attachment_state;
-        pipeline_color_blend_state_info.blendConstants[0] = 0.0f;
-        pipeline_color_blend_state_info.blendConstants[1] = 0.0f;
-        pipeline_color_blend_state_info.blendConstants[2] = 0.0f;
-        pipeline_color_blend_state_info.blendConstants[3] = 0.0f;
+        release_framebuffers_using_render_pass(g_render_pass);
+        g_render_pass = NULL;
+    }
 
-        VkPipelineLayoutCreateInfo pipeline_layout_create_info;
-        pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipeline_layout_create_info.pNext = NULL;
-        pipeline_layout_create_info.flags = 0;
-        pipeline_layout_create_info.setLayoutCount = 0;
-        pipeline_layout_create_info.pSetLayouts = NULL;
-        pipeline_layout_create_info.pushConstantRangeCount = 0;
-        pipeline_layout_create_info.pPushConstantRanges = NULL;
+    g_msaa_samples = samples;
 
-        if(vk_ctx->create_pipeline_layout(vk_ctx->device, &pipeline_layout_create_info, vk_ctx->allocation_callbacks, &g_pipeline_layout) != VK_SUCCESS)
-        {
-            printf("Could not create pipeline layout\n");
-            status = false;
-        }
+    status = create_render_targets();
 
-        VkGraphicsPipelineCreateInfo graphics_pipeline_create_info;
-        graphics_pipeline_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-        graphics_pipeline_create_info.pNext = NULL;
-        graphics_pipeline_create_info.flags = 0;
-        graphics_pipeline_create_info.stageCount = 2;
-        graphics_pipeline_create_info.pStages = pipeline_shader_stage_create_info;
-        graphics_pipeline_create_info.pVertexInputState = &pipeline_vertex_input_state_info;
-        graphics_pipeline_create_info.pInputAssemblyState = &pipeline_input_assembly_state_info;
-        graphics_pipeline_create_info.pTessellationState = NULL;
-        graphics_pipeline_create_info.pViewportState = &pipeline_viewport_state_info;
-        graphics_pipeline_create_info.pRasterizationState = &pipeline_rasterization_state_info;
-        graphics_pipeline_create_info.pMultisampleState = &pipeline_multisample_state_info;
-        graphics_pipeline_create_info.pDepthStencilState = NULL;
-        graphics_pipeline_create_info.pColorBlendState = &pipeline_color_blend_state_info;
-        graphics_pipeline_create_info.pDynamicState = NULL;
-        graphics_pipeline_create_info.layout = g_pipeline_layout;
-        graphics_pipeline_create_info.renderPass = g_render_pass;
-        graphics_pipeline_create_info.subpass = 0;
-        graphics_pipeline_create_info.basePipelineHandle = NULL;
-        graphics_pipeline_create_info.basePipelineIndex = -1;
-
-        if(vk_ctx->create_graphics_pipelines(vk_ctx->device, NULL, 1, &graphics_pipeline_create_info, vk_ctx->allocation_callbacks, &g_graphics_pipeline) != VK_SUCCESS)
-        {
-            printf("Could not create graphics pipeline\n");
-            status = false;
+    if(status && !g_dynamic_rendering)
+    {
+        g_render_pass = g_render_passes[get_sample_count_index(samples)];
+
+        if(g_render_pass == NULL)
+        {
+            status = create_render_pass();
         }
     }
 
-    if(ext_array != NULL)
+    if(status)
     {
-        free(ext_array);
-        ext_array = NULL;
+        status = create_pipelines();
     }
 
     return status;
 }
 
-void uninitialize(void)
+bool initialize(void)
 {
-    uninitialize_vulkan_context();
+    bool status = true;
 
-    SDL_Vulkan_UnloadLibrary();
-    SDL_Quit();
-}
+    uint32_t ext_count = 0;
+    const char** ext_array = NULL;
 
-bool render(void)
-{
-    bool status = true;
+    VkSurfaceKHR surface = NULL;
 
-    uint32_t swapchain_index = 0;
+    if(SDL_Init(SDL_INIT_EVERYTHING) != 0)
+    {
+        LOG_ERROR("Could not initialize SDL\n");
+        status = false;
+    }
 
     if(status)
     {
-        if(vk_ctx->acquire_next_image(vk_ctx->device, vk_ctx->swapchain, UINT64_MAX, vk_ctx->image_available_semaphore, NULL, &swapchain_index) != VK_SUCCESS)
+        if(SDL_Vulkan_LoadLibrary(NULL) != 0)
         {
-            printf("Could not get next surface image\n");
+            LOG_ERROR("Could not load the vulkan library\n");
             status = false;
         }
     }
 
     if(status)
     {
-        VkCommandBufferBeginInfo params;
-        params.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-        params.pNext = NULL;
-        params.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-        params.pInheritanceInfo = NULL;
+        g_window = SDL_CreateWindow(window_title, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, window_width, window_height, SDL_WINDOW_VULKAN | SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
 
-        if(vk_ctx->begin_command_buffer(vk_ctx->command_buffer, &params) != VK_SUCCESS)
+        if (g_window == NULL)
         {
-            printf("Failed to begin command buffer\n");
             status = false;
+            LOG_ERROR("Could not create SDL window\n");
         }
     }
 
     if(status)
     {
-        VkImageMemoryBarrier barrier;
-        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        barrier.pNext = NULL;
-        barrier.srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        barrier.srcQueueFamilyIndex = vk_ctx->graphics_queue_family;
-        barrier.dstQueueFamilyIndex = vk_ctx->graphics_queue_family;
-        barrier.image = vk_ctx->swapchain_images[swapchain_index];
-        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        barrier.subresourceRange.baseMipLevel = 0;
-        barrier.subresourceRange.levelCount = 1;
-        barrier.subresourceRange.baseArrayLayer = 0,
-        barrier.subresourceRange.layerCount = 1;
-
-        vk_ctx->cmd_pipeline_barrier(vk_ctx->command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+        if(SDL_Vulkan_GetInstanceExtensions(g_window, &ext_count, NULL) != SDL_TRUE)
+        {
+            status = false;
+            LOG_ERROR("Could not get required SDL extension count\n");
+        }
     }
 
     if(status)
     {
-        VkClearColorValue color;
-        color.float32[0] = 0.0f;
-        color.float32[1] = 0.0f;
-        color.float32[2] = 1.0f;
-        color.float32[3] = 0.0f;
+        ext_array = malloc(ext_count * sizeof(char*));
+
+        if(ext_array == NULL)
+        {
+            status = false;
+            LOG_ERROR("Failed to allocate memory\n");
+        }
+    }
+
+    if(status)
+    {
+        if(SDL_Vulkan_GetInstanceExtensions(g_window, &ext_count, ext_array) != SDL_TRUE)
+        {
+            status = false;
+            LOG_ERROR("Could not get required SDL extension count\n");
+        }
+    }
+
+    if(status && (ext_count > 0))
+    {
+        LOG_DEBUG("Required SDL extensions:\n");
+        for(uint32_t i = 0; i < ext_count; i++)
+        {
+            LOG_DEBUG("\t%s\n", ext_array[i]);
+        }
+    }
+
+    if(status)
+    {
+        status = initialize_vulkan_context(vk_ctx, SDL_Vulkan_GetVkGetInstanceProcAddr(), ext_count, ext_array, &g_vk_context_options);
+    }
+
+    if(status)
+    {
+        status = initialize_queue_scheduler();
+    }
+
+    if(status)
+    {
+        if(SDL_Vulkan_CreateSurface(g_window, vk_ctx->instance, (VkSurfaceKHR*) &surface) != SDL_TRUE)
+        {
+            LOG_ERROR("Could not create vulkan surface\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        status = initialize_swapchain(vk_ctx, surface, get_drawable_extent());
+    }
+
+    if(status)
+    {
+        g_depth_format = find_depth_format();
+
+        if(g_depth_format != VK_FORMAT_UNDEFINED)
+        {
+            LOG_INFO("Depth format: %u, depth pre-pass %s\n", g_depth_format, g_depth_prepass ? "enabled" : "disabled");
+        }
+        else
+        {
+            LOG_ERROR("Could not find supported depth format\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        // the benchmark starts without multisampling and steps up from there
+        g_msaa_samples = get_supported_sample_count(g_msaa_benchmark ? 1 : g_msaa_requested);
+
+        if(!g_msaa_benchmark && (g_msaa_samples < g_msaa_requested))
+        {
+            LOG_WARNING("%u samples not supported, using %u\n", g_msaa_requested, (uint32_t) g_msaa_samples);
+        }
+
+        status = create_render_targets();
+    }
+
+    if(status)
+    {
+        status = create_swapchain_image_views();
+    }
+
+    if(status)
+    {
+        // without render pass and framebuffer objects a swapchain change only recreates the image views
+        g_dynamic_rendering = g_dynamic_rendering_requested && vk_ctx->dynamic_rendering_supported;
+
+        LOG_INFO("Rendering path: %s\n", g_dynamic_rendering ? "dynamic rendering" : "render pass");
+    }
+
+    if(status && g_benchmark)
+    {
+        status = initialize_gpu_profiler(PROFILE_SECTION_COUNT, profile_section_names);
+    }
+
+    if(status && !g_dynamic_rendering)
+    {
+        status = create_render_pass();
+    }
+
+    if(status)
+    {
+        status = create_shader_module_from_file("c:/workspace/vk-cube/bin/shader.vert.spv", &g_vertex_shader_module);
+    }
+
+    if(status)
+    {
+        status = create_shader_module_from_file("c:/workspace/vk-cube/bin/shader.frag.spv", &g_fragment_shader_module);
+    }
+
+    if(status)
+    {
+        VK_CTX_NAME(vk_ctx, VK_OBJECT_TYPE_SHADER_MODULE, g_vertex_shader_module, "shader.vert");
+        VK_CTX_NAME(vk_ctx, VK_OBJECT_TYPE_SHADER_MODULE, g_fragment_shader_module, "shader.frag");
+    }
+
+    if(status)
+    {
+        status = initialize_bindless_table();
+    }
+
+    for(uint32_t i = 0; status && (i < VK_CTX_NUM_FRAMES); i++)
+    {
+        status = create_gpu_buffer(MAX_DRAWS * sizeof(struct draw_data), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &g_draw_buffers[i]);
+
+        if(status)
+        {
+            VK_CTX_NAME(vk_ctx, VK_OBJECT_TYPE_BUFFER, g_draw_buffers[i].handle, "draw buffer %u", i);
+
+            g_draw_buffer_indices[i] = register_bindless_buffer(g_draw_buffers[i].handle);
+            status = (g_draw_buffer_indices[i] != BINDLESS_INVALID_INDEX);
+        }
+    }
+
+    if(status && (g_simulation_instances > 0))
+    {
+        status = initialize_simulation(g_simulation_instances);
+    }
+
+    // also without textures, the placeholder fills the texture table
+    if(status)
+    {
+        status = initialize_texture_streaming(g_texture_budget, g_texture_compression);
+    }
+
+    // a mix of sizes so that the budget decides between evicting and dropping mips
+    for(uint32_t i = 0; status && (i < g_texture_count); i++)
+    {
+        status = (create_streamed_texture(NULL, TEXTURE_MAX_SIZE >> (i % 3), i) != TEXTURE_INVALID);
+    }
+
+    if(status)
+    {
+        VkDescriptorSetLayout set_layout = get_bindless_set_layout();
+
+        VkPushConstantRange push_constant_range;
+        push_constant_range.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        push_constant_range.offset = 0;
+        push_constant_range.size = sizeof(struct draw_constants);
+
+        VkPipelineLayoutCreateInfo pipeline_layout_create_info;
+        pipeline_layout_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipeline_layout_create_info.pNext = NULL;
+        pipeline_layout_create_info.flags = 0;
+        pipeline_layout_create_info.setLayoutCount = 1;
+        pipeline_layout_create_info.pSetLayouts = &set_layout;
+        pipeline_layout_create_info.pushConstantRangeCount = 1;
+        pipeline_layout_create_info.pPushConstantRanges = &push_constant_range;
+
+        if(vk_ctx->create_pipeline_layout(vk_ctx->device, &pipeline_layout_create_info, vk_ctx->allocation_callbacks, &g_pipeline_layout) != VK_SUCCESS)
+        {
+            LOG_ERROR("Could not create pipeline layout\n");
+            status = false;
+        }
+        else
+        {
+            VK_CTX_NAME(vk_ctx, VK_OBJECT_TYPE_PIPELINE_LAYOUT, g_pipeline_layout, "main pipeline layout");
+        }
+    }
+
+    if(status)
+    {
+        status = initialize_pipeline_registry("c:/workspace/vk-cube/bin/pipeline_cache.bin");
+    }
+
+    if(status)
+    {
+        status = create_pipelines();
+    }
+
+    if(status)
+    {
+        status = generate_cube_stack_mesh(cube_subdivisions, 1.0f, g_overdraw_layers, &g_mesh);
+    }
+
+    if(status)
+    {
+        status = create_gpu_buffer_with_data(g_mesh.vertices, g_mesh.vertex_count * sizeof(struct vertex), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, &g_vertex_buffer);
+    }
+
+    if(status)
+    {
+        status = create_gpu_buffer_with_data(g_mesh.indices, g_mesh.index_count * sizeof(uint32_t), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, &g_index_buffer);
+    }
+
+    if(status)
+    {
+        VK_CTX_NAME(vk_ctx, VK_OBJECT_TYPE_BUFFER, g_vertex_buffer.handle, "mesh vertices");
+        VK_CTX_NAME(vk_ctx, VK_OBJECT_TYPE_BUFFER, g_index_buffer.handle, "mesh indices");
+    }
+
+    if(status && g_cluster_culling_requested && (g_simulation_instances > 0))
+    {
+        // the clusters are culled in object space for a single instance
+        LOG_WARNING("Cluster culling does not support instances, using the triangle list path\n");
+        g_cluster_culling_requested = false;
+    }
+
+    if(status && g_cluster_culling_requested)
+    {
+        if(vk_ctx->draw_indirect_count_supported)
+        {
+            struct meshlet_list meshlet_list = { 0 };
+
+            status = build_meshlets(&g_mesh, &meshlet_list);
+
+            if(status)
+            {
+                status = initialize_cluster_culling(&meshlet_list);
+            }
+
+            free_meshlets(&meshlet_list);
+
+            g_cluster_culling = status;
+        }
+        else
+        {
+            LOG_WARNING("Draw indirect count not supported, using the triangle list path\n");
+        }
+    }
+
+    if(ext_array != NULL)
+    {
+        free(ext_array);
+        ext_array = NULL;
+    }
+
+    return status;
+}
+
+void uninitialize(void)
+{
+    if((vk_ctx->device != NULL) && (vk_ctx->wait_for_device_idle != NULL))
+    {
+        vk_ctx->wait_for_device_idle(vk_ctx->device);
+
+        uninitialize_cluster_culling();
+        uninitialize_gpu_profiler();
+        uninitialize_framebuffer_cache();
+        uninitialize_pipeline_registry();
+        g_graphics_pipeline = NULL;
+        g_depth_prepass_pipeline = NULL;
+        g_uniform_branching_pipeline = NULL;
+
+        // the device is idle, the views go with the collect of uninitialize_vulkan_context
+        destroy_swapchain_image_views(NULL, 0);
+
+        for(uint32_t i = 0; i < MAX_SAMPLE_COUNTS; i++)
+        {
+            if(g_render_passes[i] != NULL)
+            {
+                vk_ctx->destroy_render_pass(vk_ctx->device, g_render_passes[i], vk_ctx->allocation_callbacks);
+                g_render_passes[i] = NULL;
+            }
+        }
+
+        g_render_pass = NULL;
+
+        if(g_pipeline_layout != NULL)
+        {
+            vk_ctx->destroy_pipeline_layout(vk_ctx->device, g_pipeline_layout, vk_ctx->allocation_callbacks);
+            g_pipeline_layout = NULL;
+        }
+
+        if(g_vertex_shader_module != NULL)
+        {
+            vk_ctx->destroy_shader_module(vk_ctx->device, g_vertex_shader_module, vk_ctx->allocation_callbacks);
+            g_vertex_shader_module = NULL;
+        }
+
+        if(g_fragment_shader_module != NULL)
+        {
+            vk_ctx->destroy_shader_module(vk_ctx->device, g_fragment_shader_module, vk_ctx->allocation_callbacks);
+            g_fragment_shader_module = NULL;
+        }
+
+        destroy_gpu_buffer(&g_index_buffer);
+        destroy_gpu_buffer(&g_vertex_buffer);
+
+        for(uint32_t i = 0; i < VK_CTX_NUM_FRAMES; i++)
+        {
+            destroy_gpu_buffer(&g_draw_buffers[i]);
+        }
+
+        uninitialize_simulation();
+        uninitialize_texture_streaming();
+        uninitialize_bindless_table();
+
+        destroy_gpu_image(&g_msaa_color_image);
+        destroy_gpu_image(&g_depth_image);
+    }
+
+    free_mesh(&g_mesh);
+
+    uninitialize_queue_scheduler();
+    uninitialize_vulkan_context(vk_ctx);
+
+    SDL_Vulkan_UnloadLibrary();
+    SDL_Quit();
+}
+
+// picks the textures of the frame and marks them as used, returns their bindless indices. the cluster draws are
+// indirect and share one texture, otherwise the instances are split into one group per texture
+uint32_t select_textures(uint32_t* texture_indices)
+{
+    uint32_t instance_count = (g_simulation_instances > 0) ? g_simulation_instances : 1;
+    uint32_t group_count = (g_texture_count < instance_count) ? g_texture_count : instance_count;
+
+    if(g_cluster_culling || (group_count == 0))
+    {
+        group_count = 1;
+    }
+
+    // the cube fills the viewport, the simulated instances are about a tenth of it
+    uint32_t pixels = (g_simulation_instances > 0) ? vk_ctx->swapchain_extent.height / 10 : vk_ctx->swapchain_extent.height;
+    uint32_t first = g_frame_index / TEXTURE_SWITCH_FRAMES;
+
+    for(uint32_t i = 0; i < group_count; i++)
+    {
+        // without textures the placeholder is returned
+        uint32_t texture = (g_texture_count > 0) ? (first + i) % g_texture_count : TEXTURE_INVALID;
+
+        texture_indices[i] = use_streamed_texture(texture, get_streamed_texture_mip(texture, pixels));
+    }
+
+    return group_count;
+}
+
+// the draw indices of the instances continue across the groups through firstInstance
+void draw_geometry(VkCommandBuffer command_buffer, const uint32_t* texture_indices, uint32_t group_count)
+{
+    if(g_cluster_culling)
+    {
+        record_cluster_draws(command_buffer);
+    }
+    else
+    {
+        uint32_t instance_count = (g_simulation_instances > 0) ? g_simulation_instances : 1;
+
+        vk_ctx->cmd_bind_index_buffer(command_buffer, g_index_buffer.handle, 0, VK_INDEX_TYPE_UINT32);
+
+        for(uint32_t i = 0; i < group_count; i++)
+        {
+            uint32_t first_instance = instance_count * i / group_count;
+            uint32_t end_instance = instance_count * (i + 1) / group_count;
+
+            if(group_count > 1)
+            {
+                vk_ctx->cmd_push_constants(command_buffer, g_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, offsetof(struct draw_constants, texture_index), sizeof(uint32_t), &texture_indices[i]);
+            }
+
+            vk_ctx->cmd_draw_indexed(command_buffer, g_mesh.index_count, end_instance - first_instance, 0, 0, first_instance);
+        }
+    }
+}
+
+// without extended dynamic state the depth state is baked into the pipelines
+void set_depth_state(VkCommandBuffer command_buffer, VkBool32 depth_write, VkCompareOp compare_op)
+{
+    if(vk_ctx->extended_dynamic_state_supported)
+    {
+        vk_ctx->cmd_set_depth_write_enable(command_buffer, depth_write);
+        vk_ctx->cmd_set_depth_compare_op(command_buffer, compare_op);
+    }
+}
+
+// viewport and scissor are dynamic state of every pipeline, both cover the whole swapchain extent
+void set_frame_viewport(VkCommandBuffer command_buffer)
+{
+    VkViewport viewport;
+    viewport.x = 0.0f;
+    viewport.y = 0.0f;
+    viewport.width = (float) vk_ctx->swapchain_extent.width;
+    viewport.height = (float) vk_ctx->swapchain_extent.height;
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+
+    VkRect2D scissor;
+    scissor.offset.x = 0;
+    scissor.offset.y = 0;
+    scissor.extent = vk_ctx->swapchain_extent;
+
+    vk_ctx->cmd_set_viewport(command_buffer, 0, 1, &viewport);
+    vk_ctx->cmd_set_scissor(command_buffer, 0, 1, &scissor);
+}
+
+void draw_mesh(VkCommandBuffer command_buffer, uint32_t frame_slot)
+{
+    struct draw_constants constants;
+    constants.draw_buffer = g_draw_buffer_indices[frame_slot];
+    constants.draw_index = 0;
+    constants.color_mode = g_shader_features.color_mode;
+    constants.lighting_model = g_shader_features.lighting_model;
+
+    uint32_t texture_indices[TEXTURE_MAX_COUNT];
+    uint32_t texture_group_count = select_textures(texture_indices);
+
+    constants.texture_index = texture_indices[0];
+
+    if(g_simulation_instances > 0)
+    {
+        // one transform per instance, written by the simulation step of the frame
+        constants.draw_buffer = g_simulation_frame.transform_buffer;
+    }
+    else
+    {
+        struct draw_data* draws = (struct draw_data*) g_draw_buffers[frame_slot].mapped;
+        memcpy(draws[constants.draw_index].transform, view_projection, sizeof(view_projection));
+    }
+
+    // the push constants stay valid across the pipeline binds below, all pipelines share the layout
+    vk_ctx->cmd_push_constants(command_buffer, g_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(struct draw_constants), &constants);
+
+    set_frame_viewport(command_buffer);
+
+    VkDeviceSize vertex_buffer_offset = 0;
+
+    vk_ctx->cmd_bind_vertex_buffers(command_buffer, 0, 1, &g_vertex_buffer.handle, &vertex_buffer_offset);
+
+    write_gpu_profiler_timestamp(command_buffer, PROFILE_DEPTH_PREPASS);
+
+    if(g_depth_prepass)
+    {
+        VK_CTX_BEGIN_LABEL(vk_ctx, command_buffer, profile_section_names[PROFILE_DEPTH_PREPASS]);
+        vk_ctx->cmd_bind_pipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, g_depth_prepass_pipeline);
+        set_depth_state(command_buffer, VK_TRUE, VK_COMPARE_OP_LESS);
+        draw_geometry(command_buffer, texture_indices, texture_group_count);
+        VK_CTX_END_LABEL(vk_ctx, command_buffer);
+    }
+
+    write_gpu_profiler_timestamp(command_buffer, PROFILE_MAIN_PASS);
+
+    // the labels carry the names of the profiler sections so that captures line up with the printed timings
+    VK_CTX_BEGIN_LABEL(vk_ctx, command_buffer, profile_section_names[PROFILE_MAIN_PASS]);
+
+    begin_gpu_profiler_statistics(command_buffer);
+
+    VkPipeline pipeline = g_uniform_branching ? g_uniform_branching_pipeline : g_graphics_pipeline;
+
+    if(g_wireframe)
+    {
+        pipeline = get_pipeline(&g_wireframe_pipeline_desc, pipeline);
+    }
+
+    vk_ctx->cmd_bind_pipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    set_depth_state(command_buffer, g_depth_prepass ? VK_FALSE : VK_TRUE, g_depth_prepass ? VK_COMPARE_OP_EQUAL : VK_COMPARE_OP_LESS);
+    draw_geometry(command_buffer, texture_indices, texture_group_count);
+
+    end_gpu_profiler_statistics(command_buffer);
+
+    VK_CTX_END_LABEL(vk_ctx, command_buffer);
+
+    write_gpu_profiler_timestamp(command_buffer, PROFILE_SECTION_COUNT);
+}
+
+// the render pass path clears through the attachment load ops and transitions the layouts through its dependencies,
+// dynamic rendering has no such objects so the transitions are recorded explicitly around the rendering scope
+void begin_frame_rendering(VkCommandBuffer command_buffer, uint32_t swapchain_index, VkFramebuffer framebuffer)
+{
+    bool multisampled = (g_msaa_samples != VK_SAMPLE_COUNT_1_BIT);
+
+    // the resolve attachment of the render pass is not cleared, its value is ignored
+    VkClearValue clear_values[3];
+    clear_values[0].color.float32[0] = 0.0f;
+    clear_values[0].color.float32[1] = 0.0f;
+    clear_values[0].color.float32[2] = 1.0f;
+    clear_values[0].color.float32[3] = 0.0f;
+    clear_values[1].depthStencil.depth = 1.0f;
+    clear_values[1].depthStencil.stencil = 0;
+    clear_values[2] = clear_values[0];
+
+    VkRect2D render_area;
+    render_area.offset.x = 0;
+    render_area.offset.y = 0;
+    render_area.extent = vk_ctx->swapchain_extent;
+
+    if(g_dynamic_rendering)
+    {
+        VkImageMemoryBarrier barriers[3];
+
+        // same ordering as the render pass dependencies: the swapchain image waits for the acquire semaphore at the
+        // color output stage and the shared depth image waits for the depth tests of the previous frame
+        barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barriers[0].pNext = NULL;
+        barriers[0].srcAccessMask = 0;
+        barriers[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        barriers[0].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barriers[0].newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[0].image = vk_ctx->swapchain_images[swapchain_index];
+        barriers[0].subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barriers[0].subresourceRange.baseMipLevel = 0;
+        barriers[0].subresourceRange.levelCount = 1;
+        barriers[0].subresourceRange.baseArrayLayer = 0;
+        barriers[0].subresourceRange.layerCount = 1;
+
+        barriers[1] = barriers[0];
+        barriers[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        barriers[1].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        barriers[1].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        barriers[1].image = g_depth_image.handle;
+        barriers[1].subresourceRange.aspectMask = get_format_aspect(g_depth_image.format);
+
+        // the multisampled color image is shared by all frames as well, the clear waits for the previous resolve
+        barriers[2] = barriers[0];
+        barriers[2].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        barriers[2].image = g_msaa_color_image.handle;
+
+        VkPipelineStageFlags stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+
+        vk_ctx->cmd_pipeline_barrier(command_buffer, stages, stages, 0, 0, NULL, 0, NULL, multisampled ? 3 : 2, barriers);
+
+        VkRenderingAttachmentInfo color_attachment;
+        color_attachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+        color_attachment.pNext = NULL;
+        color_attachment.imageView = g_image_views[swapchain_index];
+        color_attachment.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        color_attachment.resolveMode = VK_RESOLVE_MODE_NONE;
+        color_attachment.resolveImageView = NULL;
+        color_attachment.resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        color_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        color_attachment.clearValue = clear_values[0];
+
+        // the samples are averaged into the swapchain image when the rendering ends and are never stored
+        if(multisampled)
+        {
+            color_attachment.imageView = g_msaa_color_image.view;
+            color_attachment.resolveMode = VK_RESOLVE_MODE_AVERAGE_BIT;
+            color_attachment.resolveImageView = g_image_views[swapchain_index];
+            color_attachment.resolveImageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+            color_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        }
+
+        // depth is only needed within the frame, it is cleared on load and never stored
+        VkRenderingAttachmentInfo depth_attachment = color_attachment;
+        depth_attachment.imageView = g_depth_image.view;
+        depth_attachment.resolveMode = VK_RESOLVE_MODE_NONE;
+        depth_attachment.resolveImageView = NULL;
+        depth_attachment.resolveImageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        depth_attachment.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        depth_attachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depth_attachment.clearValue = clear_values[1];
+
+        VkRenderingInfo rendering_info;
+        rendering_info.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+        rendering_info.pNext = NULL;
+        rendering_info.flags = 0;
+        rendering_info.renderArea = render_area;
+        rendering_info.layerCount = 1;
+        rendering_info.viewMask = 0;
+        rendering_info.colorAttachmentCount = 1;
+        rendering_info.pColorAttachments = &color_attachment;
+        rendering_info.pDepthAttachment = &depth_attachment;
+        rendering_info.pStencilAttachment = (get_format_aspect(g_depth_image.format) & VK_IMAGE_ASPECT_STENCIL_BIT) ? &depth_attachment : NULL;
+
+        vk_ctx->cmd_begin_rendering(command_buffer, &rendering_info);
+    }
+    else
+    {
+        VkRenderPassBeginInfo render_pass_begin_info;
+        render_pass_begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        render_pass_begin_info.pNext = NULL;
+        render_pass_begin_info.renderPass = g_render_pass;
+        render_pass_begin_info.framebuffer = framebuffer;
+        render_pass_begin_info.renderArea = render_area;
+        render_pass_begin_info.clearValueCount = multisampled ? 3 : 2;
+        render_pass_begin_info.pClearValues = clear_values;
+
+        vk_ctx->cmd_begin_render_pass(command_buffer, &render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+    }
+}
+
+void end_frame_rendering(VkCommandBuffer command_buffer, uint32_t swapchain_index)
+{
+    if(g_dynamic_rendering)
+    {
+        vk_ctx->cmd_end_rendering(command_buffer);
+
+        // presentation itself is ordered by the rendering finished semaphore
+        VkImageMemoryBarrier barrier;
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.pNext = NULL;
+        barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = vk_ctx->swapchain_images[swapchain_index];
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+
+        vk_ctx->cmd_pipeline_barrier(command_buffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+    }
+    else
+    {
+        vk_ctx->cmd_end_render_pass(command_buffer);
+    }
+}
+
+bool render(void)
+{
+    bool status = true;
+
+    bool skip_frame = false;
+
+    uint32_t swapchain_index = 0;
+
+    VkFramebuffer framebuffer = NULL;
+
+    uint32_t frame_slot = g_frame_index % VK_CTX_NUM_FRAMES;
+
+    VkCommandBuffer command_buffer = vk_ctx->command_buffers[frame_slot];
+
+    struct queue_point simulation_point = { QUEUE_CLASS_COMPUTE, 0 };
+
+    if(status && g_swapchain_changed)
+    {
+        status = handle_swapchain_change();
+
+        // still set while the window is minimized, there is nothing to draw into
+        skip_frame = g_swapchain_changed;
+    }
+
+    if(status && !skip_frame)
+    {
+        // the command buffer, the acquire semaphore and the draw buffer of the slot are free again
+        status = wait_for_queue_point(&g_frame_points[frame_slot]);
+
+        collect_deferred_destructions(vk_ctx, false);
+
+        // before the streaming, the textures it evicts under pressure are not requested again this frame
+        update_memory_budget(vk_ctx);
+    }
+
+    if(status && !skip_frame)
+    {
+        status = update_texture_streaming(g_frame_index);
+    }
+
+    if(status && !skip_frame)
+    {
+        VkResult result = vk_ctx->acquire_next_image(vk_ctx->device, vk_ctx->swapchain, UINT64_MAX, vk_ctx->image_available_semaphores[frame_slot], NULL, &swapchain_index);
+
+        if(result == VK_ERROR_OUT_OF_DATE_KHR)
+        {
+            // the semaphore is not signaled, recreate and try again next frame
+            g_swapchain_changed = true;
+            skip_frame = true;
+        }
+        else if(result == VK_SUBOPTIMAL_KHR)
+        {
+            // still presentable, recreate after this frame
+            g_swapchain_changed = true;
+        }
+        else if(result != VK_SUCCESS)
+        {
+            LOG_ERROR("Could not get next surface image\n");
+            status = false;
+        }
+    }
+
+    if(status && !skip_frame && !g_dynamic_rendering)
+    {
+        framebuffer = get_frame_framebuffer(swapchain_index);
+
+        if(framebuffer == NULL)
+        {
+            status = false;
+        }
+    }
+
+    if(status && skip_frame)
+    {
+        SDL_Delay(1);
+    }
+
+    if(status && !skip_frame)
+    {
+        VkCommandBufferBeginInfo params;
+        params.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        params.pNext = NULL;
+        params.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        params.pInheritanceInfo = NULL;
+
+        if(vk_ctx->begin_command_buffer(command_buffer, &params) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to begin command buffer\n");
+            status = false;
+        }
+        else
+        {
+            VK_CTX_BEGIN_LABEL(vk_ctx, command_buffer, "Frame");
+        }
+    }
+
+    if(status && !skip_frame && (g_simulation_instances > 0))
+    {
+        get_simulation_frame(&g_simulation_frame);
+        begin_simulation_frame(command_buffer, &g_simulation_frame);
+    }
+
+    if(status && !skip_frame)
+    {
+        begin_gpu_profiler_frame(command_buffer);
+        write_gpu_profiler_timestamp(command_buffer, PROFILE_CLUSTER_CULLING);
+    }
+
+    if(status && !skip_frame && g_cluster_culling)
+    {
+        VK_CTX_BEGIN_LABEL(vk_ctx, command_buffer, profile_section_names[PROFILE_CLUSTER_CULLING]);
+        record_cluster_culling(command_buffer, view_projection, camera);
+        VK_CTX_END_LABEL(vk_ctx, command_buffer);
+    }
+
+    if(status && !skip_frame)
+    {
+        bind_bindless_table(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, g_pipeline_layout, frame_slot);
+
+        VK_CTX_BEGIN_LABEL(vk_ctx, command_buffer, "Rendering");
+        begin_frame_rendering(command_buffer, swapchain_index, framebuffer);
 
-        VkImageSubresourceRange subresource_range;
-        subresource_range.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        subresource_range.baseMipLevel = 0;
-        subresource_range.levelCount = 1;
-        subresource_range.baseArrayLayer = 0,
-        subresource_range.layerCount = 1;
+        draw_mesh(command_buffer, frame_slot);
 
-        vk_ctx->cmd_clear_color_image(vk_ctx->command_buffer, vk_ctx->swapchain_images[swapchain_index], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &color, 1, &subresource_range);
+        end_frame_rendering(command_buffer, swapchain_index);
+        VK_CTX_END_LABEL(vk_ctx, command_buffer);
     }
 
-    if(status)
+    if(status && !skip_frame && (g_simulation_instances > 0))
     {
-        VkImageMemoryBarrier barrier;
-        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-        barrier.pNext = NULL;
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-        barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-        barrier.srcQueueFamilyIndex = vk_ctx->graphics_queue_family;
-        barrier.dstQueueFamilyIndex = vk_ctx->graphics_queue_family;
-        barrier.image = vk_ctx->swapchain_images[swapchain_index];
-        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        barrier.subresourceRange.baseMipLevel = 0;
-        barrier.subresourceRange.levelCount = 1;
-        barrier.subresourceRange.baseArrayLayer = 0,
-        barrier.subresourceRange.layerCount = 1;
-
-        vk_ctx->cmd_pipeline_barrier(vk_ctx->command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+        end_simulation_frame(command_buffer, &g_simulation_frame);
     }
 
-    if(status)
+    if(status && !skip_frame)
     {
-        if(vk_ctx->end_command_buffer(vk_ctx->command_buffer) != VK_SUCCESS)
+        VK_CTX_END_LABEL(vk_ctx, command_buffer);
+
+        if(vk_ctx->end_command_buffer(command_buffer) != VK_SUCCESS)
         {
-            printf("Failed to end command buffer\n");
+            LOG_ERROR("Failed to end command buffer\n");
             status = false;
         }
     }
 
-    if(status)
+    if(status && !skip_frame && (g_simulation_instances > 0))
+    {
+        // submitted right before the frame that draws it so that it overlaps the previous frame
+        status = submit_simulation_step(view_projection, &simulation_point);
+    }
+
+    if(status && !skip_frame)
     {
-        VkPipelineStageFlags wait_dst_stage_masks[] = { VK_PIPELINE_STAGE_TRANSFER_BIT };
+        struct queue_submission submission;
+        init_queue_submission(&submission, 1, &command_buffer);
+        add_queue_submission_wait(&submission, &simulation_point, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+
+        // the textures that became resident this frame were uploaded on the bulk queue
+        struct queue_point upload_point;
+        get_texture_upload_point(&upload_point);
+        add_queue_submission_wait(&submission, &upload_point, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+        submission.acquire_semaphore = vk_ctx->image_available_semaphores[frame_slot];
+        submission.acquire_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        submission.present_semaphore = vk_ctx->rendering_finished_semaphores[swapchain_index];
 
-        VkSubmitInfo submit_info;
-        submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-        submit_info.pNext = NULL;
-        submit_info.waitSemaphoreCount = 1;
-        submit_info.pWaitSemaphores = &vk_ctx->image_available_semaphore;
-        submit_info.pWaitDstStageMask = wait_dst_stage_masks;
-        submit_info.commandBufferCount = 1;
-        submit_info.pCommandBuffers = &vk_ctx->command_buffer;
-        submit_info.signalSemaphoreCount = 1;
-        submit_info.pSignalSemaphores = &vk_ctx->rendering_finished_semaphore;
+        status = submit_to_queue(QUEUE_CLASS_FRAME, &submission, &g_frame_points[frame_slot]);
 
-        if(vk_ctx->queue_submit(vk_ctx->graphics_queues[0], 1, &submit_info, NULL) != VK_SUCCESS)
+        if(status && (g_simulation_instances > 0))
         {
-            printf("Failed to submit command buffer\n");
-            status = false;
+            release_simulation_frame(&g_simulation_frame, &g_frame_points[frame_slot]);
         }
+
+        g_frame_index++;
     }
 
-    if(status)
+    if(status && !skip_frame)
     {
         VkPresentInfoKHR present_info;
         present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
         present_info.pNext = NULL;
         present_info.waitSemaphoreCount = 1;
-        present_info.pWaitSemaphores = &vk_ctx->rendering_finished_semaphore;
+        present_info.pWaitSemaphores = &vk_ctx->rendering_finished_semaphores[swapchain_index];
         present_info.swapchainCount = 1;
         present_info.pSwapchains = &vk_ctx->swapchain;
         present_info.pImageIndices = &swapchain_index;
         present_info.pResults = NULL;
 
-        if(vk_ctx->queue_present(vk_ctx->graphics_queues[0], &present_info) != VK_SUCCESS)
+        VkResult result = present_to_queue(&present_info);
+
+        if((result == VK_ERROR_OUT_OF_DATE_KHR) || (result == VK_SUBOPTIMAL_KHR))
+        {
+            g_swapchain_changed = true;
+        }
+        else if(result != VK_SUCCESS)
         {
-            printf("Failed to present\n");
+            LOG_ERROR("Failed to present\n");
             status = false;
         }
     }
@@ -621,6 +1505,10 @@ bool run(void)
     bool exit = false;
     SDL_Event event = { 0 };
 
+    uint32_t frame_count = 0;
+    uint64_t frame_ticks = 0;
+    uint64_t frame_start = SDL_GetPerformanceCounter();
+
     while(status)
     {
         while(status && (SDL_PollEvent(&event) != 0))
@@ -632,6 +1520,14 @@ bool run(void)
                     exit = true;
                     break;
                 }
+                case SDL_WINDOWEVENT:
+                {
+                    if(event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+                    {
+                        g_swapchain_changed = true;
+                    }
+                    break;
+                }
                 default:
                 {
                     break;
@@ -642,6 +1538,66 @@ bool run(void)
         if(!exit)
         {
             status = render();
+
+            if(g_benchmark)
+            {
+                uint64_t frame_end = SDL_GetPerformanceCounter();
+
+                frame_ticks += frame_end - frame_start;
+                frame_start = frame_end;
+                frame_count++;
+
+                if(frame_count == GPU_PROFILER_REPORT_FRAMES)
+                {
+                    if(g_compare_shader_variants)
+                    {
+                        // the gpu profile of these frames is printed with the next frame
+                        LOG_INFO("Shader variant: %s\n", g_uniform_branching ? "uniform branching" : "specialized");
+                        g_uniform_branching = !g_uniform_branching;
+                    }
+
+                    if(g_msaa_benchmark)
+                    {
+                        LOG_INFO("MSAA samples: %u\n", (uint32_t) g_msaa_samples);
+                    }
+
+                    LOG_INFO("Frame time: %.3f ms\n", (double) frame_ticks * 1000.0 / (double) SDL_GetPerformanceFrequency() / frame_count);
+
+                    if(g_texture_count > 0)
+                    {
+                        print_texture_streaming_stats();
+                    }
+
+                    for(uint32_t i = 0; i < vk_ctx->memory_properties.memoryHeapCount; i++)
+                    {
+                        if(vk_ctx->memory_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+                        {
+                            LOG_INFO("Memory heap %u: %llu of %llu MB\n", i, (unsigned long long) (vk_ctx->heap_budgets[i].usage >> 20), (unsigned long long) (vk_ctx->heap_budgets[i].budget >> 20));
+                        }
+                    }
+
+                    frame_count = 0;
+                    frame_ticks = 0;
+
+                    if(g_msaa_benchmark)
+                    {
+                        // the next supported count above the current one, after 8 or the highest supported count
+                        // it starts over at 1. the pipelines are compiled before the timing restarts
+                        uint32_t next = 1;
+
+                        for(uint32_t count = (uint32_t) g_msaa_samples * 2; (next == 1) && (count <= 8); count *= 2)
+                        {
+                            if(vk_ctx->framebuffer_sample_counts & count)
+                            {
+                                next = count;
+                            }
+                        }
+
+                        status = set_msaa_samples((VkSampleCountFlagBits) next);
+                        frame_start = SDL_GetPerformanceCounter();
+                    }
+                }
+            }
         }
         else
         {
@@ -652,16 +1608,416 @@ bool run(void)
     return status;
 }
 
+// records the same draws through the device level pointer of vk_ctx and through the loader trampoline that
+// vkGetInstanceProcAddr returns, the difference is the cost of the loader dispatch per call. only the cpu time
+// of recording is measured, the command buffer is never submitted
+bool run_dispatch_benchmark(uint32_t draw_count)
+{
+    bool status = true;
+
+    const uint32_t round_count = 4;
+
+    VkCommandBuffer command_buffer = vk_ctx->command_buffers[0];
+
+    VkFramebuffer framebuffer = NULL;
+
+    PFN_vkCmdDraw cmd_draw[2];
+    cmd_draw[0] = vk_ctx->cmd_draw;
+    cmd_draw[1] = (PFN_vkCmdDraw) vk_ctx->get_instance_proc_addr(vk_ctx->instance, "vkCmdDraw");
+
+    const char* dispatch_names[2] = { "device", "loader" };
+
+    double best_times[2] = { 0.0, 0.0 };
+
+    // the first draw of the draw buffer with the current shader features
+    struct draw_constants constants;
+    constants.draw_buffer = g_draw_buffer_indices[0];
+    constants.draw_index = 0;
+    constants.color_mode = g_shader_features.color_mode;
+    constants.lighting_model = g_shader_features.lighting_model;
+    constants.texture_index = 0; // the placeholder, only sampled with textures
+
+    if(cmd_draw[1] == NULL)
+    {
+        LOG_ERROR("Failed to load the loader trampoline of vkCmdDraw\n");
+        status = false;
+    }
+
+    if(status && !g_dynamic_rendering)
+    {
+        framebuffer = get_frame_framebuffer(0);
+
+        if(framebuffer == NULL)
+        {
+            status = false;
+        }
+    }
+
+    // alternate the paths so that both see a warm command pool, keep the best round of each
+    for(uint32_t round = 0; status && (round < 2 * round_count); round++)
+    {
+        uint32_t path = round % 2;
+
+        VkCommandBufferBeginInfo params;
+        params.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        params.pNext = NULL;
+        params.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        params.pInheritanceInfo = NULL;
+
+        if(vk_ctx->begin_command_buffer(command_buffer, &params) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to begin command buffer\n");
+            status = false;
+        }
+
+        if(status)
+        {
+            // the state a frame sets before its draws, the command buffer is never submitted so slot 0 of the
+            // bindless table is free to use
+            bind_bindless_table(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, g_pipeline_layout, 0);
+
+            begin_frame_rendering(command_buffer, 0, framebuffer);
+
+            vk_ctx->cmd_bind_pipeline(command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, g_graphics_pipeline);
+            vk_ctx->cmd_push_constants(command_buffer, g_pipeline_layout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(struct draw_constants), &constants);
+
+            set_frame_viewport(command_buffer);
+
+            uint64_t start = SDL_GetPerformanceCounter();
+
+            for(uint32_t i = 0; i < draw_count; i++)
+            {
+                cmd_draw[path](command_buffer, 3, 1, 0, 0);
+            }
+
+            uint64_t end = SDL_GetPerformanceCounter();
+
+            end_frame_rendering(command_buffer, 0);
+
+            if(vk_ctx->end_command_buffer(command_buffer) != VK_SUCCESS)
+            {
+                LOG_ERROR("Failed to end command buffer\n");
+                status = false;
+            }
+
+            double time = (double) (end - start) * 1000000000.0 / (double) SDL_GetPerformanceFrequency() / draw_count;
+
+            if((best_times[path] == 0.0) || (time < best_times[path]))
+            {
+                best_times[path] = time;
+            }
+        }
+    }
+
+    if(status)
+    {
+        for(uint32_t path = 0; path < 2; path++)
+        {
+            LOG_INFO("vkCmdDraw through the %s dispatch: %.2f ns per call\n", dispatch_names[path], best_times[path]);
+        }
+
+        LOG_INFO("Device level dispatch saves %.2f ns per call\n", best_times[1] - best_times[0]);
+    }
+
+    return status;
+}
+
+// every thread creates its own context, defers the destruction of an object and tears the context down again
+int context_test_thread(void* data)
+{
+    struct context_test* test = (struct context_test*) data;
+
+    struct vk_context ctx;
+    struct vk_context_options options;
+
+    VkSemaphore semaphore = NULL;
+
+    init_vk_context_options(&options);
+    options.device_selector = g_vk_context_options.device_selector;
+
+    test->status = initialize_vulkan_context(&ctx, SDL_Vulkan_GetVkGetInstanceProcAddr(), test->ext_count, test->ext_array, &options);
+
+    if(test->status)
+    {
+        VkSemaphoreCreateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        info.pNext = NULL;
+        info.flags = 0;
+
+        if(ctx.create_semaphore(ctx.device, &info, ctx.allocation_callbacks, &semaphore) != VK_SUCCESS)
+        {
+            LOG_ERROR("Context %u: failed to create semaphore\n", test->index);
+            test->status = false;
+        }
+    }
+
+    if(test->status)
+    {
+        defer_destruction(&ctx, VK_OBJECT_TYPE_SEMAPHORE, (uint64_t) semaphore, NULL, 0);
+        collect_deferred_destructions(&ctx, false);
+
+        struct vk_context_stats stats;
+        get_vk_context_stats(&ctx, &stats);
+
+        LOG_INFO("Context %u: Vulkan %u.%u, %llu host allocations, %llu deferred destructions\n", test->index, VK_API_VERSION_MAJOR(ctx.api_version), VK_API_VERSION_MINOR(ctx.api_version), (unsigned long long) stats.host_allocation_count, (unsigned long long) stats.deferred_destruction_count);
+    }
+
+    // also after a failed initialization, whatever was created up to the failure is destroyed
+    uninitialize_vulkan_context(&ctx);
+
+    return 0;
+}
+
+bool run_context_test(uint32_t context_count)
+{
+    bool status = true;
+
+    struct context_test tests[MAX_TEST_CONTEXTS];
+    SDL_Thread* threads[MAX_TEST_CONTEXTS] = { NULL };
+
+    uint32_t ext_count = 0;
+    const char** ext_array = NULL;
+
+    if(context_count > MAX_TEST_CONTEXTS)
+    {
+        context_count = MAX_TEST_CONTEXTS;
+    }
+
+    if(SDL_Vulkan_GetInstanceExtensions(g_window, &ext_count, NULL) != SDL_TRUE)
+    {
+        LOG_ERROR("Could not get required SDL extension count\n");
+        status = false;
+    }
+
+    if(status)
+    {
+        ext_array = malloc(ext_count * sizeof(char*));
+
+        if((ext_array == NULL) || (SDL_Vulkan_GetInstanceExtensions(g_window, &ext_count, ext_array) != SDL_TRUE))
+        {
+            LOG_ERROR("Could not get required SDL extensions\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        for(uint32_t i = 0; i < context_count; i++)
+        {
+            tests[i].index = i;
+            tests[i].ext_count = ext_count;
+            tests[i].ext_array = ext_array;
+            tests[i].status = false;
+
+            threads[i] = SDL_CreateThread(context_test_thread, "context test", &tests[i]);
+
+            if(threads[i] == NULL)
+            {
+                LOG_ERROR("Failed to create context test thread\n");
+                status = false;
+            }
+        }
+
+        for(uint32_t i = 0; i < context_count; i++)
+        {
+            if(threads[i] != NULL)
+            {
+                SDL_WaitThread(threads[i], NULL);
+                status = status && tests[i].status;
+            }
+        }
+
+        LOG_INFO("Context test: %u contexts %s\n", context_count, status ? "passed" : "failed");
+    }
+
+    free(ext_array);
+
+    return status;
+}
+
+void parse_arguments(int argc, char* argv[])
+{
+    init_vk_context_options(&g_vk_context_options);
+
+    // the command line overrides the environment
+    g_vk_context_options.device_selector = getenv("VK_CUBE_DEVICE");
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "--no-cluster-culling") == 0)
+        {
+            g_cluster_culling_requested = false;
+        }
+        else if(strcmp(argv[i], "--no-dynamic-rendering") == 0)
+        {
+            g_dynamic_rendering_requested = false;
+        }
+        else if(strcmp(argv[i], "--depth-prepass") == 0)
+        {
+            g_depth_prepass = true;
+        }
+        else if(strcmp(argv[i], "--benchmark") == 0)
+        {
+            g_benchmark = true;
+        }
+        else if(strcmp(argv[i], "--flat-color") == 0)
+        {
+            g_shader_features.color_mode = COLOR_MODE_FLAT;
+        }
+        else if(strcmp(argv[i], "--lighting") == 0)
+        {
+            g_shader_features.lighting_model = LIGHTING_MODEL_LAMBERT;
+        }
+        else if(strcmp(argv[i], "--uniform-branching") == 0)
+        {
+            g_uniform_branching = true;
+        }
+        else if(strcmp(argv[i], "--compare-shader-variants") == 0)
+        {
+            // alternates between both variants every report interval
+            g_compare_shader_variants = true;
+            g_benchmark = true;
+        }
+        else if((strcmp(argv[i], "--msaa") == 0) && (i + 1 < argc))
+        {
+            g_msaa_requested = (uint32_t) strtoul(argv[++i], NULL, 10);
+        }
+        else if(strcmp(argv[i], "--msaa-benchmark") == 0)
+        {
+            // steps through the supported sample counts up to 8 every report interval
+            g_msaa_benchmark = true;
+            g_benchmark = true;
+        }
+        else if(strcmp(argv[i], "--wireframe") == 0)
+        {
+            g_wireframe = true;
+        }
+        else if((strcmp(argv[i], "--overdraw") == 0) && (i + 1 < argc))
+        {
+            g_overdraw_layers = (uint32_t) strtoul(argv[++i], NULL, 10);
+        }
+        else if((strcmp(argv[i], "--textures") == 0) && (i + 1 < argc))
+        {
+            g_texture_count = (uint32_t) strtoul(argv[++i], NULL, 10);
+            g_shader_features.color_mode = COLOR_MODE_TEXTURE;
+        }
+        else if((strcmp(argv[i], "--texture-budget") == 0) && (i + 1 < argc))
+        {
+            // in megabytes
+            g_texture_budget = (VkDeviceSize) strtoul(argv[++i], NULL, 10) * 1024 * 1024;
+        }
+        else if(strcmp(argv[i], "--uncompressed-textures") == 0)
+        {
+            // rgba8 for comparison, the stats show the memory and upload bytes of both
+            g_texture_compression = false;
+        }
+        else if((strcmp(argv[i], "--simulate") == 0) && (i + 1 < argc))
+        {
+            g_simulation_instances = (uint32_t) strtoul(argv[++i], NULL, 10);
+        }
+        else if((strcmp(argv[i], "--device") == 0) && (i + 1 < argc))
+        {
+            g_vk_context_options.device_selector = argv[++i];
+        }
+        else if((strcmp(argv[i], "--bulk-queue-priority") == 0) && (i + 1 < argc))
+        {
+            g_vk_context_options.graphics_queue_priorities[1] = strtof(argv[++i], NULL);
+        }
+        else if(strcmp(argv[i], "--validation-info") == 0)
+        {
+            g_vk_context_options.debug_messenger.severities |= VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT;
+        }
+        else if(strcmp(argv[i], "--validation-repeats") == 0)
+        {
+            // print every message, the repeat and rate limits hide how often the same problem occurs
+            g_vk_context_options.debug_messenger.repeat_limit = 0;
+            g_vk_context_options.debug_messenger.rate_limit = 0;
+        }
+        else if((strcmp(argv[i], "--queue-priority-test") == 0) && (i + 1 < argc))
+        {
+            g_queue_priority_test_iterations = (uint32_t) strtoul(argv[++i], NULL, 10);
+        }
+        else if((strcmp(argv[i], "--dispatch-benchmark") == 0) && (i + 1 < argc))
+        {
+            g_dispatch_benchmark_draws = (uint32_t) strtoul(argv[++i], NULL, 10);
+        }
+        else if((strcmp(argv[i], "--context-test") == 0) && (i + 1 < argc))
+        {
+            g_context_test_count = (uint32_t) strtoul(argv[++i], NULL, 10);
+        }
+        else if((strcmp(argv[i], "--binary-log") == 0) && (i + 1 < argc))
+        {
+            g_binary_log_path = argv[++i];
+        }
+        else if((strcmp(argv[i], "--decode-log") == 0) && (i + 1 < argc))
+        {
+            g_decode_log_path = argv[++i];
+        }
+        else if((strcmp(argv[i], "--log-level") == 0) && (i + 1 < argc))
+        {
+            static const char* level_names[LOG_LEVEL_COUNT] = { "debug", "info", "warning", "error" };
+
+            const char* name = argv[++i];
+
+            for(uint32_t level = 0; level < LOG_LEVEL_COUNT; level++)
+            {
+                if(strcmp(name, level_names[level]) == 0)
+                {
+                    g_log_level = (enum log_level) level;
+                }
+            }
+        }
+        else
+        {
+            LOG_WARNING("Unknown argument %s\n", argv[i]);
+        }
+    }
+}
+
 int main(int argc, char* argv[])
 {
     int status = 0;
 
-    if(!initialize())
+    parse_arguments(argc, argv);
+
+    // without the writer thread the messages are printed directly
+    initialize_logger(g_binary_log_path);
+    set_log_level(g_log_level);
+
+    if((status == 0) && (g_decode_log_path == NULL) && !initialize())
     {
         status = -1;
     }
 
-    if(status == 0)
+    if((status == 0) && (g_decode_log_path != NULL))
+    {
+        if(!decode_log_file(g_decode_log_path))
+        {
+            status = -1;
+        }
+    }
+    else if((status == 0) && (g_queue_priority_test_iterations > 0))
+    {
+        if(!run_queue_priority_test(g_queue_priority_test_iterations))
+        {
+            status = -1;
+        }
+    }
+    else if((status == 0) && (g_context_test_count > 0))
+    {
+        if(!run_context_test(g_context_test_count))
+        {
+            status = -1;
+        }
+    }
+    else if((status == 0) && (g_dispatch_benchmark_draws > 0))
+    {
+        if(!run_dispatch_benchmark(g_dispatch_benchmark_draws))
+        {
+            status = -1;
+        }
+    }
+    else if(status == 0)
     {
         if(!run())
         {
@@ -669,7 +2025,13 @@ int main(int argc, char* argv[])
         }
     }
 
-    uninitialize();
+    if(g_decode_log_path == NULL)
+    {
+        uninitialize();
+    }
+
+    // after the context, which reports its host memory use when it is torn down
+    uninitialize_logger();
 
     printf("Exit with code 0x%X\n", status);
 
@@ -0,0 +1,171 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "logger.h"
+#include "mesh.h"
+
+enum { CUBE_TILE_SIZE = 7 };
+
+struct cube_face
+{
+    float origin[3];
+    float u[3];
+    float v[3];
+    float color[3];
+};
+
+// u x v points out of the cube so that the faces are counter clockwise when viewed from outside
+static const struct cube_face cube_faces[6] =
+{
+    { { -1.0f, -1.0f,  1.0f }, {  2.0f,  0.0f,  0.0f }, {  0.0f,  2.0f,  0.0f }, { 1.0f, 0.0f, 0.0f } }, // +z
+    { {  1.0f, -1.0f, -1.0f }, { -2.0f,  0.0f,  0.0f }, {  0.0f,  2.0f,  0.0f }, { 0.0f, 1.0f, 0.0f } }, // -z
+    { {  1.0f, -1.0f,  1.0f }, {  0.0f,  0.0f, -2.0f }, {  0.0f,  2.0f,  0.0f }, { 0.0f, 0.0f, 1.0f } }, // +x
+    { { -1.0f, -1.0f, -1.0f }, {  0.0f,  0.0f,  2.0f }, {  0.0f,  2.0f,  0.0f }, { 1.0f, 1.0f, 0.0f } }, // -x
+    { { -1.0f,  1.0f,  1.0f }, {  2.0f,  0.0f,  0.0f }, {  0.0f,  0.0f, -2.0f }, { 1.0f, 0.0f, 1.0f } }, // +y
+    { { -1.0f, -1.0f, -1.0f }, {  2.0f,  0.0f,  0.0f }, {  0.0f,  0.0f,  2.0f }, { 0.0f, 1.0f, 1.0f } }, // -y
+};
+
+static void write_cube(uint32_t subdivisions, float size, const float center[3], uint32_t base_vertex, struct vertex* vertex, uint32_t* index)
+{
+    uint32_t face_vertices = (subdivisions + 1) * (subdivisions + 1);
+    float half_size = size * 0.5f;
+
+    for(uint32_t f = 0; f < 6; f++)
+    {
+        const struct cube_face* face = &cube_faces[f];
+        uint32_t base = base_vertex + f * face_vertices;
+
+        for(uint32_t y = 0; y <= subdivisions; y++)
+        {
+            for(uint32_t x = 0; x <= subdivisions; x++)
+            {
+                float s = (float) x / (float) subdivisions;
+                float t = (float) y / (float) subdivisions;
+
+                for(uint32_t c = 0; c < 3; c++)
+                {
+                    vertex->position[c] = center[c] + (face->origin[c] + face->u[c] * s + face->v[c] * t) * half_size;
+                    vertex->color[c] = face->color[c];
+                }
+
+                vertex++;
+            }
+        }
+
+        // emit the quads in tiles so that consecutive triangles share vertices, this keeps the
+        // meshlets built from the index order compact (a 7x7 tile touches exactly 64 vertices)
+        for(uint32_t tile_y = 0; tile_y < subdivisions; tile_y += CUBE_TILE_SIZE)
+        {
+            for(uint32_t tile_x = 0; tile_x < subdivisions; tile_x += CUBE_TILE_SIZE)
+            {
+                uint32_t end_y = (tile_y + CUBE_TILE_SIZE < subdivisions) ? tile_y + CUBE_TILE_SIZE : subdivisions;
+                uint32_t end_x = (tile_x + CUBE_TILE_SIZE < subdivisions) ? tile_x + CUBE_TILE_SIZE : subdivisions;
+
+                for(uint32_t y = tile_y; y < end_y; y++)
+                {
+                    for(uint32_t x = tile_x; x < end_x; x++)
+                    {
+                        uint32_t i0 = base + y * (subdivisions + 1) + x;
+                        uint32_t i1 = i0 + 1;
+                        uint32_t i2 = i0 + (subdivisions + 1);
+                        uint32_t i3 = i2 + 1;
+
+                        *index++ = i0; *index++ = i1; *index++ = i3;
+                        *index++ = i0; *index++ = i3; *index++ = i2;
+                    }
+                }
+            }
+        }
+    }
+}
+
+bool generate_cube_mesh(uint32_t subdivisions, float size, struct mesh* mesh)
+{
+    return generate_cube_stack_mesh(subdivisions, size, 1, mesh);
+}
+
+bool generate_cube_stack_mesh(uint32_t subdivisions, float size, uint32_t layer_count, struct mesh* mesh)
+{
+    bool status = true;
+
+    uint32_t cube_vertices = 6 * (subdivisions + 1) * (subdivisions + 1);
+    uint32_t cube_indices = 6 * subdivisions * subdivisions * 6;
+
+    memset(mesh, 0, sizeof(struct mesh));
+
+    if(subdivisions == 0)
+    {
+        LOG_ERROR("Invalid cube subdivision count\n");
+        status = false;
+    }
+
+    if(layer_count == 0)
+    {
+        LOG_ERROR("Invalid cube layer count\n");
+        status = false;
+    }
+
+    if(status)
+    {
+        mesh->vertex_count = layer_count * cube_vertices;
+        mesh->vertices = malloc(mesh->vertex_count * sizeof(struct vertex));
+
+        mesh->index_count = layer_count * cube_indices;
+        mesh->indices = malloc(mesh->index_count * sizeof(uint32_t));
+
+        if((mesh->vertices == NULL) || (mesh->indices == NULL))
+        {
+            LOG_ERROR("Failed to allocate memory\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        for(uint32_t i = 0; i < layer_count; i++)
+        {
+            float center[3] = { 0.0f, 0.0f, 0.0f };
+
+            // layer 0 is the farthest away (largest z) and the layers are emitted back to front, without a depth
+            // pre-pass every layer is shaded where they overlap
+            if(layer_count > 1)
+            {
+                float t = (float) i / (float) (layer_count - 1);
+
+                center[0] = (t - 0.5f) * size * 0.25f;
+                center[1] = (t - 0.5f) * size * 0.25f;
+                center[2] = (1.0f - t) * size * 0.5f;
+            }
+
+            write_cube(subdivisions, size, center, i * cube_vertices, &mesh->vertices[i * cube_vertices], &mesh->indices[i * cube_indices]);
+        }
+    }
+
+    if(!status)
+    {
+        free_mesh(mesh);
+    }
+
+    return status;
+}
+
+void free_mesh(struct mesh* mesh)
+{
+    if(mesh != NULL)
+    {
+        if(mesh->vertices != NULL)
+        {
+            free(mesh->vertices);
+            mesh->vertices = NULL;
+        }
+
+        if(mesh->indices != NULL)
+        {
+            free(mesh->indices);
+            mesh->indices = NULL;
+        }
+
+        mesh->vertex_count = 0;
+        mesh->index_count = 0;
+    }
+}
@@ -0,0 +1,29 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+struct vertex
+{
+    float position[3];
+    float color[3];
+};
+
+struct mesh
+{
+    uint32_t       vertex_count;
+    struct vertex* vertices;
+
+    uint32_t       index_count;
+    uint32_t*      indices;
+};
+
+// generates a cube centered on the origin with every face split into subdivisions x subdivisions quads
+bool generate_cube_mesh(uint32_t subdivisions, float size, struct mesh* mesh);
+
+// generates layer_count overlapping cubes ordered back to front, used to produce overdraw
+bool generate_cube_stack_mesh(uint32_t subdivisions, float size, uint32_t layer_count, struct mesh* mesh);
+void free_mesh(struct mesh* mesh);
+
+#endif // MESH_H
@@ -0,0 +1,284 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "logger.h"
+#include "meshlet.h"
+
+enum { UNUSED_LOCAL_INDEX = 0xFF };
+
+struct meshlet_builder
+{
+    const struct mesh* mesh;
+
+    uint8_t*           local_indices;  // per source vertex, UNUSED_LOCAL_INDEX if not in the current meshlet
+    uint32_t           vertices[MESHLET_MAX_VERTICES];
+    uint32_t           vertex_count;
+
+    uint32_t           first_index;
+    uint32_t           triangle_count;
+};
+
+static void subtract(const float* a, const float* b, float* result)
+{
+    result[0] = a[0] - b[0];
+    result[1] = a[1] - b[1];
+    result[2] = a[2] - b[2];
+}
+
+static float dot(const float* a, const float* b)
+{
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+static float normalize(float* v)
+{
+    float length = sqrtf(dot(v, v));
+
+    if(length > 0.0f)
+    {
+        v[0] /= length;
+        v[1] /= length;
+        v[2] /= length;
+    }
+
+    return length;
+}
+
+static void compute_meshlet_bounds(const struct meshlet_builder* builder, struct meshlet* meshlet)
+{
+    const struct vertex* vertices = builder->mesh->vertices;
+    const uint32_t* indices = &builder->mesh->indices[builder->first_index];
+
+    float min[3] = {  INFINITY,  INFINITY,  INFINITY };
+    float max[3] = { -INFINITY, -INFINITY, -INFINITY };
+
+    float axis[3] = { 0.0f, 0.0f, 0.0f };
+    float min_dot = 1.0f;
+
+    // bounding sphere around the aabb center
+    for(uint32_t i = 0; i < builder->vertex_count; i++)
+    {
+        const float* p = vertices[builder->vertices[i]].position;
+
+        for(uint32_t c = 0; c < 3; c++)
+        {
+            min[c] = (p[c] < min[c]) ? p[c] : min[c];
+            max[c] = (p[c] > max[c]) ? p[c] : max[c];
+        }
+    }
+
+    for(uint32_t c = 0; c < 3; c++)
+    {
+        meshlet->center[c] = (min[c] + max[c]) * 0.5f;
+    }
+
+    meshlet->radius = 0.0f;
+
+    for(uint32_t i = 0; i < builder->vertex_count; i++)
+    {
+        float d[3];
+        subtract(vertices[builder->vertices[i]].position, meshlet->center, d);
+
+        float distance = sqrtf(dot(d, d));
+        meshlet->radius = (distance > meshlet->radius) ? distance : meshlet->radius;
+    }
+
+    // normal cone, the axis is the average of the triangle normals and the cutoff is derived from the widest deviation
+    for(uint32_t t = 0; t < builder->triangle_count; t++)
+    {
+        float e0[3], e1[3], n[3];
+        subtract(vertices[indices[t * 3 + 1]].position, vertices[indices[t * 3 + 0]].position, e0);
+        subtract(vertices[indices[t * 3 + 2]].position, vertices[indices[t * 3 + 0]].position, e1);
+
+        n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+        n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+        n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+
+        if(normalize(n) > 0.0f)
+        {
+            axis[0] += n[0];
+            axis[1] += n[1];
+            axis[2] += n[2];
+        }
+    }
+
+    if(normalize(axis) > 0.0f)
+    {
+        for(uint32_t t = 0; t < builder->triangle_count; t++)
+        {
+            float e0[3], e1[3], n[3];
+            subtract(vertices[indices[t * 3 + 1]].position, vertices[indices[t * 3 + 0]].position, e0);
+            subtract(vertices[indices[t * 3 + 2]].position, vertices[indices[t * 3 + 0]].position, e1);
+
+            n[0] = e0[1] * e1[2] - e0[2] * e1[1];
+            n[1] = e0[2] * e1[0] - e0[0] * e1[2];
+            n[2] = e0[0] * e1[1] - e0[1] * e1[0];
+
+            if(normalize(n) > 0.0f)
+            {
+                float d = dot(axis, n);
+                min_dot = (d < min_dot) ? d : min_dot;
+            }
+        }
+    }
+    else
+    {
+        min_dot = -1.0f;
+    }
+
+    memcpy(meshlet->cone_axis, axis, sizeof(axis));
+
+    // a cone wider than a hemisphere always has a front facing triangle
+    meshlet->cone_cutoff = (min_dot <= 0.0f) ? 1.0f : sqrtf(1.0f - min_dot * min_dot);
+}
+
+static bool flush_meshlet(struct meshlet_builder* builder, struct meshlet_list* meshlet_list, uint32_t* capacity)
+{
+    bool status = true;
+
+    if(builder->triangle_count > 0)
+    {
+        if(meshlet_list->meshlet_count == *capacity)
+        {
+            uint32_t new_capacity = (*capacity > 0) ? (*capacity * 2) : 64;
+            struct meshlet* meshlets = realloc(meshlet_list->meshlets, new_capacity * sizeof(struct meshlet));
+
+            if(meshlets != NULL)
+            {
+                meshlet_list->meshlets = meshlets;
+                *capacity = new_capacity;
+            }
+            else
+            {
+                LOG_ERROR("Failed to allocate memory\n");
+                status = false;
+            }
+        }
+
+        if(status)
+        {
+            struct meshlet* meshlet = &meshlet_list->meshlets[meshlet_list->meshlet_count++];
+
+            compute_meshlet_bounds(builder, meshlet);
+
+            meshlet->first_index = builder->first_index;
+            meshlet->index_count = builder->triangle_count * 3;
+            meshlet->vertex_count = builder->vertex_count;
+            meshlet->triangle_count = builder->triangle_count;
+        }
+
+        for(uint32_t i = 0; i < builder->vertex_count; i++)
+        {
+            builder->local_indices[builder->vertices[i]] = UNUSED_LOCAL_INDEX;
+        }
+
+        builder->first_index += builder->triangle_count * 3;
+        builder->vertex_count = 0;
+        builder->triangle_count = 0;
+    }
+
+    return status;
+}
+
+bool build_meshlets(const struct mesh* mesh, struct meshlet_list* meshlet_list)
+{
+    bool status = true;
+
+    uint32_t capacity = 0;
+    struct meshlet_builder builder = { 0 };
+
+    memset(meshlet_list, 0, sizeof(struct meshlet_list));
+
+    builder.mesh = mesh;
+
+    if(status)
+    {
+        builder.local_indices = malloc(mesh->vertex_count * sizeof(uint8_t));
+        meshlet_list->indices = malloc(mesh->index_count * sizeof(uint32_t));
+
+        if((builder.local_indices == NULL) || (meshlet_list->indices == NULL))
+        {
+            LOG_ERROR("Failed to allocate memory\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        memset(builder.local_indices, UNUSED_LOCAL_INDEX, mesh->vertex_count * sizeof(uint8_t));
+
+        // triangles are taken in index order, the meshlets therefore inherit the locality of the source mesh
+        memcpy(meshlet_list->indices, mesh->indices, mesh->index_count * sizeof(uint32_t));
+        meshlet_list->index_count = mesh->index_count;
+
+        for(uint32_t t = 0; status && (t < mesh->index_count / 3); t++)
+        {
+            const uint32_t* triangle = &mesh->indices[t * 3];
+
+            uint32_t new_vertices = 0;
+            new_vertices += (builder.local_indices[triangle[0]] == UNUSED_LOCAL_INDEX) ? 1 : 0;
+            new_vertices += (builder.local_indices[triangle[1]] == UNUSED_LOCAL_INDEX) && (triangle[1] != triangle[0]) ? 1 : 0;
+            new_vertices += (builder.local_indices[triangle[2]] == UNUSED_LOCAL_INDEX) && (triangle[2] != triangle[0]) && (triangle[2] != triangle[1]) ? 1 : 0;
+
+            if((builder.vertex_count + new_vertices > MESHLET_MAX_VERTICES) || (builder.triangle_count + 1 > MESHLET_MAX_TRIANGLES))
+            {
+                status = flush_meshlet(&builder, meshlet_list, &capacity);
+            }
+
+            for(uint32_t i = 0; i < 3; i++)
+            {
+                if(builder.local_indices[triangle[i]] == UNUSED_LOCAL_INDEX)
+                {
+                    builder.local_indices[triangle[i]] = (uint8_t) builder.vertex_count;
+                    builder.vertices[builder.vertex_count++] = triangle[i];
+                }
+            }
+
+            builder.triangle_count++;
+        }
+
+        if(status)
+        {
+            status = flush_meshlet(&builder, meshlet_list, &capacity);
+        }
+    }
+
+    if(status)
+    {
+        LOG_INFO("Built %u meshlets from %u triangles\n", meshlet_list->meshlet_count, mesh->index_count / 3);
+    }
+    else
+    {
+        free_meshlets(meshlet_list);
+    }
+
+    if(builder.local_indices != NULL)
+    {
+        free(builder.local_indices);
+        builder.local_indices = NULL;
+    }
+
+    return status;
+}
+
+void free_meshlets(struct meshlet_list* meshlet_list)
+{
+    if(meshlet_list != NULL)
+    {
+        if(meshlet_list->meshlets != NULL)
+        {
+            free(meshlet_list->meshlets);
+            meshlet_list->meshlets = NULL;
+        }
+
+        if(meshlet_list->indices != NULL)
+        {
+            free(meshlet_list->indices);
+            meshlet_list->indices = NULL;
+        }
+
+        meshlet_list->meshlet_count = 0;
+        meshlet_list->index_count = 0;
+    }
+}
@@ -0,0 +1,39 @@
+#ifndef MESHLET_H
+#define MESHLET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "mesh.h"
+
+enum { MESHLET_MAX_VERTICES  = 64  };
+enum { MESHLET_MAX_TRIANGLES = 124 };
+
+// layout matches the meshlet struct in cluster_cull.comp.glsl (std430)
+struct meshlet
+{
+    float    center[3];
+    float    radius;
+
+    float    cone_axis[3];
+    float    cone_cutoff;     // sin of the normal cone half angle, 1.0 when the cone is too wide to cull
+
+    uint32_t first_index;     // into meshlet_list.indices
+    uint32_t index_count;
+    uint32_t vertex_count;
+    uint32_t triangle_count;
+};
+
+struct meshlet_list
+{
+    uint32_t        meshlet_count;
+    struct meshlet* meshlets;
+
+    uint32_t        index_count;
+    uint32_t*       indices;  // triangles of each meshlet are contiguous, indices refer to the source mesh vertices
+};
+
+bool build_meshlets(const struct mesh* mesh, struct meshlet_list* meshlet_list);
+void free_meshlets(struct meshlet_list* meshlet_list);
+
+#endif // MESHLET_H
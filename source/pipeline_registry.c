@@ -0,0 +1,604 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL2/SDL.h>
+
+#include "gpu_image.h"
+#include "logger.h"
+#include "mesh.h"
+#include "pipeline_registry.h"
+#include "vk_context.h"
+
+enum { PIPELINE_STATE_EMPTY, PIPELINE_STATE_PENDING, PIPELINE_STATE_READY, PIPELINE_STATE_FAILED };
+
+struct pipeline_entry
+{
+    struct pipeline_desc desc;
+    uint64_t             hash;
+    uint32_t             state;
+    VkPipeline           pipeline;
+};
+
+struct pipeline_registry
+{
+    struct pipeline_entry entries[PIPELINE_REGISTRY_SIZE];
+
+    // every entry is queued at most once, the ring can not overflow
+    uint32_t              queue[PIPELINE_REGISTRY_SIZE];
+    uint32_t              queue_head;
+    uint32_t              queue_count;
+
+    VkPipelineCache       cache;
+    const char*           cache_path;
+
+    SDL_mutex*            mutex;
+    SDL_cond*             job_cond;
+    SDL_cond*             ready_cond;
+    SDL_Thread*           threads[PIPELINE_REGISTRY_THREAD_COUNT];
+    bool                  quit;
+
+    uint32_t              request_count;
+    uint32_t              fallback_count;
+} g_pipeline_registry;
+
+// FNV-1a
+static uint64_t hash_pipeline_desc(const struct pipeline_desc* desc)
+{
+    const uint8_t* bytes = (const uint8_t*) desc;
+
+    uint64_t hash = 0xCBF29CE484222325ull;
+
+    for(size_t i = 0; i < sizeof(struct pipeline_desc); i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+
+    return hash;
+}
+
+static bool compile_pipeline(const struct pipeline_desc* desc, VkPipeline* pipeline)
+{
+    bool status = true;
+
+    VkSpecializationMapEntry specialization_map_entries[PIPELINE_SPECIALIZATION_CONSTANT_COUNT];
+
+    for(uint32_t i = 0; i < PIPELINE_SPECIALIZATION_CONSTANT_COUNT; i++)
+    {
+        specialization_map_entries[i].constantID = i;
+        specialization_map_entries[i].offset = i * sizeof(uint32_t);
+        specialization_map_entries[i].size = sizeof(uint32_t);
+    }
+
+    VkSpecializationInfo specialization_info;
+    specialization_info.mapEntryCount = PIPELINE_SPECIALIZATION_CONSTANT_COUNT;
+    specialization_info.pMapEntries = specialization_map_entries;
+    specialization_info.dataSize = sizeof(desc->specialization);
+    specialization_info.pData = desc->specialization;
+
+    VkPipelineShaderStageCreateInfo pipeline_shader_stage_create_info[2];
+
+    pipeline_shader_stage_create_info[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_shader_stage_create_info[0].pNext = NULL;
+    pipeline_shader_stage_create_info[0].flags = 0;
+    pipeline_shader_stage_create_info[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    pipeline_shader_stage_create_info[0].module = desc->vertex_shader;
+    pipeline_shader_stage_create_info[0].pName = "main";
+    pipeline_shader_stage_create_info[0].pSpecializationInfo = &specialization_info;
+
+    pipeline_shader_stage_create_info[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    pipeline_shader_stage_create_info[1].pNext = NULL;
+    pipeline_shader_stage_create_info[1].flags = 0;
+    pipeline_shader_stage_create_info[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    pipeline_shader_stage_create_info[1].module = desc->fragment_shader;
+    pipeline_shader_stage_create_info[1].pName = "main";
+    pipeline_shader_stage_create_info[1].pSpecializationInfo = &specialization_info;
+
+    VkVertexInputBindingDescription vertex_binding_description;
+    vertex_binding_description.binding = 0;
+    vertex_binding_description.stride = sizeof(struct vertex);
+    vertex_binding_description.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+    VkVertexInputAttributeDescription vertex_attribute_descriptions[2];
+    vertex_attribute_descriptions[0].location = 0;
+    vertex_attribute_descriptions[0].binding = 0;
+    vertex_attribute_descriptions[0].format = VK_FORMAT_R32G32B32_SFLOAT;
+    vertex_attribute_descriptions[0].offset = offsetof(struct vertex, position);
+    vertex_attribute_descriptions[1].location = 1;
+    vertex_attribute_descriptions[1].binding = 0;
+    vertex_attribute_descriptions[1].format = VK_FORMAT_R32G32B32_SFLOAT;
+    vertex_attribute_descriptions[1].offset = offsetof(struct vertex, color);
+
+    VkPipelineVertexInputStateCreateInfo pipeline_vertex_input_state_info;
+    pipeline_vertex_input_state_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    pipeline_vertex_input_state_info.pNext = NULL;
+    pipeline_vertex_input_state_info.flags = 0;
+    pipeline_vertex_input_state_info.vertexBindingDescriptionCount = 1;
+    pipeline_vertex_input_state_info.pVertexBindingDescriptions = &vertex_binding_description;
+    pipeline_vertex_input_state_info.vertexAttributeDescriptionCount = 2;
+    pipeline_vertex_input_state_info.pVertexAttributeDescriptions = vertex_attribute_descriptions;
+
+    VkPipelineInputAssemblyStateCreateInfo pipeline_input_assembly_state_info;
+    pipeline_input_assembly_state_info.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+    pipeline_input_assembly_state_info.pNext = NULL;
+    pipeline_input_assembly_state_info.flags = 0;
+    pipeline_input_assembly_state_info.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    pipeline_input_assembly_state_info.primitiveRestartEnable = VK_FALSE;
+
+    // viewport and scissor are dynamic and set from the swapchain extent every frame, a resize never
+    // needs a new pipeline
+    VkPipelineViewportStateCreateInfo pipeline_viewport_state_info;
+    pipeline_viewport_state_info.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    pipeline_viewport_state_info.pNext = NULL;
+    pipeline_viewport_state_info.flags = 0;
+    pipeline_viewport_state_info.viewportCount = 1;
+    pipeline_viewport_state_info.pViewports = NULL;
+    pipeline_viewport_state_info.scissorCount = 1;
+    pipeline_viewport_state_info.pScissors = NULL;
+
+    VkPipelineRasterizationStateCreateInfo pipeline_rasterization_state_info;
+    pipeline_rasterization_state_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+    pipeline_rasterization_state_info.pNext = NULL;
+    pipeline_rasterization_state_info.flags = 0;
+    pipeline_rasterization_state_info.depthClampEnable = VK_FALSE;
+    pipeline_rasterization_state_info.rasterizerDiscardEnable = VK_FALSE;
+    pipeline_rasterization_state_info.polygonMode = desc->polygon_mode;
+    pipeline_rasterization_state_info.cullMode = desc->cull_mode;
+    pipeline_rasterization_state_info.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    pipeline_rasterization_state_info.depthBiasEnable = VK_FALSE;
+    pipeline_rasterization_state_info.depthBiasConstantFactor = 0.0f;
+    pipeline_rasterization_state_info.depthBiasClamp = 0.0f;
+    pipeline_rasterization_state_info.depthBiasSlopeFactor = 0.0f;
+    pipeline_rasterization_state_info.lineWidth = 1.0f;
+
+    VkPipelineMultisampleStateCreateInfo pipeline_multisample_state_info;
+    pipeline_multisample_state_info.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+    pipeline_multisample_state_info.pNext = NULL;
+    pipeline_multisample_state_info.flags = 0;
+    pipeline_multisample_state_info.rasterizationSamples = desc->samples;
+    pipeline_multisample_state_info.sampleShadingEnable = VK_FALSE;
+    pipeline_multisample_state_info.minSampleShading = 1.0f;
+    pipeline_multisample_state_info.pSampleMask = NULL;
+    pipeline_multisample_state_info.alphaToCoverageEnable = VK_FALSE;
+    pipeline_multisample_state_info.alphaToOneEnable = VK_FALSE;
+
+    VkPipelineDepthStencilStateCreateInfo pipeline_depth_stencil_state_info;
+    pipeline_depth_stencil_state_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+    pipeline_depth_stencil_state_info.pNext = NULL;
+    pipeline_depth_stencil_state_info.flags = 0;
+    pipeline_depth_stencil_state_info.depthTestEnable = VK_TRUE;
+    pipeline_depth_stencil_state_info.depthWriteEnable = desc->depth_write;
+    pipeline_depth_stencil_state_info.depthCompareOp = desc->depth_compare_op;
+    pipeline_depth_stencil_state_info.depthBoundsTestEnable = VK_FALSE;
+    pipeline_depth_stencil_state_info.stencilTestEnable = VK_FALSE;
+    pipeline_depth_stencil_state_info.front.failOp = VK_STENCIL_OP_KEEP;
+    pipeline_depth_stencil_state_info.front.passOp = VK_STENCIL_OP_KEEP;
+    pipeline_depth_stencil_state_info.front.depthFailOp = VK_STENCIL_OP_KEEP;
+    pipeline_depth_stencil_state_info.front.compareOp = VK_COMPARE_OP_ALWAYS;
+    pipeline_depth_stencil_state_info.front.compareMask = 0;
+    pipeline_depth_stencil_state_info.front.writeMask = 0;
+    pipeline_depth_stencil_state_info.front.reference = 0;
+    pipeline_depth_stencil_state_info.back = pipeline_depth_stencil_state_info.front;
+    pipeline_depth_stencil_state_info.minDepthBounds = 0.0f;
+    pipeline_depth_stencil_state_info.maxDepthBounds = 1.0f;
+
+    VkPipelineColorBlendAttachmentState pipeline_color_blend_attachment_state;
+    pipeline_color_blend_attachment_state.blendEnable = VK_FALSE;
+    pipeline_color_blend_attachment_state.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+    pipeline_color_blend_attachment_state.dstColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+    pipeline_color_blend_attachment_state.colorBlendOp = VK_BLEND_OP_ADD;
+    pipeline_color_blend_attachment_state.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    pipeline_color_blend_attachment_state.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    pipeline_color_blend_attachment_state.alphaBlendOp = VK_BLEND_OP_ADD;
+    pipeline_color_blend_attachment_state.colorWriteMask = desc->color_write_mask;
+
+    VkPipelineColorBlendStateCreateInfo pipeline_color_blend_state_info;
+    pipeline_color_blend_state_info.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+    pipeline_color_blend_state_info.pNext = NULL;
+    pipeline_color_blend_state_info.flags = 0;
+    pipeline_color_blend_state_info.logicOpEnable = VK_FALSE;
+    pipeline_color_blend_state_info.logicOp = VK_LOGIC_OP_COPY;
+    pipeline_color_blend_state_info.attachmentCount = 1;
+    pipeline_color_blend_state_info.pAttachments = &pipeline_color_blend_attachment_state;
+    pipeline_color_blend_state_info.blendConstants[0] = 0.0f;
+    pipeline_color_blend_state_info.blendConstants[1] = 0.0f;
+    pipeline_color_blend_state_info.blendConstants[2] = 0.0f;
+    pipeline_color_blend_state_info.blendConstants[3] = 0.0f;
+
+    // with extended dynamic state the depth write and compare op are set per pass while recording
+    const VkDynamicState dynamic_states[] =
+    {
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR,
+        VK_DYNAMIC_STATE_DEPTH_WRITE_ENABLE,
+        VK_DYNAMIC_STATE_DEPTH_COMPARE_OP,
+    };
+
+    VkPipelineDynamicStateCreateInfo pipeline_dynamic_state_info;
+    pipeline_dynamic_state_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+    pipeline_dynamic_state_info.pNext = NULL;
+    pipeline_dynamic_state_info.flags = 0;
+    pipeline_dynamic_state_info.dynamicStateCount = vk_ctx->extended_dynamic_state_supported ? 4 : 2;
+    pipeline_dynamic_state_info.pDynamicStates = dynamic_states;
+
+    // the attachment formats take the place of the render pass with dynamic rendering
+    VkPipelineRenderingCreateInfo pipeline_rendering_create_info;
+    pipeline_rendering_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+    pipeline_rendering_create_info.pNext = NULL;
+    pipeline_rendering_create_info.viewMask = 0;
+    pipeline_rendering_create_info.colorAttachmentCount = 1;
+    pipeline_rendering_create_info.pColorAttachmentFormats = &desc->color_format;
+    pipeline_rendering_create_info.depthAttachmentFormat = desc->depth_format;
+    pipeline_rendering_create_info.stencilAttachmentFormat = (get_format_aspect(desc->depth_format) & VK_IMAGE_ASPECT_STENCIL_BIT) ? desc->depth_format : VK_FORMAT_UNDEFINED;
+
+    VkGraphicsPipelineCreateInfo graphics_pipeline_create_info;
+    graphics_pipeline_create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    graphics_pipeline_create_info.pNext = (desc->render_pass == NULL) ? &pipeline_rendering_create_info : NULL;
+    graphics_pipeline_create_info.flags = 0;
+    graphics_pipeline_create_info.stageCount = (desc->fragment_shader != NULL) ? 2 : 1;
+    graphics_pipeline_create_info.pStages = pipeline_shader_stage_create_info;
+    graphics_pipeline_create_info.pVertexInputState = &pipeline_vertex_input_state_info;
+    graphics_pipeline_create_info.pInputAssemblyState = &pipeline_input_assembly_state_info;
+    graphics_pipeline_create_info.pTessellationState = NULL;
+    graphics_pipeline_create_info.pViewportState = &pipeline_viewport_state_info;
+    graphics_pipeline_create_info.pRasterizationState = &pipeline_rasterization_state_info;
+    graphics_pipeline_create_info.pMultisampleState = &pipeline_multisample_state_info;
+    graphics_pipeline_create_info.pDepthStencilState = &pipeline_depth_stencil_state_info;
+    graphics_pipeline_create_info.pColorBlendState = &pipeline_color_blend_state_info;
+    graphics_pipeline_create_info.pDynamicState = &pipeline_dynamic_state_info;
+    graphics_pipeline_create_info.layout = desc->layout;
+    graphics_pipeline_create_info.renderPass = desc->render_pass;
+    graphics_pipeline_create_info.subpass = 0;
+    graphics_pipeline_create_info.basePipelineHandle = NULL;
+    graphics_pipeline_create_info.basePipelineIndex = -1;
+
+    // the pipeline cache is internally synchronized, all compile threads share it
+    if(vk_ctx->create_graphics_pipelines(vk_ctx->device, g_pipeline_registry.cache, 1, &graphics_pipeline_create_info, vk_ctx->allocation_callbacks, pipeline) != VK_SUCCESS)
+    {
+        LOG_ERROR("Could not create graphics pipeline\n");
+        status = false;
+    }
+
+    return status;
+}
+
+static int pipeline_compile_thread(void* data)
+{
+    (void) data;
+
+    SDL_LockMutex(g_pipeline_registry.mutex);
+
+    while(!g_pipeline_registry.quit)
+    {
+        if(g_pipeline_registry.queue_count > 0)
+        {
+            struct pipeline_entry* entry = &g_pipeline_registry.entries[g_pipeline_registry.queue[g_pipeline_registry.queue_head]];
+
+            g_pipeline_registry.queue_head = (g_pipeline_registry.queue_head + 1) % PIPELINE_REGISTRY_SIZE;
+            g_pipeline_registry.queue_count--;
+
+            // the description of a pending entry is never modified, it can be read without the lock
+            SDL_UnlockMutex(g_pipeline_registry.mutex);
+
+            VkPipeline pipeline = NULL;
+            uint64_t start = SDL_GetPerformanceCounter();
+            bool compiled = compile_pipeline(&entry->desc, &pipeline);
+            uint64_t ticks = SDL_GetPerformanceCounter() - start;
+
+            if(compiled)
+            {
+                LOG_INFO("Compiled pipeline %016llx in %.3f ms\n", (unsigned long long) entry->hash, (double) ticks * 1000.0 / (double) SDL_GetPerformanceFrequency());
+            }
+
+            SDL_LockMutex(g_pipeline_registry.mutex);
+
+            entry->pipeline = pipeline;
+            entry->state = compiled ? PIPELINE_STATE_READY : PIPELINE_STATE_FAILED;
+
+            SDL_CondBroadcast(g_pipeline_registry.ready_cond);
+        }
+        else
+        {
+            SDL_CondWait(g_pipeline_registry.job_cond, g_pipeline_registry.mutex);
+        }
+    }
+
+    SDL_UnlockMutex(g_pipeline_registry.mutex);
+
+    return 0;
+}
+
+// looks up the entry for the description and queues a new one on a miss, must be called with the lock held
+static struct pipeline_entry* find_or_queue_pipeline(const struct pipeline_desc* desc)
+{
+    struct pipeline_entry* entry = NULL;
+
+    uint64_t hash = hash_pipeline_desc(desc);
+
+    // open addressing, entries are only removed when the registry is destroyed
+    for(uint32_t i = 0; i < PIPELINE_REGISTRY_SIZE; i++)
+    {
+        uint32_t index = (uint32_t) ((hash + i) % PIPELINE_REGISTRY_SIZE);
+
+        struct pipeline_entry* candidate = &g_pipeline_registry.entries[index];
+
+        if(candidate->state == PIPELINE_STATE_EMPTY)
+        {
+            candidate->desc = *desc;
+            candidate->hash = hash;
+            candidate->state = PIPELINE_STATE_PENDING;
+
+            g_pipeline_registry.queue[(g_pipeline_registry.queue_head + g_pipeline_registry.queue_count) % PIPELINE_REGISTRY_SIZE] = index;
+            g_pipeline_registry.queue_count++;
+
+            SDL_CondSignal(g_pipeline_registry.job_cond);
+
+            entry = candidate;
+            break;
+        }
+        else if((candidate->hash == hash) && (memcmp(&candidate->desc, desc, sizeof(struct pipeline_desc)) == 0))
+        {
+            entry = candidate;
+            break;
+        }
+    }
+
+    if(entry == NULL)
+    {
+        LOG_ERROR("Pipeline registry is full\n");
+    }
+
+    g_pipeline_registry.request_count++;
+
+    return entry;
+}
+
+static void load_pipeline_cache_data(const char* path, void** data, size_t* size)
+{
+    FILE* file = fopen(path, "rb");
+
+    *data = NULL;
+    *size = 0;
+
+    if(file != NULL)
+    {
+        fseek(file, 0, SEEK_END);
+        long file_size = ftell(file);
+        rewind(file);
+
+        if(file_size > 0)
+        {
+            *data = malloc((size_t) file_size);
+
+            if((*data != NULL) && (fread(*data, 1, (size_t) file_size, file) == (size_t) file_size))
+            {
+                *size = (size_t) file_size;
+            }
+        }
+
+        fclose(file);
+        file = NULL;
+    }
+}
+
+static void save_pipeline_cache_data(const char* path)
+{
+    size_t size = 0;
+    void* data = NULL;
+
+    if(vk_ctx->get_pipeline_cache_data(vk_ctx->device, g_pipeline_registry.cache, &size, NULL) == VK_SUCCESS)
+    {
+        data = malloc(size);
+    }
+
+    if((data != NULL) && (vk_ctx->get_pipeline_cache_data(vk_ctx->device, g_pipeline_registry.cache, &size, data) == VK_SUCCESS))
+    {
+        FILE* file = fopen(path, "wb");
+
+        if(file != NULL)
+        {
+            fwrite(data, 1, size, file);
+            fclose(file);
+            file = NULL;
+        }
+        else
+        {
+            LOG_ERROR("Could not write pipeline cache %s\n", path);
+        }
+    }
+
+    if(data != NULL)
+    {
+        free(data);
+        data = NULL;
+    }
+}
+
+bool initialize_pipeline_registry(const char* cache_path)
+{
+    bool status = true;
+
+    void* cache_data = NULL;
+    size_t cache_size = 0;
+
+    memset(&g_pipeline_registry, 0, sizeof(struct pipeline_registry));
+
+    g_pipeline_registry.cache_path = cache_path;
+
+    if(status)
+    {
+        // the driver validates the header and ignores data from a different device or driver version
+        load_pipeline_cache_data(cache_path, &cache_data, &cache_size);
+
+        VkPipelineCacheCreateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        info.pNext = NULL;
+        info.flags = 0;
+        info.initialDataSize = cache_size;
+        info.pInitialData = cache_data;
+
+        if(vk_ctx->create_pipeline_cache(vk_ctx->device, &info, vk_ctx->allocation_callbacks, &g_pipeline_registry.cache) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create pipeline cache\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        g_pipeline_registry.mutex = SDL_CreateMutex();
+        g_pipeline_registry.job_cond = SDL_CreateCond();
+        g_pipeline_registry.ready_cond = SDL_CreateCond();
+
+        if((g_pipeline_registry.mutex == NULL) || (g_pipeline_registry.job_cond == NULL) || (g_pipeline_registry.ready_cond == NULL))
+        {
+            LOG_ERROR("Failed to create pipeline registry synchronization objects\n");
+            status = false;
+        }
+    }
+
+    for(uint32_t i = 0; status && (i < PIPELINE_REGISTRY_THREAD_COUNT); i++)
+    {
+        g_pipeline_registry.threads[i] = SDL_CreateThread(pipeline_compile_thread, "pipeline compile", NULL);
+
+        if(g_pipeline_registry.threads[i] == NULL)
+        {
+            LOG_ERROR("Failed to create pipeline compile thread\n");
+            status = false;
+        }
+    }
+
+    if(cache_data != NULL)
+    {
+        free(cache_data);
+        cache_data = NULL;
+    }
+
+    if(!status)
+    {
+        uninitialize_pipeline_registry();
+    }
+
+    return status;
+}
+
+void uninitialize_pipeline_registry(void)
+{
+    if(g_pipeline_registry.mutex != NULL)
+    {
+        SDL_LockMutex(g_pipeline_registry.mutex);
+        g_pipeline_registry.quit = true;
+        SDL_CondBroadcast(g_pipeline_registry.job_cond);
+        SDL_UnlockMutex(g_pipeline_registry.mutex);
+    }
+
+    for(uint32_t i = 0; i < PIPELINE_REGISTRY_THREAD_COUNT; i++)
+    {
+        if(g_pipeline_registry.threads[i] != NULL)
+        {
+            SDL_WaitThread(g_pipeline_registry.threads[i], NULL);
+            g_pipeline_registry.threads[i] = NULL;
+        }
+    }
+
+    if(g_pipeline_registry.request_count > 0)
+    {
+        LOG_INFO("Pipeline registry: %u requests, %u served by a fallback\n", g_pipeline_registry.request_count, g_pipeline_registry.fallback_count);
+    }
+
+    for(uint32_t i = 0; i < PIPELINE_REGISTRY_SIZE; i++)
+    {
+        if(g_pipeline_registry.entries[i].pipeline != NULL)
+        {
+            vk_ctx->destroy_pipeline(vk_ctx->device, g_pipeline_registry.entries[i].pipeline, vk_ctx->allocation_callbacks);
+            g_pipeline_registry.entries[i].pipeline = NULL;
+        }
+
+        g_pipeline_registry.entries[i].state = PIPELINE_STATE_EMPTY;
+    }
+
+    if(g_pipeline_registry.cache != NULL)
+    {
+        save_pipeline_cache_data(g_pipeline_registry.cache_path);
+
+        vk_ctx->destroy_pipeline_cache(vk_ctx->device, g_pipeline_registry.cache, vk_ctx->allocation_callbacks);
+        g_pipeline_registry.cache = NULL;
+    }
+
+    if(g_pipeline_registry.ready_cond != NULL)
+    {
+        SDL_DestroyCond(g_pipeline_registry.ready_cond);
+        g_pipeline_registry.ready_cond = NULL;
+    }
+
+    if(g_pipeline_registry.job_cond != NULL)
+    {
+        SDL_DestroyCond(g_pipeline_registry.job_cond);
+        g_pipeline_registry.job_cond = NULL;
+    }
+
+    if(g_pipeline_registry.mutex != NULL)
+    {
+        SDL_DestroyMutex(g_pipeline_registry.mutex);
+        g_pipeline_registry.mutex = NULL;
+    }
+}
+
+void init_pipeline_desc(struct pipeline_desc* desc)
+{
+    memset(desc, 0, sizeof(struct pipeline_desc));
+
+    desc->samples = VK_SAMPLE_COUNT_1_BIT;
+    desc->polygon_mode = VK_POLYGON_MODE_FILL;
+    desc->cull_mode = VK_CULL_MODE_BACK_BIT;
+    desc->depth_write = VK_TRUE;
+    desc->depth_compare_op = VK_COMPARE_OP_LESS;
+    desc->color_write_mask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+}
+
+VkPipeline get_pipeline(const struct pipeline_desc* desc, VkPipeline fallback)
+{
+    VkPipeline pipeline = fallback;
+
+    SDL_LockMutex(g_pipeline_registry.mutex);
+
+    struct pipeline_entry* entry = find_or_queue_pipeline(desc);
+
+    if((entry != NULL) && (entry->state == PIPELINE_STATE_READY))
+    {
+        pipeline = entry->pipeline;
+    }
+    else
+    {
+        g_pipeline_registry.fallback_count++;
+    }
+
+    SDL_UnlockMutex(g_pipeline_registry.mutex);
+
+    return pipeline;
+}
+
+VkPipeline get_pipeline_blocking(const struct pipeline_desc* desc)
+{
+    VkPipeline pipeline = NULL;
+
+    SDL_LockMutex(g_pipeline_registry.mutex);
+
+    struct pipeline_entry* entry = find_or_queue_pipeline(desc);
+
+    while((entry != NULL) && (entry->state == PIPELINE_STATE_PENDING))
+    {
+        SDL_CondWait(g_pipeline_registry.ready_cond, g_pipeline_registry.mutex);
+    }
+
+    if((entry != NULL) && (entry->state == PIPELINE_STATE_READY))
+    {
+        pipeline = entry->pipeline;
+    }
+
+    SDL_UnlockMutex(g_pipeline_registry.mutex);
+
+    return pipeline;
+}
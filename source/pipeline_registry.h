@@ -0,0 +1,50 @@
+#ifndef PIPELINE_REGISTRY_H
+#define PIPELINE_REGISTRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+enum { PIPELINE_REGISTRY_SIZE         = 64 };
+enum { PIPELINE_REGISTRY_THREAD_COUNT = 2 };
+
+enum { PIPELINE_SPECIALIZATION_CONSTANT_COUNT = 4 };
+
+// everything that distinguishes two graphics pipelines, all of them consume struct vertex and use
+// dynamic viewport and scissor. the description is hashed and compared bytewise, always start from
+// init_pipeline_desc so that the padding is zeroed
+struct pipeline_desc
+{
+    VkShaderModule        vertex_shader;
+    VkShaderModule        fragment_shader; // NULL for depth only pipelines
+    VkPipelineLayout      layout;
+    VkRenderPass          render_pass;     // NULL to render with dynamic rendering
+    VkFormat              color_format;
+    VkFormat              depth_format;
+    VkSampleCountFlagBits samples;         // of the color and depth attachments
+    VkPolygonMode         polygon_mode;
+    VkCullModeFlags       cull_mode;
+    VkBool32              depth_write;
+    VkCompareOp           depth_compare_op;
+    VkColorComponentFlags color_write_mask;
+
+    // 32 bit specialization constants with ids 0 to PIPELINE_SPECIALIZATION_CONSTANT_COUNT - 1, passed to
+    // every stage. a stage ignores the ids that its module does not declare
+    uint32_t              specialization[PIPELINE_SPECIALIZATION_CONSTANT_COUNT];
+};
+
+// the compiled pipelines are shared through one VkPipelineCache that is loaded from and saved to cache_path
+bool initialize_pipeline_registry(const char* cache_path);
+void uninitialize_pipeline_registry(void);
+
+void init_pipeline_desc(struct pipeline_desc* desc);
+
+// returns the pipeline for the description if it is compiled, otherwise queues it for compilation on a
+// background thread and returns the fallback
+VkPipeline get_pipeline(const struct pipeline_desc* desc, VkPipeline fallback);
+
+// waits until the pipeline is compiled, returns NULL if the compilation failed
+VkPipeline get_pipeline_blocking(const struct pipeline_desc* desc);
+
+#endif // PIPELINE_REGISTRY_H
@@ -0,0 +1,632 @@
+#include <string.h>
+
+#include <SDL2/SDL.h>
+
+#include "gpu_buffer.h"
+#include "logger.h"
+#include "queue_scheduler.h"
+#include "vk_context.h"
+
+enum { PRIORITY_TEST_LOAD_SIZE  = 64 * 1024 * 1024 };
+enum { PRIORITY_TEST_LOAD_FILLS = 32 };
+enum { PRIORITY_TEST_PROBE_SIZE = 256 };
+
+// the graphics queues followed by the compute queue
+enum { SCHEDULER_QUEUE_COUNT = VK_CTX_NUM_GRAPHICS_QUEUES + 1 };
+enum { SCHEDULER_COMPUTE_QUEUE = VK_CTX_NUM_GRAPHICS_QUEUES };
+
+// the semaphores of one submission, the binary semaphores are listed after the timelines and their values are
+// ignored
+struct queue_batch
+{
+    uint32_t             wait_count;
+    VkSemaphore          wait_semaphores[QUEUE_SUBMISSION_MAX_WAITS + 1];
+    uint64_t             wait_values[QUEUE_SUBMISSION_MAX_WAITS + 1];
+    VkPipelineStageFlags wait_stages[QUEUE_SUBMISSION_MAX_WAITS + 1];
+    uint32_t             signal_count;
+    VkSemaphore          signal_semaphores[2];
+    uint64_t             signal_values[2];
+};
+
+typedef VkResult (*submit_batch_function)(VkQueue queue, const struct queue_submission* submission, const struct queue_batch* batch);
+
+struct queue_scheduler
+{
+    uint32_t   queue_indices[QUEUE_CLASS_COUNT];
+
+    // one lock per queue, classes that share a queue share the lock
+    VkQueue    queues[SCHEDULER_QUEUE_COUNT];
+    uint32_t   queue_families[SCHEDULER_QUEUE_COUNT];
+    SDL_mutex* locks[SCHEDULER_QUEUE_COUNT];
+
+    // one timeline per queue, the value of the last submission is only accessed under the lock of the queue
+    VkSemaphore timelines[SCHEDULER_QUEUE_COUNT];
+    uint64_t    submitted_values[SCHEDULER_QUEUE_COUNT];
+
+    // chosen once at initialization from the capabilities of vk_ctx
+    submit_batch_function submit_batch;
+
+    uint32_t   submit_counts[QUEUE_CLASS_COUNT];
+} g_queue_scheduler;
+
+static const char* queue_class_names[QUEUE_CLASS_COUNT] = { "frame", "bulk", "compute" };
+
+static VkResult submit_batch(VkQueue queue, const struct queue_submission* submission, const struct queue_batch* batch)
+{
+    VkTimelineSemaphoreSubmitInfo timeline_info;
+    timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timeline_info.pNext = NULL;
+    timeline_info.waitSemaphoreValueCount = batch->wait_count;
+    timeline_info.pWaitSemaphoreValues = batch->wait_values;
+    timeline_info.signalSemaphoreValueCount = batch->signal_count;
+    timeline_info.pSignalSemaphoreValues = batch->signal_values;
+
+    VkSubmitInfo submit_info;
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.pNext = &timeline_info;
+    submit_info.waitSemaphoreCount = batch->wait_count;
+    submit_info.pWaitSemaphores = batch->wait_semaphores;
+    submit_info.pWaitDstStageMask = batch->wait_stages;
+    submit_info.commandBufferCount = submission->command_buffer_count;
+    submit_info.pCommandBuffers = submission->command_buffers;
+    submit_info.signalSemaphoreCount = batch->signal_count;
+    submit_info.pSignalSemaphores = batch->signal_semaphores;
+
+    return vk_ctx->queue_submit(queue, 1, &submit_info, NULL);
+}
+
+// synchronization2 takes the values with the semaphores and the signals are scoped to the stages that write
+static VkResult submit_batch2(VkQueue queue, const struct queue_submission* submission, const struct queue_batch* batch)
+{
+    VkSemaphoreSubmitInfo wait_infos[QUEUE_SUBMISSION_MAX_WAITS + 1];
+    VkSemaphoreSubmitInfo signal_infos[2];
+    VkCommandBufferSubmitInfo command_buffer_infos[QUEUE_SUBMISSION_MAX_COMMAND_BUFFERS];
+
+    if(submission->command_buffer_count > QUEUE_SUBMISSION_MAX_COMMAND_BUFFERS)
+    {
+        LOG_ERROR("Too many command buffers in one submission\n");
+        return VK_ERROR_INITIALIZATION_FAILED;
+    }
+
+    for(uint32_t i = 0; i < batch->wait_count; i++)
+    {
+        wait_infos[i].sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+        wait_infos[i].pNext = NULL;
+        wait_infos[i].semaphore = batch->wait_semaphores[i];
+        wait_infos[i].value = batch->wait_values[i];
+        wait_infos[i].stageMask = batch->wait_stages[i];
+        wait_infos[i].deviceIndex = 0;
+    }
+
+    for(uint32_t i = 0; i < batch->signal_count; i++)
+    {
+        signal_infos[i].sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+        signal_infos[i].pNext = NULL;
+        signal_infos[i].semaphore = batch->signal_semaphores[i];
+        signal_infos[i].value = batch->signal_values[i];
+        signal_infos[i].stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        signal_infos[i].deviceIndex = 0;
+    }
+
+    for(uint32_t i = 0; i < submission->command_buffer_count; i++)
+    {
+        command_buffer_infos[i].sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+        command_buffer_infos[i].pNext = NULL;
+        command_buffer_infos[i].commandBuffer = submission->command_buffers[i];
+        command_buffer_infos[i].deviceMask = 0;
+    }
+
+    VkSubmitInfo2 submit_info;
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+    submit_info.pNext = NULL;
+    submit_info.flags = 0;
+    submit_info.waitSemaphoreInfoCount = batch->wait_count;
+    submit_info.pWaitSemaphoreInfos = wait_infos;
+    submit_info.commandBufferInfoCount = submission->command_buffer_count;
+    submit_info.pCommandBufferInfos = command_buffer_infos;
+    submit_info.signalSemaphoreInfoCount = batch->signal_count;
+    submit_info.pSignalSemaphoreInfos = signal_infos;
+
+    return vk_ctx->queue_submit2(queue, 1, &submit_info, NULL);
+}
+
+bool initialize_queue_scheduler(void)
+{
+    bool status = true;
+
+    memset(&g_queue_scheduler, 0, sizeof(struct queue_scheduler));
+
+    for(uint32_t i = 0; i < vk_ctx->graphics_queue_count; i++)
+    {
+        g_queue_scheduler.queues[i] = vk_ctx->graphics_queues[i];
+        g_queue_scheduler.queue_families[i] = vk_ctx->graphics_queue_family;
+    }
+
+    g_queue_scheduler.queues[SCHEDULER_COMPUTE_QUEUE] = vk_ctx->compute_queue;
+    g_queue_scheduler.queue_families[SCHEDULER_COMPUTE_QUEUE] = vk_ctx->compute_queue_family;
+
+    for(uint32_t i = 0; status && (i < SCHEDULER_QUEUE_COUNT); i++)
+    {
+        if(g_queue_scheduler.queues[i] == NULL)
+        {
+            continue;
+        }
+
+        g_queue_scheduler.locks[i] = SDL_CreateMutex();
+
+        if(g_queue_scheduler.locks[i] == NULL)
+        {
+            LOG_ERROR("Failed to create queue lock\n");
+            status = false;
+        }
+
+        if(status)
+        {
+            VkSemaphoreTypeCreateInfo type_info;
+            type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+            type_info.pNext = NULL;
+            type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+            type_info.initialValue = 0;
+
+            VkSemaphoreCreateInfo info;
+            info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            info.pNext = &type_info;
+            info.flags = 0;
+
+            if(vk_ctx->create_semaphore(vk_ctx->device, &info, vk_ctx->allocation_callbacks, &g_queue_scheduler.timelines[i]) != VK_SUCCESS)
+            {
+                LOG_ERROR("Failed to create queue timeline\n");
+                status = false;
+            }
+        }
+    }
+
+    if(status)
+    {
+        uint32_t highest = 0;
+        uint32_t lowest = 0;
+
+        for(uint32_t i = 1; i < vk_ctx->graphics_queue_count; i++)
+        {
+            if(vk_ctx->graphics_queue_priorities[i] > vk_ctx->graphics_queue_priorities[highest])
+            {
+                highest = i;
+            }
+
+            // on equal priorities prefer a queue other than the frame queue
+            if(vk_ctx->graphics_queue_priorities[i] <= vk_ctx->graphics_queue_priorities[lowest])
+            {
+                lowest = i;
+            }
+        }
+
+        if((lowest == highest) && (vk_ctx->graphics_queue_count > 1))
+        {
+            lowest = (highest + 1) % vk_ctx->graphics_queue_count;
+        }
+
+        g_queue_scheduler.queue_indices[QUEUE_CLASS_FRAME] = highest;
+        g_queue_scheduler.queue_indices[QUEUE_CLASS_BULK] = lowest;
+        g_queue_scheduler.queue_indices[QUEUE_CLASS_COMPUTE] = vk_ctx->async_compute_supported ? SCHEDULER_COMPUTE_QUEUE : lowest;
+
+        g_queue_scheduler.submit_batch = vk_ctx->synchronization2_supported ? submit_batch2 : submit_batch;
+
+        LOG_INFO("Queue scheduler: submit with %s\n", vk_ctx->synchronization2_supported ? "vkQueueSubmit2" : "vkQueueSubmit");
+
+        for(uint32_t i = 0; i < QUEUE_CLASS_COUNT; i++)
+        {
+            uint32_t queue_index = g_queue_scheduler.queue_indices[i];
+
+            if(queue_index == SCHEDULER_COMPUTE_QUEUE)
+            {
+                LOG_INFO("Queue scheduler: %s work on the async compute queue\n", queue_class_names[i]);
+            }
+            else
+            {
+                LOG_INFO("Queue scheduler: %s work on queue %u (priority %.2f)\n", queue_class_names[i], queue_index, vk_ctx->graphics_queue_priorities[queue_index]);
+            }
+        }
+    }
+    else
+    {
+        uninitialize_queue_scheduler();
+    }
+
+    return status;
+}
+
+void uninitialize_queue_scheduler(void)
+{
+    for(uint32_t i = 0; i < QUEUE_CLASS_COUNT; i++)
+    {
+        if(g_queue_scheduler.submit_counts[i] > 0)
+        {
+            LOG_INFO("Queue scheduler: %u %s submissions\n", g_queue_scheduler.submit_counts[i], queue_class_names[i]);
+        }
+    }
+
+    for(uint32_t i = 0; i < SCHEDULER_QUEUE_COUNT; i++)
+    {
+        if(g_queue_scheduler.timelines[i] != NULL)
+        {
+            vk_ctx->destroy_semaphore(vk_ctx->device, g_queue_scheduler.timelines[i], vk_ctx->allocation_callbacks);
+            g_queue_scheduler.timelines[i] = NULL;
+        }
+
+        if(g_queue_scheduler.locks[i] != NULL)
+        {
+            SDL_DestroyMutex(g_queue_scheduler.locks[i]);
+            g_queue_scheduler.locks[i] = NULL;
+        }
+    }
+}
+
+uint32_t get_queue_family(enum queue_class queue_class)
+{
+    return g_queue_scheduler.queue_families[g_queue_scheduler.queue_indices[queue_class]];
+}
+
+void init_queue_submission(struct queue_submission* submission, uint32_t command_buffer_count, const VkCommandBuffer* command_buffers)
+{
+    memset(submission, 0, sizeof(struct queue_submission));
+
+    submission->command_buffer_count = command_buffer_count;
+    submission->command_buffers = command_buffers;
+}
+
+void add_queue_submission_wait(struct queue_submission* submission, const struct queue_point* point, VkPipelineStageFlags stages)
+{
+    if(point->value > 0)
+    {
+        uint32_t queue_index = g_queue_scheduler.queue_indices[point->queue_class];
+        uint32_t i = 0;
+
+        // classes that share a queue share the timeline, a single wait for the later value covers both
+        while(i < submission->wait_point_count)
+        {
+            if(g_queue_scheduler.queue_indices[submission->wait_points[i].queue_class] == queue_index)
+            {
+                break;
+            }
+
+            i++;
+        }
+
+        if(i < submission->wait_point_count)
+        {
+            if(point->value > submission->wait_points[i].value)
+            {
+                submission->wait_points[i].value = point->value;
+            }
+
+            submission->wait_stages[i] |= stages;
+        }
+        else if(i < QUEUE_SUBMISSION_MAX_WAITS)
+        {
+            submission->wait_points[i] = *point;
+            submission->wait_stages[i] = stages;
+            submission->wait_point_count++;
+        }
+        else
+        {
+            LOG_ERROR("Too many waits in one submission\n");
+        }
+    }
+}
+
+bool submit_to_queue(enum queue_class queue_class, const struct queue_submission* submission, struct queue_point* point)
+{
+    bool status = true;
+
+    uint32_t queue_index = g_queue_scheduler.queue_indices[queue_class];
+
+    struct queue_batch batch;
+    batch.wait_count = 0;
+    batch.signal_count = 1;
+
+    for(uint32_t i = 0; i < submission->wait_point_count; i++)
+    {
+        batch.wait_semaphores[batch.wait_count] = g_queue_scheduler.timelines[g_queue_scheduler.queue_indices[submission->wait_points[i].queue_class]];
+        batch.wait_values[batch.wait_count] = submission->wait_points[i].value;
+        batch.wait_stages[batch.wait_count] = submission->wait_stages[i];
+        batch.wait_count++;
+    }
+
+    if(submission->acquire_semaphore != NULL)
+    {
+        batch.wait_semaphores[batch.wait_count] = submission->acquire_semaphore;
+        batch.wait_values[batch.wait_count] = 0;
+        batch.wait_stages[batch.wait_count] = submission->acquire_stage;
+        batch.wait_count++;
+    }
+
+    batch.signal_semaphores[0] = g_queue_scheduler.timelines[queue_index];
+    batch.signal_values[1] = 0;
+
+    if(submission->present_semaphore != NULL)
+    {
+        batch.signal_semaphores[batch.signal_count] = submission->present_semaphore;
+        batch.signal_count++;
+    }
+
+    SDL_LockMutex(g_queue_scheduler.locks[queue_index]);
+
+    // values are taken under the lock so they increase in submission order
+    uint64_t value = g_queue_scheduler.submitted_values[queue_index] + 1;
+    batch.signal_values[0] = value;
+
+    if(g_queue_scheduler.submit_batch(g_queue_scheduler.queues[queue_index], submission, &batch) == VK_SUCCESS)
+    {
+        g_queue_scheduler.submitted_values[queue_index] = value;
+        g_queue_scheduler.submit_counts[queue_class]++;
+    }
+    else
+    {
+        LOG_ERROR("Failed to submit %s work\n", queue_class_names[queue_class]);
+        status = false;
+    }
+
+    SDL_UnlockMutex(g_queue_scheduler.locks[queue_index]);
+
+    if(status && (point != NULL))
+    {
+        point->queue_class = queue_class;
+        point->value = value;
+    }
+
+    return status;
+}
+
+VkResult present_to_queue(const VkPresentInfoKHR* present_info)
+{
+    uint32_t queue_index = g_queue_scheduler.queue_indices[QUEUE_CLASS_FRAME];
+
+    SDL_LockMutex(g_queue_scheduler.locks[queue_index]);
+
+    VkResult result = vk_ctx->queue_present(g_queue_scheduler.queues[queue_index], present_info);
+
+    SDL_UnlockMutex(g_queue_scheduler.locks[queue_index]);
+
+    return result;
+}
+
+void get_last_queue_point(enum queue_class queue_class, struct queue_point* point)
+{
+    uint32_t queue_index = g_queue_scheduler.queue_indices[queue_class];
+
+    SDL_LockMutex(g_queue_scheduler.locks[queue_index]);
+
+    point->queue_class = queue_class;
+    point->value = g_queue_scheduler.submitted_values[queue_index];
+
+    SDL_UnlockMutex(g_queue_scheduler.locks[queue_index]);
+}
+
+VkSemaphore get_queue_timeline(enum queue_class queue_class)
+{
+    return g_queue_scheduler.timelines[g_queue_scheduler.queue_indices[queue_class]];
+}
+
+bool is_queue_point_reached(const struct queue_point* point)
+{
+    bool reached = true;
+
+    if(point->value > 0)
+    {
+        uint64_t value = 0;
+
+        VkSemaphore timeline = g_queue_scheduler.timelines[g_queue_scheduler.queue_indices[point->queue_class]];
+
+        reached = (vk_ctx->get_semaphore_counter_value(vk_ctx->device, timeline, &value) == VK_SUCCESS) && (value >= point->value);
+    }
+
+    return reached;
+}
+
+bool wait_for_queue_point(const struct queue_point* point)
+{
+    bool status = true;
+
+    if(point->value > 0)
+    {
+        VkSemaphoreWaitInfo info;
+        info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        info.pNext = NULL;
+        info.flags = 0;
+        info.semaphoreCount = 1;
+        info.pSemaphores = &g_queue_scheduler.timelines[g_queue_scheduler.queue_indices[point->queue_class]];
+        info.pValues = &point->value;
+
+        if(vk_ctx->wait_semaphores(vk_ctx->device, &info, UINT64_MAX) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to wait for %s work\n", queue_class_names[point->queue_class]);
+            status = false;
+        }
+    }
+
+    return status;
+}
+
+static bool record_fills(VkCommandBuffer command_buffer, VkBuffer buffer, VkDeviceSize size, uint32_t fill_count)
+{
+    bool status = true;
+
+    VkCommandBufferBeginInfo info;
+    info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    info.pNext = NULL;
+    info.flags = 0;
+    info.pInheritanceInfo = NULL;
+
+    if(vk_ctx->begin_command_buffer(command_buffer, &info) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to begin command buffer\n");
+        status = false;
+    }
+
+    if(status)
+    {
+        for(uint32_t i = 0; i < fill_count; i++)
+        {
+            vk_ctx->cmd_fill_buffer(command_buffer, buffer, 0, size, i);
+        }
+
+        if(vk_ctx->end_command_buffer(command_buffer) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to end command buffer\n");
+            status = false;
+        }
+    }
+
+    return status;
+}
+
+// submits the probe while the load is running and returns the time until the probe completed in milliseconds
+static bool measure_probe_latency(VkCommandBuffer load, VkCommandBuffer probe, enum queue_class probe_class, double* latency)
+{
+    bool status = true;
+
+    struct queue_submission submission;
+    struct queue_point load_point = { QUEUE_CLASS_BULK, 0 };
+    struct queue_point probe_point = { probe_class, 0 };
+
+    uint64_t start = 0;
+
+    if(status)
+    {
+        init_queue_submission(&submission, 1, &load);
+        status = submit_to_queue(QUEUE_CLASS_BULK, &submission, &load_point);
+    }
+
+    if(status)
+    {
+        init_queue_submission(&submission, 1, &probe);
+        start = SDL_GetPerformanceCounter();
+        status = submit_to_queue(probe_class, &submission, &probe_point);
+    }
+
+    if(status)
+    {
+        status = wait_for_queue_point(&probe_point);
+
+        *latency = (double) (SDL_GetPerformanceCounter() - start) * 1000.0 / (double) SDL_GetPerformanceFrequency();
+    }
+
+    if(status)
+    {
+        status = wait_for_queue_point(&load_point);
+    }
+
+    return status;
+}
+
+bool run_queue_priority_test(uint32_t iterations)
+{
+    bool status = true;
+
+    struct gpu_buffer load_buffer = { 0 };
+    struct gpu_buffer probe_buffer = { 0 };
+
+    VkCommandBuffer command_buffers[2] = { NULL, NULL };
+
+    double latencies[QUEUE_CLASS_COUNT] = { 0.0, 0.0 };
+    double max_latencies[QUEUE_CLASS_COUNT] = { 0.0, 0.0 };
+
+    if(g_queue_scheduler.queue_indices[QUEUE_CLASS_FRAME] == g_queue_scheduler.queue_indices[QUEUE_CLASS_BULK])
+    {
+        LOG_ERROR("Queue priority test needs two graphics queues, the device provides %u\n", vk_ctx->graphics_queue_count);
+        status = false;
+    }
+
+    if(status)
+    {
+        status = create_gpu_buffer(PRIORITY_TEST_LOAD_SIZE, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &load_buffer);
+    }
+
+    if(status)
+    {
+        status = create_gpu_buffer(PRIORITY_TEST_PROBE_SIZE, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &probe_buffer);
+    }
+
+    if(status)
+    {
+        VkCommandBufferAllocateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        info.pNext = NULL;
+        info.commandPool = vk_ctx->command_pool;
+        info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        info.commandBufferCount = 2;
+
+        if(vk_ctx->allocate_command_buffers(vk_ctx->device, &info, command_buffers) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to allocate command buffers\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        status = record_fills(command_buffers[0], load_buffer.handle, PRIORITY_TEST_LOAD_SIZE, PRIORITY_TEST_LOAD_FILLS);
+    }
+
+    if(status)
+    {
+        status = record_fills(command_buffers[1], probe_buffer.handle, PRIORITY_TEST_PROBE_SIZE, 1);
+    }
+
+    // the probe runs on the frame queue, then queued behind the load on the bulk queue
+    for(uint32_t probe_class = 0; status && (probe_class <= QUEUE_CLASS_BULK); probe_class++)
+    {
+        for(uint32_t i = 0; status && (i < iterations); i++)
+        {
+            double latency = 0.0;
+
+            status = measure_probe_latency(command_buffers[0], command_buffers[1], probe_class, &latency);
+
+            latencies[probe_class] += latency;
+
+            if(latency > max_latencies[probe_class])
+            {
+                max_latencies[probe_class] = latency;
+            }
+        }
+    }
+
+    if(status && (iterations > 0))
+    {
+        double frame_latency = latencies[QUEUE_CLASS_FRAME] / (double) iterations;
+        double bulk_latency = latencies[QUEUE_CLASS_BULK] / (double) iterations;
+
+        LOG_INFO("Queue priority test, %u iterations under %u MiB of fills:\n", iterations, (PRIORITY_TEST_LOAD_SIZE >> 20) * PRIORITY_TEST_LOAD_FILLS);
+        LOG_INFO("\tFrame queue: %.3f ms average, %.3f ms max\n", frame_latency, max_latencies[QUEUE_CLASS_FRAME]);
+        LOG_INFO("\tBulk queue: %.3f ms average, %.3f ms max\n", bulk_latency, max_latencies[QUEUE_CLASS_BULK]);
+
+        // priorities are only a hint, an implementation may ignore them
+        if(frame_latency < bulk_latency)
+        {
+            LOG_INFO("\tSeparation: %.1fx\n", bulk_latency / frame_latency);
+        }
+        else
+        {
+            LOG_INFO("\tNo separation, the implementation does not schedule queues by priority\n");
+            status = false;
+        }
+    }
+
+    if(vk_ctx->queue_wait_idle != NULL)
+    {
+        for(uint32_t i = 0; i < vk_ctx->graphics_queue_count; i++)
+        {
+            vk_ctx->queue_wait_idle(vk_ctx->graphics_queues[i]);
+        }
+    }
+
+    if(command_buffers[0] != NULL)
+    {
+        vk_ctx->free_command_buffers(vk_ctx->device, vk_ctx->command_pool, 2, command_buffers);
+    }
+
+    destroy_gpu_buffer(&probe_buffer);
+    destroy_gpu_buffer(&load_buffer);
+
+    return status;
+}
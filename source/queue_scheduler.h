@@ -0,0 +1,73 @@
+#ifndef QUEUE_SCHEDULER_H
+#define QUEUE_SCHEDULER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+enum queue_class
+{
+    QUEUE_CLASS_FRAME,   // latency critical: the frame and its present
+    QUEUE_CLASS_BULK,    // work that may take several frames: uploads
+    QUEUE_CLASS_COMPUTE, // async compute that overlaps the frame
+    QUEUE_CLASS_COUNT
+};
+
+enum { QUEUE_SUBMISSION_MAX_WAITS = 4 };
+enum { QUEUE_SUBMISSION_MAX_COMMAND_BUFFERS = 8 };
+
+// a position on the timeline of the queue a class is routed to. the value is signaled when all work submitted
+// up to and including the submission that returned the point has completed, the value 0 is always reached
+struct queue_point
+{
+    enum queue_class queue_class;
+    uint64_t         value;
+};
+
+// one batch of command buffers. the waits are points on any timeline, the binary semaphores are only used for
+// the swapchain: acquire_semaphore is waited on at acquire_stage and present_semaphore is signaled for present
+struct queue_submission
+{
+    uint32_t                  command_buffer_count;
+    const VkCommandBuffer*    command_buffers;
+    uint32_t                  wait_point_count;
+    struct queue_point        wait_points[QUEUE_SUBMISSION_MAX_WAITS];
+    VkPipelineStageFlags      wait_stages[QUEUE_SUBMISSION_MAX_WAITS];
+    VkSemaphore               acquire_semaphore;
+    VkPipelineStageFlags      acquire_stage;
+    VkSemaphore               present_semaphore;
+};
+
+void init_queue_submission(struct queue_submission* submission, uint32_t command_buffer_count, const VkCommandBuffer* command_buffers);
+
+// waits for the point before the stages, points with the value 0 are skipped
+void add_queue_submission_wait(struct queue_submission* submission, const struct queue_point* point, VkPipelineStageFlags stages);
+
+// routes each class to one of the queues of vk_ctx, the frame class to the graphics queue with the highest
+// priority and the bulk class to the one with the lowest. with a single graphics queue both classes share it.
+// the compute class uses the async compute queue and falls back to the bulk queue without one
+bool initialize_queue_scheduler(void);
+void uninitialize_queue_scheduler(void);
+
+uint32_t get_queue_family(enum queue_class queue_class);
+
+// queues are externally synchronized, the scheduler serializes the access so every thread can submit. every
+// submission advances the timeline of its queue by one, point receives the value it signals and may be NULL
+bool submit_to_queue(enum queue_class queue_class, const struct queue_submission* submission, struct queue_point* point);
+VkResult present_to_queue(const VkPresentInfoKHR* present_info);
+
+// the point of the last submission to the queue of the class, waiting for it drains the queue
+void get_last_queue_point(enum queue_class queue_class, struct queue_point* point);
+
+// the timeline semaphore behind the points of the class, for the deferred destruction of vk_ctx
+VkSemaphore get_queue_timeline(enum queue_class queue_class);
+
+bool is_queue_point_reached(const struct queue_point* point);
+bool wait_for_queue_point(const struct queue_point* point);
+
+// measures the latency of a small frame class submission while the bulk queue is saturated, once on the frame
+// queue and once behind the bulk work on the bulk queue
+bool run_queue_priority_test(uint32_t iterations);
+
+#endif // QUEUE_SCHEDULER_H
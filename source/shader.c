@@ -0,0 +1,71 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "logger.h"
+#include "shader.h"
+#include "vk_context.h"
+
+bool create_shader_module_from_file(const char* path, VkShaderModule* shader_module)
+{
+    bool status = true;
+
+    uint8_t* code = NULL;
+    uint64_t code_size = 0;
+
+    FILE* file = fopen(path, "rb");
+
+    if(file != NULL)
+    {
+        fseek(file, 0, SEEK_END);
+        code_size = ftell(file);
+        rewind(file);
+        code = (uint8_t*) malloc(code_size * sizeof(uint8_t));
+
+        if(code == NULL)
+        {
+            LOG_ERROR("Failed to allocate memory\n");
+            status = false;
+        }
+        else if(fread(code, sizeof(uint8_t), code_size, file) != code_size)
+        {
+            LOG_ERROR("Error reading shader code %s\n", path);
+            status = false;
+        }
+    }
+    else
+    {
+        LOG_ERROR("Could not read shader %s\n", path);
+        status = false;
+    }
+
+    if(file != NULL)
+    {
+        fclose(file);
+        file = NULL;
+    }
+
+    if(status)
+    {
+        VkShaderModuleCreateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        info.pNext = NULL;
+        info.flags = 0;
+        info.codeSize = code_size;
+        info.pCode = (const uint32_t*) code;
+
+        if(vk_ctx->create_shader_module(vk_ctx->device, &info, vk_ctx->allocation_callbacks, shader_module) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create shader module %s\n", path);
+            status = false;
+        }
+    }
+
+    if(code != NULL)
+    {
+        free(code);
+        code = NULL;
+    }
+
+    return status;
+}
@@ -1,10 +1,60 @@
 #version 450
 
 layout(location = 0) in vec3 color;
+layout(location = 1) in vec3 position;
 
 layout(location = 0) out vec4 fragment_color;
 
+// feature toggles, the ids must match SHADER_CONSTANT_* in main.c. a specialized pipeline has the branches
+// resolved when it is compiled, otherwise they are read from the push constants at runtime
+layout(constant_id = 0) const bool specialized = true;
+layout(constant_id = 1) const uint specialized_color_mode = 0;
+layout(constant_id = 2) const uint specialized_lighting_model = 0;
+
+// follows the draw indices of the vertex shader in struct draw_constants
+layout(push_constant) uniform draw_constants
+{
+    layout(offset = 8) uint color_mode;
+    layout(offset = 12) uint lighting_model;
+    layout(offset = 16) uint texture_index;
+} features;
+
+// the bindless texture table, the array size must match BINDLESS_MAX_TEXTURES
+layout(set = 0, binding = 1) uniform sampler2D textures[256];
+
+const uint COLOR_MODE_VERTEX = 0;
+const uint COLOR_MODE_FLAT = 1;
+const uint COLOR_MODE_TEXTURE = 2;
+
+const uint LIGHTING_MODEL_UNLIT = 0;
+const uint LIGHTING_MODEL_LAMBERT = 1;
+
+const vec3 flat_color = vec3(0.8, 0.5, 0.2);
+const vec3 light_direction = vec3(0.27, 0.45, -0.85);
+
 void main()
 {
-    fragment_color = vec4(color, 1.0);
+    uint color_mode = specialized ? specialized_color_mode : features.color_mode;
+    uint lighting_model = specialized ? specialized_lighting_model : features.lighting_model;
+
+    // faceted normal from the screen space derivatives, the sign depends on the winding so both sides are lit
+    vec3 normal = normalize(cross(dFdx(position), dFdy(position)));
+
+    vec3 albedo = (color_mode == COLOR_MODE_FLAT) ? flat_color : color;
+
+    if(color_mode == COLOR_MODE_TEXTURE)
+    {
+        // the cube spans -1 to 1, each face is mapped by dropping the axis of its normal
+        vec3 axis = abs(normal);
+        vec2 uv = (axis.x > axis.y) ? ((axis.x > axis.z) ? position.zy : position.xy) : ((axis.y > axis.z) ? position.xz : position.xy);
+
+        albedo = texture(textures[features.texture_index], uv * 0.5 + 0.5).rgb;
+    }
+
+    if(lighting_model == LIGHTING_MODEL_LAMBERT)
+    {
+        albedo *= 0.2 + 0.8 * abs(dot(normal, light_direction));
+    }
+
+    fragment_color = vec4(albedo, 1.0);
 }
@@ -0,0 +1,10 @@
+#ifndef SHADER_H
+#define SHADER_H
+
+#include <stdbool.h>
+
+#include <vulkan/vulkan.h>
+
+bool create_shader_module_from_file(const char* path, VkShaderModule* shader_module);
+
+#endif // SHADER_H
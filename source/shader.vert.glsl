@@ -1,8 +1,35 @@
 #version 450
 
 layout(location = 0) in vec3 position;
+layout(location = 1) in vec3 color;
+
+layout(location = 0) out vec3 vertex_color;
+layout(location = 1) out vec3 vertex_position;
+
+// per draw indices into the bindless table, must match struct draw_constants in main.c
+layout(push_constant) uniform draw_constants
+{
+    uint draw_buffer;
+    uint draw_index;
+} constants;
+
+struct draw_data
+{
+    mat4 transform;
+};
+
+// the bindless buffer table, the array size must match BINDLESS_MAX_BUFFERS
+layout(set = 0, binding = 0, std430) readonly buffer draw_data_buffer
+{
+    draw_data draws[];
+} buffers[64];
+
+// the depth pre-pass and the main pass must produce bit identical depth for the equal test
+invariant gl_Position;
 
 void main()
 {
-    gl_Position = vec4(position, 1.0);
+    vertex_color = color;
+    vertex_position = position;
+    gl_Position = buffers[constants.draw_buffer].draws[constants.draw_index + gl_InstanceIndex].transform * vec4(position, 1.0);
 }
@@ -0,0 +1,615 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL2/SDL.h>
+
+#include "bindless.h"
+#include "gpu_buffer.h"
+#include "logger.h"
+#include "queue_scheduler.h"
+#include "shader.h"
+#include "simulation.h"
+#include "vk_context.h"
+
+enum { SIMULATION_GROUP_SIZE      = 64 };
+enum { SIMULATION_QUERY_FRAMES    = 4 };
+enum { SIMULATION_QUERIES         = 4 };
+enum { SIMULATION_REPORT_INTERVAL = 256 };
+
+// timestamps of one step and of the frame that rendered while it ran
+enum { QUERY_STEP_BEGIN, QUERY_STEP_END, QUERY_FRAME_BEGIN, QUERY_FRAME_END };
+
+struct simulation_instance
+{
+    float position[4];
+    float velocity[4];
+    float rotation[4];
+    float angular_velocity[4];
+};
+
+struct simulation_constants
+{
+    float    view_projection[16];
+    float    bounds_min[4];
+    float    bounds_max[4];
+    float    time_step;
+    uint32_t instance_count;
+};
+
+struct simulation
+{
+    uint32_t              instance_count;
+
+    struct gpu_buffer     instance_buffer;
+    struct gpu_buffer     transform_buffers[SIMULATION_SLOT_COUNT];
+    uint32_t              transform_buffer_indices[SIMULATION_SLOT_COUNT];
+
+    VkShaderModule        shader_module;
+    VkDescriptorSetLayout descriptor_set_layout;
+    VkDescriptorPool      descriptor_pool;
+    VkDescriptorSet       descriptor_sets[SIMULATION_SLOT_COUNT];
+    VkPipelineLayout      pipeline_layout;
+    VkPipeline            pipeline;
+
+    VkCommandPool         command_pool;
+    VkCommandBuffer       command_buffers[SIMULATION_SLOT_COUNT];
+
+    // finished: the step wrote the transforms, released: the frame no longer reads them
+    struct queue_point    finished_points[SIMULATION_SLOT_COUNT];
+    struct queue_point    released_points[SIMULATION_SLOT_COUNT];
+
+    // query frame k holds step k and the frame that draws step k - 1
+    VkQueryPool           timestamp_pool;
+
+    uint64_t              step_count;
+    uint64_t              last_step_counter;
+
+    uint32_t              measurement_count;
+    double                step_time;
+    double                overlap_time;
+} g_simulation;
+
+static float random_float(float min, float max)
+{
+    return min + (max - min) * ((float) rand() / (float) RAND_MAX);
+}
+
+bool initialize_simulation(uint32_t instance_count)
+{
+    bool status = true;
+
+    struct simulation_instance* instances = NULL;
+
+    memset(&g_simulation, 0, sizeof(struct simulation));
+
+    g_simulation.instance_count = instance_count;
+
+    for(uint32_t i = 0; i < SIMULATION_SLOT_COUNT; i++)
+    {
+        g_simulation.transform_buffer_indices[i] = BINDLESS_INVALID_INDEX;
+    }
+
+    if(status)
+    {
+        instances = malloc(instance_count * sizeof(struct simulation_instance));
+
+        if(instances == NULL)
+        {
+            LOG_ERROR("Failed to allocate memory\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        // a field of small cubes inside the clip volume, the bounds in the constants keep them there
+        for(uint32_t i = 0; i < instance_count; i++)
+        {
+            struct simulation_instance* instance = &instances[i];
+
+            instance->position[0] = random_float(-0.8f, 0.8f);
+            instance->position[1] = random_float(-0.8f, 0.8f);
+            instance->position[2] = random_float(0.3f, 0.7f);
+            instance->position[3] = random_float(0.05f, 0.15f);
+
+            instance->velocity[0] = random_float(-0.5f, 0.5f);
+            instance->velocity[1] = random_float(-0.5f, 0.5f);
+            instance->velocity[2] = random_float(-0.1f, 0.1f);
+            instance->velocity[3] = 0.0f;
+
+            instance->rotation[0] = 0.0f;
+            instance->rotation[1] = 0.0f;
+            instance->rotation[2] = 0.0f;
+            instance->rotation[3] = 1.0f;
+
+            instance->angular_velocity[0] = random_float(-2.0f, 2.0f);
+            instance->angular_velocity[1] = random_float(-2.0f, 2.0f);
+            instance->angular_velocity[2] = random_float(-2.0f, 2.0f);
+            instance->angular_velocity[3] = 0.0f;
+        }
+
+        status = create_gpu_buffer_with_data(instances, instance_count * sizeof(struct simulation_instance), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, &g_simulation.instance_buffer);
+    }
+
+    // written on the compute queue and read by the vertex shaders on the frame queue
+    for(uint32_t i = 0; status && (i < SIMULATION_SLOT_COUNT); i++)
+    {
+        uint32_t queue_families[2] = { get_queue_family(QUEUE_CLASS_FRAME), get_queue_family(QUEUE_CLASS_COMPUTE) };
+        uint32_t queue_family_count = (queue_families[0] != queue_families[1]) ? 2 : 1;
+
+        status = create_shared_gpu_buffer(instance_count * 16 * sizeof(float), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, queue_family_count, queue_families, &g_simulation.transform_buffers[i]);
+
+        if(status)
+        {
+            g_simulation.transform_buffer_indices[i] = register_bindless_buffer(g_simulation.transform_buffers[i].handle);
+            status = (g_simulation.transform_buffer_indices[i] != BINDLESS_INVALID_INDEX);
+        }
+    }
+
+    if(status)
+    {
+        status = create_shader_module_from_file("c:/workspace/vk-cube/bin/simulation.comp.spv", &g_simulation.shader_module);
+    }
+
+    if(status)
+    {
+        VkDescriptorSetLayoutBinding bindings[2];
+
+        for(uint32_t i = 0; i < 2; i++)
+        {
+            bindings[i].binding = i;
+            bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            bindings[i].descriptorCount = 1;
+            bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+            bindings[i].pImmutableSamplers = NULL;
+        }
+
+        VkDescriptorSetLayoutCreateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        info.pNext = NULL;
+        info.flags = 0;
+        info.bindingCount = 2;
+        info.pBindings = bindings;
+
+        if(vk_ctx->create_descriptor_set_layout(vk_ctx->device, &info, vk_ctx->allocation_callbacks, &g_simulation.descriptor_set_layout) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create simulation descriptor set layout\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        VkDescriptorPoolSize pool_size;
+        pool_size.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        pool_size.descriptorCount = 2 * SIMULATION_SLOT_COUNT;
+
+        VkDescriptorPoolCreateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        info.pNext = NULL;
+        info.flags = 0;
+        info.maxSets = SIMULATION_SLOT_COUNT;
+        info.poolSizeCount = 1;
+        info.pPoolSizes = &pool_size;
+
+        if(vk_ctx->create_descriptor_pool(vk_ctx->device, &info, vk_ctx->allocation_callbacks, &g_simulation.descriptor_pool) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create simulation descriptor pool\n");
+            status = false;
+        }
+    }
+
+    for(uint32_t slot = 0; status && (slot < SIMULATION_SLOT_COUNT); slot++)
+    {
+        VkDescriptorSetAllocateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        info.pNext = NULL;
+        info.descriptorPool = g_simulation.descriptor_pool;
+        info.descriptorSetCount = 1;
+        info.pSetLayouts = &g_simulation.descriptor_set_layout;
+
+        if(vk_ctx->allocate_descriptor_sets(vk_ctx->device, &info, &g_simulation.descriptor_sets[slot]) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to allocate simulation descriptor set\n");
+            status = false;
+        }
+
+        if(status)
+        {
+            const struct gpu_buffer* buffers[2] = { &g_simulation.instance_buffer, &g_simulation.transform_buffers[slot] };
+
+            VkDescriptorBufferInfo buffer_infos[2];
+            VkWriteDescriptorSet writes[2];
+
+            for(uint32_t i = 0; i < 2; i++)
+            {
+                buffer_infos[i].buffer = buffers[i]->handle;
+                buffer_infos[i].offset = 0;
+                buffer_infos[i].range = VK_WHOLE_SIZE;
+
+                writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writes[i].pNext = NULL;
+                writes[i].dstSet = g_simulation.descriptor_sets[slot];
+                writes[i].dstBinding = i;
+                writes[i].dstArrayElement = 0;
+                writes[i].descriptorCount = 1;
+                writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+                writes[i].pImageInfo = NULL;
+                writes[i].pBufferInfo = &buffer_infos[i];
+                writes[i].pTexelBufferView = NULL;
+            }
+
+            vk_ctx->update_descriptor_sets(vk_ctx->device, 2, writes, 0, NULL);
+        }
+    }
+
+    if(status)
+    {
+        VkPushConstantRange push_constant_range;
+        push_constant_range.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        push_constant_range.offset = 0;
+        push_constant_range.size = sizeof(struct simulation_constants);
+
+        VkPipelineLayoutCreateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        info.pNext = NULL;
+        info.flags = 0;
+        info.setLayoutCount = 1;
+        info.pSetLayouts = &g_simulation.descriptor_set_layout;
+        info.pushConstantRangeCount = 1;
+        info.pPushConstantRanges = &push_constant_range;
+
+        if(vk_ctx->create_pipeline_layout(vk_ctx->device, &info, vk_ctx->allocation_callbacks, &g_simulation.pipeline_layout) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create simulation pipeline layout\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        VkComputePipelineCreateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        info.pNext = NULL;
+        info.flags = 0;
+        info.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        info.stage.pNext = NULL;
+        info.stage.flags = 0;
+        info.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        info.stage.module = g_simulation.shader_module;
+        info.stage.pName = "main";
+        info.stage.pSpecializationInfo = NULL;
+        info.layout = g_simulation.pipeline_layout;
+        info.basePipelineHandle = NULL;
+        info.basePipelineIndex = -1;
+
+        if(vk_ctx->create_compute_pipelines(vk_ctx->device, NULL, 1, &info, vk_ctx->allocation_callbacks, &g_simulation.pipeline) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create simulation pipeline\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        VkCommandPoolCreateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        info.pNext = NULL;
+        info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        info.queueFamilyIndex = get_queue_family(QUEUE_CLASS_COMPUTE);
+
+        if(vk_ctx->create_command_pool(vk_ctx->device, &info, vk_ctx->allocation_callbacks, &g_simulation.command_pool) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create simulation command pool\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        VkCommandBufferAllocateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        info.pNext = NULL;
+        info.commandPool = g_simulation.command_pool;
+        info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        info.commandBufferCount = SIMULATION_SLOT_COUNT;
+
+        if(vk_ctx->allocate_command_buffers(vk_ctx->device, &info, g_simulation.command_buffers) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to allocate simulation command buffers\n");
+            status = false;
+        }
+    }
+
+    // the value 0 lets the first use of each slot pass without waiting
+    for(uint32_t i = 0; i < SIMULATION_SLOT_COUNT; i++)
+    {
+        g_simulation.finished_points[i].queue_class = QUEUE_CLASS_COMPUTE;
+        g_simulation.released_points[i].queue_class = QUEUE_CLASS_FRAME;
+    }
+
+    if(status && vk_ctx->timestamps_supported)
+    {
+        VkQueryPoolCreateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        info.pNext = NULL;
+        info.flags = 0;
+        info.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        info.queryCount = SIMULATION_QUERY_FRAMES * SIMULATION_QUERIES;
+        info.pipelineStatistics = 0;
+
+        if(vk_ctx->create_query_pool(vk_ctx->device, &info, vk_ctx->allocation_callbacks, &g_simulation.timestamp_pool) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create simulation query pool\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        LOG_INFO("Simulation: %u instances on the %s queue\n", instance_count, vk_ctx->async_compute_supported ? "async compute" : "bulk graphics");
+    }
+    else
+    {
+        uninitialize_simulation();
+    }
+
+    if(instances != NULL)
+    {
+        free(instances);
+        instances = NULL;
+    }
+
+    return status;
+}
+
+void uninitialize_simulation(void)
+{
+    if(g_simulation.measurement_count > 0)
+    {
+        LOG_INFO("Simulation: %.3f ms per step, %.0f%% overlapped with rendering\n", g_simulation.step_time / g_simulation.measurement_count, 100.0 * g_simulation.overlap_time / g_simulation.step_time);
+    }
+
+    if(g_simulation.timestamp_pool != NULL)
+    {
+        vk_ctx->destroy_query_pool(vk_ctx->device, g_simulation.timestamp_pool, vk_ctx->allocation_callbacks);
+        g_simulation.timestamp_pool = NULL;
+    }
+
+    if(g_simulation.command_pool != NULL)
+    {
+        vk_ctx->destroy_command_pool(vk_ctx->device, g_simulation.command_pool, vk_ctx->allocation_callbacks);
+        g_simulation.command_pool = NULL;
+
+        for(uint32_t i = 0; i < SIMULATION_SLOT_COUNT; i++)
+        {
+            g_simulation.command_buffers[i] = NULL;
+        }
+    }
+
+    if(g_simulation.pipeline != NULL)
+    {
+        vk_ctx->destroy_pipeline(vk_ctx->device, g_simulation.pipeline, vk_ctx->allocation_callbacks);
+        g_simulation.pipeline = NULL;
+    }
+
+    if(g_simulation.pipeline_layout != NULL)
+    {
+        vk_ctx->destroy_pipeline_layout(vk_ctx->device, g_simulation.pipeline_layout, vk_ctx->allocation_callbacks);
+        g_simulation.pipeline_layout = NULL;
+    }
+
+    if(g_simulation.descriptor_pool != NULL)
+    {
+        vk_ctx->destroy_descriptor_pool(vk_ctx->device, g_simulation.descriptor_pool, vk_ctx->allocation_callbacks);
+        g_simulation.descriptor_pool = NULL;
+
+        for(uint32_t i = 0; i < SIMULATION_SLOT_COUNT; i++)
+        {
+            g_simulation.descriptor_sets[i] = NULL;
+        }
+    }
+
+    if(g_simulation.descriptor_set_layout != NULL)
+    {
+        vk_ctx->destroy_descriptor_set_layout(vk_ctx->device, g_simulation.descriptor_set_layout, vk_ctx->allocation_callbacks);
+        g_simulation.descriptor_set_layout = NULL;
+    }
+
+    if(g_simulation.shader_module != NULL)
+    {
+        vk_ctx->destroy_shader_module(vk_ctx->device, g_simulation.shader_module, vk_ctx->allocation_callbacks);
+        g_simulation.shader_module = NULL;
+    }
+
+    // the bindless table has no removal, the slots stay allocated until the table is destroyed
+    for(uint32_t i = 0; i < SIMULATION_SLOT_COUNT; i++)
+    {
+        destroy_gpu_buffer(&g_simulation.transform_buffers[i]);
+    }
+
+    destroy_gpu_buffer(&g_simulation.instance_buffer);
+
+    g_simulation.instance_count = 0;
+}
+
+void get_simulation_frame(struct simulation_frame* frame)
+{
+    uint32_t slot = g_simulation.step_count % SIMULATION_SLOT_COUNT;
+
+    frame->step = g_simulation.step_count;
+    frame->transform_buffer = g_simulation.transform_buffer_indices[slot];
+}
+
+void release_simulation_frame(const struct simulation_frame* frame, const struct queue_point* frame_point)
+{
+    g_simulation.released_points[frame->step % SIMULATION_SLOT_COUNT] = *frame_point;
+}
+
+// reads the query frame of a step that completed, the frame that rendered next to it may still be running
+static void read_simulation_timestamps(uint64_t step)
+{
+    uint64_t timestamps[SIMULATION_QUERIES];
+
+    uint32_t first_query = (step % SIMULATION_QUERY_FRAMES) * SIMULATION_QUERIES;
+
+    if(vk_ctx->get_query_pool_results(vk_ctx->device, g_simulation.timestamp_pool, first_query, SIMULATION_QUERIES, sizeof(timestamps), timestamps, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS)
+    {
+        double step_begin = (double) timestamps[QUERY_STEP_BEGIN];
+        double step_end = (double) timestamps[QUERY_STEP_END];
+        double overlap_begin = (timestamps[QUERY_FRAME_BEGIN] > timestamps[QUERY_STEP_BEGIN]) ? (double) timestamps[QUERY_FRAME_BEGIN] : step_begin;
+        double overlap_end = (timestamps[QUERY_FRAME_END] < timestamps[QUERY_STEP_END]) ? (double) timestamps[QUERY_FRAME_END] : step_end;
+
+        double to_ms = vk_ctx->timestamp_period / 1000000.0;
+
+        g_simulation.step_time += (step_end - step_begin) * to_ms;
+        g_simulation.overlap_time += (overlap_end > overlap_begin) ? (overlap_end - overlap_begin) * to_ms : 0.0;
+        g_simulation.measurement_count++;
+
+        if(g_simulation.measurement_count % SIMULATION_REPORT_INTERVAL == 0)
+        {
+            LOG_INFO("Simulation: %.3f ms per step, %.0f%% overlapped with rendering\n", g_simulation.step_time / g_simulation.measurement_count, 100.0 * g_simulation.overlap_time / g_simulation.step_time);
+        }
+    }
+}
+
+bool submit_simulation_step(const float view_projection[16], struct queue_point* ready)
+{
+    bool status = true;
+
+    uint64_t step = g_simulation.step_count;
+    uint32_t slot = step % SIMULATION_SLOT_COUNT;
+
+    VkCommandBuffer command_buffer = g_simulation.command_buffers[slot];
+
+    uint64_t counter = SDL_GetPerformanceCounter();
+
+    struct simulation_constants constants = { 0 };
+    memcpy(constants.view_projection, view_projection, sizeof(constants.view_projection));
+    constants.bounds_min[0] = -1.0f;
+    constants.bounds_min[1] = -1.0f;
+    constants.bounds_min[2] = 0.0f;
+    constants.bounds_max[0] = 1.0f;
+    constants.bounds_max[1] = 1.0f;
+    constants.bounds_max[2] = 1.0f;
+    constants.time_step = (step > 0) ? (float) (counter - g_simulation.last_step_counter) / (float) SDL_GetPerformanceFrequency() : 0.0f;
+    constants.instance_count = g_simulation.instance_count;
+
+    // keep the motion stable across hitches
+    if(constants.time_step > 0.05f)
+    {
+        constants.time_step = 0.05f;
+    }
+
+    g_simulation.last_step_counter = counter;
+
+    // the command buffer of the slot was last used by the step two steps earlier
+    status = wait_for_queue_point(&g_simulation.finished_points[slot]);
+
+    if(status)
+    {
+        // the first step has no frame next to it
+        if((g_simulation.timestamp_pool != NULL) && (step >= SIMULATION_SLOT_COUNT + 1))
+        {
+            read_simulation_timestamps(step - SIMULATION_SLOT_COUNT);
+        }
+    }
+
+    if(status)
+    {
+        VkCommandBufferBeginInfo info;
+        info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        info.pNext = NULL;
+        info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        info.pInheritanceInfo = NULL;
+
+        if(vk_ctx->begin_command_buffer(command_buffer, &info) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to begin simulation command buffer\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        uint32_t first_query = (step % SIMULATION_QUERY_FRAMES) * SIMULATION_QUERIES;
+
+        if(g_simulation.timestamp_pool != NULL)
+        {
+            // later query frames are reset by the frame two steps earlier, see begin_simulation_frame
+            if(step == 0)
+            {
+                vk_ctx->cmd_reset_query_pool(command_buffer, g_simulation.timestamp_pool, 0, SIMULATION_QUERY_FRAMES * SIMULATION_QUERIES);
+            }
+
+            vk_ctx->cmd_write_timestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, g_simulation.timestamp_pool, first_query + QUERY_STEP_BEGIN);
+        }
+
+        // the previous step updated the instances in place
+        VkMemoryBarrier barrier;
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.pNext = NULL;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+        vk_ctx->cmd_pipeline_barrier(command_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, NULL, 0, NULL);
+
+        vk_ctx->cmd_bind_pipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, g_simulation.pipeline);
+        vk_ctx->cmd_bind_descriptor_sets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, g_simulation.pipeline_layout, 0, 1, &g_simulation.descriptor_sets[slot], 0, NULL);
+        vk_ctx->cmd_push_constants(command_buffer, g_simulation.pipeline_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(struct simulation_constants), &constants);
+        vk_ctx->cmd_dispatch(command_buffer, (g_simulation.instance_count + SIMULATION_GROUP_SIZE - 1) / SIMULATION_GROUP_SIZE, 1, 1);
+
+        if(g_simulation.timestamp_pool != NULL)
+        {
+            vk_ctx->cmd_write_timestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, g_simulation.timestamp_pool, first_query + QUERY_STEP_END);
+        }
+
+        if(vk_ctx->end_command_buffer(command_buffer) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to end simulation command buffer\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        // the transforms of the slot were last read by the frame two steps earlier
+        struct queue_submission submission;
+        init_queue_submission(&submission, 1, &command_buffer);
+        add_queue_submission_wait(&submission, &g_simulation.released_points[slot], VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+        status = submit_to_queue(QUEUE_CLASS_COMPUTE, &submission, &g_simulation.finished_points[slot]);
+    }
+
+    if(status)
+    {
+        *ready = g_simulation.finished_points[slot];
+        g_simulation.step_count++;
+    }
+
+    return status;
+}
+
+void begin_simulation_frame(VkCommandBuffer command_buffer, const struct simulation_frame* frame)
+{
+    if(g_simulation.timestamp_pool != NULL)
+    {
+        // the frame of step N renders next to step N + 1. it resets the query frame of step N + 2, whose step
+        // waits for this frame and whose neighbour frame follows on the same queue
+        uint32_t next_query = ((frame->step + 1) % SIMULATION_QUERY_FRAMES) * SIMULATION_QUERIES;
+        uint32_t reset_query = ((frame->step + 2) % SIMULATION_QUERY_FRAMES) * SIMULATION_QUERIES;
+
+        vk_ctx->cmd_reset_query_pool(command_buffer, g_simulation.timestamp_pool, reset_query, SIMULATION_QUERIES);
+        vk_ctx->cmd_write_timestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, g_simulation.timestamp_pool, next_query + QUERY_FRAME_BEGIN);
+    }
+}
+
+void end_simulation_frame(VkCommandBuffer command_buffer, const struct simulation_frame* frame)
+{
+    if(g_simulation.timestamp_pool != NULL)
+    {
+        uint32_t next_query = ((frame->step + 1) % SIMULATION_QUERY_FRAMES) * SIMULATION_QUERIES;
+
+        vk_ctx->cmd_write_timestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, g_simulation.timestamp_pool, next_query + QUERY_FRAME_END);
+    }
+}
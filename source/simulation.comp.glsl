@@ -0,0 +1,80 @@
+#version 450
+
+layout(local_size_x = 64) in;
+
+// must match struct simulation_instance in simulation.c
+struct instance
+{
+    vec4 position;         // xyz position, w scale
+    vec4 velocity;         // xyz velocity
+    vec4 rotation;         // quaternion, xyz vector part
+    vec4 angular_velocity; // xyz axis scaled by radians per second
+};
+
+struct draw_data
+{
+    mat4 transform;
+};
+
+layout(std430, set = 0, binding = 0) buffer instance_buffer
+{
+    instance instances[];
+};
+
+layout(std430, set = 0, binding = 1) writeonly buffer draw_data_buffer
+{
+    draw_data draws[];
+};
+
+layout(push_constant) uniform constants
+{
+    mat4  view_projection;
+    vec4  bounds_min;
+    vec4  bounds_max;
+    float time_step;
+    uint  instance_count;
+};
+
+vec4 multiply_quaternions(vec4 a, vec4 b)
+{
+    return vec4(a.w * b.xyz + b.w * a.xyz + cross(a.xyz, b.xyz), a.w * b.w - dot(a.xyz, b.xyz));
+}
+
+void main()
+{
+    uint index = gl_GlobalInvocationID.x;
+
+    if(index < instance_count)
+    {
+        instance i = instances[index];
+
+        float radius = 0.5 * i.position.w;
+
+        // bounce off the walls of the bounds
+        vec3 position = i.position.xyz + i.velocity.xyz * time_step;
+        vec3 low = bounds_min.xyz + radius;
+        vec3 high = bounds_max.xyz - radius;
+        vec3 velocity = mix(i.velocity.xyz, abs(i.velocity.xyz), lessThan(position, low));
+        velocity = mix(velocity, -abs(velocity), greaterThan(position, high));
+        position = clamp(position, low, high);
+
+        // q' = q + dt / 2 * (w, 0) * q
+        vec4 rotation = i.rotation + 0.5 * time_step * multiply_quaternions(vec4(i.angular_velocity.xyz, 0.0), i.rotation);
+        rotation = normalize(rotation);
+
+        instances[index].position.xyz = position;
+        instances[index].velocity.xyz = velocity;
+        instances[index].rotation = rotation;
+
+        vec3 q = rotation.xyz;
+        float w = rotation.w;
+        float s = i.position.w;
+
+        mat4 model = mat4(vec4(s * (1.0 - 2.0 * (q.y * q.y + q.z * q.z)), s * 2.0 * (q.x * q.y + w * q.z), s * 2.0 * (q.x * q.z - w * q.y), 0.0),
+                          vec4(s * 2.0 * (q.x * q.y - w * q.z), s * (1.0 - 2.0 * (q.x * q.x + q.z * q.z)), s * 2.0 * (q.y * q.z + w * q.x), 0.0),
+                          vec4(s * 2.0 * (q.x * q.z + w * q.y), s * 2.0 * (q.y * q.z - w * q.x), s * (1.0 - 2.0 * (q.x * q.x + q.y * q.y)), 0.0),
+                          vec4(position, 1.0));
+
+        draws[index].transform = view_projection * model;
+    }
+}
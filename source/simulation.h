@@ -0,0 +1,38 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include "queue_scheduler.h"
+
+enum { SIMULATION_SLOT_COUNT = 2 };
+
+// what the frame that draws a simulation step reads: one struct draw_data per instance in the transform buffer
+struct simulation_frame
+{
+    uint64_t     step;
+    uint32_t     transform_buffer; // index into the bindless table
+};
+
+// integrates positions and rotations of instance_count cubes in a compute shader on the async compute queue.
+// the transforms are double buffered, the step of frame N runs while frame N - 1 is rendered
+bool initialize_simulation(uint32_t instance_count);
+void uninitialize_simulation(void);
+
+// describes the step that the next submit_simulation_step submits
+void get_simulation_frame(struct simulation_frame* frame);
+
+// records and submits the next step. the frame that draws it waits for ready before its vertex shaders and
+// passes its own point to release_simulation_frame before the next step is submitted
+bool submit_simulation_step(const float view_projection[16], struct queue_point* ready);
+void release_simulation_frame(const struct simulation_frame* frame, const struct queue_point* frame_point);
+
+// bracket the frame that draws the step with timestamps to measure how much of the simulation overlapped the
+// rendering of the previous frame
+void begin_simulation_frame(VkCommandBuffer command_buffer, const struct simulation_frame* frame);
+void end_simulation_frame(VkCommandBuffer command_buffer, const struct simulation_frame* frame);
+
+#endif // SIMULATION_H
@@ -0,0 +1,249 @@
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TEXTURE_CODEC_SSE2
+#endif
+
+#include "texture_codec.h"
+
+enum { BC1_BLOCK_TEXELS = 4 };
+
+static uint16_t pack_565(const uint8_t* color)
+{
+    return (uint16_t) (((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+}
+
+// the endpoint as rgba8, the top bits are repeated into the low ones so that 31 and 63 map to 255
+static uint32_t unpack_565(uint16_t color)
+{
+    uint32_t r = (color >> 11) & 0x1F;
+    uint32_t g = (color >> 5) & 0x3F;
+    uint32_t b = color & 0x1F;
+
+    r = (r << 3) | (r >> 2);
+    g = (g << 2) | (g >> 4);
+    b = (b << 3) | (b >> 2);
+
+    return r | (g << 8) | (b << 16) | 0xFF000000;
+}
+
+// the four colors of the block as rgba8. with color0 > color1 two colors lie between the endpoints, otherwise
+// one color halfway and black
+static void get_bc1_palette(uint16_t color0, uint16_t color1, uint32_t palette[4])
+{
+    uint32_t c0 = unpack_565(color0);
+    uint32_t c1 = unpack_565(color1);
+
+#ifdef TEXTURE_CODEC_SSE2
+    // one 16 bit lane per channel, x / 3 is exact as (x * 21846) >> 16 for the sums up to 3 * 255
+    __m128i zero = _mm_setzero_si128();
+    __m128i e0 = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int) c0), zero);
+    __m128i e1 = _mm_unpacklo_epi8(_mm_cvtsi32_si128((int) c1), zero);
+    __m128i p2;
+    __m128i p3;
+
+    if(color0 > color1)
+    {
+        __m128i third = _mm_set1_epi16(21846);
+
+        p2 = _mm_mulhi_epu16(_mm_add_epi16(_mm_add_epi16(e0, e0), e1), third);
+        p3 = _mm_mulhi_epu16(_mm_add_epi16(_mm_add_epi16(e1, e1), e0), third);
+    }
+    else
+    {
+        p2 = _mm_srli_epi16(_mm_add_epi16(e0, e1), 1);
+        p3 = _mm_set_epi16(0, 0, 0, 0, 255, 0, 0, 0);
+    }
+
+    _mm_storeu_si128((__m128i*) palette, _mm_packus_epi16(_mm_unpacklo_epi64(e0, e1), _mm_unpacklo_epi64(p2, p3)));
+#else
+    palette[0] = c0;
+    palette[1] = c1;
+    palette[2] = 0xFF000000;
+    palette[3] = 0xFF000000;
+
+    for(uint32_t shift = 0; shift < 24; shift += 8)
+    {
+        uint32_t a = (c0 >> shift) & 0xFF;
+        uint32_t b = (c1 >> shift) & 0xFF;
+
+        if(color0 > color1)
+        {
+            palette[2] |= ((2 * a + b) / 3) << shift;
+            palette[3] |= ((a + 2 * b) / 3) << shift;
+        }
+        else
+        {
+            palette[2] |= ((a + b) / 2) << shift;
+        }
+    }
+#endif
+}
+
+// writes 4 rows of 4 texels, stride is in bytes
+static void decode_bc1_block(const uint8_t* block, uint8_t* texels, size_t stride)
+{
+    uint16_t color0 = (uint16_t) (block[0] | (block[1] << 8));
+    uint16_t color1 = (uint16_t) (block[2] | (block[3] << 8));
+
+    uint32_t palette[4];
+    get_bc1_palette(color0, color1, palette);
+
+    for(uint32_t y = 0; y < BC1_BLOCK_TEXELS; y++)
+    {
+        uint32_t indices = block[4 + y];
+        uint8_t* row = texels + y * stride;
+
+#ifdef TEXTURE_CODEC_SSE2
+        _mm_storeu_si128((__m128i*) row, _mm_set_epi32((int) palette[(indices >> 6) & 3], (int) palette[(indices >> 4) & 3], (int) palette[(indices >> 2) & 3], (int) palette[indices & 3]));
+#else
+        for(uint32_t x = 0; x < BC1_BLOCK_TEXELS; x++)
+        {
+            memcpy(row + x * 4, &palette[(indices >> (x * 2)) & 3], 4);
+        }
+#endif
+    }
+}
+
+static uint32_t get_color_distance(const uint8_t* texel, uint32_t color)
+{
+    int32_t r = (int32_t) texel[0] - (int32_t) (color & 0xFF);
+    int32_t g = (int32_t) texel[1] - (int32_t) ((color >> 8) & 0xFF);
+    int32_t b = (int32_t) texel[2] - (int32_t) ((color >> 16) & 0xFF);
+
+    return (uint32_t) (r * r + g * g + b * b);
+}
+
+// texels holds the 4x4 block as rgba8 without stride
+static void encode_bc1_block(const uint8_t* texels, uint8_t* block)
+{
+    uint8_t min[3] = { 255, 255, 255 };
+    uint8_t max[3] = { 0, 0, 0 };
+
+    for(uint32_t i = 0; i < BC1_BLOCK_TEXELS * BC1_BLOCK_TEXELS; i++)
+    {
+        for(uint32_t c = 0; c < 3; c++)
+        {
+            uint8_t value = texels[i * 4 + c];
+
+            min[c] = (value < min[c]) ? value : min[c];
+            max[c] = (value > max[c]) ? value : max[c];
+        }
+    }
+
+    // the maximum is never below the minimum in any channel, so color0 >= color1 and the block uses four colors
+    // unless both endpoints are equal
+    uint16_t color0 = pack_565(max);
+    uint16_t color1 = pack_565(min);
+    uint32_t indices = 0;
+
+    if(color0 != color1)
+    {
+        uint32_t palette[4];
+        get_bc1_palette(color0, color1, palette);
+
+        for(uint32_t i = 0; i < BC1_BLOCK_TEXELS * BC1_BLOCK_TEXELS; i++)
+        {
+            uint32_t best = 0;
+            uint32_t best_distance = get_color_distance(&texels[i * 4], palette[0]);
+
+            for(uint32_t j = 1; j < 4; j++)
+            {
+                uint32_t distance = get_color_distance(&texels[i * 4], palette[j]);
+
+                if(distance < best_distance)
+                {
+                    best = j;
+                    best_distance = distance;
+                }
+            }
+
+            indices |= best << (i * 2);
+        }
+    }
+
+    block[0] = (uint8_t) (color0 & 0xFF);
+    block[1] = (uint8_t) (color0 >> 8);
+    block[2] = (uint8_t) (color1 & 0xFF);
+    block[3] = (uint8_t) (color1 >> 8);
+    block[4] = (uint8_t) (indices & 0xFF);
+    block[5] = (uint8_t) ((indices >> 8) & 0xFF);
+    block[6] = (uint8_t) ((indices >> 16) & 0xFF);
+    block[7] = (uint8_t) (indices >> 24);
+}
+
+uint32_t get_bc1_block_count(uint32_t size)
+{
+    return (size + BC1_BLOCK_TEXELS - 1) / BC1_BLOCK_TEXELS;
+}
+
+size_t get_bc1_size(uint32_t width, uint32_t height)
+{
+    return (size_t) get_bc1_block_count(width) * get_bc1_block_count(height) * BC1_BLOCK_SIZE;
+}
+
+void encode_bc1(const uint8_t* texels, uint32_t width, uint32_t height, uint8_t* blocks)
+{
+    uint8_t block_texels[BC1_BLOCK_TEXELS * BC1_BLOCK_TEXELS * 4];
+
+    for(uint32_t by = 0; by < get_bc1_block_count(height); by++)
+    {
+        for(uint32_t bx = 0; bx < get_bc1_block_count(width); bx++)
+        {
+            // the texels outside of small mips repeat the last row and column
+            for(uint32_t y = 0; y < BC1_BLOCK_TEXELS; y++)
+            {
+                uint32_t sy = by * BC1_BLOCK_TEXELS + y;
+                sy = (sy < height) ? sy : height - 1;
+
+                for(uint32_t x = 0; x < BC1_BLOCK_TEXELS; x++)
+                {
+                    uint32_t sx = bx * BC1_BLOCK_TEXELS + x;
+                    sx = (sx < width) ? sx : width - 1;
+
+                    memcpy(&block_texels[(y * BC1_BLOCK_TEXELS + x) * 4], &texels[((size_t) sy * width + sx) * 4], 4);
+                }
+            }
+
+            encode_bc1_block(block_texels, blocks);
+            blocks += BC1_BLOCK_SIZE;
+        }
+    }
+}
+
+void decode_bc1(const uint8_t* blocks, uint32_t width, uint32_t height, uint8_t* texels)
+{
+    size_t stride = (size_t) width * 4;
+
+    for(uint32_t by = 0; by < get_bc1_block_count(height); by++)
+    {
+        for(uint32_t bx = 0; bx < get_bc1_block_count(width); bx++)
+        {
+            uint32_t x = bx * BC1_BLOCK_TEXELS;
+            uint32_t y = by * BC1_BLOCK_TEXELS;
+
+            uint8_t* target = &texels[(size_t) y * stride + (size_t) x * 4];
+
+            if((x + BC1_BLOCK_TEXELS <= width) && (y + BC1_BLOCK_TEXELS <= height))
+            {
+                decode_bc1_block(blocks, target, stride);
+            }
+            else
+            {
+                // only the part of the block inside of the mip is copied out
+                uint8_t block_texels[BC1_BLOCK_TEXELS * BC1_BLOCK_TEXELS * 4];
+                decode_bc1_block(blocks, block_texels, BC1_BLOCK_TEXELS * 4);
+
+                for(uint32_t j = 0; (j < BC1_BLOCK_TEXELS) && (y + j < height); j++)
+                {
+                    uint32_t count = (width - x < BC1_BLOCK_TEXELS) ? width - x : BC1_BLOCK_TEXELS;
+
+                    memcpy(target + j * stride, &block_texels[j * BC1_BLOCK_TEXELS * 4], (size_t) count * 4);
+                }
+            }
+
+            blocks += BC1_BLOCK_SIZE;
+        }
+    }
+}
@@ -0,0 +1,22 @@
+#ifndef TEXTURE_CODEC_H
+#define TEXTURE_CODEC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// bc1 stores each 4x4 block of rgb texels in 8 bytes: two 565 endpoints and 2 bit indices into the palette
+// interpolated between them, an eighth of the size of rgba8
+enum { BC1_BLOCK_SIZE = 8 };
+
+// blocks along a side of size texels, the blocks of mips smaller than 4x4 are padded
+uint32_t get_bc1_block_count(uint32_t size);
+size_t get_bc1_size(uint32_t width, uint32_t height);
+
+// range fit of the texels of each block, rgba8 in. stands in for an offline encoder, it is fast rather than good
+void encode_bc1(const uint8_t* texels, uint32_t width, uint32_t height, uint8_t* blocks);
+
+// rgba8 out with alpha 255, the transcoder for devices without bc1. the palettes are interpolated with sse2
+// where it is available
+void decode_bc1(const uint8_t* blocks, uint32_t width, uint32_t height, uint8_t* texels);
+
+#endif // TEXTURE_CODEC_H
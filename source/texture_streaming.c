@@ -0,0 +1,1759 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <SDL2/SDL.h>
+
+#include "bindless.h"
+#include "gpu_buffer.h"
+#include "gpu_image.h"
+#include "logger.h"
+#include "queue_scheduler.h"
+#include "texture_codec.h"
+#include "texture_streaming.h"
+#include "vk_context.h"
+
+enum { TEXTURE_TEXEL_SIZE        = 4 };
+enum { TEXTURE_IN_USE_FRAMES     = 2 }; // a texture used by one of the last frames is never evicted
+enum { TEXTURE_PLACEHOLDER       = 0x80 };
+enum { TEXTURE_STAGING_ALIGNMENT = 16 };
+enum { DDS_HEADER_SIZE           = 128 }; // the magic and the header, the blocks of the mips follow
+enum { TEXTURE_PRESSURE_FRAMES   = 120 }; // frames without memory pressure before the budget is restored
+
+enum texture_source
+{
+    TEXTURE_SOURCE_GENERATED,
+    TEXTURE_SOURCE_PPM,
+    TEXTURE_SOURCE_DDS // bc1 blocks of a full mip chain
+};
+
+enum texture_job_state
+{
+    TEXTURE_JOB_FREE,
+    TEXTURE_JOB_QUEUED,
+    TEXTURE_JOB_DECODING,
+    TEXTURE_JOB_DECODED,
+    TEXTURE_JOB_FAILED
+};
+
+// one decode of a texture at the size of mip. the payload holds the mips in the format of the texture, only mip
+// itself for the rgba8 textures with mips generated on the gpu
+struct texture_job
+{
+    enum texture_job_state state;
+    uint32_t               texture;
+    uint32_t               mip;
+    uint8_t*               payload;
+    bool                   transcoded;
+};
+
+struct streamed_texture
+{
+    enum texture_source source;
+    char*              path; // NULL for the generated textures
+    uint32_t           file_size; // of the first mip in a dds file
+    uint32_t           file_mip;  // the mip of the file that is the first mip of the texture
+    uint32_t           seed;
+    uint32_t           size;
+    uint32_t           mip_count;
+    VkFormat           format;
+
+    uint64_t           last_used_frame;
+    uint32_t           wanted_mip;
+
+    // the image with the mips from resident_mip down, resident_mip is mip_count while nothing is resident
+    struct gpu_image   image;
+    uint32_t           resident_mip;
+    uint32_t           bindless_index;
+
+    // requested_mip is mip_count while no decode or upload is in flight. the upload becomes the resident
+    // image once pending_point is reached
+    uint32_t           requested_mip;
+    bool               uploading;
+    struct gpu_image   pending_image;
+    struct queue_point pending_point;
+};
+
+struct texture_upload_slot
+{
+    VkCommandBuffer    command_buffer;
+    struct gpu_buffer  staging_buffer;
+    struct queue_point point;
+};
+
+struct texture_streaming
+{
+    struct streamed_texture        textures[TEXTURE_MAX_COUNT];
+    uint32_t                       texture_count;
+
+    struct gpu_image               placeholder;
+    uint32_t                       placeholder_index;
+
+    VkCommandPool                  command_pool;
+    struct texture_upload_slot     upload_slots[TEXTURE_UPLOAD_SLOTS];
+    uint32_t                       next_upload_slot;
+    struct queue_point             upload_point;
+
+    // the decode jobs are shared with the worker threads, the textures are only touched by the thread that
+    // renders
+    struct texture_job             jobs[TEXTURE_MAX_JOBS];
+    SDL_mutex*                     mutex;
+    SDL_cond*                      job_cond;
+    SDL_Thread*                    threads[TEXTURE_WORKER_COUNT];
+    bool                           quit;
+
+    // bc1 when the device samples it, VK_FORMAT_UNDEFINED otherwise. with compress the generated and ppm
+    // textures are encoded too, the dds textures are always uploaded as they are when the format is supported
+    VkFormat                       compressed_format;
+    bool                           compress;
+
+    VkDeviceSize                   budget;
+    uint64_t                       frame;
+
+    // lowered when the device local heaps run out of budget so that the evicted textures are not streamed right
+    // back in, VK_WHOLE_SIZE without pressure
+    VkDeviceSize                   pressure_limit;
+    uint64_t                       pressure_frame;
+    struct texture_streaming_stats stats;
+} g_texture_streaming;
+
+static uint32_t hash_u32(uint32_t x)
+{
+    x ^= x >> 16;
+    x *= 0x7FEB352D;
+    x ^= x >> 15;
+    x *= 0x846CA68B;
+    x ^= x >> 16;
+
+    return x;
+}
+
+static VkDeviceSize get_level_bytes(VkFormat format, uint32_t size)
+{
+    return (format == VK_FORMAT_R8G8B8A8_UNORM) ? (VkDeviceSize) size * size * TEXTURE_TEXEL_SIZE : (VkDeviceSize) get_bc1_size(size, size);
+}
+
+// the bytes of the mips from mip down to 1x1, 0 for mip_count
+static VkDeviceSize get_texture_bytes(const struct streamed_texture* texture, uint32_t mip)
+{
+    VkDeviceSize bytes = 0;
+
+    for(uint32_t i = mip; i < texture->mip_count; i++)
+    {
+        bytes += get_level_bytes(texture->format, texture->size >> i);
+    }
+
+    return bytes;
+}
+
+// blits do not support compressed formats, the compressed textures and the transcoded ones bring all mips
+static bool are_texture_mips_generated(const struct streamed_texture* texture)
+{
+    return (texture->format == VK_FORMAT_R8G8B8A8_UNORM) && (texture->source != TEXTURE_SOURCE_DDS);
+}
+
+static uint32_t get_payload_mip_count(const struct streamed_texture* texture, uint32_t mip)
+{
+    return are_texture_mips_generated(texture) ? 1 : texture->mip_count - mip;
+}
+
+static VkDeviceSize get_payload_bytes(const struct streamed_texture* texture, uint32_t mip)
+{
+    VkDeviceSize bytes = 0;
+
+    for(uint32_t i = 0; i < get_payload_mip_count(texture, mip); i++)
+    {
+        bytes += get_level_bytes(texture->format, texture->size >> (mip + i));
+    }
+
+    return bytes;
+}
+
+static VkDeviceSize get_texture_budget(void)
+{
+    return (g_texture_streaming.pressure_limit < g_texture_streaming.budget) ? g_texture_streaming.pressure_limit : g_texture_streaming.budget;
+}
+
+static bool is_texture_in_use(const struct streamed_texture* texture)
+{
+    return texture->last_used_frame + TEXTURE_IN_USE_FRAMES >= g_texture_streaming.frame;
+}
+
+static bool is_texture_busy(const struct streamed_texture* texture)
+{
+    return texture->requested_mip < texture->mip_count;
+}
+
+// the memory the textures hold or are about to hold once the requests in flight complete, both images are
+// alive while an upload replaces a resident image but the older one is released soon after
+static VkDeviceSize get_committed_bytes(void)
+{
+    VkDeviceSize committed = 0;
+
+    for(uint32_t i = 0; i < g_texture_streaming.texture_count; i++)
+    {
+        const struct streamed_texture* texture = &g_texture_streaming.textures[i];
+
+        VkDeviceSize resident = get_texture_bytes(texture, texture->resident_mip);
+        VkDeviceSize requested = get_texture_bytes(texture, texture->requested_mip);
+
+        committed += (resident > requested) ? resident : requested;
+    }
+
+    return committed;
+}
+
+static bool read_ppm_token(FILE* file, uint32_t* value)
+{
+    int c = fgetc(file);
+
+    // whitespace and comments separate the fields of the header
+    while((c == ' ') || (c == '\t') || (c == '\r') || (c == '\n') || (c == '#'))
+    {
+        if(c == '#')
+        {
+            while((c != EOF) && (c != '\n'))
+            {
+                c = fgetc(file);
+            }
+        }
+
+        c = fgetc(file);
+    }
+
+    *value = 0;
+
+    bool found = false;
+
+    while((c >= '0') && (c <= '9') && (*value < 0x10000000))
+    {
+        *value = *value * 10 + (uint32_t) (c - '0');
+        found = true;
+
+        c = fgetc(file);
+    }
+
+    // a single whitespace ends the last field before the texels
+    return found && ((c == ' ') || (c == '\t') || (c == '\r') || (c == '\n'));
+}
+
+static bool read_ppm_header(FILE* file, uint32_t* width, uint32_t* height)
+{
+    bool status = true;
+
+    uint32_t max_value = 0;
+
+    if((fgetc(file) != 'P') || (fgetc(file) != '6'))
+    {
+        status = false;
+    }
+
+    if(status)
+    {
+        status = read_ppm_token(file, width) && read_ppm_token(file, height) && read_ppm_token(file, &max_value);
+    }
+
+    if(status)
+    {
+        status = (*width > 0) && (*height > 0) && (max_value == 255);
+    }
+
+    return status;
+}
+
+static uint32_t read_u32(const uint8_t* bytes)
+{
+    return (uint32_t) bytes[0] | ((uint32_t) bytes[1] << 8) | ((uint32_t) bytes[2] << 16) | ((uint32_t) bytes[3] << 24);
+}
+
+// only square dxt1 (bc1) files with a power of two size and every mip down to 1x1 are streamed, the mips of
+// the texture are read straight out of the file
+static bool read_dds_header(FILE* file, uint32_t* size)
+{
+    bool status = true;
+
+    uint8_t header[DDS_HEADER_SIZE];
+
+    if(fread(header, 1, DDS_HEADER_SIZE, file) != DDS_HEADER_SIZE)
+    {
+        status = false;
+    }
+
+    if(status)
+    {
+        status = (memcmp(header, "DDS ", 4) == 0) && (memcmp(&header[84], "DXT1", 4) == 0);
+    }
+
+    if(status)
+    {
+        uint32_t height = read_u32(&header[12]);
+        uint32_t width = read_u32(&header[16]);
+        uint32_t mip_count = read_u32(&header[28]);
+
+        VkExtent2D extent = { width, height };
+
+        status = (width == height) && (width > 0) && ((width & (width - 1)) == 0) && (mip_count == get_mip_count(extent));
+
+        *size = width;
+    }
+
+    return status;
+}
+
+// the kind of the file decides by its magic, the square that is streamed is the smaller side
+static bool read_texture_header(const char* path, enum texture_source* source, uint32_t* size)
+{
+    bool status = true;
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    FILE* file = fopen(path, "rb");
+
+    if(file == NULL)
+    {
+        LOG_ERROR("Failed to open texture %s\n", path);
+        status = false;
+    }
+
+    if(status)
+    {
+        if(read_dds_header(file, size))
+        {
+            *source = TEXTURE_SOURCE_DDS;
+        }
+        else if((fseek(file, 0, SEEK_SET) == 0) && read_ppm_header(file, &width, &height))
+        {
+            *source = TEXTURE_SOURCE_PPM;
+            *size = (width < height) ? width : height;
+        }
+        else
+        {
+            LOG_ERROR("Texture %s is neither a bc1 dds with all mips nor a binary ppm with 8 bits per channel\n", path);
+            status = false;
+        }
+    }
+
+    if(file != NULL)
+    {
+        fclose(file);
+        file = NULL;
+    }
+
+    return status;
+}
+
+// reads the blocks of the mips from mip down, they follow the header from the largest to the smallest
+static bool read_dds_mips(const struct streamed_texture* texture, uint32_t mip, uint8_t* blocks)
+{
+    bool status = true;
+
+    long offset = DDS_HEADER_SIZE;
+    size_t bytes = 0;
+
+    for(uint32_t i = 0; i < texture->file_mip + mip; i++)
+    {
+        offset += (long) get_bc1_size(texture->file_size >> i, texture->file_size >> i);
+    }
+
+    for(uint32_t i = mip; i < texture->mip_count; i++)
+    {
+        bytes += get_bc1_size(texture->size >> i, texture->size >> i);
+    }
+
+    FILE* file = fopen(texture->path, "rb");
+
+    if(file == NULL)
+    {
+        LOG_ERROR("Failed to open texture %s\n", texture->path);
+        status = false;
+    }
+
+    if(status)
+    {
+        if((fseek(file, offset, SEEK_SET) != 0) || (fread(blocks, 1, bytes, file) != bytes))
+        {
+            LOG_ERROR("Failed to read texture %s\n", texture->path);
+            status = false;
+        }
+    }
+
+    if(file != NULL)
+    {
+        fclose(file);
+        file = NULL;
+    }
+
+    return status;
+}
+
+// box filters the file down to size x size. the filtered square is a whole multiple of size and centered, the
+// rest of the source is cropped
+static bool decode_ppm(const char* path, uint32_t size, uint8_t* texels)
+{
+    bool status = true;
+
+    FILE* file = NULL;
+    uint8_t* pixels = NULL;
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+
+    if(status)
+    {
+        file = fopen(path, "rb");
+
+        if(file == NULL)
+        {
+            LOG_ERROR("Failed to open texture %s\n", path);
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        if(!read_ppm_header(file, &width, &height))
+        {
+            LOG_ERROR("Texture %s is not a binary ppm with 8 bits per channel\n", path);
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        pixels = malloc((size_t) width * height * 3);
+
+        if(pixels == NULL)
+        {
+            LOG_ERROR("Failed to allocate memory\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        if(fread(pixels, 3, (size_t) width * height, file) != (size_t) width * height)
+        {
+            LOG_ERROR("Failed to read texture %s\n", path);
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        uint32_t square = (width < height) ? width : height;
+        uint32_t scale = square / size;
+        uint32_t left = (width - scale * size) / 2;
+        uint32_t top = (height - scale * size) / 2;
+
+        for(uint32_t y = 0; y < size; y++)
+        {
+            for(uint32_t x = 0; x < size; x++)
+            {
+                uint32_t sum[3] = { 0, 0, 0 };
+
+                for(uint32_t j = 0; j < scale; j++)
+                {
+                    const uint8_t* row = &pixels[((size_t) (top + y * scale + j) * width + left + x * scale) * 3];
+
+                    for(uint32_t i = 0; i < scale; i++)
+                    {
+                        sum[0] += row[i * 3 + 0];
+                        sum[1] += row[i * 3 + 1];
+                        sum[2] += row[i * 3 + 2];
+                    }
+                }
+
+                uint8_t* texel = &texels[((size_t) y * size + x) * TEXTURE_TEXEL_SIZE];
+                texel[0] = (uint8_t) (sum[0] / (scale * scale));
+                texel[1] = (uint8_t) (sum[1] / (scale * scale));
+                texel[2] = (uint8_t) (sum[2] / (scale * scale));
+                texel[3] = 255;
+            }
+        }
+    }
+
+    if(pixels != NULL)
+    {
+        free(pixels);
+        pixels = NULL;
+    }
+
+    if(file != NULL)
+    {
+        fclose(file);
+        file = NULL;
+    }
+
+    return status;
+}
+
+// a checker board of two colors picked by seed with a vertical gradient, evaluated at the texel centers so
+// every mip is a filtered version of the same image
+static void generate_texels(uint32_t seed, uint32_t size, uint8_t* texels)
+{
+    uint32_t colors[2] = { hash_u32(seed * 2 + 1), hash_u32(seed * 2 + 2) };
+    uint32_t cells = 2u << (hash_u32(seed) % 4);
+
+    for(uint32_t y = 0; y < size; y++)
+    {
+        float v = ((float) y + 0.5f) / (float) size;
+        float shade = 0.6f + 0.4f * v;
+
+        for(uint32_t x = 0; x < size; x++)
+        {
+            float u = ((float) x + 0.5f) / (float) size;
+
+            uint32_t color = colors[((uint32_t) (u * (float) cells) + (uint32_t) (v * (float) cells)) & 1];
+
+            uint8_t* texel = &texels[((size_t) y * size + x) * TEXTURE_TEXEL_SIZE];
+            texel[0] = (uint8_t) ((float) ((color >> 0) & 0xFF) * shade);
+            texel[1] = (uint8_t) ((float) ((color >> 8) & 0xFF) * shade);
+            texel[2] = (uint8_t) ((float) ((color >> 16) & 0xFF) * shade);
+            texel[3] = 255;
+        }
+    }
+}
+
+// halves size with a 2x2 box filter in place, every texel is written after the texels it is made of were read
+static void downsample_texels(uint8_t* texels, uint32_t size)
+{
+    uint32_t half = size / 2;
+
+    for(uint32_t y = 0; y < half; y++)
+    {
+        for(uint32_t x = 0; x < half; x++)
+        {
+            const uint8_t* top = &texels[((size_t) (y * 2) * size + x * 2) * TEXTURE_TEXEL_SIZE];
+            const uint8_t* bottom = top + (size_t) size * TEXTURE_TEXEL_SIZE;
+
+            for(uint32_t c = 0; c < TEXTURE_TEXEL_SIZE; c++)
+            {
+                texels[((size_t) y * half + x) * TEXTURE_TEXEL_SIZE + c] = (uint8_t) ((top[c] + top[TEXTURE_TEXEL_SIZE + c] + bottom[c] + bottom[TEXTURE_TEXEL_SIZE + c] + 2) / 4);
+            }
+        }
+    }
+}
+
+// fills the payload of mip. the dds blocks are copied or transcoded to rgba8 when the device cannot sample bc1,
+// the other sources are decoded to rgba8 and encoded to bc1 mip by mip when the texture is compressed
+static bool decode_texture(const struct streamed_texture* texture, uint32_t mip, uint8_t* payload, bool* transcoded)
+{
+    bool status = true;
+
+    uint32_t size = texture->size >> mip;
+    uint8_t* scratch = NULL;
+
+    *transcoded = false;
+
+    if(texture->source == TEXTURE_SOURCE_DDS)
+    {
+        if(texture->format == VK_FORMAT_R8G8B8A8_UNORM)
+        {
+            size_t bytes = 0;
+
+            for(uint32_t i = mip; i < texture->mip_count; i++)
+            {
+                bytes += get_bc1_size(texture->size >> i, texture->size >> i);
+            }
+
+            scratch = malloc(bytes);
+
+            if(scratch == NULL)
+            {
+                LOG_ERROR("Failed to allocate memory\n");
+                status = false;
+            }
+
+            if(status)
+            {
+                status = read_dds_mips(texture, mip, scratch);
+            }
+
+            if(status)
+            {
+                const uint8_t* blocks = scratch;
+
+                for(uint32_t i = mip; i < texture->mip_count; i++)
+                {
+                    uint32_t level_size = texture->size >> i;
+
+                    decode_bc1(blocks, level_size, level_size, payload);
+
+                    blocks += get_bc1_size(level_size, level_size);
+                    payload += get_level_bytes(VK_FORMAT_R8G8B8A8_UNORM, level_size);
+                }
+
+                *transcoded = true;
+            }
+        }
+        else
+        {
+            status = read_dds_mips(texture, mip, payload);
+        }
+    }
+    else
+    {
+        uint8_t* texels = payload;
+
+        if(!are_texture_mips_generated(texture))
+        {
+            scratch = malloc((size_t) size * size * TEXTURE_TEXEL_SIZE);
+            texels = scratch;
+
+            if(scratch == NULL)
+            {
+                LOG_ERROR("Failed to allocate memory\n");
+                status = false;
+            }
+        }
+
+        if(status)
+        {
+            if(texture->source == TEXTURE_SOURCE_PPM)
+            {
+                status = decode_ppm(texture->path, size, texels);
+            }
+            else
+            {
+                generate_texels(texture->seed, size, texels);
+            }
+        }
+
+        if(status && !are_texture_mips_generated(texture))
+        {
+            for(uint32_t i = mip; i < texture->mip_count; i++)
+            {
+                uint32_t level_size = texture->size >> i;
+
+                encode_bc1(texels, level_size, level_size, payload);
+                payload += get_bc1_size(level_size, level_size);
+
+                downsample_texels(texels, level_size);
+            }
+        }
+    }
+
+    if(scratch != NULL)
+    {
+        free(scratch);
+        scratch = NULL;
+    }
+
+    return status;
+}
+
+static int texture_decode_thread(void* data)
+{
+    (void) data;
+
+    SDL_LockMutex(g_texture_streaming.mutex);
+
+    while(!g_texture_streaming.quit)
+    {
+        struct texture_job* job = NULL;
+
+        for(uint32_t i = 0; i < TEXTURE_MAX_JOBS; i++)
+        {
+            if(g_texture_streaming.jobs[i].state == TEXTURE_JOB_QUEUED)
+            {
+                job = &g_texture_streaming.jobs[i];
+                break;
+            }
+        }
+
+        if(job != NULL)
+        {
+            job->state = TEXTURE_JOB_DECODING;
+
+            // the source of a texture never changes after it was created, it can be read without the lock
+            const struct streamed_texture* texture = &g_texture_streaming.textures[job->texture];
+            uint32_t mip = job->mip;
+
+            SDL_UnlockMutex(g_texture_streaming.mutex);
+
+            uint8_t* payload = malloc((size_t) get_payload_bytes(texture, mip));
+            bool transcoded = false;
+            bool decoded = (payload != NULL) && decode_texture(texture, mip, payload, &transcoded);
+
+            if((!decoded) && (payload != NULL))
+            {
+                free(payload);
+                payload = NULL;
+            }
+
+            SDL_LockMutex(g_texture_streaming.mutex);
+
+            job->payload = payload;
+            job->transcoded = transcoded;
+            job->state = decoded ? TEXTURE_JOB_DECODED : TEXTURE_JOB_FAILED;
+        }
+        else
+        {
+            SDL_CondWait(g_texture_streaming.job_cond, g_texture_streaming.mutex);
+        }
+    }
+
+    SDL_UnlockMutex(g_texture_streaming.mutex);
+
+    return 0;
+}
+
+// fails when all jobs are taken, the request is repeated by a later update
+static bool queue_texture_decode(uint32_t texture, uint32_t mip)
+{
+    bool queued = false;
+
+    SDL_LockMutex(g_texture_streaming.mutex);
+
+    for(uint32_t i = 0; i < TEXTURE_MAX_JOBS; i++)
+    {
+        struct texture_job* job = &g_texture_streaming.jobs[i];
+
+        if(job->state == TEXTURE_JOB_FREE)
+        {
+            job->state = TEXTURE_JOB_QUEUED;
+            job->texture = texture;
+            job->mip = mip;
+            job->payload = NULL;
+
+            SDL_CondSignal(g_texture_streaming.job_cond);
+
+            queued = true;
+            break;
+        }
+    }
+
+    SDL_UnlockMutex(g_texture_streaming.mutex);
+
+    if(queued)
+    {
+        g_texture_streaming.textures[texture].requested_mip = mip;
+    }
+
+    return queued;
+}
+
+// copies copy_count mips, either all of them or only mip 0 with the others generated by linear blits. every mip
+// ends up in shader read only layout for the fragment shaders of the frame queue
+static void record_texture_upload(VkCommandBuffer command_buffer, VkBuffer staging_buffer, VkDeviceSize offset, const struct gpu_image* image, uint32_t copy_count)
+{
+    VkImageMemoryBarrier barrier;
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.pNext = NULL;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image->handle;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = image->mip_count;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = 1;
+
+    vk_ctx->cmd_pipeline_barrier(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+
+    VkBufferImageCopy region;
+    region.bufferOffset = offset;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset.x = 0;
+    region.imageOffset.y = 0;
+    region.imageOffset.z = 0;
+    region.imageExtent.depth = 1;
+
+    // the mips are tightly packed, the blocks of the compressed mips below 4x4 are padded
+    for(uint32_t mip = 0; mip < copy_count; mip++)
+    {
+        region.imageSubresource.mipLevel = mip;
+        region.imageExtent.width = image->extent.width >> mip;
+        region.imageExtent.height = image->extent.height >> mip;
+
+        vk_ctx->cmd_copy_buffer_to_image(command_buffer, staging_buffer, image->handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+        region.bufferOffset += get_level_bytes(image->format, image->extent.width >> mip);
+    }
+
+    for(uint32_t mip = copy_count; mip < image->mip_count; mip++)
+    {
+        // the previous mip was written by the copy or the last blit and is the source of this one
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.subresourceRange.baseMipLevel = mip - 1;
+        barrier.subresourceRange.levelCount = 1;
+
+        vk_ctx->cmd_pipeline_barrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL, 0, NULL, 1, &barrier);
+
+        VkImageBlit blit;
+        blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.srcSubresource.mipLevel = mip - 1;
+        blit.srcSubresource.baseArrayLayer = 0;
+        blit.srcSubresource.layerCount = 1;
+        blit.srcOffsets[0].x = 0;
+        blit.srcOffsets[0].y = 0;
+        blit.srcOffsets[0].z = 0;
+        blit.srcOffsets[1].x = (int32_t) (image->extent.width >> (mip - 1));
+        blit.srcOffsets[1].y = (int32_t) (image->extent.height >> (mip - 1));
+        blit.srcOffsets[1].z = 1;
+        blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        blit.dstSubresource.mipLevel = mip;
+        blit.dstSubresource.baseArrayLayer = 0;
+        blit.dstSubresource.layerCount = 1;
+        blit.dstOffsets[0].x = 0;
+        blit.dstOffsets[0].y = 0;
+        blit.dstOffsets[0].z = 0;
+        blit.dstOffsets[1].x = (int32_t) (image->extent.width >> mip);
+        blit.dstOffsets[1].y = (int32_t) (image->extent.height >> mip);
+        blit.dstOffsets[1].z = 1;
+
+        vk_ctx->cmd_blit_image(command_buffer, image->handle, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, image->handle, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+    }
+
+    // with blits all mips but the last one were blit sources, the last one was only written
+    VkImageMemoryBarrier barriers[2];
+    uint32_t barrier_count = 0;
+
+    if(copy_count < image->mip_count)
+    {
+        barriers[barrier_count] = barrier;
+        barriers[barrier_count].srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barriers[barrier_count].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barriers[barrier_count].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barriers[barrier_count].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barriers[barrier_count].subresourceRange.baseMipLevel = 0;
+        barriers[barrier_count].subresourceRange.levelCount = image->mip_count - 1;
+        barrier_count++;
+    }
+
+    barriers[barrier_count] = barrier;
+    barriers[barrier_count].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barriers[barrier_count].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barriers[barrier_count].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barriers[barrier_count].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barriers[barrier_count].subresourceRange.baseMipLevel = (copy_count < image->mip_count) ? image->mip_count - 1 : 0;
+    barriers[barrier_count].subresourceRange.levelCount = (copy_count < image->mip_count) ? 1 : image->mip_count;
+    barrier_count++;
+
+    vk_ctx->cmd_pipeline_barrier(command_buffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, NULL, 0, NULL, barrier_count, barriers);
+}
+
+// returns NULL while the batches of all slots are still in flight
+static struct texture_upload_slot* begin_texture_upload(void)
+{
+    struct texture_upload_slot* slot = &g_texture_streaming.upload_slots[g_texture_streaming.next_upload_slot];
+
+    if(is_queue_point_reached(&slot->point))
+    {
+        VkCommandBufferBeginInfo info;
+        info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        info.pNext = NULL;
+        info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        info.pInheritanceInfo = NULL;
+
+        if(vk_ctx->begin_command_buffer(slot->command_buffer, &info) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to begin texture upload command buffer\n");
+            slot = NULL;
+        }
+    }
+    else
+    {
+        slot = NULL;
+    }
+
+    return slot;
+}
+
+static bool submit_texture_upload(struct texture_upload_slot* slot)
+{
+    bool status = true;
+
+    if(vk_ctx->end_command_buffer(slot->command_buffer) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to end texture upload command buffer\n");
+        status = false;
+    }
+
+    if(status)
+    {
+        struct queue_submission submission;
+        init_queue_submission(&submission, 1, &slot->command_buffer);
+
+        status = submit_to_queue(QUEUE_CLASS_BULK, &submission, &slot->point);
+    }
+
+    if(status)
+    {
+        g_texture_streaming.next_upload_slot = (g_texture_streaming.next_upload_slot + 1) % TEXTURE_UPLOAD_SLOTS;
+    }
+
+    return status;
+}
+
+// the frames that were submitted so far may still sample the image, it goes away after the last of them
+static void release_texture_image(struct streamed_texture* texture)
+{
+    struct queue_point frame_point;
+    get_last_queue_point(QUEUE_CLASS_FRAME, &frame_point);
+
+    if(texture->bindless_index != BINDLESS_INVALID_INDEX)
+    {
+        release_bindless_texture(texture->bindless_index, &frame_point);
+        texture->bindless_index = BINDLESS_INVALID_INDEX;
+    }
+
+    defer_gpu_image_destruction(&texture->image, get_queue_timeline(QUEUE_CLASS_FRAME), frame_point.value);
+
+    texture->resident_mip = texture->mip_count;
+}
+
+static void evict_texture(struct streamed_texture* texture)
+{
+    g_texture_streaming.stats.bytes_streamed_out += get_texture_bytes(texture, texture->resident_mip);
+    g_texture_streaming.stats.evictions++;
+
+    release_texture_image(texture);
+}
+
+// the resident texture that was used least recently and has no request in flight. with in_use false the
+// textures used by the last frames are skipped, with true only textures that can lose a mip are considered
+static struct streamed_texture* find_lru_texture(const struct streamed_texture* exclude, bool in_use)
+{
+    struct streamed_texture* lru = NULL;
+
+    for(uint32_t i = 0; i < g_texture_streaming.texture_count; i++)
+    {
+        struct streamed_texture* texture = &g_texture_streaming.textures[i];
+
+        bool candidate = (texture != exclude) && (texture->resident_mip < texture->mip_count) && !is_texture_busy(texture);
+
+        if(in_use)
+        {
+            candidate = candidate && (texture->resident_mip + 1 < texture->mip_count);
+        }
+        else
+        {
+            candidate = candidate && !is_texture_in_use(texture);
+        }
+
+        if(candidate && ((lru == NULL) || (texture->last_used_frame < lru->last_used_frame)))
+        {
+            lru = texture;
+        }
+    }
+
+    return lru;
+}
+
+// evicts the unused textures until mip of texture fits into the budget. nothing is evicted when it would not
+// fit even without all of them
+static bool make_texture_room(struct streamed_texture* texture, uint32_t mip)
+{
+    VkDeviceSize committed = get_committed_bytes() - get_texture_bytes(texture, texture->resident_mip) + get_texture_bytes(texture, mip);
+    VkDeviceSize evictable = 0;
+
+    for(uint32_t i = 0; i < g_texture_streaming.texture_count; i++)
+    {
+        struct streamed_texture* other = &g_texture_streaming.textures[i];
+
+        if((other != texture) && !is_texture_busy(other) && !is_texture_in_use(other))
+        {
+            evictable += get_texture_bytes(other, other->resident_mip);
+        }
+    }
+
+    bool fits = (committed <= get_texture_budget() + evictable);
+
+    while(fits && (committed > get_texture_budget()))
+    {
+        struct streamed_texture* lru = find_lru_texture(texture, false);
+
+        committed -= get_texture_bytes(lru, lru->resident_mip);
+        evict_texture(lru);
+    }
+
+    return fits;
+}
+
+// swaps the uploads that completed in as the resident images
+static void activate_texture_uploads(void)
+{
+    for(uint32_t i = 0; i < g_texture_streaming.texture_count; i++)
+    {
+        struct streamed_texture* texture = &g_texture_streaming.textures[i];
+
+        if(texture->uploading && is_queue_point_reached(&texture->pending_point))
+        {
+            if(texture->resident_mip < texture->mip_count)
+            {
+                if(texture->requested_mip > texture->resident_mip)
+                {
+                    g_texture_streaming.stats.bytes_streamed_out += get_texture_bytes(texture, texture->resident_mip) - get_texture_bytes(texture, texture->requested_mip);
+                }
+
+                release_texture_image(texture);
+            }
+
+            texture->image = texture->pending_image;
+            memset(&texture->pending_image, 0, sizeof(struct gpu_image));
+
+            texture->bindless_index = register_bindless_texture(texture->image.view);
+
+            if(texture->bindless_index != BINDLESS_INVALID_INDEX)
+            {
+                texture->resident_mip = texture->requested_mip;
+
+                // the upload already completed, the wait of the frame makes the writes of the bulk queue
+                // visible to it. both queues are of the graphics family, the images need no ownership transfer
+                if(texture->pending_point.value > g_texture_streaming.upload_point.value)
+                {
+                    g_texture_streaming.upload_point = texture->pending_point;
+                }
+            }
+            else
+            {
+                LOG_WARNING("Texture table is full\n");
+                destroy_gpu_image(&texture->image);
+            }
+
+            texture->requested_mip = texture->mip_count;
+            texture->uploading = false;
+        }
+    }
+}
+
+// uploads the finished decodes in one batch, the ones that do not fit into the staging buffer of the slot
+// wait for the next update
+static bool upload_decoded_textures(void)
+{
+    bool status = true;
+
+    struct texture_job* jobs[TEXTURE_MAX_JOBS];
+    uint32_t job_count = 0;
+
+    SDL_LockMutex(g_texture_streaming.mutex);
+
+    for(uint32_t i = 0; i < TEXTURE_MAX_JOBS; i++)
+    {
+        if((g_texture_streaming.jobs[i].state == TEXTURE_JOB_DECODED) || (g_texture_streaming.jobs[i].state == TEXTURE_JOB_FAILED))
+        {
+            jobs[job_count] = &g_texture_streaming.jobs[i];
+            job_count++;
+        }
+    }
+
+    SDL_UnlockMutex(g_texture_streaming.mutex);
+
+    struct texture_upload_slot* slot = NULL;
+    VkDeviceSize staging_offset = 0;
+
+    struct streamed_texture* uploads[TEXTURE_MAX_JOBS];
+    uint32_t upload_count = 0;
+
+    for(uint32_t i = 0; status && (i < job_count); i++)
+    {
+        struct texture_job* job = jobs[i];
+        struct streamed_texture* texture = &g_texture_streaming.textures[job->texture];
+
+        bool done = true;
+
+        if(job->state == TEXTURE_JOB_DECODED)
+        {
+            uint32_t size = texture->size >> job->mip;
+            VkDeviceSize bytes = get_payload_bytes(texture, job->mip);
+
+            // the copies need offsets aligned to the texel blocks of the formats that share the buffer
+            staging_offset = (staging_offset + TEXTURE_STAGING_ALIGNMENT - 1) & ~((VkDeviceSize) TEXTURE_STAGING_ALIGNMENT - 1);
+
+            if(slot == NULL)
+            {
+                slot = begin_texture_upload();
+            }
+
+            if((slot == NULL) || (staging_offset + bytes > TEXTURE_STAGING_SIZE))
+            {
+                done = false;
+            }
+            else
+            {
+                VkExtent2D extent = { size, size };
+
+                VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+                if(are_texture_mips_generated(texture))
+                {
+                    usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+                }
+
+                // a failed allocation drops the request, the texture keeps its resident mips
+                if(create_gpu_texture(extent, texture->format, texture->mip_count - job->mip, usage, &texture->pending_image))
+                {
+                    memcpy((uint8_t*) slot->staging_buffer.mapped + staging_offset, job->payload, (size_t) bytes);
+
+                    record_texture_upload(slot->command_buffer, slot->staging_buffer.handle, staging_offset, &texture->pending_image, get_payload_mip_count(texture, job->mip));
+
+                    staging_offset += bytes;
+
+                    texture->uploading = true;
+                    uploads[upload_count] = texture;
+                    upload_count++;
+
+                    g_texture_streaming.stats.bytes_streamed_in += bytes;
+                    g_texture_streaming.stats.decodes++;
+
+                    if(job->transcoded)
+                    {
+                        g_texture_streaming.stats.transcodes++;
+                    }
+                }
+                else
+                {
+                    texture->requested_mip = texture->mip_count;
+                }
+            }
+        }
+        else
+        {
+            texture->requested_mip = texture->mip_count;
+        }
+
+        if(done)
+        {
+            if(job->payload != NULL)
+            {
+                free(job->payload);
+                job->payload = NULL;
+            }
+
+            SDL_LockMutex(g_texture_streaming.mutex);
+            job->state = TEXTURE_JOB_FREE;
+            SDL_UnlockMutex(g_texture_streaming.mutex);
+        }
+    }
+
+    if(slot != NULL)
+    {
+        // an empty batch still has to be submitted, the command buffer was begun
+        status = submit_texture_upload(slot);
+    }
+
+    for(uint32_t i = 0; status && (i < upload_count); i++)
+    {
+        uploads[i]->pending_point = slot->point;
+    }
+
+    return status;
+}
+
+// over the budget the unused textures are evicted first, then the textures in use lose their finest mip. a
+// downgrade is decoded again at the coarser size, the resident image stays until its replacement is uploaded
+static void enforce_texture_budget(void)
+{
+    VkDeviceSize committed = get_committed_bytes();
+
+    while(committed > get_texture_budget())
+    {
+        struct streamed_texture* texture = find_lru_texture(NULL, false);
+
+        if(texture != NULL)
+        {
+            committed -= get_texture_bytes(texture, texture->resident_mip);
+            evict_texture(texture);
+        }
+        else
+        {
+            texture = find_lru_texture(NULL, true);
+
+            if((texture == NULL) || !queue_texture_decode((uint32_t) (texture - g_texture_streaming.textures), texture->resident_mip + 1))
+            {
+                break;
+            }
+
+            committed -= get_texture_bytes(texture, texture->resident_mip) - get_texture_bytes(texture, texture->requested_mip);
+            g_texture_streaming.stats.downgrades++;
+        }
+    }
+}
+
+// called by update_memory_budget on the thread that renders. only the unused textures are evicted, the ones in
+// use are left to enforce_texture_budget under the lowered limit
+static VkDeviceSize release_texture_memory(void* user_data, uint32_t heap_index, VkDeviceSize excess)
+{
+    (void) user_data;
+
+    VkDeviceSize released = 0;
+
+    if(vk_ctx->memory_properties.memoryHeaps[heap_index].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+    {
+        VkDeviceSize committed = get_committed_bytes();
+
+        while(released < excess)
+        {
+            struct streamed_texture* texture = find_lru_texture(NULL, false);
+
+            if(texture == NULL)
+            {
+                break;
+            }
+
+            released += get_texture_bytes(texture, texture->resident_mip);
+            evict_texture(texture);
+        }
+
+        committed = (committed > excess) ? committed - excess : 0;
+
+        if(committed < get_texture_budget())
+        {
+            g_texture_streaming.pressure_limit = committed;
+        }
+
+        g_texture_streaming.pressure_frame = g_texture_streaming.frame;
+    }
+
+    return released;
+}
+
+// requests the finest mip that fits for every texture the last frames asked for more than is resident
+static void request_textures(void)
+{
+    for(uint32_t i = 0; i < g_texture_streaming.texture_count; i++)
+    {
+        struct streamed_texture* texture = &g_texture_streaming.textures[i];
+
+        if(!is_texture_busy(texture) && is_texture_in_use(texture) && (texture->wanted_mip < texture->resident_mip))
+        {
+            for(uint32_t mip = texture->wanted_mip; mip < texture->resident_mip; mip++)
+            {
+                if(make_texture_room(texture, mip))
+                {
+                    queue_texture_decode(i, mip);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+static bool create_placeholder_texture(void)
+{
+    bool status = true;
+
+    VkExtent2D extent = { 1, 1 };
+    struct texture_upload_slot* slot = &g_texture_streaming.upload_slots[0];
+
+    status = create_gpu_texture(extent, VK_FORMAT_R8G8B8A8_UNORM, 1, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, &g_texture_streaming.placeholder);
+
+    if(status)
+    {
+        memset(slot->staging_buffer.mapped, TEXTURE_PLACEHOLDER, TEXTURE_TEXEL_SIZE);
+
+        slot = begin_texture_upload();
+
+        if(slot == NULL)
+        {
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        record_texture_upload(slot->command_buffer, slot->staging_buffer.handle, 0, &g_texture_streaming.placeholder, 1);
+
+        status = submit_texture_upload(slot);
+    }
+
+    if(status)
+    {
+        status = wait_for_queue_point(&slot->point);
+    }
+
+    if(status)
+    {
+        // registered first so it also fills the unused slots of the table
+        g_texture_streaming.placeholder_index = register_bindless_texture(g_texture_streaming.placeholder.view);
+
+        if(g_texture_streaming.placeholder_index == BINDLESS_INVALID_INDEX)
+        {
+            LOG_ERROR("Failed to register placeholder texture\n");
+            status = false;
+        }
+    }
+
+    return status;
+}
+
+// the payloads are bc1, the other block formats are reported to see what a device would take. a family is only
+// usable when its feature was enabled on the device
+static void probe_compressed_formats(void)
+{
+    struct compressed_format
+    {
+        const char* name;
+        VkFormat    format;
+        VkBool32    enabled;
+    };
+
+    const struct compressed_format formats[] =
+    {
+        { "BC7",      VK_FORMAT_BC7_UNORM_BLOCK,          vk_ctx->texture_compression_bc_supported },
+        { "BC1",      VK_FORMAT_BC1_RGB_UNORM_BLOCK,      vk_ctx->texture_compression_bc_supported },
+        { "ETC2",     VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK,  vk_ctx->texture_compression_etc2_supported },
+        { "ASTC 4x4", VK_FORMAT_ASTC_4x4_UNORM_BLOCK,     vk_ctx->texture_compression_astc_ldr_supported }
+    };
+
+    g_texture_streaming.compressed_format = VK_FORMAT_UNDEFINED;
+
+    for(uint32_t i = 0; i < sizeof(formats) / sizeof(formats[0]); i++)
+    {
+        VkFormat format = formats[i].format;
+
+        bool supported = formats[i].enabled && (find_supported_format(&format, 1, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) != VK_FORMAT_UNDEFINED);
+
+        LOG_DEBUG("Texture format %s: %s\n", formats[i].name, supported ? "supported" : "not supported");
+
+        if(supported && (format == VK_FORMAT_BC1_RGB_UNORM_BLOCK))
+        {
+            g_texture_streaming.compressed_format = format;
+        }
+    }
+
+    if(g_texture_streaming.compressed_format == VK_FORMAT_UNDEFINED)
+    {
+        LOG_WARNING("Compressed textures are transcoded to RGBA8\n");
+    }
+}
+
+bool initialize_texture_streaming(VkDeviceSize budget, bool compress)
+{
+    bool status = true;
+
+    memset(&g_texture_streaming, 0, sizeof(struct texture_streaming));
+
+    g_texture_streaming.budget = budget;
+    g_texture_streaming.pressure_limit = VK_WHOLE_SIZE;
+    g_texture_streaming.compress = compress;
+    g_texture_streaming.placeholder_index = BINDLESS_INVALID_INDEX;
+    g_texture_streaming.upload_point.queue_class = QUEUE_CLASS_BULK;
+
+    if(status)
+    {
+        // the mips are generated with linear blits and sampled trilinearly
+        VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+
+        if(find_supported_format(&format, 1, VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT | VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT) == VK_FORMAT_UNDEFINED)
+        {
+            LOG_ERROR("Texture format does not support linear blits\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        probe_compressed_formats();
+    }
+
+    if(status)
+    {
+        VkCommandPoolCreateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        info.pNext = NULL;
+        info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        info.queueFamilyIndex = get_queue_family(QUEUE_CLASS_BULK);
+
+        if(vk_ctx->create_command_pool(vk_ctx->device, &info, vk_ctx->allocation_callbacks, &g_texture_streaming.command_pool) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to create texture upload command pool\n");
+            status = false;
+        }
+    }
+
+    for(uint32_t i = 0; status && (i < TEXTURE_UPLOAD_SLOTS); i++)
+    {
+        struct texture_upload_slot* slot = &g_texture_streaming.upload_slots[i];
+
+        // the value 0 lets the first use of each slot pass without waiting
+        slot->point.queue_class = QUEUE_CLASS_BULK;
+
+        VkCommandBufferAllocateInfo info;
+        info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        info.pNext = NULL;
+        info.commandPool = g_texture_streaming.command_pool;
+        info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        info.commandBufferCount = 1;
+
+        if(vk_ctx->allocate_command_buffers(vk_ctx->device, &info, &slot->command_buffer) != VK_SUCCESS)
+        {
+            LOG_ERROR("Failed to allocate texture upload command buffer\n");
+            status = false;
+        }
+
+        if(status)
+        {
+            status = create_gpu_buffer(TEXTURE_STAGING_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &slot->staging_buffer);
+        }
+    }
+
+    if(status)
+    {
+        status = create_placeholder_texture();
+    }
+
+    if(status)
+    {
+        g_texture_streaming.mutex = SDL_CreateMutex();
+        g_texture_streaming.job_cond = SDL_CreateCond();
+
+        if((g_texture_streaming.mutex == NULL) || (g_texture_streaming.job_cond == NULL))
+        {
+            LOG_ERROR("Failed to create texture streaming synchronization objects\n");
+            status = false;
+        }
+    }
+
+    for(uint32_t i = 0; status && (i < TEXTURE_WORKER_COUNT); i++)
+    {
+        g_texture_streaming.threads[i] = SDL_CreateThread(texture_decode_thread, "texture decode", NULL);
+
+        if(g_texture_streaming.threads[i] == NULL)
+        {
+            LOG_ERROR("Failed to create texture decode thread\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        status = add_memory_pressure_callback(vk_ctx, release_texture_memory, NULL);
+    }
+
+    if(!status)
+    {
+        uninitialize_texture_streaming();
+    }
+
+    return status;
+}
+
+void uninitialize_texture_streaming(void)
+{
+    remove_memory_pressure_callback(vk_ctx, release_texture_memory, NULL);
+
+    if(g_texture_streaming.mutex != NULL)
+    {
+        SDL_LockMutex(g_texture_streaming.mutex);
+        g_texture_streaming.quit = true;
+        SDL_CondBroadcast(g_texture_streaming.job_cond);
+        SDL_UnlockMutex(g_texture_streaming.mutex);
+    }
+
+    for(uint32_t i = 0; i < TEXTURE_WORKER_COUNT; i++)
+    {
+        if(g_texture_streaming.threads[i] != NULL)
+        {
+            SDL_WaitThread(g_texture_streaming.threads[i], NULL);
+            g_texture_streaming.threads[i] = NULL;
+        }
+    }
+
+    if(g_texture_streaming.texture_count > 0)
+    {
+        print_texture_streaming_stats();
+    }
+
+    for(uint32_t i = 0; i < TEXTURE_MAX_JOBS; i++)
+    {
+        if(g_texture_streaming.jobs[i].payload != NULL)
+        {
+            free(g_texture_streaming.jobs[i].payload);
+            g_texture_streaming.jobs[i].payload = NULL;
+        }
+
+        g_texture_streaming.jobs[i].state = TEXTURE_JOB_FREE;
+    }
+
+    // the device is idle, the bindless table releases its slots when it is destroyed
+    for(uint32_t i = 0; i < g_texture_streaming.texture_count; i++)
+    {
+        struct streamed_texture* texture = &g_texture_streaming.textures[i];
+
+        destroy_gpu_image(&texture->pending_image);
+        destroy_gpu_image(&texture->image);
+
+        if(texture->path != NULL)
+        {
+            free(texture->path);
+            texture->path = NULL;
+        }
+    }
+
+    g_texture_streaming.texture_count = 0;
+
+    destroy_gpu_image(&g_texture_streaming.placeholder);
+
+    for(uint32_t i = 0; i < TEXTURE_UPLOAD_SLOTS; i++)
+    {
+        destroy_gpu_buffer(&g_texture_streaming.upload_slots[i].staging_buffer);
+    }
+
+    if(g_texture_streaming.command_pool != NULL)
+    {
+        vk_ctx->destroy_command_pool(vk_ctx->device, g_texture_streaming.command_pool, vk_ctx->allocation_callbacks);
+        g_texture_streaming.command_pool = NULL;
+
+        for(uint32_t i = 0; i < TEXTURE_UPLOAD_SLOTS; i++)
+        {
+            g_texture_streaming.upload_slots[i].command_buffer = NULL;
+        }
+    }
+
+    if(g_texture_streaming.job_cond != NULL)
+    {
+        SDL_DestroyCond(g_texture_streaming.job_cond);
+        g_texture_streaming.job_cond = NULL;
+    }
+
+    if(g_texture_streaming.mutex != NULL)
+    {
+        SDL_DestroyMutex(g_texture_streaming.mutex);
+        g_texture_streaming.mutex = NULL;
+    }
+}
+
+uint32_t create_streamed_texture(const char* path, uint32_t size, uint32_t seed)
+{
+    bool status = true;
+
+    uint32_t index = g_texture_streaming.texture_count;
+    struct streamed_texture* texture = &g_texture_streaming.textures[index];
+
+    if(index == TEXTURE_MAX_COUNT)
+    {
+        LOG_ERROR("Too many textures\n");
+        status = false;
+    }
+
+    if(status)
+    {
+        memset(texture, 0, sizeof(struct streamed_texture));
+    }
+
+    if(status && (path != NULL))
+    {
+        uint32_t square = 0;
+
+        status = read_texture_header(path, &texture->source, &square);
+
+        if(status)
+        {
+            if((size == 0) || (size > square))
+            {
+                size = square;
+            }
+
+            texture->file_size = square;
+
+            size_t length = strlen(path) + 1;
+            texture->path = malloc(length);
+
+            if(texture->path == NULL)
+            {
+                LOG_ERROR("Failed to allocate memory\n");
+                status = false;
+            }
+            else
+            {
+                memcpy(texture->path, path, length);
+            }
+        }
+    }
+
+    if(status)
+    {
+        if(size > TEXTURE_MAX_SIZE)
+        {
+            size = TEXTURE_MAX_SIZE;
+        }
+
+        if(size == 0)
+        {
+            LOG_ERROR("Texture size must not be 0\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        // the mips halve exactly down to 1x1
+        texture->size = 1;
+
+        while(texture->size * 2 <= size)
+        {
+            texture->size *= 2;
+        }
+
+        VkExtent2D extent = { texture->size, texture->size };
+
+        // the larger mips of a dds file are skipped
+        while((texture->file_size >> texture->file_mip) > texture->size)
+        {
+            texture->file_mip++;
+        }
+
+        if(texture->source == TEXTURE_SOURCE_DDS)
+        {
+            texture->format = (g_texture_streaming.compressed_format != VK_FORMAT_UNDEFINED) ? g_texture_streaming.compressed_format : VK_FORMAT_R8G8B8A8_UNORM;
+        }
+        else
+        {
+            texture->format = g_texture_streaming.compress ? g_texture_streaming.compressed_format : VK_FORMAT_UNDEFINED;
+            texture->format = (texture->format != VK_FORMAT_UNDEFINED) ? texture->format : VK_FORMAT_R8G8B8A8_UNORM;
+        }
+
+        texture->seed = seed;
+        texture->mip_count = get_mip_count(extent);
+        texture->wanted_mip = texture->mip_count;
+        texture->resident_mip = texture->mip_count;
+        texture->requested_mip = texture->mip_count;
+        texture->bindless_index = BINDLESS_INVALID_INDEX;
+        texture->pending_point.queue_class = QUEUE_CLASS_BULK;
+
+        g_texture_streaming.texture_count++;
+    }
+
+    return status ? index : TEXTURE_INVALID;
+}
+
+bool update_texture_streaming(uint64_t frame)
+{
+    bool status = true;
+
+    g_texture_streaming.frame = frame;
+
+    if((g_texture_streaming.pressure_limit != VK_WHOLE_SIZE) && (frame > g_texture_streaming.pressure_frame + TEXTURE_PRESSURE_FRAMES))
+    {
+        LOG_INFO("Texture budget restored after memory pressure\n");
+        g_texture_streaming.pressure_limit = VK_WHOLE_SIZE;
+    }
+
+    activate_texture_uploads();
+
+    status = upload_decoded_textures();
+
+    if(status)
+    {
+        enforce_texture_budget();
+        request_textures();
+    }
+
+    return status;
+}
+
+uint32_t use_streamed_texture(uint32_t texture, uint32_t wanted_mip)
+{
+    uint32_t index = g_texture_streaming.placeholder_index;
+
+    if(texture < g_texture_streaming.texture_count)
+    {
+        struct streamed_texture* streamed = &g_texture_streaming.textures[texture];
+
+        if(wanted_mip >= streamed->mip_count)
+        {
+            wanted_mip = streamed->mip_count - 1;
+        }
+
+        // the finest mip any use of the frame asked for
+        if((streamed->last_used_frame != g_texture_streaming.frame) || (wanted_mip < streamed->wanted_mip))
+        {
+            streamed->wanted_mip = wanted_mip;
+        }
+
+        streamed->last_used_frame = g_texture_streaming.frame;
+
+        if(streamed->bindless_index != BINDLESS_INVALID_INDEX)
+        {
+            index = streamed->bindless_index;
+        }
+
+        if(streamed->resident_mip <= wanted_mip)
+        {
+            g_texture_streaming.stats.hits++;
+        }
+        else
+        {
+            g_texture_streaming.stats.misses++;
+        }
+    }
+
+    return index;
+}
+
+uint32_t get_streamed_texture_mip(uint32_t texture, uint32_t pixels)
+{
+    uint32_t mip = 0;
+
+    if(texture < g_texture_streaming.texture_count)
+    {
+        const struct streamed_texture* streamed = &g_texture_streaming.textures[texture];
+
+        while((mip + 1 < streamed->mip_count) && ((streamed->size >> (mip + 1)) >= pixels))
+        {
+            mip++;
+        }
+    }
+
+    return mip;
+}
+
+void get_texture_upload_point(struct queue_point* point)
+{
+    *point = g_texture_streaming.upload_point;
+}
+
+void set_texture_streaming_budget(VkDeviceSize budget)
+{
+    g_texture_streaming.budget = budget;
+}
+
+void get_texture_streaming_stats(struct texture_streaming_stats* stats)
+{
+    *stats = g_texture_streaming.stats;
+
+    stats->resident_textures = 0;
+    stats->resident_bytes = 0;
+    stats->budget = get_texture_budget();
+
+    for(uint32_t i = 0; i < g_texture_streaming.texture_count; i++)
+    {
+        const struct streamed_texture* texture = &g_texture_streaming.textures[i];
+
+        if(texture->resident_mip < texture->mip_count)
+        {
+            stats->resident_textures++;
+            stats->resident_bytes += get_texture_bytes(texture, texture->resident_mip);
+        }
+    }
+}
+
+void print_texture_streaming_stats(void)
+{
+    struct texture_streaming_stats stats;
+    get_texture_streaming_stats(&stats);
+
+    uint64_t uses = stats.hits + stats.misses;
+
+    LOG_INFO("Textures: %u of %u resident, %.1f of %.1f MB, %.1f%% hits, %.1f MB in, %.1f MB out, %u decodes (%u transcoded), %u evictions, %u downgrades\n",
+           stats.resident_textures, g_texture_streaming.texture_count,
+           (double) stats.resident_bytes / (1024.0 * 1024.0), (double) stats.budget / (1024.0 * 1024.0),
+           (uses > 0) ? 100.0 * (double) stats.hits / (double) uses : 0.0,
+           (double) stats.bytes_streamed_in / (1024.0 * 1024.0), (double) stats.bytes_streamed_out / (1024.0 * 1024.0),
+           stats.decodes, stats.transcodes, stats.evictions, stats.downgrades);
+}
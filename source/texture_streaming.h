@@ -0,0 +1,67 @@
+#ifndef TEXTURE_STREAMING_H
+#define TEXTURE_STREAMING_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <vulkan/vulkan.h>
+
+#include "queue_scheduler.h"
+
+enum { TEXTURE_MAX_COUNT        = 64 };
+enum { TEXTURE_MAX_SIZE         = 1024 }; // of the first mip, larger sources are scaled down
+enum { TEXTURE_WORKER_COUNT     = 2 };
+enum { TEXTURE_MAX_JOBS         = 16 };   // decodes queued, running or waiting for an upload
+enum { TEXTURE_UPLOAD_SLOTS     = 3 };    // batches of uploads in flight on the bulk queue
+enum { TEXTURE_STAGING_SIZE     = 8 * 1024 * 1024 }; // bytes per upload slot
+enum { TEXTURE_INVALID          = 0xFFFFFFFF };
+
+struct texture_streaming_stats
+{
+    uint64_t     hits;               // uses that found the wanted mip resident
+    uint64_t     misses;             // uses served by a coarser mip or the placeholder
+    uint64_t     bytes_streamed_in;  // payloads uploaded, the mips generated on the gpu are not included
+    uint64_t     bytes_streamed_out; // of the images released by evictions and downgrades
+    uint32_t     decodes;
+    uint32_t     transcodes;         // decodes of bc1 payloads to rgba8 for a device without bc1
+    uint32_t     evictions;
+    uint32_t     downgrades;
+    uint32_t     resident_textures;
+    VkDeviceSize resident_bytes;     // all mips of the resident images
+    VkDeviceSize budget;             // lower than the one set while the device local heaps are under pressure
+};
+
+// textures are images with a full mip chain. the mips from the finest one that is requested down are decoded on
+// a worker thread and uploaded on the bulk queue. they stay bc1 compressed on the gpu when the device samples
+// bc1, rgba8 textures only upload the finest mip and generate the others with vkCmdBlitImage. budget limits
+// the bytes of the resident images, the texture that was used least recently is evicted or loses its finest
+// mip when a new one does not fit. under memory pressure from vk_context the unused textures are evicted and the
+// budget is held below the bytes still resident for a while. with compress the generated and ppm textures are
+// encoded to bc1 as well
+bool initialize_texture_streaming(VkDeviceSize budget, bool compress);
+void uninitialize_texture_streaming(void);
+
+// the texels come from a binary ppm (P6) file or a dds file with bc1 (DXT1) blocks and all mips, or are
+// generated from seed when path is NULL. size 0 takes the size of the file. only the header of the file is
+// read here. returns TEXTURE_INVALID on failure
+uint32_t create_streamed_texture(const char* path, uint32_t size, uint32_t seed);
+
+// call once per frame before the textures are used. activates the uploads that completed, evicts under the
+// budget, uploads the finished decodes and queues decodes for the textures used in the previous frames
+bool update_texture_streaming(uint64_t frame);
+
+// marks the texture as used by the frame and asks for wanted_mip (0 is the full resolution). returns the bindless
+// index of the best resident version, the placeholder while nothing is resident
+uint32_t use_streamed_texture(uint32_t texture, uint32_t wanted_mip);
+
+// the coarsest mip that still has at least pixels texels along each side
+uint32_t get_streamed_texture_mip(uint32_t texture, uint32_t pixels);
+
+// the upload of the textures activated last, the frame that samples them waits for it. the value 0 if none
+void get_texture_upload_point(struct queue_point* point);
+
+void set_texture_streaming_budget(VkDeviceSize budget);
+void get_texture_streaming_stats(struct texture_streaming_stats* stats);
+void print_texture_streaming_stats(void);
+
+#endif // TEXTURE_STREAMING_H
@@ -1,45 +1,104 @@
 
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include <SDL2/SDL.h>
+
+#include "logger.h"
 #include "vk_context.h"
 
-struct vk_context  g_vk_ctx = { 0 };
-struct vk_context* vk_ctx   = &g_vk_ctx;
+struct vk_allocation_header
+{
+    uint64_t size;
+    uint64_t reserved[3];
+};
 
-VkAllocationCallbacks g_allocation_callbacks = { 0 };
+enum { MAX_DEFERRED_DESTRUCTIONS  = 256 };
+enum { INVALID_INDEX              = 0xFFFFFFFF };
 
-struct vk_memory_usage
+struct deferred_destruction
 {
-    uint64_t size;
-} g_vk_memory_usage;
+    VkObjectType type;
+    uint64_t     handle;
+    VkSemaphore  timeline;
+    uint64_t     value;
+};
 
-struct vk_allocation_header
+// kept in the order the objects were deferred, collecting compacts the array
+struct deferred_destruction_queue
 {
-    uint64_t size;
-    uint64_t reserved[3];
+    struct deferred_destruction entries[MAX_DEFERRED_DESTRUCTIONS];
+    uint32_t                    count;
+};
+
+struct memory_pressure_callback
+{
+    vk_memory_pressure_callback callback;
+    void*                       user_data;
 };
 
-enum { MAX_EXTENSIONS = 16 };
-enum { INVALID_INDEX  = 0xFFFFFFFF };
+// everything a context needs besides its vulkan objects. the allocation callbacks may be called from any thread
+// that uses the device, the stats are guarded by a spin lock
+struct vk_context_state
+{
+    VkAllocationCallbacks             allocation_callbacks;
+
+    SDL_SpinLock                      stats_lock;
+    struct vk_context_stats           stats;
+
+    struct deferred_destruction_queue deferred_destructions;
+
+    struct memory_pressure_callback   memory_pressure_callbacks[VK_CTX_MAX_MEMORY_PRESSURE_CALLBACKS];
+    uint32_t                          memory_pressure_callback_count;
+
+    // an overrun is logged when it starts. after the callbacks were asked the heap is skipped for a few updates,
+    // the memory they release is destroyed once the frames in flight completed
+    bool                              heap_over_budget[VK_MAX_MEMORY_HEAPS];
+    uint32_t                          heap_pressure_cooldowns[VK_MAX_MEMORY_HEAPS];
+
+    // the logger behind the debug utils messenger of the instance, NULL in release builds
+    struct debug_messenger*           debug_messenger;
+};
 
 struct gpu_info
 {
     VkPhysicalDevice                     handle;
     VkPhysicalDeviceProperties           properties;
     VkPhysicalDeviceFeatures             features;
+    VkPhysicalDeviceMemoryProperties     memory_properties;
+
+    uint8_t                              device_uuid[VK_UUID_SIZE];
+    VkBool32                             device_uuid_valid;
 
     uint32_t                             queue_group_count;
     VkQueueFamilyProperties*             queue_group_properties;
 };
 
+// the slots are an open addressing hash table over the names in array, built once per enumeration. a slot
+// holds the index into array + 1, 0 marks an empty slot
 struct extension_list
 {
     uint32_t               count;
     VkExtensionProperties* array;
+
+    uint32_t               slot_count; // power of two, at least twice the count
+    uint32_t*              slots;
+};
+
+// the extensions enabled for an instance or a device. names points into the available list and is passed as
+// ppEnabledExtensionNames, enabling an extension twice keeps one entry. missing required extensions are counted
+// so that all of them are reported before creation fails
+struct extension_set
+{
+    struct extension_list* available;
+    uint8_t*               enabled; // per entry of available
+    const char**           names;
+    uint32_t               count;
+    uint32_t               missing_count;
 };
 
 struct layer_list
@@ -50,33 +109,75 @@ struct layer_list
     struct extension_list* extension_lists;
 };
 
-bool     initialize_global_function_pointers(void);
-bool     initialize_instance_function_pointers(void);
-bool     initialize_device_function_pointers(void);
-bool     initialize_allocation_callbacks(void);
+bool     initialize_global_function_pointers(struct vk_context* ctx);
+bool     initialize_instance_function_pointers(struct vk_context* ctx);
+bool     initialize_device_function_pointers(struct vk_context* ctx);
+bool     initialize_allocation_callbacks(struct vk_context* ctx);
+
+bool     initialize_instance(struct vk_context* ctx, uint32_t ext_count, const char** ext_array, const struct vk_context_options* options);
+bool     initialize_device(struct vk_context* ctx, const struct vk_context_options* options);
+bool     initialize_queues(struct vk_context* ctx);
+bool     initialize_debug_layer(struct vk_context* ctx);
 
-bool     initialize_instance(uint32_t ext_count, const char** ext_array);
-bool     initialize_device(void);
-bool     initialize_queues(void);
-bool     initialize_debug_layer(void);
+VkExtent2D get_swapchain_extent(const VkSurfaceCapabilitiesKHR* surface_capabilities, VkExtent2D extent);
+bool     create_swapchain(struct vk_context* ctx, const VkSurfaceCapabilitiesKHR* surface_capabilities, VkExtent2D extent, VkSemaphore retire_timeline, uint64_t retire_value);
 
-bool     enumerate_instance_layers(struct layer_list* instance_layers);
-bool     enumerate_instance_extensions(const char* layer, struct extension_list* instance_extensions);
-bool     enumerate_gpus(uint32_t* gpu_count, struct gpu_info** gpu_info_array);
-bool     enumerate_device_layers_and_extensions(VkPhysicalDevice physical_device, struct layer_list* device_layers);
-bool     enumerate_device_extensions(VkPhysicalDevice physical_device, const char* layer, struct extension_list* device_extensions);
+bool     enumerate_instance_layers(struct vk_context* ctx, struct layer_list* instance_layers);
+bool     enumerate_instance_extensions(struct vk_context* ctx, const char* layer, struct extension_list* instance_extensions);
+bool     enumerate_gpus(struct vk_context* ctx, uint32_t* gpu_count, struct gpu_info** gpu_info_array);
+bool     enumerate_device_layers_and_extensions(struct vk_context* ctx, VkPhysicalDevice physical_device, struct layer_list* device_layers);
+bool     enumerate_device_extensions(struct vk_context* ctx, VkPhysicalDevice physical_device, const char* layer, struct extension_list* device_extensions);
 
-bool     get_gpu_queue_info(VkPhysicalDevice physical_device, uint32_t* num_queue_groups, struct VkQueueFamilyProperties** queue_group_properties);
+bool     get_gpu_queue_info(struct vk_context* ctx, VkPhysicalDevice physical_device, uint32_t* num_queue_groups, struct VkQueueFamilyProperties** queue_group_properties);
 
 void     print_gpu_info(uint32_t gpu_index, struct gpu_info* gpu_info);
 
+uint64_t score_gpu(struct vk_context* ctx, struct gpu_info* gpu_info);
+bool     match_gpu(uint32_t gpu_index, struct gpu_info* gpu_info, const char* device_selector);
+
+bool     index_extensions(struct extension_list* extension_list);
 uint32_t find_extension(struct extension_list* extension_list, const char* extension_name);
-bool     add_extension(struct extension_list* extensions, const char** ext_array, uint32_t* ext_count, const char* ext_name);
+
+bool     init_extension_set(struct extension_set* set, struct extension_list* available);
+void     free_extension_set(struct extension_set* set);
+void     require_extension(struct extension_set* set, const char* extension_name);
+bool     request_extension(struct extension_set* set, const char* extension_name);
 
 void     free_layers(struct layer_list* layers);
 void     free_extensions(struct extension_list* extensions);
 void     free_gpu_info(uint32_t gpu_count, struct gpu_info* gpu_info_array);
 
+// user_data is the vk_context_state of the context that owns the allocation
+static void update_host_memory_stats(void* user_data, uint64_t allocated_size, uint64_t freed_size)
+{
+    struct vk_context_state* state = (struct vk_context_state*) user_data;
+
+    SDL_AtomicLock(&state->stats_lock);
+
+    if(freed_size <= state->stats.host_memory_size + allocated_size)
+    {
+        state->stats.host_memory_size += allocated_size;
+        state->stats.host_memory_size -= freed_size;
+    }
+    else
+    {
+        LOG_ERROR("Memory over-freed\n");
+        state->stats.host_memory_size = 0;
+    }
+
+    if(allocated_size > 0)
+    {
+        state->stats.host_allocation_count++;
+    }
+
+    if(state->stats.host_memory_size > state->stats.host_memory_peak)
+    {
+        state->stats.host_memory_peak = state->stats.host_memory_size;
+    }
+
+    SDL_AtomicUnlock(&state->stats_lock);
+}
+
 void* vk_allocation_callback(void* user_data, uint64_t size, uint64_t alignment, enum vk_system_allocation_scope scope)
 {
     uint64_t aligned_size = size + (alignment-1) & ~(alignment-1);
@@ -90,7 +191,7 @@ void* vk_allocation_callback(void* user_data, uint64_t size, uint64_t alignment,
 
         memset(memory, 0, total_size);
         header->size = aligned_size;
-        g_vk_memory_usage.size += aligned_size;
+        update_host_memory_stats(user_data, aligned_size, 0);
     }
 
     return memory + sizeof(struct vk_allocation_header);
@@ -111,7 +212,7 @@ void* vk_reallocation_callback(void* user_data, void* original, uint64_t size, u
         struct vk_allocation_header* header = (struct vk_allocation_header*) memory;
 
         header->size = aligned_size;
-        g_vk_memory_usage.size += (aligned_size - original_size);
+        update_host_memory_stats(user_data, aligned_size, original_size);
     }
 
     return memory + sizeof(struct vk_allocation_header);
@@ -124,14 +225,7 @@ void vk_free_callback(void* user_data, void* allocation)
         uint8_t* original_ptr = ((uint8_t*) allocation) - sizeof(struct vk_allocation_header);
         struct vk_allocation_header* header = (struct vk_allocation_header*) original_ptr;
 
-        if(header->size <= g_vk_memory_usage.size)
-        {
-            g_vk_memory_usage.size -= header->size;
-        }
-        else
-        {
-            printf("Memory over-freed\n");
-        }
+        update_host_memory_stats(user_data, 0, header->size);
 
         free(original_ptr);
     }
@@ -145,307 +239,242 @@ void vk_free_notification(void* user_data, uint64_t size, enum vk_internal_alloc
 {
 }
 
-VkBool32 debug_callback(VkDebugReportFlagsEXT flags, VkDebugReportObjectTypeEXT object_type, uint64_t object, uint64_t location, int32_t message_code, const char* layer_prefix, const char* message, void* user_data)
+void init_vk_context_options(struct vk_context_options* options)
 {
-    bool status = true;
-
-    enum { buffer_size = 512 };
+    memset(options, 0, sizeof(struct vk_context_options));
 
-    uint32_t index = 0;
-    char buffer[buffer_size] = { 0 };
+    // one queue for the frame, the second one only gets a share of the gpu when the frame queue is idle
+    options->graphics_queue_count = VK_CTX_NUM_GRAPHICS_QUEUES;
+    options->graphics_queue_priorities[0] = 1.0f;
 
-    if(status && (index < buffer_size))
-    {
-        if(flags == VK_DEBUG_REPORT_INFORMATION_BIT_EXT)
-        {
-            index += snprintf(buffer + index, buffer_size - index, "Information: ");
-        }
-        else if(flags == VK_DEBUG_REPORT_WARNING_BIT_EXT)
-        {
-            index += snprintf(buffer + index, buffer_size - index, "Warning: ");
-        }
-        else if(flags == VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT)
-        {
-            index += snprintf(buffer + index, buffer_size - index, "Performance Warning: ");
-        }
-        else if(flags == VK_DEBUG_REPORT_ERROR_BIT_EXT)
-        {
-            index += snprintf(buffer + index, buffer_size - index, "Error: ");
-        }
-        else if(flags == VK_DEBUG_REPORT_DEBUG_BIT_EXT)
-        {
-            index += snprintf(buffer + index, buffer_size - index, "Debug: ");
-        }
-        else
-        {
-            index += snprintf(buffer + index, buffer_size - index, "Unknown: ");
-        }
-    }
-    else
+    for(uint32_t i = 1; i < VK_CTX_NUM_GRAPHICS_QUEUES; i++)
     {
-        status = false;
+        options->graphics_queue_priorities[i] = 0.0f;
     }
 
-    if(status && (index < buffer_size))
-    {
-        switch(object_type)
-        {
-            case VK_DEBUG_REPORT_OBJECT_TYPE_INSTANCE_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:Instance ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_PHYSICAL_DEVICE_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:PhysicalDevice ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_DEVICE_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:Device ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_QUEUE_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:Queue ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_SEMAPHORE_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:Semaphore ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_COMMAND_BUFFER_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:CommandBuffer ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_FENCE_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:Fence ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_DEVICE_MEMORY_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:DeviceMemory ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:Buffer ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_IMAGE_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:Image ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_EVENT_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:Event ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_QUERY_POOL_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:QueryPool ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_BUFFER_VIEW_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:BufferView ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_IMAGE_VIEW_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:ImageView ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_SHADER_MODULE_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:ShaderModule ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_CACHE_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:PipelineCache ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_LAYOUT_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:PipelineLayout ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_RENDER_PASS_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:RenderPass ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:Pipeline ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:DescriptorSetLayout ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_SAMPLER_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:Sampler ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_DESCRIPTOR_POOL_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:DescriptorPool ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_DESCRIPTOR_SET_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:DescriptorSet ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_FRAMEBUFFER_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:Framebuffer ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_COMMAND_POOL_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:CommandPool ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_SURFACE_KHR_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:Surface ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_SWAPCHAIN_KHR_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:Swapchain ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_DEBUG_REPORT_CALLBACK_EXT_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:DebugReport ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_DISPLAY_KHR_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:Display ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_DISPLAY_MODE_KHR_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:DisplayMode ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_VALIDATION_CACHE_EXT_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:ValidationCache ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_SAMPLER_YCBCR_CONVERSION_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:Conversion ");
-                break;
-            case VK_DEBUG_REPORT_OBJECT_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_EXT:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:DescriptorUpdateTemplate ");
-                break;
-            default:
-                index += snprintf(buffer + index, buffer_size - index, "ObjectType:0x%X ", object_type);
-                break;
-        }
-    }
-    else
-    {
-        status = false;
-    }
+    init_debug_messenger_options(&options->debug_messenger);
+}
+
+bool initialize_vulkan_context(struct vk_context* ctx, PFN_vkGetInstanceProcAddr pfn_get_instance_proc_addr, uint32_t ext_count, const char** ext_array, const struct vk_context_options* options)
+{
+    bool status = true;
+
+    memset(ctx, 0, sizeof(struct vk_context));
 
-    if(status && (index < buffer_size)) { index += snprintf(buffer + index, buffer_size - index, "Object:0x%llX ", object); } else { status = false; }
-    if(status && (index < buffer_size)) { index += snprintf(buffer + index, buffer_size - index, "Location:0x%llX ", location); } else { status = false; }
-    if(status && (index < buffer_size)) { index += snprintf(buffer + index, buffer_size - index, "MessageCode:0x%X ", message_code); } else { status = false; }
-    if(status && (index < buffer_size)) { index += snprintf(buffer + index, buffer_size - index, "Layer:%s ", layer_prefix); } else { status = false; }
-    if(status && (index < buffer_size)) { index += snprintf(buffer + index, buffer_size - index, "UserData:0x%llX\n", (uint64_t) user_data); } else { status = false; }
-    if(status && (index < buffer_size)) { index += snprintf(buffer + index, buffer_size - index, "\t%s", message); } else { status = false; }
+    ctx->get_instance_proc_addr = pfn_get_instance_proc_addr;
 
-    if (index >= buffer_size)
+    ctx->state = (struct vk_context_state*) calloc(1, sizeof(struct vk_context_state));
+
+    if(ctx->state == NULL)
     {
-        status = false; // ran out of buffer space
+        LOG_ERROR("Failed to allocate memory\n");
+        status = false;
     }
 
     if(status)
     {
-        printf("%s\n", buffer);
+        status = initialize_global_function_pointers(ctx);
     }
-    else
-    {
-        printf("Error: Could not parse debug report message\n");
-    }
-
-    return VK_TRUE;
-}
-
-bool initialize_vulkan_context(PFN_vkGetInstanceProcAddr pfn_get_instance_proc_addr, uint32_t ext_count, const char** ext_array)
-{
-    bool status = true;
-
-    g_vk_ctx.get_instance_proc_addr = pfn_get_instance_proc_addr;
 
     if(status)
     {
-        status = initialize_global_function_pointers();
+        status = initialize_allocation_callbacks(ctx);
     }
 
     if(status)
     {
-        status = initialize_allocation_callbacks();
+        status = initialize_instance(ctx, ext_count, ext_array, options);
     }
 
     if(status)
     {
-        status = initialize_instance(ext_count, ext_array);
+        status = initialize_device(ctx, options);
     }
 
     if(status)
     {
-        status = initialize_device();
+        status = initialize_queues(ctx);
     }
 
     if(status)
     {
-        status = initialize_queues();
+        update_memory_budget(ctx);
+
+        for(uint32_t i = 0; i < ctx->memory_properties.memoryHeapCount; i++)
+        {
+            LOG_INFO("Memory heap %u: %llu MB%s, budget %llu MB, usage %llu MB\n", i, (unsigned long long) (ctx->memory_properties.memoryHeaps[i].size >> 20),
+                     (ctx->memory_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? " device local" : "",
+                     (unsigned long long) (ctx->heap_budgets[i].budget >> 20), (unsigned long long) (ctx->heap_budgets[i].usage >> 20));
+        }
     }
 
     return status;
 }
 
-void uninitialize_vulkan_context(void)
+// also tears down a context whose initialization failed partway, only the objects that exist are destroyed
+void uninitialize_vulkan_context(struct vk_context* ctx)
 {
-    g_vk_ctx.wait_for_device_idle(g_vk_ctx.device);
+    // the device functions are loaded right after the device is created, a failed load leaves them NULL
+    bool device_valid = (ctx->device != NULL) && (ctx->destroy_device != NULL);
+
+    if(device_valid)
+    {
+        ctx->wait_for_device_idle(ctx->device);
+
+        collect_deferred_destructions(ctx, true);
+    }
 
-    if(g_vk_ctx.command_buffer != NULL)
+    if(ctx->command_buffers[0] != NULL)
     {
-        g_vk_ctx.free_command_buffers(g_vk_ctx.device, g_vk_ctx.command_pool, 1, &g_vk_ctx.command_buffer);
-        g_vk_ctx.command_buffer = NULL;
+        ctx->free_command_buffers(ctx->device, ctx->command_pool, VK_CTX_NUM_FRAMES, ctx->command_buffers);
+
+        for(uint32_t i = 0; i < VK_CTX_NUM_FRAMES; i++)
+        {
+            ctx->command_buffers[i] = NULL;
+        }
+    }
+
+    if(ctx->command_pool != NULL)
+    {
+        ctx->destroy_command_pool(ctx->device, ctx->command_pool, ctx->allocation_callbacks);
+        ctx->command_pool = NULL;
     }
 
-    if(g_vk_ctx.command_pool != NULL)
+    if(ctx->surface != NULL)
     {
-        g_vk_ctx.destroy_command_pool(g_vk_ctx.device, g_vk_ctx.command_pool, g_vk_ctx.allocation_callbacks);
-        g_vk_ctx.command_pool = NULL;
+        ctx->destroy_surface(ctx->instance, ctx->surface, NULL);
+        ctx->surface = NULL;
     }
 
-    if(g_vk_ctx.surface != NULL)
+    for(uint32_t i = 0; i < VK_CTX_NUM_FRAMES; i++)
     {
-        g_vk_ctx.destroy_surface(g_vk_ctx.instance, g_vk_ctx.surface, NULL);
-        g_vk_ctx.surface = NULL;
+        if(ctx->image_available_semaphores[i] != NULL)
+        {
+            ctx->destroy_semaphore(ctx->device, ctx->image_available_semaphores[i], ctx->allocation_callbacks);
+            ctx->image_available_semaphores[i] = NULL;
+        }
     }
 
-    if(g_vk_ctx.image_available_semaphore != NULL)
+    for(uint32_t i = 0; i < VK_CTX_MAX_SWAPCHAIN_IMAGES; i++)
     {
-        g_vk_ctx.destroy_semaphore(g_vk_ctx.device, g_vk_ctx.image_available_semaphore, g_vk_ctx.allocation_callbacks);
-        g_vk_ctx.image_available_semaphore = NULL;
+        if(ctx->rendering_finished_semaphores[i] != NULL)
+        {
+            ctx->destroy_semaphore(ctx->device, ctx->rendering_finished_semaphores[i], ctx->allocation_callbacks);
+            ctx->rendering_finished_semaphores[i] = NULL;
+        }
     }
 
-    if(g_vk_ctx.rendering_finished_semaphore != NULL)
+    if(ctx->swapchain != NULL)
     {
-        g_vk_ctx.destroy_semaphore(g_vk_ctx.device, g_vk_ctx.rendering_finished_semaphore, g_vk_ctx.allocation_callbacks);
-        g_vk_ctx.rendering_finished_semaphore = NULL;
+        ctx->destroy_swapchain(ctx->device, ctx->swapchain, ctx->allocation_callbacks);
+        ctx->swapchain = NULL;
     }
 
-    if(g_vk_ctx.swapchain != NULL)
+    if(device_valid)
     {
-        g_vk_ctx.destroy_swapchain(g_vk_ctx.device, g_vk_ctx.swapchain, g_vk_ctx.allocation_callbacks);
-        g_vk_ctx.swapchain = NULL;
+        ctx->destroy_device(ctx->device, ctx->allocation_callbacks);
     }
 
-    g_vk_ctx.destroy_device(g_vk_ctx.device, g_vk_ctx.allocation_callbacks);
-    g_vk_ctx.device = NULL;
+    ctx->device = NULL;
 
-    if(g_vk_ctx.debug_callback != NULL)
+    if(ctx->debug_messenger != NULL)
     {
-        g_vk_ctx.unregister_debug_callback(g_vk_ctx.instance, g_vk_ctx.debug_callback, g_vk_ctx.allocation_callbacks);
+        ctx->destroy_debug_messenger(ctx->instance, ctx->debug_messenger, ctx->allocation_callbacks);
+        ctx->debug_messenger = NULL;
     }
 
-    g_vk_ctx.destroy_instance(g_vk_ctx.instance, g_vk_ctx.allocation_callbacks);
-    g_vk_ctx.instance = NULL;
+    if((ctx->instance != NULL) && (ctx->destroy_instance != NULL))
+    {
+        ctx->destroy_instance(ctx->instance, ctx->allocation_callbacks);
+    }
 
-    memset(&g_vk_ctx, 0, sizeof(struct vk_context));
+    ctx->instance = NULL;
 
-    if(g_vk_memory_usage.size != 0)
+    // the state is allocated first, without it nothing else was created
+    if(ctx->state != NULL)
     {
-        printf("Critical error: VK leaking %llu bytes\n", g_vk_memory_usage.size);
+        if(ctx->state->debug_messenger != NULL)
+        {
+            uninitialize_debug_messenger(ctx->state->debug_messenger);
+            ctx->state->debug_messenger = NULL;
+        }
+
+        struct vk_context_stats stats;
+        get_vk_context_stats(ctx, &stats);
+
+        if(stats.deferred_destruction_count > 0)
+        {
+            LOG_INFO("Deferred destructions: %llu\n", (unsigned long long) stats.deferred_destruction_count);
+        }
+
+        LOG_INFO("Host memory: %llu allocations, %llu bytes peak\n", (unsigned long long) stats.host_allocation_count, (unsigned long long) stats.host_memory_peak);
+
+        if(stats.memory_overrun_count > 0)
+        {
+            LOG_WARNING("Memory heaps went over budget %llu times\n", (unsigned long long) stats.memory_overrun_count);
+        }
+
+        if(stats.host_memory_size != 0)
+        {
+            LOG_ERROR("Critical error: VK leaking %llu bytes\n", (unsigned long long) stats.host_memory_size);
+        }
+
+        free(ctx->state);
     }
+
+    memset(ctx, 0, sizeof(struct vk_context));
+}
+
+void get_vk_context_stats(struct vk_context* ctx, struct vk_context_stats* stats)
+{
+    SDL_AtomicLock(&ctx->state->stats_lock);
+
+    (*stats) = ctx->state->stats;
+
+    SDL_AtomicUnlock(&ctx->state->stats_lock);
 }
 
-bool initialize_queues(void)
+bool initialize_queues(struct vk_context* ctx)
 {
     bool status = true;
 
     if(status)
     {
-        for(uint32_t i = 0; i < VK_CTX_NUM_GRAPHICS_QUEUES; i++)
+        for(uint32_t i = 0; i < ctx->graphics_queue_count; i++)
         {
-            g_vk_ctx.get_device_queue(g_vk_ctx.device, g_vk_ctx.graphics_queue_family, i, g_vk_ctx.graphics_queues);
+            ctx->get_device_queue(ctx->device, ctx->graphics_queue_family, i, &ctx->graphics_queues[i]);
 
-            if(g_vk_ctx.graphics_queues[i] == NULL)
+            if(ctx->graphics_queues[i] == NULL)
             {
                 status = false;
-                printf("Could not get graphics queue %u\n", i);
+                LOG_ERROR("Could not get graphics queue %u\n", i);
                 break;
             }
         }
     }
 
+    if(status && ctx->async_compute_supported)
+    {
+        ctx->get_device_queue(ctx->device, ctx->compute_queue_family, 0, &ctx->compute_queue);
+
+        if(ctx->compute_queue == NULL)
+        {
+            status = false;
+            LOG_ERROR("Could not get compute queue\n");
+        }
+    }
+
     if(status)
     {
         VkCommandPoolCreateInfo info;
         info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
         info.pNext = NULL;
         info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-        info.queueFamilyIndex = g_vk_ctx.graphics_queue_family;
+        info.queueFamilyIndex = ctx->graphics_queue_family;
 
-        if(g_vk_ctx.create_command_pool(g_vk_ctx.device, &info, g_vk_ctx.allocation_callbacks, &g_vk_ctx.command_pool) != VK_SUCCESS)
+        if(ctx->create_command_pool(ctx->device, &info, ctx->allocation_callbacks, &ctx->command_pool) != VK_SUCCESS)
         {
-            printf("Failed to create command pool\n");
+            LOG_ERROR("Failed to create command pool\n");
             status = false;
         }
     }
@@ -455,28 +484,50 @@ bool initialize_queues(void)
         VkCommandBufferAllocateInfo info;
         info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         info.pNext = NULL;
-        info.commandPool = g_vk_ctx.command_pool;
+        info.commandPool = ctx->command_pool;
         info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        info.commandBufferCount = 1;
+        info.commandBufferCount = VK_CTX_NUM_FRAMES;
 
-        if(g_vk_ctx.allocate_command_buffers(g_vk_ctx.device, &info, &g_vk_ctx.command_buffer) != VK_SUCCESS)
+        if(ctx->allocate_command_buffers(ctx->device, &info, ctx->command_buffers) != VK_SUCCESS)
         {
-            printf("Failed to create command buffer\n");
+            LOG_ERROR("Failed to create command buffer\n");
             status = false;
         }
     }
 
+#ifdef DEBUG
+    if(status)
+    {
+        VK_CTX_NAME(ctx, VK_OBJECT_TYPE_DEVICE, ctx->device, "device");
+        VK_CTX_NAME(ctx, VK_OBJECT_TYPE_COMMAND_POOL, ctx->command_pool, "frame command pool");
+
+        for(uint32_t i = 0; i < ctx->graphics_queue_count; i++)
+        {
+            VK_CTX_NAME(ctx, VK_OBJECT_TYPE_QUEUE, ctx->graphics_queues[i], "graphics queue %u", i);
+        }
+
+        if(ctx->compute_queue != NULL)
+        {
+            VK_CTX_NAME(ctx, VK_OBJECT_TYPE_QUEUE, ctx->compute_queue, "compute queue");
+        }
+
+        for(uint32_t i = 0; i < VK_CTX_NUM_FRAMES; i++)
+        {
+            VK_CTX_NAME(ctx, VK_OBJECT_TYPE_COMMAND_BUFFER, ctx->command_buffers[i], "frame command buffer %u", i);
+        }
+    }
+#endif
+
     return status;
 }
 
-bool initialize_swapchain(VkSurfaceKHR surface)
+bool initialize_swapchain(struct vk_context* ctx, VkSurfaceKHR surface, VkExtent2D extent)
 {
     bool status = true;
 
     uint32_t supported = VK_FALSE;
     uint32_t format_count = 0;
     uint32_t present_mode_count = 0;
-    uint32_t num_swapchain_images = 0;
     uint32_t format_index = INVALID_INDEX;
     
     VkPresentModeKHR* present_mode_array = NULL;
@@ -486,19 +537,19 @@ bool initialize_swapchain(VkSurfaceKHR surface)
 
     if(surface != NULL)
     {
-        g_vk_ctx.surface = surface;
+        ctx->surface = surface;
     }
     else
     {
-        printf("Invalid surface");
+        LOG_ERROR("Invalid surface\n");
         status = false;
     }
 
     if(status)
     {
-        if(g_vk_ctx.get_physical_device_surface_support(g_vk_ctx.physical_device, g_vk_ctx.graphics_queue_family, surface, &supported) != VK_SUCCESS)
+        if(ctx->get_physical_device_surface_support(ctx->physical_device, ctx->graphics_queue_family, surface, &supported) != VK_SUCCESS)
         {
-            printf("Failed to check device surface support\n");
+            LOG_ERROR("Failed to check device surface support\n");
             status = false;
         }
     }
@@ -507,34 +558,34 @@ bool initialize_swapchain(VkSurfaceKHR surface)
     {
         if(supported != VK_TRUE)
         {
-            printf("Device/graphics queue family does not support surface\n");
+            LOG_ERROR("Device/graphics queue family does not support surface\n");
             status = false;
         }
     }
 
     if(status)
     {
-        if(g_vk_ctx.get_physical_device_surface_capabilities(g_vk_ctx.physical_device, surface, &surface_capabilities) != VK_SUCCESS)
+        if(ctx->get_physical_device_surface_capabilities(ctx->physical_device, surface, &surface_capabilities) != VK_SUCCESS)
         {
-            printf("Could not get surface capabilities\n");
+            LOG_ERROR("Could not get surface capabilities\n");
             status = false;
         }
     }
 
     if(status)
     {
-        if(g_vk_ctx.get_physical_device_surface_present_modes(g_vk_ctx.physical_device, surface, &present_mode_count, NULL) != VK_SUCCESS)
+        if(ctx->get_physical_device_surface_present_modes(ctx->physical_device, surface, &present_mode_count, NULL) != VK_SUCCESS)
         {
-            printf("Could not get present mode count\n");
+            LOG_ERROR("Could not get present mode count\n");
             status = false;
         }
     }
 
     if(status)
     {
-        if(g_vk_ctx.get_physical_device_surface_formats(g_vk_ctx.physical_device, surface, &format_count, NULL) != VK_SUCCESS)
+        if(ctx->get_physical_device_surface_formats(ctx->physical_device, surface, &format_count, NULL) != VK_SUCCESS)
         {
-            printf("Count not get format count\n");
+            LOG_ERROR("Count not get format count\n");
             status = false;
         }
     }
@@ -544,7 +595,7 @@ bool initialize_swapchain(VkSurfaceKHR surface)
         present_mode_array = (VkPresentModeKHR*) malloc(present_mode_count * sizeof(VkPresentModeKHR));
         if(present_mode_array == NULL)
         {
-            printf("Failed to allocate memory for present mode array\n");
+            LOG_ERROR("Failed to allocate memory for present mode array\n");
             status = false;
         }
     }
@@ -554,25 +605,25 @@ bool initialize_swapchain(VkSurfaceKHR surface)
         format_array = (VkSurfaceFormatKHR*) malloc(format_count * sizeof(VkSurfaceFormatKHR));
         if(format_array == NULL)
         {
-            printf("Failed to allocate memory for format array\n");
+            LOG_ERROR("Failed to allocate memory for format array\n");
             status = false;
         }
     }
 
     if(status)
     {
-        if(g_vk_ctx.get_physical_device_surface_present_modes(g_vk_ctx.physical_device, surface, &present_mode_count, present_mode_array) != VK_SUCCESS)
+        if(ctx->get_physical_device_surface_present_modes(ctx->physical_device, surface, &present_mode_count, present_mode_array) != VK_SUCCESS)
         {
-            printf("Could not get present mode array\n");
+            LOG_ERROR("Could not get present mode array\n");
             status = false;
         }
     }
 
     if(status)
     {
-        if(g_vk_ctx.get_physical_device_surface_formats(g_vk_ctx.physical_device, surface, &format_count, format_array) != VK_SUCCESS)
+        if(ctx->get_physical_device_surface_formats(ctx->physical_device, surface, &format_count, format_array) != VK_SUCCESS)
         {
-            printf("Could not get format array");
+            LOG_ERROR("Could not get format array\n");
             status = false;
         }
     }
@@ -590,26 +641,26 @@ bool initialize_swapchain(VkSurfaceKHR surface)
 
         if(format_index >= format_count)
         {
-            printf("Could not find supported format\n");
+            LOG_ERROR("Could not find supported format\n");
             status = false;
         }
     }
 
     if(status)
     {
-        printf("Surface capabilities:\n");
-        printf("\tMinimum image count: %u\n", surface_capabilities.minImageCount);
-        printf("\tMaximum image count: %u\n", surface_capabilities.maxImageCount);
-        printf("\tCurrent extent: %ux%u\n", surface_capabilities.currentExtent.width, surface_capabilities.currentExtent.height);
-        printf("\tMinimum extent: %ux%u\n", surface_capabilities.minImageExtent.width, surface_capabilities.minImageExtent.height);
-        printf("\tMaximum extent: %ux%u\n", surface_capabilities.maxImageExtent.width, surface_capabilities.maxImageExtent.height);
-        printf("\tMaximum array image array layers: %u\n", surface_capabilities.maxImageArrayLayers);
-        printf("\tSupported transforms: %u\n", surface_capabilities.supportedTransforms);
-        printf("\tCurrent transform: %u\n", surface_capabilities.currentTransform);
-        printf("\tSupported composite alpha: %u\n", surface_capabilities.supportedCompositeAlpha);
-        printf("\tSupported usage flags: %u\n", surface_capabilities.supportedUsageFlags);
+        LOG_DEBUG("Surface capabilities:\n");
+        LOG_DEBUG("\tMinimum image count: %u\n", surface_capabilities.minImageCount);
+        LOG_DEBUG("\tMaximum image count: %u\n", surface_capabilities.maxImageCount);
+        LOG_DEBUG("\tCurrent extent: %ux%u\n", surface_capabilities.currentExtent.width, surface_capabilities.currentExtent.height);
+        LOG_DEBUG("\tMinimum extent: %ux%u\n", surface_capabilities.minImageExtent.width, surface_capabilities.minImageExtent.height);
+        LOG_DEBUG("\tMaximum extent: %ux%u\n", surface_capabilities.maxImageExtent.width, surface_capabilities.maxImageExtent.height);
+        LOG_DEBUG("\tMaximum array image array layers: %u\n", surface_capabilities.maxImageArrayLayers);
+        LOG_DEBUG("\tSupported transforms: %u\n", surface_capabilities.supportedTransforms);
+        LOG_DEBUG("\tCurrent transform: %u\n", surface_capabilities.currentTransform);
+        LOG_DEBUG("\tSupported composite alpha: %u\n", surface_capabilities.supportedCompositeAlpha);
+        LOG_DEBUG("\tSupported usage flags: %u\n", surface_capabilities.supportedUsageFlags);
 
-        printf("Surface supported present modes:\n");
+        LOG_DEBUG("Surface supported present modes:\n");
         for(uint32_t i = 0; i < present_mode_count; i++)
         {
             const char* mode = "Unknown";
@@ -636,96 +687,33 @@ bool initialize_swapchain(VkSurfaceKHR surface)
                 default:
                     break;
             }
-            printf("\t%s\n", mode);
-        }
-    }
-
-    if(status)
-    {
-        VkSwapchainCreateInfoKHR info;
-        info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
-        info.pNext = NULL;
-        info.flags = 0;
-        info.surface = surface;
-        info.minImageCount = VK_CTX_NUM_SWAPCHAIN_BUFFERS;
-        info.imageFormat = format_array[format_index].format;
-        info.imageColorSpace = format_array[format_index].colorSpace;
-        info.imageExtent.width = surface_capabilities.currentExtent.width;
-        info.imageExtent.height = surface_capabilities.currentExtent.height;
-        info.imageArrayLayers = 1;
-        info.imageUsage = 0;
-        info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        info.queueFamilyIndexCount = 0;
-        info.pQueueFamilyIndices = NULL;
-        info.preTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
-        info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-        info.presentMode = VK_PRESENT_MODE_FIFO_KHR;
-        info.clipped = VK_TRUE;
-        info.oldSwapchain = NULL;
-
-        if(g_vk_ctx.create_swapchain(g_vk_ctx.device, &info, g_vk_ctx.allocation_callbacks, &g_vk_ctx.swapchain) != VK_SUCCESS)
-        {
-            printf("Could not create swapchain\n");
-            status = false;
+            LOG_DEBUG("\t%s\n", mode);
         }
     }
 
     if(status)
     {
-        g_vk_ctx.surface_format = format_array[format_index].format;
-    }
-
-    if(status)
-    {
-        VkSemaphoreCreateInfo info;
-        info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-        info.pNext = NULL;
-        info.flags = 0;
+        ctx->surface_format = format_array[format_index].format;
+        ctx->surface_color_space = format_array[format_index].colorSpace;
 
-        if(g_vk_ctx.create_semaphore(g_vk_ctx.device, &info, g_vk_ctx.allocation_callbacks, &g_vk_ctx.image_available_semaphore) != VK_SUCCESS)
-        {
-            printf("Failed to create semaphore\n");
-            status = false;
-        }
+        status = create_swapchain(ctx, &surface_capabilities, get_swapchain_extent(&surface_capabilities, extent), NULL, 0);
     }
 
-    if(status)
+    for(uint32_t i = 0; status && (i < VK_CTX_NUM_FRAMES); i++)
     {
         VkSemaphoreCreateInfo info;
         info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
         info.pNext = NULL;
         info.flags = 0;
 
-        if(g_vk_ctx.create_semaphore(g_vk_ctx.device, &info, g_vk_ctx.allocation_callbacks, &g_vk_ctx.rendering_finished_semaphore) != VK_SUCCESS)
+        if(ctx->create_semaphore(ctx->device, &info, ctx->allocation_callbacks, &ctx->image_available_semaphores[i]) != VK_SUCCESS)
         {
-            printf("Failed to create semaphore\n");
+            LOG_ERROR("Failed to create semaphore\n");
             status = false;
         }
-    }
-
-    if(status)
-    {
-        if(g_vk_ctx.get_swapchain_images(g_vk_ctx.device, g_vk_ctx.swapchain, &num_swapchain_images, NULL) == VK_SUCCESS)
-        {
-            if(num_swapchain_images != VK_CTX_NUM_SWAPCHAIN_BUFFERS)
-            {
-                printf("Unexpected number of swapchain images\n");
-                status = false;
-            }
-        }
         else
         {
-            printf("Could not get swapchain image count\n");
-            status = false;
-        }
-    }
-
-    if(status)
-    {
-        if(g_vk_ctx.get_swapchain_images(g_vk_ctx.device, g_vk_ctx.swapchain, &num_swapchain_images, g_vk_ctx.swapchain_images) != VK_SUCCESS)
-        {
-            printf("Could not get swapchain images\n");
-            status = false;
+            VK_CTX_NAME(ctx, VK_OBJECT_TYPE_SEMAPHORE, ctx->image_available_semaphores[i], "image available %u", i);
         }
     }
 
@@ -744,154 +732,309 @@ bool initialize_swapchain(VkSurfaceKHR surface)
     return status;
 }
 
-bool load_function_pointer(VkInstance instance, const char* name, void** pfn)
+// the current extent of the surface, or extent clamped to the supported range when the current extent is
+// 0xFFFFFFFF and the size is up to the application
+VkExtent2D get_swapchain_extent(const VkSurfaceCapabilitiesKHR* surface_capabilities, VkExtent2D extent)
 {
-    bool status = true;
-
-    if(pfn != NULL)
+    if(surface_capabilities->currentExtent.width != 0xFFFFFFFF)
     {
-        (*pfn) = g_vk_ctx.get_instance_proc_addr(instance, name);
-
-        if((*pfn) == NULL)
-        {
-            status = false;
-            printf("Failed to load function pointer %s\n", name);
-        }
+        extent = surface_capabilities->currentExtent;
     }
     else
     {
-        status = false;
+        extent.width = (extent.width > surface_capabilities->minImageExtent.width) ? extent.width : surface_capabilities->minImageExtent.width;
+        extent.width = (extent.width < surface_capabilities->maxImageExtent.width) ? extent.width : surface_capabilities->maxImageExtent.width;
+        extent.height = (extent.height > surface_capabilities->minImageExtent.height) ? extent.height : surface_capabilities->minImageExtent.height;
+        extent.height = (extent.height < surface_capabilities->maxImageExtent.height) ? extent.height : surface_capabilities->maxImageExtent.height;
     }
 
-    return status;
+    return extent;
 }
 
-bool load_device_function_pointer(VkDevice device, const char* name, void** pfn)
+bool create_swapchain(struct vk_context* ctx, const VkSurfaceCapabilitiesKHR* surface_capabilities, VkExtent2D extent, VkSemaphore retire_timeline, uint64_t retire_value)
 {
     bool status = true;
 
-    if(pfn != NULL)
+    uint32_t num_swapchain_images = 0;
+
+    // within the limits of the surface, a maxImageCount of 0 means no limit
+    uint32_t min_image_count = VK_CTX_NUM_SWAPCHAIN_BUFFERS;
+
+    if(min_image_count < surface_capabilities->minImageCount)
     {
-        (*pfn) = g_vk_ctx.get_device_proc_addr(device, name);
+        min_image_count = surface_capabilities->minImageCount;
+    }
 
-        if((*pfn) == NULL)
-        {
-            status = false;
-            printf("Failed to load device function pointer %s\n", name);
-        }
+    if((surface_capabilities->maxImageCount != 0) && (min_image_count > surface_capabilities->maxImageCount))
+    {
+        min_image_count = surface_capabilities->maxImageCount;
     }
-    else
+
+    VkSwapchainKHR old_swapchain = ctx->swapchain;
+
+    if(status)
+    {
+        VkSwapchainCreateInfoKHR info;
+        info.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
+        info.pNext = NULL;
+        info.flags = 0;
+        info.surface = ctx->surface;
+        info.minImageCount = min_image_count;
+        info.imageFormat = ctx->surface_format;
+        info.imageColorSpace = ctx->surface_color_space;
+        info.imageExtent = extent;
+        info.imageArrayLayers = 1;
+        info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+        info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        info.queueFamilyIndexCount = 0;
+        info.pQueueFamilyIndices = NULL;
+        info.preTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+        info.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+        info.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+        info.clipped = VK_TRUE;
+        info.oldSwapchain = old_swapchain;
+
+        if(ctx->create_swapchain(ctx->device, &info, ctx->allocation_callbacks, &ctx->swapchain) != VK_SUCCESS)
+        {
+            LOG_ERROR("Could not create swapchain\n");
+            ctx->swapchain = NULL;
+            status = false;
+        }
+    }
+
+    // the old swapchain is retired even if creating the new one failed, its images may still be in flight
+    if(old_swapchain != NULL)
+    {
+        defer_destruction(ctx, VK_OBJECT_TYPE_SWAPCHAIN_KHR, (uint64_t) old_swapchain, retire_timeline, retire_value);
+        old_swapchain = NULL;
+    }
+
+    if(status)
+    {
+        if(ctx->get_swapchain_images(ctx->device, ctx->swapchain, &num_swapchain_images, NULL) == VK_SUCCESS)
+        {
+            // the driver may create more images than requested
+            if(num_swapchain_images > VK_CTX_MAX_SWAPCHAIN_IMAGES)
+            {
+                LOG_ERROR("Too many swapchain images: %u\n", num_swapchain_images);
+                status = false;
+            }
+        }
+        else
+        {
+            LOG_ERROR("Could not get swapchain image count\n");
+            status = false;
+        }
+    }
+
+    if(status)
+    {
+        if(ctx->get_swapchain_images(ctx->device, ctx->swapchain, &num_swapchain_images, ctx->swapchain_images) != VK_SUCCESS)
+        {
+            LOG_ERROR("Could not get swapchain images\n");
+            status = false;
+        }
+        else
+        {
+            ctx->swapchain_image_count = num_swapchain_images;
+        }
+    }
+
+    // one per image, the semaphores of earlier swapchains are kept and only missing ones are created
+    for(uint32_t i = 0; status && (i < ctx->swapchain_image_count); i++)
+    {
+        if(ctx->rendering_finished_semaphores[i] == NULL)
+        {
+            VkSemaphoreCreateInfo info;
+            info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            info.pNext = NULL;
+            info.flags = 0;
+
+            if(ctx->create_semaphore(ctx->device, &info, ctx->allocation_callbacks, &ctx->rendering_finished_semaphores[i]) != VK_SUCCESS)
+            {
+                LOG_ERROR("Failed to create semaphore\n");
+                status = false;
+            }
+            else
+            {
+                VK_CTX_NAME(ctx, VK_OBJECT_TYPE_SEMAPHORE, ctx->rendering_finished_semaphores[i], "rendering finished %u", i);
+            }
+        }
+    }
+
+#ifdef DEBUG
+    if(status)
+    {
+        VK_CTX_NAME(ctx, VK_OBJECT_TYPE_SWAPCHAIN_KHR, ctx->swapchain, "swapchain");
+
+        for(uint32_t i = 0; i < ctx->swapchain_image_count; i++)
+        {
+            VK_CTX_NAME(ctx, VK_OBJECT_TYPE_IMAGE, ctx->swapchain_images[i], "swapchain image %u", i);
+        }
+    }
+#endif
+
+    if(status)
+    {
+        ctx->swapchain_extent = extent;
+    }
+
+    return status;
+}
+
+bool recreate_swapchain(struct vk_context* ctx, VkExtent2D extent, VkSemaphore timeline, uint64_t value)
+{
+    bool status = true;
+
+    VkSurfaceCapabilitiesKHR surface_capabilities = { 0 };
+
+    if(ctx->get_physical_device_surface_capabilities(ctx->physical_device, ctx->surface, &surface_capabilities) != VK_SUCCESS)
     {
+        LOG_ERROR("Could not get surface capabilities\n");
         status = false;
     }
 
+    if(status)
+    {
+        extent = get_swapchain_extent(&surface_capabilities, extent);
+
+        if((extent.width == 0) || (extent.height == 0))
+        {
+            ctx->swapchain_extent.width = 0;
+            ctx->swapchain_extent.height = 0;
+        }
+        else
+        {
+            LOG_INFO("Recreate swapchain %ux%u\n", extent.width, extent.height);
+            status = create_swapchain(ctx, &surface_capabilities, extent, timeline, value);
+        }
+    }
+
+    return status;
+}
+
+// resolves one entry of the dispatch tables. disabled entries are left NULL, optional entries may be NULL
+bool load_table_entry(struct vk_context* ctx, VkInstance instance, VkDevice device, const char* name, enum vk_ctx_function_kind kind, VkBool32 enabled, uint32_t api_version, uint32_t core_version, const char* suffix, void** pfn)
+{
+    bool status = true;
+
+    char promoted_name[VK_MAX_EXTENSION_NAME_SIZE];
+
+    (*pfn) = NULL;
+
+    if(enabled)
+    {
+        if((suffix != NULL) && (api_version < core_version))
+        {
+            snprintf(promoted_name, sizeof(promoted_name), "%s%s", name, suffix);
+            name = promoted_name;
+        }
+
+        if(device != NULL)
+        {
+            (*pfn) = ctx->get_device_proc_addr(device, name);
+        }
+        else
+        {
+            (*pfn) = ctx->get_instance_proc_addr(instance, name);
+        }
+
+        if(((*pfn) == NULL) && (kind == VK_CTX_FUNCTION_REQUIRED))
+        {
+            status = false;
+            LOG_ERROR("Failed to load function pointer %s\n", name);
+        }
+    }
+
     return status;
 }
 
-bool initialize_global_function_pointers(void)
+bool initialize_global_function_pointers(struct vk_context* ctx)
 {
     bool status = true;
 
-    status &= load_function_pointer(NULL, "vkCreateInstance", (void**) &g_vk_ctx.create_instance);
-    status &= load_function_pointer(NULL, "vkEnumerateInstanceVersion", (void**) &g_vk_ctx.enumerate_instance_version);
-    status &= load_function_pointer(NULL, "vkEnumerateInstanceLayerProperties", (void**) &g_vk_ctx.enumerate_instance_layers);
-    status &= load_function_pointer(NULL, "vkEnumerateInstanceExtensionProperties", (void**) &g_vk_ctx.enumerate_instance_extensions);
+#define LOAD_GLOBAL_FUNCTION(name, member, gate, core_version, suffix) \
+    status &= load_table_entry(ctx, NULL, NULL, #name, gate, 0, core_version, suffix, (void**) &ctx->member);
+
+    VK_CTX_GLOBAL_FUNCTIONS(LOAD_GLOBAL_FUNCTION)
+
+#undef LOAD_GLOBAL_FUNCTION
 
     return status;
 }
 
-bool initialize_instance_function_pointers(void)
+bool initialize_instance_function_pointers(struct vk_context* ctx)
 {
     bool status = true;
 
-    status &= load_function_pointer(g_vk_ctx.instance, "vkDestroyInstance", (void**) &g_vk_ctx.destroy_instance);
-    status &= load_function_pointer(g_vk_ctx.instance, "vkEnumeratePhysicalDevices", (void**) &g_vk_ctx.enumerate_physical_devices);
-    status &= load_function_pointer(g_vk_ctx.instance, "vkGetPhysicalDeviceProperties", (void**) &g_vk_ctx.get_physical_device_properties);
-    status &= load_function_pointer(g_vk_ctx.instance, "vkGetPhysicalDeviceFeatures", (void**) &g_vk_ctx.get_physical_device_features);
-    status &= load_function_pointer(g_vk_ctx.instance, "vkGetPhysicalDeviceQueueFamilyProperties", (void**) &g_vk_ctx.get_physical_queue_group_properties);
-    status &= load_function_pointer(g_vk_ctx.instance, "vkCreateDevice", (void**) &g_vk_ctx.create_device);
-    status &= load_function_pointer(g_vk_ctx.instance, "vkGetPhysicalDeviceSurfaceSupportKHR", (void**) &g_vk_ctx.get_physical_device_surface_support);
-    status &= load_function_pointer(g_vk_ctx.instance, "vkEnumerateDeviceLayerProperties", (void**) &g_vk_ctx.enumerate_device_layers);
-    status &= load_function_pointer(g_vk_ctx.instance, "vkEnumerateDeviceExtensionProperties", (void**) &g_vk_ctx.enumerate_device_extensions);
-    status &= load_function_pointer(g_vk_ctx.instance, "vkGetPhysicalDeviceSurfaceCapabilitiesKHR", (void**) &g_vk_ctx.get_physical_device_surface_capabilities);
-    status &= load_function_pointer(g_vk_ctx.instance, "vkGetPhysicalDeviceSurfacePresentModesKHR", (void**) &g_vk_ctx.get_physical_device_surface_present_modes);
-    status &= load_function_pointer(g_vk_ctx.instance, "vkGetPhysicalDeviceSurfaceFormatsKHR", (void**) &g_vk_ctx.get_physical_device_surface_formats);
-    status &= load_function_pointer(g_vk_ctx.instance, "vkDestroySurfaceKHR", (void**) &g_vk_ctx.destroy_surface);
+#define LOAD_INSTANCE_FUNCTION(name, member, gate, core_version, suffix) \
+    status &= load_table_entry(ctx, ctx->instance, NULL, #name, gate, ctx->instance_api_version, core_version, suffix, (void**) &ctx->member);
 
-#ifdef DEBUG
-    status &= load_function_pointer(g_vk_ctx.instance, "vkCreateDebugReportCallbackEXT", (void**) &g_vk_ctx.register_debug_callback);
-    status &= load_function_pointer(g_vk_ctx.instance, "vkDestroyDebugReportCallbackEXT", (void*) &g_vk_ctx.unregister_debug_callback);
-#endif
+    VK_CTX_INSTANCE_FUNCTIONS(LOAD_INSTANCE_FUNCTION)
+
+#undef LOAD_INSTANCE_FUNCTION
+
+    if(status)
+    {
+        ctx->get_device_proc_addr = (PFN_vkGetDeviceProcAddr) ctx->get_instance_proc_addr(ctx->instance, "vkGetDeviceProcAddr");
+
+        if(ctx->get_device_proc_addr == NULL)
+        {
+            status = false;
+            LOG_ERROR("Failed to load function pointer vkGetDeviceProcAddr\n");
+        }
+    }
 
     return status;
 }
 
-bool initialize_device_function_pointers(void)
+bool initialize_device_function_pointers(struct vk_context* ctx)
 {
     bool status = true;
 
-    status &= load_function_pointer(g_vk_ctx.instance, "vkGetDeviceProcAddr", (void**) &g_vk_ctx.get_device_proc_addr);
-
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkCreateSemaphore", (void**) &g_vk_ctx.create_semaphore);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkDestroySemaphore", (void**) &g_vk_ctx.destroy_semaphore);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkCreateSwapchainKHR", (void**) &g_vk_ctx.create_swapchain);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkDestroySwapchainKHR", (void**) &g_vk_ctx.destroy_swapchain);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkAcquireNextImageKHR", (void**) &g_vk_ctx.acquire_next_image);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkDeviceWaitIdle", (void**) &g_vk_ctx.wait_for_device_idle);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkDestroyDevice", (void**) &g_vk_ctx.destroy_device);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkCreateCommandPool", (void**) &g_vk_ctx.create_command_pool);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkDestroyCommandPool", (void**) &g_vk_ctx.destroy_command_pool);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkAllocateCommandBuffers", (void**) &g_vk_ctx.allocate_command_buffers);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkFreeCommandBuffers", (void**) &g_vk_ctx.free_command_buffers);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkBeginCommandBuffer", (void**) &g_vk_ctx.begin_command_buffer);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkEndCommandBuffer", (void**) &g_vk_ctx.end_command_buffer);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkCmdPipelineBarrier", (void**) &g_vk_ctx.cmd_pipeline_barrier);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkGetSwapchainImagesKHR", (void**) &g_vk_ctx.get_swapchain_images);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkCmdClearColorImage", (void**) &g_vk_ctx.cmd_clear_color_image);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkQueueSubmit", (void**) &g_vk_ctx.queue_submit);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkQueuePresentKHR", (void**) &g_vk_ctx.queue_present);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkGetDeviceQueue", (void**) &g_vk_ctx.get_device_queue);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkCreateRenderPass", (void**) &g_vk_ctx.create_render_pass);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkCreateImageView", (void**) &g_vk_ctx.create_image_view);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkCreateFramebuffer", (void**) &g_vk_ctx.create_framebuffer);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkCreateShaderModule", (void**) &g_vk_ctx.create_shader_module);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkCreatePipelineLayout", (void**) &g_vk_ctx.create_pipeline_layout);
-    status &= load_device_function_pointer(g_vk_ctx.device, "vkCreateGraphicsPipelines", (void**) &g_vk_ctx.create_graphics_pipelines);
+#define LOAD_DEVICE_FUNCTION(name, member, gate, core_version, suffix) \
+    status &= load_table_entry(ctx, NULL, ctx->device, #name, gate, ctx->api_version, core_version, suffix, (void**) &ctx->member);
+
+    VK_CTX_DEVICE_FUNCTIONS(LOAD_DEVICE_FUNCTION)
+
+#undef LOAD_DEVICE_FUNCTION
 
     return status;
 }
 
-bool initialize_allocation_callbacks(void)
+bool initialize_allocation_callbacks(struct vk_context* ctx)
 {
     bool status = true;
 
-    g_allocation_callbacks.pUserData = NULL;
-    g_allocation_callbacks.pfnAllocation = vk_allocation_callback;
-    g_allocation_callbacks.pfnReallocation = vk_reallocation_callback;
-    g_allocation_callbacks.pfnFree = vk_free_callback;
-    g_allocation_callbacks.pfnInternalAllocation = vk_allocation_notification;
-    g_allocation_callbacks.pfnInternalFree = vk_free_notification;
+    VkAllocationCallbacks* callbacks = &ctx->state->allocation_callbacks;
+
+    callbacks->pUserData = ctx->state;
+    callbacks->pfnAllocation = vk_allocation_callback;
+    callbacks->pfnReallocation = vk_reallocation_callback;
+    callbacks->pfnFree = vk_free_callback;
+    callbacks->pfnInternalAllocation = vk_allocation_notification;
+    callbacks->pfnInternalFree = vk_free_notification;
 
-    g_vk_ctx.allocation_callbacks = &g_allocation_callbacks;
+    ctx->allocation_callbacks = callbacks;
 
     return status;
 }
 
-bool enumerate_instance_layers(struct layer_list* instance_layers)
+bool enumerate_instance_layers(struct vk_context* ctx, struct layer_list* instance_layers)
 {
     bool status = true;
 
     uint32_t num_layers = 0;
     struct layer_list layers = { 0 };
 
-    if(g_vk_ctx.enumerate_instance_layers(&num_layers, NULL) == VK_SUCCESS)
+    if(ctx->enumerate_instance_layers(&num_layers, NULL) == VK_SUCCESS)
     {
         layers.count = num_layers + 1; // +1 for vulkan implementation
     }
     else
     {
         status = false;
-        printf("Failed to get number of layers\n");
+        LOG_ERROR("Failed to get number of layers\n");
     }
 
     if(status)
@@ -901,7 +1044,7 @@ bool enumerate_instance_layers(struct layer_list* instance_layers)
         if(layers.array == NULL)
         {
             status = false;
-            printf("Failed to allocate memory\n");
+            LOG_ERROR("Failed to allocate memory\n");
         }
     }
 
@@ -912,23 +1055,23 @@ bool enumerate_instance_layers(struct layer_list* instance_layers)
         if(layers.extension_lists == NULL)
         {
             status = false;
-            printf("Failed to allocate memory\n");
+            LOG_ERROR("Failed to allocate memory\n");
         }
     }
 
     if(status)
     {
         // enumerate the extensions provided by the vulkan implementation
-        printf("Layer: Vulkan Implementation\n");
-        status = enumerate_instance_extensions(NULL, &layers.extension_lists[0]);
+        LOG_DEBUG("Layer: Vulkan Implementation\n");
+        status = enumerate_instance_extensions(ctx, NULL, &layers.extension_lists[0]);
     }
 
     if(status)
     {
-        if(g_vk_ctx.enumerate_instance_layers(&num_layers, &layers.array[1]) != VK_SUCCESS) // start reading at element 1 because element 0 is the vulkan implementation
+        if(ctx->enumerate_instance_layers(&num_layers, &layers.array[1]) != VK_SUCCESS) // start reading at element 1 because element 0 is the vulkan implementation
         {
             status = false;
-            printf("Failed to get layers\n");
+            LOG_ERROR("Failed to get layers\n");
         }
     }
 
@@ -936,8 +1079,8 @@ bool enumerate_instance_layers(struct layer_list* instance_layers)
     {
         for(uint32_t i = 1; i <= num_layers; i++) // start at 1 because index 0 used for vulkan implementation
         {
-            printf("Layer %s (0x%X, %u): %s\n", layers.array[i].layerName, layers.array[i].specVersion, layers.array[i].implementationVersion, layers.array[i].description);
-            status = enumerate_instance_extensions(layers.array[i].layerName, &layers.extension_lists[i]);
+            LOG_DEBUG("Layer %s (0x%X, %u): %s\n", layers.array[i].layerName, layers.array[i].specVersion, layers.array[i].implementationVersion, layers.array[i].description);
+            status = enumerate_instance_extensions(ctx, layers.array[i].layerName, &layers.extension_lists[i]);
         }
     }
 
@@ -955,49 +1098,136 @@ bool enumerate_instance_layers(struct layer_list* instance_layers)
     return status;
 }
 
-uint32_t find_extension(struct extension_list* extension_list, const char* extension_name)
+// fnv-1a
+static uint32_t hash_extension_name(const char* name)
 {
-    uint32_t index = INVALID_INDEX;
+    uint32_t hash = 2166136261u;
 
-    for(uint32_t i = 0; i < extension_list->count; i++)
+    for(uint32_t i = 0; (i < VK_MAX_EXTENSION_NAME_SIZE) && (name[i] != '\0'); i++)
     {
-        if(strncmp(extension_list->array[i].extensionName, extension_name, VK_MAX_EXTENSION_NAME_SIZE) == 0)
-        {
-            index = i;
-        }
+        hash ^= (uint8_t) name[i];
+        hash *= 16777619u;
     }
 
-    return index;
+    return hash;
 }
 
-bool add_extension(struct extension_list* extensions, const char** ext_array, uint32_t* ext_count, const char* ext_name)
+bool index_extensions(struct extension_list* extension_list)
 {
     bool status = true;
-    uint32_t index = INVALID_INDEX;
 
-    if((*ext_count) + 1 <= MAX_EXTENSIONS)
+    uint32_t slot_count = 16;
+
+    while(slot_count < 2 * extension_list->count)
+    {
+        slot_count *= 2;
+    }
+
+    extension_list->slots = calloc(slot_count, sizeof(uint32_t));
+
+    if(extension_list->slots != NULL)
     {
-        index = find_extension(extensions, ext_name);
+        extension_list->slot_count = slot_count;
 
-        if(index != INVALID_INDEX)
+        for(uint32_t i = 0; i < extension_list->count; i++)
         {
-            ext_array[*ext_count] = extensions->array[index].extensionName;
-            (*ext_count)++;
+            uint32_t slot = hash_extension_name(extension_list->array[i].extensionName) & (slot_count - 1);
+
+            while(extension_list->slots[slot] != 0)
+            {
+                slot = (slot + 1) & (slot_count - 1);
+            }
+
+            extension_list->slots[slot] = i + 1;
         }
-        else
+    }
+    else
+    {
+        status = false;
+        LOG_ERROR("Failed to allocate memory\n");
+    }
+
+    return status;
+}
+
+uint32_t find_extension(struct extension_list* extension_list, const char* extension_name)
+{
+    uint32_t index = INVALID_INDEX;
+
+    if(extension_list->slots != NULL)
+    {
+        uint32_t slot = hash_extension_name(extension_name) & (extension_list->slot_count - 1);
+
+        // the table is at most half full, the probe always ends at an empty slot
+        while((index == INVALID_INDEX) && (extension_list->slots[slot] != 0))
         {
-            printf("Could not find extension %s\n", ext_name);
+            uint32_t candidate = extension_list->slots[slot] - 1;
+
+            if(strncmp(extension_list->array[candidate].extensionName, extension_name, VK_MAX_EXTENSION_NAME_SIZE) == 0)
+            {
+                index = candidate;
+            }
+
+            slot = (slot + 1) & (extension_list->slot_count - 1);
         }
     }
-    else
+
+    return index;
+}
+
+bool init_extension_set(struct extension_set* set, struct extension_list* available)
+{
+    bool status = true;
+
+    memset(set, 0, sizeof(struct extension_set));
+
+    set->available = available;
+
+    // every extension can be enabled at most once, so the available count bounds the set
+    set->enabled = calloc(available->count + 1, sizeof(uint8_t));
+    set->names = calloc(available->count + 1, sizeof(const char*));
+
+    if((set->enabled == NULL) || (set->names == NULL))
     {
-        printf("Extension list out of room\n");
         status = false;
+        LOG_ERROR("Failed to allocate memory\n");
     }
 
     return status;
 }
 
+void free_extension_set(struct extension_set* set)
+{
+    free(set->enabled);
+    free(set->names);
+
+    memset(set, 0, sizeof(struct extension_set));
+}
+
+// returns whether the extension is available and enabled
+bool request_extension(struct extension_set* set, const char* extension_name)
+{
+    uint32_t index = find_extension(set->available, extension_name);
+
+    if((index != INVALID_INDEX) && !set->enabled[index])
+    {
+        set->enabled[index] = 1;
+        set->names[set->count] = set->available->array[index].extensionName;
+        set->count++;
+    }
+
+    return (index != INVALID_INDEX);
+}
+
+void require_extension(struct extension_set* set, const char* extension_name)
+{
+    if(!request_extension(set, extension_name))
+    {
+        LOG_ERROR("Missing required extension %s\n", extension_name);
+        set->missing_count++;
+    }
+}
+
 void free_layers(struct layer_list* layers)
 {
     if(layers != NULL)
@@ -1033,20 +1263,27 @@ void free_extensions(struct extension_list* extensions)
             extensions->array = NULL;
         }
 
+        if(extensions->slots != NULL)
+        {
+            free(extensions->slots);
+            extensions->slots = NULL;
+        }
+
         extensions->count = 0;
+        extensions->slot_count = 0;
     }
 }
 
-bool enumerate_instance_extensions(const char* layer, struct extension_list* instance_extensions)
+bool enumerate_instance_extensions(struct vk_context* ctx, const char* layer, struct extension_list* instance_extensions)
 {
     bool status = true;
 
     struct extension_list extensions = { 0 };
 
-    if(g_vk_ctx.enumerate_instance_extensions(layer, &extensions.count, NULL) != VK_SUCCESS)
+    if(ctx->enumerate_instance_extensions(layer, &extensions.count, NULL) != VK_SUCCESS)
     {
         status = false;
-        printf("Failed to get number of extensions\n");
+        LOG_ERROR("Failed to get number of extensions\n");
     }
 
     if(status)
@@ -1056,16 +1293,16 @@ bool enumerate_instance_extensions(const char* layer, struct extension_list* ins
         if(extensions.array == NULL)
         {
             status = false;
-            printf("Failed to allocate memory\n");
+            LOG_ERROR("Failed to allocate memory\n");
         }
     }
 
     if(status)
     {
-        if(g_vk_ctx.enumerate_instance_extensions(layer, &extensions.count, extensions.array) != VK_SUCCESS)
+        if(ctx->enumerate_instance_extensions(layer, &extensions.count, extensions.array) != VK_SUCCESS)
         {
             status = false;
-            printf("Failed to get extensions\n");
+            LOG_ERROR("Failed to get extensions\n");
         }
     }
 
@@ -1073,14 +1310,18 @@ bool enumerate_instance_extensions(const char* layer, struct extension_list* ins
     {
         for(uint32_t i = 0; i < extensions.count; i++)
         {
-            printf("\tExtension: %s\n", extensions.array[i].extensionName);
+            LOG_DEBUG("\tExtension: %s\n", extensions.array[i].extensionName);
         }
     }
 
     if(status)
     {
-        instance_extensions->array = extensions.array;
-        instance_extensions->count = extensions.count;
+        status = index_extensions(&extensions);
+    }
+
+    if(status)
+    {
+        (*instance_extensions) = extensions;
     }
     else
     {
@@ -1090,38 +1331,89 @@ bool enumerate_instance_extensions(const char* layer, struct extension_list* ins
     return status;
 }
 
-bool initialize_instance(uint32_t ext_count, const char** ext_array)
+bool initialize_instance(struct vk_context* ctx, uint32_t ext_count, const char** ext_array, const struct vk_context_options* options)
 {
     bool status = true;
 
     struct layer_list layers = { 0 };
 
-    uint32_t num_extensions = 0;
-    const char* extensions[MAX_EXTENSIONS] = { 0 };
+    struct extension_set enabled_extensions = { 0 };
+
+    if(status)
+    {
+        status = enumerate_instance_layers(ctx, &layers);
+    }
 
     if(status)
     {
-        status = enumerate_instance_layers(&layers);
+        status = init_extension_set(&enabled_extensions, &layers.extension_lists[0]);
     }
 
     if(status)
     {
-        for(uint32_t i = 0; status && (i < ext_count); i++)
+        // the extensions the window system needs, missing ones fail the creation below
+        for(uint32_t i = 0; i < ext_count; i++)
         {
-            status = add_extension(&layers.extension_lists[0], extensions, &num_extensions, ext_array[i]);
+            require_extension(&enabled_extensions, ext_array[i]);
         }
+    }
 
-        if(!status)
+    if(status)
+    {
+        uint32_t loader_version = VK_API_VERSION_1_0;
+
+        if((ctx->enumerate_instance_version != NULL) && (ctx->enumerate_instance_version(&loader_version) != VK_SUCCESS))
         {
-            printf("Could not enable all required extensions\n");
-            status = false;
+            loader_version = VK_API_VERSION_1_0;
         }
+
+        // the patch version does not matter for the features, newer minor versions are not used yet
+        ctx->instance_api_version = VK_MAKE_API_VERSION(0, VK_API_VERSION_MAJOR(loader_version), VK_API_VERSION_MINOR(loader_version), 0);
+
+        if(ctx->instance_api_version > VK_API_VERSION_1_3)
+        {
+            ctx->instance_api_version = VK_API_VERSION_1_3;
+        }
+
+        LOG_INFO("Instance API version %u.%u\n", VK_API_VERSION_MAJOR(ctx->instance_api_version), VK_API_VERSION_MINOR(ctx->instance_api_version));
+    }
+
+    if(status && (ctx->instance_api_version >= VK_API_VERSION_1_1))
+    {
+        // both instance extensions below are core in 1.1
+        ctx->physical_device_properties2_supported = VK_TRUE;
+        ctx->device_id_properties_supported = VK_TRUE;
+    }
+
+    if(status && !ctx->physical_device_properties2_supported)
+    {
+        // optional: a dependency of the optional device extensions on a 1.0 instance
+        ctx->physical_device_properties2_supported = request_extension(&enabled_extensions, "VK_KHR_get_physical_device_properties2");
+    }
+
+    if(status && ctx->physical_device_properties2_supported && !ctx->device_id_properties_supported)
+    {
+        // optional: the device uuid used to select a device is part of the external memory capabilities
+        ctx->device_id_properties_supported = request_extension(&enabled_extensions, "VK_KHR_external_memory_capabilities");
+    }
+
+#ifdef DEBUG
+    if(status)
+    {
+        require_extension(&enabled_extensions, "VK_EXT_debug_utils");
+    }
+#endif
+
+    if(status && (enabled_extensions.missing_count > 0))
+    {
+        LOG_ERROR("%u required instance extensions are missing\n", enabled_extensions.missing_count);
+        status = false;
     }
 
 #ifdef DEBUG
     if(status)
     {
-        status = add_extension(&layers.extension_lists[0], extensions, &num_extensions, "VK_EXT_debug_report");
+        status = initialize_debug_messenger(&ctx->state->debug_messenger, &options->debug_messenger);
     }
 #endif
 
@@ -1134,63 +1426,71 @@ bool initialize_instance(uint32_t ext_count, const char** ext_array)
         app_info.applicationVersion = 1;
         app_info.pEngineName = "vk-cube";
         app_info.engineVersion = 1;
-        app_info.apiVersion = VK_API_VERSION_1_0;
+        app_info.apiVersion = ctx->instance_api_version;
 
         VkInstanceCreateInfo instance_info;
         instance_info.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
         instance_info.pNext = NULL;
+
+        // reports the messages of vkCreateInstance and vkDestroyInstance, which no messenger of the instance sees
+        VkDebugUtilsMessengerCreateInfoEXT messenger_info;
+
+        if(ctx->state->debug_messenger != NULL)
+        {
+            get_debug_messenger_create_info(ctx->state->debug_messenger, &messenger_info);
+            instance_info.pNext = &messenger_info;
+        }
+
         instance_info.flags = 0;
         instance_info.pApplicationInfo = &app_info;
         instance_info.enabledLayerCount = 0;
         instance_info.ppEnabledLayerNames = NULL;
-        instance_info.enabledExtensionCount = num_extensions;
-        instance_info.ppEnabledExtensionNames = extensions;
+        instance_info.enabledExtensionCount = enabled_extensions.count;
+        instance_info.ppEnabledExtensionNames = enabled_extensions.names;
 
-        if(g_vk_ctx.create_instance(&instance_info, g_vk_ctx.allocation_callbacks, &g_vk_ctx.instance) != VK_SUCCESS)
+        if(ctx->create_instance(&instance_info, ctx->allocation_callbacks, &ctx->instance) != VK_SUCCESS)
         {
             status = false;
-            printf("Failed to create vulkan instance\n");
+            LOG_ERROR("Failed to create vulkan instance\n");
         }
     }
 
     if(status)
     {
-        status = initialize_instance_function_pointers();
+        status = initialize_instance_function_pointers(ctx);
     }
 
 #ifdef DEBUG
     if(status)
     {
-        status = initialize_debug_layer();
+        status = initialize_debug_layer(ctx);
     }
 #endif
 
+    free_extension_set(&enabled_extensions);
+
     free_layers(&layers);
-    
+
     return status;
 }
 
-bool initialize_debug_layer(void)
+bool initialize_debug_layer(struct vk_context* ctx)
 {
     bool status = true;
 
-    VkDebugReportCallbackCreateInfoEXT callback_info;
-    callback_info.sType = VK_STRUCTURE_TYPE_DEBUG_REPORT_CALLBACK_CREATE_INFO_EXT;
-    callback_info.pNext = NULL;
-    callback_info.flags = VK_DEBUG_REPORT_FLAG_BITS_MAX_ENUM_EXT;
-    callback_info.pfnCallback = debug_callback;
-    callback_info.pUserData = NULL;
+    VkDebugUtilsMessengerCreateInfoEXT messenger_info;
+    get_debug_messenger_create_info(ctx->state->debug_messenger, &messenger_info);
 
-    if(g_vk_ctx.register_debug_callback(g_vk_ctx.instance, &callback_info, g_vk_ctx.allocation_callbacks, &g_vk_ctx.debug_callback) != VK_SUCCESS)
+    if(ctx->create_debug_messenger(ctx->instance, &messenger_info, ctx->allocation_callbacks, &ctx->debug_messenger) != VK_SUCCESS)
     {
-        printf("Failed to register debug callback\n");
+        LOG_ERROR("Failed to create debug messenger\n");
         status = false;
     }
 
     return status;
 }
 
-bool enumerate_gpus(uint32_t* gpu_count, struct gpu_info** gpu_info_array)
+bool enumerate_gpus(struct vk_context* ctx, uint32_t* gpu_count, struct gpu_info** gpu_info_array)
 {
     bool status = true;
 
@@ -1200,10 +1500,10 @@ bool enumerate_gpus(uint32_t* gpu_count, struct gpu_info** gpu_info_array)
 
     struct gpu_info* info_array = NULL;
 
-    if(g_vk_ctx.enumerate_physical_devices(g_vk_ctx.instance, &num_physical_devices, NULL) != VK_SUCCESS)
+    if(ctx->enumerate_physical_devices(ctx->instance, &num_physical_devices, NULL) != VK_SUCCESS)
     {
         status = false;
-        printf("Failed to get number of devices\n");
+        LOG_ERROR("Failed to get number of devices\n");
     }
 
     if(status)
@@ -1213,16 +1513,16 @@ bool enumerate_gpus(uint32_t* gpu_count, struct gpu_info** gpu_info_array)
         if(physical_device_handles == NULL)
         {
             status = false;
-            printf("Failed to allocate memory\n");
+            LOG_ERROR("Failed to allocate memory\n");
         }
     }
 
     if(status)
     {
-        if(g_vk_ctx.enumerate_physical_devices(g_vk_ctx.instance, &num_physical_devices, physical_device_handles) != VK_SUCCESS)
+        if(ctx->enumerate_physical_devices(ctx->instance, &num_physical_devices, physical_device_handles) != VK_SUCCESS)
         {
             status = false;
-            printf("Failed to get devices\n");
+            LOG_ERROR("Failed to get devices\n");
         }
     }
 
@@ -1233,7 +1533,7 @@ bool enumerate_gpus(uint32_t* gpu_count, struct gpu_info** gpu_info_array)
         if(info_array == NULL)
         {
             status = false;
-            printf("Failed to allocate memory\n");
+            LOG_ERROR("Failed to allocate memory\n");
         }
     }
 
@@ -1242,10 +1542,28 @@ bool enumerate_gpus(uint32_t* gpu_count, struct gpu_info** gpu_info_array)
         for(uint32_t i = 0; status && (i < num_physical_devices); i++)
         {
             info_array[i].handle = physical_device_handles[i];
-            g_vk_ctx.get_physical_device_properties(physical_device_handles[i], &info_array[i].properties);
-            g_vk_ctx.get_physical_device_features(physical_device_handles[i], &info_array[i].features);
-            
-            status = get_gpu_queue_info(physical_device_handles[i], &info_array[i].queue_group_count, &info_array[i].queue_group_properties);
+            ctx->get_physical_device_properties(physical_device_handles[i], &info_array[i].properties);
+            ctx->get_physical_device_features(physical_device_handles[i], &info_array[i].features);
+            ctx->get_physical_device_memory_properties(physical_device_handles[i], &info_array[i].memory_properties);
+
+            info_array[i].device_uuid_valid = VK_FALSE;
+
+            if(ctx->device_id_properties_supported)
+            {
+                VkPhysicalDeviceIDProperties id_properties = { 0 };
+                id_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+
+                VkPhysicalDeviceProperties2 properties = { 0 };
+                properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+                properties.pNext = &id_properties;
+
+                ctx->get_physical_device_properties2(physical_device_handles[i], &properties);
+
+                memcpy(info_array[i].device_uuid, id_properties.deviceUUID, VK_UUID_SIZE);
+                info_array[i].device_uuid_valid = VK_TRUE;
+            }
+
+            status = get_gpu_queue_info(ctx, physical_device_handles[i], &info_array[i].queue_group_count, &info_array[i].queue_group_properties);
         }
     }
 
@@ -1295,8 +1613,10 @@ void free_gpu_info(uint32_t gpu_count, struct gpu_info* gpu_info_array)
     }
 }
 
-bool initialize_device(void)
+bool initialize_device(struct vk_context* ctx, const struct vk_context_options* options)
 {
+    const char* device_selector = options->device_selector;
+
     bool status = true;
 
     uint32_t gpu_count = 0;
@@ -1305,46 +1625,235 @@ bool initialize_device(void)
 
     struct layer_list layers = { 0 };
 
-    uint32_t num_extensions = 0;
-    const char* extensions[MAX_EXTENSIONS] = { 0 };
+    struct extension_set enabled_extensions = { 0 };
+
+    // the core features of the negotiated version, only queried on 1.2 and later
+    VkPhysicalDeviceVulkan12Features vulkan12_features = { 0 };
+    VkPhysicalDeviceVulkan13Features vulkan13_features = { 0 };
 
     if(status)
     {
-        status = enumerate_gpus(&gpu_count, &gpu_info);
+        status = enumerate_gpus(ctx, &gpu_count, &gpu_info);
     }
 
     if(status)
     {
-        while(gpu_index < gpu_count)
-        {
-            if(gpu_info[gpu_index].properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
-            {
-                printf("Use device %u\n", gpu_index);
-                break;
-            }
+        uint64_t best_score = 0;
 
-            gpu_index++;
-        }
+        gpu_index = INVALID_INDEX;
 
-        if(gpu_index < gpu_count)
+        for(uint32_t i = 0; i < gpu_count; i++)
         {
-            g_vk_ctx.physical_device = gpu_info[gpu_index].handle;
+            uint64_t score = score_gpu(ctx, &gpu_info[i]);
+
+            LOG_INFO("Device %u score: 0x%llX%s\n", i, (unsigned long long) score, (score == 0) ? " (unsuitable)" : "");
+
+            if(device_selector != NULL)
+            {
+                if(match_gpu(i, &gpu_info[i], device_selector))
+                {
+                    if(score == 0)
+                    {
+                        LOG_ERROR("Device %s does not meet the requirements\n", device_selector);
+                    }
+                    else
+                    {
+                        gpu_index = i;
+                    }
+                }
+            }
+            else if(score > best_score)
+            {
+                best_score = score;
+                gpu_index = i;
+            }
+        }
+
+        if(gpu_index != INVALID_INDEX)
+        {
+            LOG_INFO("Use device %u: %s\n", gpu_index, gpu_info[gpu_index].properties.deviceName);
+        }
+
+        if(gpu_index != INVALID_INDEX)
+        {
+            ctx->physical_device = gpu_info[gpu_index].handle;
+            ctx->get_physical_device_memory_properties(ctx->physical_device, &ctx->memory_properties);
+
+            ctx->timestamps_supported = gpu_info[gpu_index].properties.limits.timestampComputeAndGraphics;
+            ctx->timestamp_period = gpu_info[gpu_index].properties.limits.timestampPeriod;
+            ctx->framebuffer_sample_counts = gpu_info[gpu_index].properties.limits.framebufferColorSampleCounts & gpu_info[gpu_index].properties.limits.framebufferDepthSampleCounts;
+            ctx->pipeline_statistics_supported = gpu_info[gpu_index].features.pipelineStatisticsQuery;
+            ctx->fill_mode_non_solid_supported = gpu_info[gpu_index].features.fillModeNonSolid;
+            ctx->storage_buffer_array_dynamic_indexing_supported = gpu_info[gpu_index].features.shaderStorageBufferArrayDynamicIndexing;
+            ctx->sampled_image_array_dynamic_indexing_supported = gpu_info[gpu_index].features.shaderSampledImageArrayDynamicIndexing;
+            ctx->texture_compression_bc_supported = gpu_info[gpu_index].features.textureCompressionBC;
+            ctx->texture_compression_etc2_supported = gpu_info[gpu_index].features.textureCompressionETC2;
+            ctx->texture_compression_astc_ldr_supported = gpu_info[gpu_index].features.textureCompressionASTC_LDR;
+
+            uint32_t device_version = gpu_info[gpu_index].properties.apiVersion;
+            device_version = VK_MAKE_API_VERSION(0, VK_API_VERSION_MAJOR(device_version), VK_API_VERSION_MINOR(device_version), 0);
+
+            ctx->api_version = (device_version < ctx->instance_api_version) ? device_version : ctx->instance_api_version;
+
+            LOG_INFO("Use API version %u.%u\n", VK_API_VERSION_MAJOR(ctx->api_version), VK_API_VERSION_MINOR(ctx->api_version));
         }
         else
         {
             status = false;
-            printf("Could not find discrete gpu\n");
+            LOG_ERROR("Could not find a suitable device%s%s\n", (device_selector != NULL) ? " for " : "", (device_selector != NULL) ? device_selector : "");
         }
     }
 
     if(status)
     {
-        status = enumerate_device_layers_and_extensions(g_vk_ctx.physical_device, &layers);
+        status = enumerate_device_layers_and_extensions(ctx, ctx->physical_device, &layers);
+    }
+
+    if(status)
+    {
+        status = init_extension_set(&enabled_extensions, &layers.extension_lists[0]);
+    }
+
+    if(status)
+    {
+        require_extension(&enabled_extensions, "VK_KHR_swapchain");
+    }
+
+    if(status && (ctx->api_version >= VK_API_VERSION_1_2))
+    {
+        vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        vulkan12_features.pNext = (ctx->api_version >= VK_API_VERSION_1_3) ? &vulkan13_features : NULL;
+
+        vulkan13_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+        vulkan13_features.pNext = NULL;
+
+        VkPhysicalDeviceFeatures2 features = { 0 };
+        features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features.pNext = &vulkan12_features;
+
+        ctx->get_physical_device_features2(ctx->physical_device, &features);
+
+        // the fast paths promoted to core are decided here once, the extensions they came from are not enabled
+        ctx->draw_indirect_count_supported = vulkan12_features.drawIndirectCount;
+        ctx->descriptor_indexing_supported = vulkan12_features.descriptorBindingPartiallyBound && vulkan12_features.descriptorBindingStorageBufferUpdateAfterBind && vulkan12_features.descriptorBindingSampledImageUpdateAfterBind && vulkan12_features.descriptorBindingUpdateUnusedWhilePending;
+        ctx->buffer_device_address_supported = vulkan12_features.bufferDeviceAddress;
+        ctx->dynamic_rendering_supported = vulkan13_features.dynamicRendering;
+        ctx->synchronization2_supported = vulkan13_features.synchronization2;
+        ctx->maintenance4_supported = vulkan13_features.maintenance4;
+
+        // extended dynamic state is core in 1.3 without a feature bit
+        ctx->extended_dynamic_state_supported = (ctx->api_version >= VK_API_VERSION_1_3);
     }
 
     if(status)
     {
-        status = add_extension(&layers.extension_lists[0], extensions, &num_extensions, "VK_KHR_swapchain");
+        // every queue has a timeline that the frame loop and the async work wait on. before 1.2 the feature can
+        // only be queried through the properties2 instance extension
+        VkBool32 timeline_semaphore_supported = vulkan12_features.timelineSemaphore;
+
+        if((ctx->api_version < VK_API_VERSION_1_2) && ctx->physical_device_properties2_supported)
+        {
+            VkPhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore_features = { 0 };
+            timeline_semaphore_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+
+            VkPhysicalDeviceFeatures2 features = { 0 };
+            features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            features.pNext = &timeline_semaphore_features;
+
+            ctx->get_physical_device_features2(ctx->physical_device, &features);
+
+            timeline_semaphore_supported = timeline_semaphore_features.timelineSemaphore;
+
+            if(timeline_semaphore_supported)
+            {
+                require_extension(&enabled_extensions, "VK_KHR_timeline_semaphore");
+            }
+        }
+
+        if(!timeline_semaphore_supported)
+        {
+            LOG_ERROR("Timeline semaphores are not supported\n");
+            status = false;
+        }
+    }
+
+    if(status && (ctx->api_version < VK_API_VERSION_1_2))
+    {
+        // optional: used to draw the compacted output of the cluster culling pass
+        ctx->draw_indirect_count_supported = request_extension(&enabled_extensions, "VK_KHR_draw_indirect_count");
+    }
+
+    if(status && (ctx->api_version < VK_API_VERSION_1_3))
+    {
+        // optional: render without render pass and framebuffer objects. on a 1.0 instance the extension
+        // requires its dependencies to be enabled as well, so it is only used when all of them are present
+        const char* dynamic_rendering_extensions[] =
+        {
+            "VK_KHR_multiview",
+            "VK_KHR_maintenance2",
+            "VK_KHR_create_renderpass2",
+            "VK_KHR_depth_stencil_resolve",
+            "VK_KHR_dynamic_rendering",
+        };
+
+        const uint32_t dynamic_rendering_extension_count = sizeof(dynamic_rendering_extensions) / sizeof(dynamic_rendering_extensions[0]);
+
+        uint32_t found = 0;
+
+        for(uint32_t i = 0; i < dynamic_rendering_extension_count; i++)
+        {
+            if(find_extension(&layers.extension_lists[0], dynamic_rendering_extensions[i]) != INVALID_INDEX)
+            {
+                found++;
+            }
+        }
+
+        if(ctx->physical_device_properties2_supported && (found == dynamic_rendering_extension_count))
+        {
+            for(uint32_t i = 0; i < dynamic_rendering_extension_count; i++)
+            {
+                request_extension(&enabled_extensions, dynamic_rendering_extensions[i]);
+            }
+
+            ctx->dynamic_rendering_supported = VK_TRUE;
+        }
+    }
+
+    if(status && ctx->physical_device_properties2_supported && (ctx->api_version < VK_API_VERSION_1_2))
+    {
+        // optional: a bindless descriptor table that is updated while it is bound. only the features used by
+        // the table are checked, the shaders index it with dynamically uniform indices
+        if((find_extension(&layers.extension_lists[0], "VK_KHR_maintenance3") != INVALID_INDEX) && (find_extension(&layers.extension_lists[0], "VK_EXT_descriptor_indexing") != INVALID_INDEX))
+        {
+            VkPhysicalDeviceDescriptorIndexingFeatures descriptor_indexing_features = { 0 };
+            descriptor_indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+            VkPhysicalDeviceFeatures2 features = { 0 };
+            features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+            features.pNext = &descriptor_indexing_features;
+
+            ctx->get_physical_device_features2(ctx->physical_device, &features);
+
+            if(descriptor_indexing_features.descriptorBindingPartiallyBound && descriptor_indexing_features.descriptorBindingStorageBufferUpdateAfterBind && descriptor_indexing_features.descriptorBindingSampledImageUpdateAfterBind && descriptor_indexing_features.descriptorBindingUpdateUnusedWhilePending)
+            {
+                request_extension(&enabled_extensions, "VK_KHR_maintenance3");
+                request_extension(&enabled_extensions, "VK_EXT_descriptor_indexing");
+
+                ctx->descriptor_indexing_supported = VK_TRUE;
+            }
+        }
+    }
+
+    if(status && ctx->physical_device_properties2_supported && (ctx->api_version < VK_API_VERSION_1_3))
+    {
+        // optional: depth state set while recording, the extension guarantees the feature
+        ctx->extended_dynamic_state_supported = request_extension(&enabled_extensions, "VK_EXT_extended_dynamic_state");
+    }
+
+    if(status && ctx->physical_device_properties2_supported)
+    {
+        // optional: the usage and budget of each heap as the driver sees them, including other processes
+        ctx->memory_budget_supported = request_extension(&enabled_extensions, "VK_EXT_memory_budget");
     }
 
     if(status)
@@ -1355,7 +1864,7 @@ bool initialize_device(void)
         {
             if(gpu_info[gpu_index].queue_group_properties[queue_group_index].queueFlags & VK_QUEUE_GRAPHICS_BIT)
             {
-                printf("Use queue group %u\n", queue_group_index);
+                LOG_INFO("Use queue group %u\n", queue_group_index);
                 break;
             }
 
@@ -1364,58 +1873,202 @@ bool initialize_device(void)
 
         if(queue_group_index < gpu_info[gpu_index].queue_group_count)
         {
-            g_vk_ctx.graphics_queue_family = queue_group_index;
+            ctx->graphics_queue_family = queue_group_index;
         }
         else
         {
             status = false;
-            printf("Could not find queue group\n");
+            LOG_ERROR("Could not find queue group\n");
         }
     }
 
     if(status)
     {
-        const float queue_priorities[VK_CTX_NUM_GRAPHICS_QUEUES] = { 1.0f };
+        // optional: a compute only family usually maps to separate hardware queues that run next to graphics
+        for(uint32_t i = 0; i < gpu_info[gpu_index].queue_group_count; i++)
+        {
+            VkQueueFlags flags = gpu_info[gpu_index].queue_group_properties[i].queueFlags;
 
-        uint32_t queue_count = gpu_info[gpu_index].queue_group_properties[g_vk_ctx.graphics_queue_family].queueCount;
+            if((flags & VK_QUEUE_COMPUTE_BIT) && !(flags & VK_QUEUE_GRAPHICS_BIT))
+            {
+                LOG_INFO("Use queue group %u for async compute\n", i);
+                ctx->compute_queue_family = i;
+                ctx->async_compute_supported = VK_TRUE;
+                break;
+            }
+        }
+    }
+
+    if(status && (enabled_extensions.missing_count > 0))
+    {
+        LOG_ERROR("%u required device extensions are missing\n", enabled_extensions.missing_count);
+        status = false;
+    }
+
+    if(status)
+    {
+        // only enable what is used, the statistics queries measure the fragment cost of the depth pre-pass
+        // and non solid fill modes are used by the wireframe pipeline. the compressed formats of the supported
+        // families are usable by the textures, which formats can be sampled is probed per format
+        VkPhysicalDeviceFeatures enabled_features = { 0 };
+        enabled_features.pipelineStatisticsQuery = ctx->pipeline_statistics_supported;
+        enabled_features.fillModeNonSolid = ctx->fill_mode_non_solid_supported;
+        enabled_features.shaderStorageBufferArrayDynamicIndexing = ctx->storage_buffer_array_dynamic_indexing_supported;
+        enabled_features.shaderSampledImageArrayDynamicIndexing = ctx->sampled_image_array_dynamic_indexing_supported;
+        enabled_features.textureCompressionBC = ctx->texture_compression_bc_supported;
+        enabled_features.textureCompressionETC2 = ctx->texture_compression_etc2_supported;
+        enabled_features.textureCompressionASTC_LDR = ctx->texture_compression_astc_ldr_supported;
+
+        VkPhysicalDeviceDynamicRenderingFeatures dynamic_rendering_features;
+        dynamic_rendering_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES;
+        dynamic_rendering_features.pNext = NULL;
+        dynamic_rendering_features.dynamicRendering = VK_TRUE;
+
+        VkPhysicalDeviceExtendedDynamicStateFeaturesEXT extended_dynamic_state_features;
+        extended_dynamic_state_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_EXTENDED_DYNAMIC_STATE_FEATURES_EXT;
+        extended_dynamic_state_features.pNext = NULL;
+        extended_dynamic_state_features.extendedDynamicState = VK_TRUE;
+
+        VkPhysicalDeviceDescriptorIndexingFeatures descriptor_indexing_features = { 0 };
+        descriptor_indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+        descriptor_indexing_features.descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE;
+        descriptor_indexing_features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        descriptor_indexing_features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+        descriptor_indexing_features.descriptorBindingPartiallyBound = VK_TRUE;
+
+        VkPhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore_features;
+        timeline_semaphore_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+        timeline_semaphore_features.pNext = NULL;
+        timeline_semaphore_features.timelineSemaphore = VK_TRUE;
+
+        // the structures of promoted extensions must not be chained together with the core structure that
+        // contains their features
+        VkPhysicalDeviceVulkan12Features enabled_vulkan12_features = { 0 };
+        enabled_vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        enabled_vulkan12_features.timelineSemaphore = VK_TRUE;
+        enabled_vulkan12_features.drawIndirectCount = ctx->draw_indirect_count_supported;
+        enabled_vulkan12_features.descriptorBindingStorageBufferUpdateAfterBind = ctx->descriptor_indexing_supported;
+        enabled_vulkan12_features.descriptorBindingSampledImageUpdateAfterBind = ctx->descriptor_indexing_supported;
+        enabled_vulkan12_features.descriptorBindingUpdateUnusedWhilePending = ctx->descriptor_indexing_supported;
+        enabled_vulkan12_features.descriptorBindingPartiallyBound = ctx->descriptor_indexing_supported;
+        enabled_vulkan12_features.bufferDeviceAddress = ctx->buffer_device_address_supported;
+
+        VkPhysicalDeviceVulkan13Features enabled_vulkan13_features = { 0 };
+        enabled_vulkan13_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+        enabled_vulkan13_features.dynamicRendering = ctx->dynamic_rendering_supported;
+        enabled_vulkan13_features.synchronization2 = ctx->synchronization2_supported;
+        enabled_vulkan13_features.maintenance4 = ctx->maintenance4_supported;
+
+        // chain the feature structures of the required and the enabled optional extensions
+        void* features_chain = NULL;
+
+        if(ctx->api_version >= VK_API_VERSION_1_2)
+        {
+            features_chain = &enabled_vulkan12_features;
+
+            if(ctx->api_version >= VK_API_VERSION_1_3)
+            {
+                enabled_vulkan13_features.pNext = features_chain;
+                features_chain = &enabled_vulkan13_features;
+            }
+        }
+        else
+        {
+            features_chain = &timeline_semaphore_features;
+
+            if(ctx->descriptor_indexing_supported)
+            {
+                descriptor_indexing_features.pNext = features_chain;
+                features_chain = &descriptor_indexing_features;
+            }
+        }
+
+        if(ctx->api_version < VK_API_VERSION_1_3)
+        {
+            if(ctx->extended_dynamic_state_supported)
+            {
+                extended_dynamic_state_features.pNext = features_chain;
+                features_chain = &extended_dynamic_state_features;
+            }
+
+            if(ctx->dynamic_rendering_supported)
+            {
+                dynamic_rendering_features.pNext = features_chain;
+                features_chain = &dynamic_rendering_features;
+            }
+        }
+
+        uint32_t queue_count = gpu_info[gpu_index].queue_group_properties[ctx->graphics_queue_family].queueCount;
+
+        if(queue_count > options->graphics_queue_count)
+        {
+            queue_count = options->graphics_queue_count;
+        }
 
         if(queue_count > VK_CTX_NUM_GRAPHICS_QUEUES)
         {
             queue_count = VK_CTX_NUM_GRAPHICS_QUEUES;
         }
 
-        VkDeviceQueueCreateInfo queue_info;
-        queue_info.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
-        queue_info.pNext = NULL;
-        queue_info.flags = 0;
-        queue_info.queueFamilyIndex = g_vk_ctx.graphics_queue_family;
-        queue_info.queueCount = queue_count;
-        queue_info.pQueuePriorities = queue_priorities;
+        if(queue_count == 0)
+        {
+            queue_count = 1;
+        }
+
+        // priorities are relative within the device and only a hint, the spec does not require any scheduling
+        // guarantees. discreteQueuePriorities tells how many distinct levels the implementation has
+        for(uint32_t i = 0; i < queue_count; i++)
+        {
+            float priority = options->graphics_queue_priorities[i];
+
+            ctx->graphics_queue_priorities[i] = (priority < 0.0f) ? 0.0f : ((priority > 1.0f) ? 1.0f : priority);
+        }
+
+        ctx->graphics_queue_count = queue_count;
+
+        LOG_INFO("Use %u graphics queues, %u discrete priority levels\n", queue_count, gpu_info[gpu_index].properties.limits.discreteQueuePriorities);
+
+        const float compute_queue_priority = 0.5f;
+
+        VkDeviceQueueCreateInfo queue_infos[2];
+        queue_infos[0].sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+        queue_infos[0].pNext = NULL;
+        queue_infos[0].flags = 0;
+        queue_infos[0].queueFamilyIndex = ctx->graphics_queue_family;
+        queue_infos[0].queueCount = queue_count;
+        queue_infos[0].pQueuePriorities = ctx->graphics_queue_priorities;
+
+        queue_infos[1] = queue_infos[0];
+        queue_infos[1].queueFamilyIndex = ctx->compute_queue_family;
+        queue_infos[1].queueCount = 1;
+        queue_infos[1].pQueuePriorities = &compute_queue_priority;
 
         VkDeviceCreateInfo device_info;
         device_info.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-        device_info.pNext = NULL;
+        device_info.pNext = features_chain;
         device_info.flags = 0;
-        device_info.queueCreateInfoCount = 1;
-        device_info.pQueueCreateInfos = &queue_info;
+        device_info.queueCreateInfoCount = ctx->async_compute_supported ? 2 : 1;
+        device_info.pQueueCreateInfos = queue_infos;
         device_info.enabledLayerCount = 0;
         device_info.ppEnabledLayerNames = NULL;
-        device_info.enabledExtensionCount = num_extensions;
-        device_info.ppEnabledExtensionNames = extensions;
-        device_info.pEnabledFeatures = NULL;
+        device_info.enabledExtensionCount = enabled_extensions.count;
+        device_info.ppEnabledExtensionNames = enabled_extensions.names;
+        device_info.pEnabledFeatures = &enabled_features;
 
-        if(g_vk_ctx.create_device(g_vk_ctx.physical_device, &device_info, g_vk_ctx.allocation_callbacks, &g_vk_ctx.device) != VK_SUCCESS)
+        if(ctx->create_device(ctx->physical_device, &device_info, ctx->allocation_callbacks, &ctx->device) != VK_SUCCESS)
         {
             status = false;
-            printf("Failed to create vulkan device\n");
+            LOG_ERROR("Failed to create vulkan device\n");
         }
     }
 
     if(status)
     {
-        status = initialize_device_function_pointers();
+        status = initialize_device_function_pointers(ctx);
     }
 
+    free_extension_set(&enabled_extensions);
+
     free_layers(&layers);
 
     free_gpu_info(gpu_count, gpu_info);
@@ -1424,9 +2077,183 @@ bool initialize_device(void)
     return status;
 }
 
+// the device type dominates the score, then the number of optional capabilities, then the size of the device
+// local memory in MiB. devices without a graphics queue or without swapchain support score 0
+uint64_t score_gpu(struct vk_context* ctx, struct gpu_info* gpu_info)
+{
+    uint64_t score = 0;
+
+    bool graphics_queue_found = false;
+    uint64_t capability_count = 0;
+    uint64_t device_local_size = 0;
+
+    struct extension_list extensions = { 0 };
+
+    for(uint32_t i = 0; i < gpu_info->queue_group_count; i++)
+    {
+        VkQueueFlags flags = gpu_info->queue_group_properties[i].queueFlags;
+
+        if(flags & VK_QUEUE_GRAPHICS_BIT)
+        {
+            graphics_queue_found = true;
+        }
+        else if(flags & VK_QUEUE_COMPUTE_BIT)
+        {
+            // async compute
+            capability_count++;
+        }
+        else if(flags & VK_QUEUE_TRANSFER_BIT)
+        {
+            // dedicated copy engine
+            capability_count++;
+        }
+    }
+
+    for(uint32_t i = 0; i < gpu_info->memory_properties.memoryHeapCount; i++)
+    {
+        if(gpu_info->memory_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+        {
+            device_local_size += gpu_info->memory_properties.memoryHeaps[i].size;
+        }
+    }
+
+    if(graphics_queue_found && enumerate_device_extensions(ctx, gpu_info->handle, NULL, &extensions))
+    {
+        // timeline semaphores are core in 1.2 when both the instance and the device support it. only major and
+        // minor count, devices that differ in the patch level rank the same
+        uint32_t device_version = VK_MAKE_API_VERSION(0, VK_API_VERSION_MAJOR(gpu_info->properties.apiVersion), VK_API_VERSION_MINOR(gpu_info->properties.apiVersion), 0);
+        uint32_t api_version = (device_version < ctx->instance_api_version) ? device_version : ctx->instance_api_version;
+
+        bool timeline_semaphore_found = (api_version >= VK_API_VERSION_1_2) || (find_extension(&extensions, "VK_KHR_timeline_semaphore") != INVALID_INDEX);
+
+        if((find_extension(&extensions, "VK_KHR_swapchain") != INVALID_INDEX) && timeline_semaphore_found)
+        {
+            // in 1.2 draw indirect count and descriptor indexing are optional features, they count with the same
+            // feature bits that initialize_device checks. below 1.2 the extensions are used
+            if((api_version >= VK_API_VERSION_1_2) && ctx->physical_device_properties2_supported)
+            {
+                VkPhysicalDeviceVulkan12Features vulkan12_features = { 0 };
+                vulkan12_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+                VkPhysicalDeviceFeatures2 features = { 0 };
+                features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+                features.pNext = &vulkan12_features;
+
+                ctx->get_physical_device_features2(gpu_info->handle, &features);
+
+                if(vulkan12_features.drawIndirectCount)
+                {
+                    capability_count++;
+                }
+
+                if(vulkan12_features.descriptorBindingPartiallyBound && vulkan12_features.descriptorBindingStorageBufferUpdateAfterBind && vulkan12_features.descriptorBindingSampledImageUpdateAfterBind && vulkan12_features.descriptorBindingUpdateUnusedWhilePending)
+                {
+                    capability_count++;
+                }
+            }
+            else
+            {
+                if(find_extension(&extensions, "VK_KHR_draw_indirect_count") != INVALID_INDEX)
+                {
+                    capability_count++;
+                }
+
+                if(find_extension(&extensions, "VK_EXT_descriptor_indexing") != INVALID_INDEX)
+                {
+                    capability_count++;
+                }
+            }
+
+            // dynamic rendering and extended dynamic state are mandatory in 1.3, a device of that version does not
+            // have to list the extensions
+            const char* promoted_extensions[] =
+            {
+                "VK_KHR_dynamic_rendering",
+                "VK_EXT_extended_dynamic_state",
+            };
+
+            for(uint32_t i = 0; i < sizeof(promoted_extensions) / sizeof(promoted_extensions[0]); i++)
+            {
+                if((api_version >= VK_API_VERSION_1_3) || (find_extension(&extensions, promoted_extensions[i]) != INVALID_INDEX))
+                {
+                    capability_count++;
+                }
+            }
+
+            uint64_t type_rank = 0;
+
+            switch(gpu_info->properties.deviceType)
+            {
+                case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:   type_rank = 5; break;
+                case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: type_rank = 4; break;
+                case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:    type_rank = 3; break;
+                case VK_PHYSICAL_DEVICE_TYPE_CPU:            type_rank = 2; break;
+                default:                                     type_rank = 1; break;
+            }
+
+            uint64_t device_local_mib = device_local_size >> 20;
+
+            if(device_local_mib > 0xFFFFFFFFFF)
+            {
+                device_local_mib = 0xFFFFFFFFFF;
+            }
+
+            score = (type_rank << 48) | (capability_count << 40) | device_local_mib;
+        }
+    }
+
+    free_extensions(&extensions);
+
+    return score;
+}
+
+// a selector made of decimal digits is a device index, anything else is compared to the device uuid
+bool match_gpu(uint32_t gpu_index, struct gpu_info* gpu_info, const char* device_selector)
+{
+    bool match = false;
+
+    if((device_selector[0] != '\0') && (strspn(device_selector, "0123456789") == strlen(device_selector)))
+    {
+        match = (strtoul(device_selector, NULL, 10) == gpu_index);
+    }
+    else if(gpu_info->device_uuid_valid)
+    {
+        const char* digits = "0123456789abcdef";
+        const char* c = device_selector;
+
+        uint32_t digit_index = 0;
+
+        match = true;
+
+        while(match && (*c != '\0'))
+        {
+            if(*c != '-')
+            {
+                match = (digit_index < VK_UUID_SIZE * 2);
+
+                if(match)
+                {
+                    uint8_t byte = gpu_info->device_uuid[digit_index / 2];
+                    char expected = digits[(digit_index % 2 == 0) ? (byte >> 4) : (byte & 0xF)];
+                    char actual = ((*c >= 'A') && (*c <= 'F')) ? (*c - 'A' + 'a') : *c;
+
+                    match = (actual == expected);
+                    digit_index++;
+                }
+            }
+
+            c++;
+        }
+
+        match = match && (digit_index == VK_UUID_SIZE * 2);
+    }
+
+    return match;
+}
+
 void print_gpu_info(uint32_t gpu_index, struct gpu_info* gpu_info)
 {
-    printf("Device %u: %s\n", gpu_index, gpu_info->properties.deviceName);
+    LOG_INFO("Device %u: %s\n", gpu_index, gpu_info->properties.deviceName);
 
     const char* type = "Unknown";
     switch(gpu_info->properties.deviceType )
@@ -1446,94 +2273,103 @@ void print_gpu_info(uint32_t gpu_index, struct gpu_info* gpu_info)
         default:
             break;
     }
-    printf("\tType: %s\n", type);
-
-    printf("\tVendor: 0x%X\n", gpu_info->properties.vendorID);
-    printf("\tDevice ID: 0x%X\n", gpu_info->properties.deviceID);
-    printf("\tDriver Version: 0x%X\n", gpu_info->properties.driverVersion);
-    printf("\tAPI Version: 0x%X\n", gpu_info->properties.apiVersion);
-
-    printf("\tFeatures:\n");
-    if(gpu_info->features.robustBufferAccess) { printf("\t\tRobust buffer access\n"); }
-    if(gpu_info->features.fullDrawIndexUint32) { printf("\t\tFull draw index\n"); }
-    if(gpu_info->features.imageCubeArray) { printf("\t\tImage cube array\n"); }
-    if(gpu_info->features.independentBlend) { printf("\t\tIndependent blend\n"); }
-    if(gpu_info->features.geometryShader) { printf("\t\tGeometry shader\n"); }
-    if(gpu_info->features.tessellationShader) { printf("\t\tTessellation shader\n"); }
-    if(gpu_info->features.sampleRateShading) { printf("\t\tSample rate shading\n"); }
-    if(gpu_info->features.dualSrcBlend) { printf("\t\tDual source blend\n"); }
-    if(gpu_info->features.logicOp) { printf("\t\tLogic op\n"); }
-    if(gpu_info->features.multiDrawIndirect) { printf("\t\tMulti draw indirect\n"); }
-    if(gpu_info->features.drawIndirectFirstInstance) { printf("\t\tDraw indirect first instance\n"); }
-    if(gpu_info->features.depthClamp) { printf("\t\tDepth clamp\n"); }
-    if(gpu_info->features.depthBiasClamp) { printf("\t\tDepth bias clamp\n"); }
-    if(gpu_info->features.fillModeNonSolid) { printf("\t\tFill mode non solid\n"); }
-    if(gpu_info->features.depthBounds) { printf("\t\tDepth bounds\n"); }
-    if(gpu_info->features.wideLines) { printf("\t\tWide lines\n"); }
-    if(gpu_info->features.largePoints) { printf("\t\tLarge points\n"); }
-    if(gpu_info->features.alphaToOne) { printf("\t\tAlpha to one\n"); }
-    if(gpu_info->features.multiViewport) { printf("\t\tMulti viewport\n"); }
-    if(gpu_info->features.samplerAnisotropy) { printf("\t\tSampler anisotropy\n"); }
-    if(gpu_info->features.textureCompressionETC2) { printf("\t\tTexture compression etc2\n"); }
-    if(gpu_info->features.textureCompressionASTC_LDR) { printf("\t\tTexture compression astc ldr\n"); }
-    if(gpu_info->features.textureCompressionBC) { printf("\t\tTexture compression bc\n"); }
-    if(gpu_info->features.occlusionQueryPrecise) { printf("\t\tOcclusion query precise\n"); }
-    if(gpu_info->features.pipelineStatisticsQuery) { printf("\t\tPipeline statistics query\n"); }
-    if(gpu_info->features.vertexPipelineStoresAndAtomics) { printf("\t\tVertex pipeline stores and atomics\n"); }
-    if(gpu_info->features.fragmentStoresAndAtomics) { printf("\t\tFragment stores and atomics\n"); }
-    if(gpu_info->features.shaderTessellationAndGeometryPointSize) { printf("\t\tShader tessellation and geometry point size\n"); }
-    if(gpu_info->features.shaderImageGatherExtended) { printf("\t\tShader image gather extended\n"); }
-    if(gpu_info->features.shaderStorageImageExtendedFormats) { printf("\t\tShader storage image extended formats\n"); }
-    if(gpu_info->features.shaderStorageImageMultisample) { printf("\t\tShader storage image multisample\n"); }
-    if(gpu_info->features.shaderStorageImageReadWithoutFormat) { printf("\t\tShader storage image read without format\n"); }
-    if(gpu_info->features.shaderStorageImageWriteWithoutFormat) { printf("\t\tShader storage image write without format\n"); }
-    if(gpu_info->features.shaderUniformBufferArrayDynamicIndexing) { printf("\t\tShader uniform buffer array dynamic indexing\n"); }
-    if(gpu_info->features.shaderSampledImageArrayDynamicIndexing) { printf("\t\tShader sampled image array dynamic indexing\n"); }
-    if(gpu_info->features.shaderStorageBufferArrayDynamicIndexing) { printf("\t\tShader storage buffer array dynamic indexing\n"); }
-    if(gpu_info->features.shaderStorageImageArrayDynamicIndexing) { printf("\t\tShader storage image array dynamic indexing\n"); }
-    if(gpu_info->features.shaderClipDistance) { printf("\t\tShader clip distance\n"); }
-    if(gpu_info->features.shaderCullDistance) { printf("\t\tShader cull distance\n"); }
-    if(gpu_info->features.shaderFloat64) { printf("\t\tShader float 64\n"); }
-    if(gpu_info->features.shaderInt64) { printf("\t\tShader int 64\n"); }
-    if(gpu_info->features.shaderInt16) { printf("\t\tShader int 16\n"); }
-    if(gpu_info->features.shaderResourceResidency) { printf("\t\tShader resource residency\n"); }
-    if(gpu_info->features.shaderResourceMinLod) { printf("\t\tShader resource min lod\n"); }
-    if(gpu_info->features.sparseBinding) { printf("\t\tSparse binding\n"); }
-    if(gpu_info->features.sparseResidencyBuffer) { printf("\t\tSparse residency buffer\n"); }
-    if(gpu_info->features.sparseResidencyImage2D) { printf("\t\tSparse residency image 2D\n"); }
-    if(gpu_info->features.sparseResidencyImage3D) { printf("\t\tSparse residency image 3D\n"); }
-    if(gpu_info->features.sparseResidency2Samples) { printf("\t\tSparse residency 2 samples\n"); }
-    if(gpu_info->features.sparseResidency4Samples) { printf("\t\tSparse residency 4 samples\n"); }
-    if(gpu_info->features.sparseResidency8Samples) { printf("\t\tSparse residency 8 samples\n"); }
-    if(gpu_info->features.sparseResidency16Samples) { printf("\t\tSparse residency 16 samples\n"); }
-    if(gpu_info->features.sparseResidencyAliased) { printf("\t\tSparse residency aliased\n"); }
-    if(gpu_info->features.variableMultisampleRate) { printf("\t\tVariable multi-sample rate\n"); }
-    if(gpu_info->features.inheritedQueries) { printf("\t\tInherited queries\n"); }
+    LOG_DEBUG("\tType: %s\n", type);
+
+    LOG_DEBUG("\tVendor: 0x%X\n", gpu_info->properties.vendorID);
+    LOG_DEBUG("\tDevice ID: 0x%X\n", gpu_info->properties.deviceID);
+    LOG_DEBUG("\tDriver Version: 0x%X\n", gpu_info->properties.driverVersion);
+    LOG_DEBUG("\tAPI Version: 0x%X\n", gpu_info->properties.apiVersion);
+
+    if(gpu_info->device_uuid_valid)
+    {
+        const uint8_t* uuid = gpu_info->device_uuid;
+
+        LOG_DEBUG("\tUUID: %02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x\n",
+               uuid[0], uuid[1], uuid[2], uuid[3], uuid[4], uuid[5], uuid[6], uuid[7],
+               uuid[8], uuid[9], uuid[10], uuid[11], uuid[12], uuid[13], uuid[14], uuid[15]);
+    }
+
+    LOG_DEBUG("\tFeatures:\n");
+    if(gpu_info->features.robustBufferAccess) { LOG_DEBUG("\t\tRobust buffer access\n"); }
+    if(gpu_info->features.fullDrawIndexUint32) { LOG_DEBUG("\t\tFull draw index\n"); }
+    if(gpu_info->features.imageCubeArray) { LOG_DEBUG("\t\tImage cube array\n"); }
+    if(gpu_info->features.independentBlend) { LOG_DEBUG("\t\tIndependent blend\n"); }
+    if(gpu_info->features.geometryShader) { LOG_DEBUG("\t\tGeometry shader\n"); }
+    if(gpu_info->features.tessellationShader) { LOG_DEBUG("\t\tTessellation shader\n"); }
+    if(gpu_info->features.sampleRateShading) { LOG_DEBUG("\t\tSample rate shading\n"); }
+    if(gpu_info->features.dualSrcBlend) { LOG_DEBUG("\t\tDual source blend\n"); }
+    if(gpu_info->features.logicOp) { LOG_DEBUG("\t\tLogic op\n"); }
+    if(gpu_info->features.multiDrawIndirect) { LOG_DEBUG("\t\tMulti draw indirect\n"); }
+    if(gpu_info->features.drawIndirectFirstInstance) { LOG_DEBUG("\t\tDraw indirect first instance\n"); }
+    if(gpu_info->features.depthClamp) { LOG_DEBUG("\t\tDepth clamp\n"); }
+    if(gpu_info->features.depthBiasClamp) { LOG_DEBUG("\t\tDepth bias clamp\n"); }
+    if(gpu_info->features.fillModeNonSolid) { LOG_DEBUG("\t\tFill mode non solid\n"); }
+    if(gpu_info->features.depthBounds) { LOG_DEBUG("\t\tDepth bounds\n"); }
+    if(gpu_info->features.wideLines) { LOG_DEBUG("\t\tWide lines\n"); }
+    if(gpu_info->features.largePoints) { LOG_DEBUG("\t\tLarge points\n"); }
+    if(gpu_info->features.alphaToOne) { LOG_DEBUG("\t\tAlpha to one\n"); }
+    if(gpu_info->features.multiViewport) { LOG_DEBUG("\t\tMulti viewport\n"); }
+    if(gpu_info->features.samplerAnisotropy) { LOG_DEBUG("\t\tSampler anisotropy\n"); }
+    if(gpu_info->features.textureCompressionETC2) { LOG_DEBUG("\t\tTexture compression etc2\n"); }
+    if(gpu_info->features.textureCompressionASTC_LDR) { LOG_DEBUG("\t\tTexture compression astc ldr\n"); }
+    if(gpu_info->features.textureCompressionBC) { LOG_DEBUG("\t\tTexture compression bc\n"); }
+    if(gpu_info->features.occlusionQueryPrecise) { LOG_DEBUG("\t\tOcclusion query precise\n"); }
+    if(gpu_info->features.pipelineStatisticsQuery) { LOG_DEBUG("\t\tPipeline statistics query\n"); }
+    if(gpu_info->features.vertexPipelineStoresAndAtomics) { LOG_DEBUG("\t\tVertex pipeline stores and atomics\n"); }
+    if(gpu_info->features.fragmentStoresAndAtomics) { LOG_DEBUG("\t\tFragment stores and atomics\n"); }
+    if(gpu_info->features.shaderTessellationAndGeometryPointSize) { LOG_DEBUG("\t\tShader tessellation and geometry point size\n"); }
+    if(gpu_info->features.shaderImageGatherExtended) { LOG_DEBUG("\t\tShader image gather extended\n"); }
+    if(gpu_info->features.shaderStorageImageExtendedFormats) { LOG_DEBUG("\t\tShader storage image extended formats\n"); }
+    if(gpu_info->features.shaderStorageImageMultisample) { LOG_DEBUG("\t\tShader storage image multisample\n"); }
+    if(gpu_info->features.shaderStorageImageReadWithoutFormat) { LOG_DEBUG("\t\tShader storage image read without format\n"); }
+    if(gpu_info->features.shaderStorageImageWriteWithoutFormat) { LOG_DEBUG("\t\tShader storage image write without format\n"); }
+    if(gpu_info->features.shaderUniformBufferArrayDynamicIndexing) { LOG_DEBUG("\t\tShader uniform buffer array dynamic indexing\n"); }
+    if(gpu_info->features.shaderSampledImageArrayDynamicIndexing) { LOG_DEBUG("\t\tShader sampled image array dynamic indexing\n"); }
+    if(gpu_info->features.shaderStorageBufferArrayDynamicIndexing) { LOG_DEBUG("\t\tShader storage buffer array dynamic indexing\n"); }
+    if(gpu_info->features.shaderStorageImageArrayDynamicIndexing) { LOG_DEBUG("\t\tShader storage image array dynamic indexing\n"); }
+    if(gpu_info->features.shaderClipDistance) { LOG_DEBUG("\t\tShader clip distance\n"); }
+    if(gpu_info->features.shaderCullDistance) { LOG_DEBUG("\t\tShader cull distance\n"); }
+    if(gpu_info->features.shaderFloat64) { LOG_DEBUG("\t\tShader float 64\n"); }
+    if(gpu_info->features.shaderInt64) { LOG_DEBUG("\t\tShader int 64\n"); }
+    if(gpu_info->features.shaderInt16) { LOG_DEBUG("\t\tShader int 16\n"); }
+    if(gpu_info->features.shaderResourceResidency) { LOG_DEBUG("\t\tShader resource residency\n"); }
+    if(gpu_info->features.shaderResourceMinLod) { LOG_DEBUG("\t\tShader resource min lod\n"); }
+    if(gpu_info->features.sparseBinding) { LOG_DEBUG("\t\tSparse binding\n"); }
+    if(gpu_info->features.sparseResidencyBuffer) { LOG_DEBUG("\t\tSparse residency buffer\n"); }
+    if(gpu_info->features.sparseResidencyImage2D) { LOG_DEBUG("\t\tSparse residency image 2D\n"); }
+    if(gpu_info->features.sparseResidencyImage3D) { LOG_DEBUG("\t\tSparse residency image 3D\n"); }
+    if(gpu_info->features.sparseResidency2Samples) { LOG_DEBUG("\t\tSparse residency 2 samples\n"); }
+    if(gpu_info->features.sparseResidency4Samples) { LOG_DEBUG("\t\tSparse residency 4 samples\n"); }
+    if(gpu_info->features.sparseResidency8Samples) { LOG_DEBUG("\t\tSparse residency 8 samples\n"); }
+    if(gpu_info->features.sparseResidency16Samples) { LOG_DEBUG("\t\tSparse residency 16 samples\n"); }
+    if(gpu_info->features.sparseResidencyAliased) { LOG_DEBUG("\t\tSparse residency aliased\n"); }
+    if(gpu_info->features.variableMultisampleRate) { LOG_DEBUG("\t\tVariable multi-sample rate\n"); }
+    if(gpu_info->features.inheritedQueries) { LOG_DEBUG("\t\tInherited queries\n"); }
 
     for(uint32_t i = 0; i < gpu_info->queue_group_count; i++)
     {
-        printf("\tQueue group %u:\n", i);
-        printf("\t\tQueue count: %u\n", gpu_info->queue_group_properties[i].queueCount);
+        LOG_DEBUG("\tQueue group %u:\n", i);
+        LOG_DEBUG("\t\tQueue count: %u\n", gpu_info->queue_group_properties[i].queueCount);
         
-        if(gpu_info->queue_group_properties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) { printf("\t\tGraphics supported\n"); }
-        if(gpu_info->queue_group_properties[i].queueFlags & VK_QUEUE_COMPUTE_BIT) { printf("\t\tCompute supported\n"); }
-        if(gpu_info->queue_group_properties[i].queueFlags & VK_QUEUE_TRANSFER_BIT) { printf("\t\tTransfer supported\n"); }
-        if(gpu_info->queue_group_properties[i].queueFlags & VK_QUEUE_SPARSE_BINDING_BIT) { printf("\t\tSparse binding supported\n"); }
-        if(gpu_info->queue_group_properties[i].queueFlags & VK_QUEUE_PROTECTED_BIT) { printf("\t\tProtected memory supported\n"); }
-        if(gpu_info->queue_group_properties[i].queueFlags & VK_QUEUE_VIDEO_DECODE_BIT_KHR) { printf("\t\tVideo decode supported\n"); }
-        if(gpu_info->queue_group_properties[i].queueFlags & VK_QUEUE_VIDEO_ENCODE_BIT_KHR) { printf("\t\tVideo encode supported\n"); }
-        if(gpu_info->queue_group_properties[i].queueFlags & VK_QUEUE_OPTICAL_FLOW_BIT_NV) { printf("\t\tOptical flow supported\n"); }
+        if(gpu_info->queue_group_properties[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) { LOG_DEBUG("\t\tGraphics supported\n"); }
+        if(gpu_info->queue_group_properties[i].queueFlags & VK_QUEUE_COMPUTE_BIT) { LOG_DEBUG("\t\tCompute supported\n"); }
+        if(gpu_info->queue_group_properties[i].queueFlags & VK_QUEUE_TRANSFER_BIT) { LOG_DEBUG("\t\tTransfer supported\n"); }
+        if(gpu_info->queue_group_properties[i].queueFlags & VK_QUEUE_SPARSE_BINDING_BIT) { LOG_DEBUG("\t\tSparse binding supported\n"); }
+        if(gpu_info->queue_group_properties[i].queueFlags & VK_QUEUE_PROTECTED_BIT) { LOG_DEBUG("\t\tProtected memory supported\n"); }
+        if(gpu_info->queue_group_properties[i].queueFlags & VK_QUEUE_VIDEO_DECODE_BIT_KHR) { LOG_DEBUG("\t\tVideo decode supported\n"); }
+        if(gpu_info->queue_group_properties[i].queueFlags & VK_QUEUE_VIDEO_ENCODE_BIT_KHR) { LOG_DEBUG("\t\tVideo encode supported\n"); }
+        if(gpu_info->queue_group_properties[i].queueFlags & VK_QUEUE_OPTICAL_FLOW_BIT_NV) { LOG_DEBUG("\t\tOptical flow supported\n"); }
     }
 }
 
-bool get_gpu_queue_info(VkPhysicalDevice physical_device, uint32_t* num_queue_groups, struct VkQueueFamilyProperties** queue_group_properties)
+bool get_gpu_queue_info(struct vk_context* ctx, VkPhysicalDevice physical_device, uint32_t* num_queue_groups, struct VkQueueFamilyProperties** queue_group_properties)
 {
     bool status = true;
 
     uint32_t num_groups = 0;
     VkQueueFamilyProperties* groups = NULL;
 
-    g_vk_ctx.get_physical_queue_group_properties(physical_device, &num_groups, NULL);
+    ctx->get_physical_queue_group_properties(physical_device, &num_groups, NULL);
 
     if(num_groups > 0)
     {
@@ -1542,7 +2378,7 @@ bool get_gpu_queue_info(VkPhysicalDevice physical_device, uint32_t* num_queue_gr
         if(groups == NULL)
         {
             status = false;
-            printf("Failed to allocate memory\n");
+            LOG_ERROR("Failed to allocate memory\n");
         }
     }
 
@@ -1550,7 +2386,7 @@ bool get_gpu_queue_info(VkPhysicalDevice physical_device, uint32_t* num_queue_gr
     {
         if(num_groups > 0)
         {
-            g_vk_ctx.get_physical_queue_group_properties(physical_device, &num_groups, groups);
+            ctx->get_physical_queue_group_properties(physical_device, &num_groups, groups);
         }
 
         *num_queue_groups = num_groups;
@@ -1560,21 +2396,21 @@ bool get_gpu_queue_info(VkPhysicalDevice physical_device, uint32_t* num_queue_gr
     return status;
 }
 
-bool enumerate_device_layers_and_extensions(VkPhysicalDevice physical_device, struct layer_list* device_layers)
+bool enumerate_device_layers_and_extensions(struct vk_context* ctx, VkPhysicalDevice physical_device, struct layer_list* device_layers)
 {
     bool status = true;
 
     uint32_t num_layers = 0;
     struct layer_list layers = { 0 };
 
-    if(g_vk_ctx.enumerate_device_layers(physical_device, &num_layers, NULL) == VK_SUCCESS)
+    if(ctx->enumerate_device_layers(physical_device, &num_layers, NULL) == VK_SUCCESS)
     {
         layers.count = num_layers + 1; // +1 for vulkan implementation
     }
     else
     {
         status = false;
-        printf("Failed to get number of layers\n");
+        LOG_ERROR("Failed to get number of layers\n");
     }
 
     if(status)
@@ -1584,7 +2420,7 @@ bool enumerate_device_layers_and_extensions(VkPhysicalDevice physical_device, st
         if (layers.array == NULL)
         {
             status = false;
-            printf("Failed to allocate memory\n");
+            LOG_ERROR("Failed to allocate memory\n");
         }
     }
 
@@ -1595,23 +2431,23 @@ bool enumerate_device_layers_and_extensions(VkPhysicalDevice physical_device, st
         if(layers.extension_lists == NULL)
         {
             status = false;
-            printf("Failed to allocate memory\n");
+            LOG_ERROR("Failed to allocate memory\n");
         }
     }
 
     if(status)
     {
         // enumerate the extensions provided by the vulkan implementation
-        printf("Device layer: Vulkan Implementation\n");
-        status = enumerate_device_extensions(physical_device, NULL, &layers.extension_lists[0]);
+        LOG_DEBUG("Device layer: Vulkan Implementation\n");
+        status = enumerate_device_extensions(ctx, physical_device, NULL, &layers.extension_lists[0]);
     }
 
     if(status)
     {
-        if(g_vk_ctx.enumerate_device_layers(physical_device, &num_layers, &layers.array[1]) != VK_SUCCESS)
+        if(ctx->enumerate_device_layers(physical_device, &num_layers, &layers.array[1]) != VK_SUCCESS)
         {
             status = false;
-            printf("Failed to get layers\n");
+            LOG_ERROR("Failed to get layers\n");
         }
     }
 
@@ -1619,8 +2455,8 @@ bool enumerate_device_layers_and_extensions(VkPhysicalDevice physical_device, st
     {
         for(uint32_t i = 1; i <= num_layers; i++)
         {
-            printf("Device layer %s (0x%X, %u): %s\n", layers.array[i].layerName, layers.array[i].specVersion, layers.array[i].implementationVersion, layers.array[i].description);
-            status = enumerate_device_extensions(physical_device, layers.array[i].layerName, &layers.extension_lists[i]);
+            LOG_DEBUG("Device layer %s (0x%X, %u): %s\n", layers.array[i].layerName, layers.array[i].specVersion, layers.array[i].implementationVersion, layers.array[i].description);
+            status = enumerate_device_extensions(ctx, physical_device, layers.array[i].layerName, &layers.extension_lists[i]);
         }
     }
 
@@ -1638,16 +2474,16 @@ bool enumerate_device_layers_and_extensions(VkPhysicalDevice physical_device, st
     return status;
 }
 
-bool enumerate_device_extensions(VkPhysicalDevice physical_device, const char* layer, struct extension_list* device_extensions)
+bool enumerate_device_extensions(struct vk_context* ctx, VkPhysicalDevice physical_device, const char* layer, struct extension_list* device_extensions)
 {
     bool status = true;
 
     struct extension_list extensions = { 0 };
 
-    if(g_vk_ctx.enumerate_device_extensions(physical_device, layer, &extensions.count, NULL) != VK_SUCCESS)
+    if(ctx->enumerate_device_extensions(physical_device, layer, &extensions.count, NULL) != VK_SUCCESS)
     {
         status = false;
-        printf("Failed to get number of extensions\n");
+        LOG_ERROR("Failed to get number of extensions\n");
     }
 
     if(status)
@@ -1657,16 +2493,16 @@ bool enumerate_device_extensions(VkPhysicalDevice physical_device, const char* l
         if(extensions.array == NULL)
         {
             status = false;
-            printf("Failed to allocate memory\n");
+            LOG_ERROR("Failed to allocate memory\n");
         }
     }
 
     if(status)
     {
-        if(g_vk_ctx.enumerate_device_extensions(physical_device, layer, &extensions.count, extensions.array) != VK_SUCCESS)
+        if(ctx->enumerate_device_extensions(physical_device, layer, &extensions.count, extensions.array) != VK_SUCCESS)
         {
             status = false;
-            printf("Failed to get extensions\n");
+            LOG_ERROR("Failed to get extensions\n");
         }
     }
 
@@ -1674,14 +2510,18 @@ bool enumerate_device_extensions(VkPhysicalDevice physical_device, const char* l
     {
         for(uint32_t i = 0; i < extensions.count; i++)
         {
-            printf("\tDevice extension: %s\n", extensions.array[i].extensionName);
+            LOG_DEBUG("\tDevice extension: %s\n", extensions.array[i].extensionName);
         }
     }
 
     if(status)
     {
-        device_extensions->array = extensions.array;
-        device_extensions->count = extensions.count;
+        status = index_extensions(&extensions);
+    }
+
+    if(status)
+    {
+        (*device_extensions) = extensions;
     }
     else
     {
@@ -1690,3 +2530,278 @@ bool enumerate_device_extensions(VkPhysicalDevice physical_device, const char* l
 
     return status;
 }
+
+static void destroy_object(struct vk_context* ctx, VkObjectType type, uint64_t handle)
+{
+    switch(type)
+    {
+        case VK_OBJECT_TYPE_BUFFER:                ctx->destroy_buffer(ctx->device, (VkBuffer) handle, ctx->allocation_callbacks); break;
+        case VK_OBJECT_TYPE_IMAGE:                 ctx->destroy_image(ctx->device, (VkImage) handle, ctx->allocation_callbacks); break;
+        case VK_OBJECT_TYPE_IMAGE_VIEW:            ctx->destroy_image_view(ctx->device, (VkImageView) handle, ctx->allocation_callbacks); break;
+        case VK_OBJECT_TYPE_DEVICE_MEMORY:         ctx->free_memory(ctx->device, (VkDeviceMemory) handle, ctx->allocation_callbacks); break;
+        case VK_OBJECT_TYPE_FRAMEBUFFER:           ctx->destroy_framebuffer(ctx->device, (VkFramebuffer) handle, ctx->allocation_callbacks); break;
+        case VK_OBJECT_TYPE_RENDER_PASS:           ctx->destroy_render_pass(ctx->device, (VkRenderPass) handle, ctx->allocation_callbacks); break;
+        case VK_OBJECT_TYPE_PIPELINE:              ctx->destroy_pipeline(ctx->device, (VkPipeline) handle, ctx->allocation_callbacks); break;
+        case VK_OBJECT_TYPE_PIPELINE_LAYOUT:       ctx->destroy_pipeline_layout(ctx->device, (VkPipelineLayout) handle, ctx->allocation_callbacks); break;
+        case VK_OBJECT_TYPE_SHADER_MODULE:         ctx->destroy_shader_module(ctx->device, (VkShaderModule) handle, ctx->allocation_callbacks); break;
+        case VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT: ctx->destroy_descriptor_set_layout(ctx->device, (VkDescriptorSetLayout) handle, ctx->allocation_callbacks); break;
+        case VK_OBJECT_TYPE_DESCRIPTOR_POOL:       ctx->destroy_descriptor_pool(ctx->device, (VkDescriptorPool) handle, ctx->allocation_callbacks); break;
+        case VK_OBJECT_TYPE_QUERY_POOL:            ctx->destroy_query_pool(ctx->device, (VkQueryPool) handle, ctx->allocation_callbacks); break;
+        case VK_OBJECT_TYPE_SEMAPHORE:             ctx->destroy_semaphore(ctx->device, (VkSemaphore) handle, ctx->allocation_callbacks); break;
+        case VK_OBJECT_TYPE_SWAPCHAIN_KHR:         ctx->destroy_swapchain(ctx->device, (VkSwapchainKHR) handle, ctx->allocation_callbacks); break;
+        default:                                   LOG_ERROR("Cannot destroy object type %u\n", (uint32_t) type); break;
+    }
+}
+
+void defer_destruction(struct vk_context* ctx, VkObjectType type, uint64_t handle, VkSemaphore timeline, uint64_t value)
+{
+    struct deferred_destruction_queue* queue = &ctx->state->deferred_destructions;
+
+    if(handle != 0)
+    {
+        if(queue->count == MAX_DEFERRED_DESTRUCTIONS)
+        {
+            collect_deferred_destructions(ctx, false);
+        }
+
+        if(queue->count == MAX_DEFERRED_DESTRUCTIONS)
+        {
+            // only happens when far more objects are retired than a few frames release, stall like the
+            // framebuffer cache does when it runs out of entries
+            collect_deferred_destructions(ctx, true);
+        }
+
+        struct deferred_destruction* entry = &queue->entries[queue->count];
+        entry->type = type;
+        entry->handle = handle;
+        entry->timeline = timeline;
+        entry->value = value;
+
+        queue->count++;
+    }
+}
+
+void collect_deferred_destructions(struct vk_context* ctx, bool wait_all)
+{
+    struct deferred_destruction_queue* queue = &ctx->state->deferred_destructions;
+
+    uint32_t kept = 0;
+    uint64_t destroyed_count = 0;
+
+    // entries of the same timeline are usually adjacent, the counter is only queried when it changes
+    VkSemaphore timeline = NULL;
+    uint64_t completed = 0;
+
+    if(wait_all && (queue->count > 0))
+    {
+        ctx->wait_for_device_idle(ctx->device);
+    }
+
+    for(uint32_t i = 0; i < queue->count; i++)
+    {
+        struct deferred_destruction* entry = &queue->entries[i];
+
+        bool reached = wait_all || (entry->timeline == NULL) || (entry->value == 0);
+
+        if(!reached)
+        {
+            if(entry->timeline != timeline)
+            {
+                timeline = entry->timeline;
+
+                if(ctx->get_semaphore_counter_value(ctx->device, timeline, &completed) != VK_SUCCESS)
+                {
+                    completed = 0;
+                }
+            }
+
+            reached = (completed >= entry->value);
+        }
+
+        if(reached)
+        {
+            destroy_object(ctx, entry->type, entry->handle);
+            destroyed_count++;
+        }
+        else
+        {
+            queue->entries[kept] = *entry;
+            kept++;
+        }
+    }
+
+    queue->count = kept;
+
+    SDL_AtomicLock(&ctx->state->stats_lock);
+    ctx->state->stats.deferred_destruction_count += destroyed_count;
+    SDL_AtomicUnlock(&ctx->state->stats_lock);
+}
+
+bool add_memory_pressure_callback(struct vk_context* ctx, vk_memory_pressure_callback callback, void* user_data)
+{
+    bool status = true;
+
+    struct vk_context_state* state = ctx->state;
+
+    if(state->memory_pressure_callback_count < VK_CTX_MAX_MEMORY_PRESSURE_CALLBACKS)
+    {
+        state->memory_pressure_callbacks[state->memory_pressure_callback_count].callback = callback;
+        state->memory_pressure_callbacks[state->memory_pressure_callback_count].user_data = user_data;
+        state->memory_pressure_callback_count++;
+    }
+    else
+    {
+        LOG_ERROR("Too many memory pressure callbacks\n");
+        status = false;
+    }
+
+    return status;
+}
+
+void remove_memory_pressure_callback(struct vk_context* ctx, vk_memory_pressure_callback callback, void* user_data)
+{
+    struct vk_context_state* state = ctx->state;
+
+    uint32_t kept = 0;
+
+    // the order of the others is kept, earlier callbacks are asked first
+    for(uint32_t i = 0; i < state->memory_pressure_callback_count; i++)
+    {
+        if((state->memory_pressure_callbacks[i].callback != callback) || (state->memory_pressure_callbacks[i].user_data != user_data))
+        {
+            state->memory_pressure_callbacks[kept] = state->memory_pressure_callbacks[i];
+            kept++;
+        }
+    }
+
+    state->memory_pressure_callback_count = kept;
+}
+
+void update_memory_budget(struct vk_context* ctx)
+{
+    struct vk_context_state* state = ctx->state;
+
+    uint32_t heap_count = ctx->memory_properties.memoryHeapCount;
+
+    if(ctx->memory_budget_supported)
+    {
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budget_properties = { 0 };
+        budget_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+        VkPhysicalDeviceMemoryProperties2 properties = { 0 };
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+        properties.pNext = &budget_properties;
+
+        ctx->get_physical_device_memory_properties2(ctx->physical_device, &properties);
+
+        for(uint32_t i = 0; i < heap_count; i++)
+        {
+            ctx->heap_budgets[i].usage = budget_properties.heapUsage[i];
+            ctx->heap_budgets[i].budget = budget_properties.heapBudget[i];
+        }
+    }
+    else
+    {
+        for(uint32_t i = 0; i < heap_count; i++)
+        {
+            ctx->heap_budgets[i].usage = 0;
+            ctx->heap_budgets[i].budget = ctx->memory_properties.memoryHeaps[i].size;
+        }
+    }
+
+    for(uint32_t i = 0; i < heap_count; i++)
+    {
+        const struct vk_memory_heap_budget* heap = &ctx->heap_budgets[i];
+
+        bool over_budget = (heap->usage > heap->budget);
+
+        if(over_budget && !state->heap_over_budget[i])
+        {
+            LOG_WARNING("Memory heap %u over budget: %llu of %llu MB\n", i, (unsigned long long) (heap->usage >> 20), (unsigned long long) (heap->budget >> 20));
+
+            SDL_AtomicLock(&state->stats_lock);
+            state->stats.memory_overrun_count++;
+            SDL_AtomicUnlock(&state->stats_lock);
+        }
+        else if(!over_budget && state->heap_over_budget[i])
+        {
+            LOG_INFO("Memory heap %u back within budget: %llu of %llu MB\n", i, (unsigned long long) (heap->usage >> 20), (unsigned long long) (heap->budget >> 20));
+        }
+
+        state->heap_over_budget[i] = over_budget;
+
+        VkDeviceSize threshold = heap->budget / 100 * VK_CTX_MEMORY_PRESSURE_PERCENT;
+
+        if(state->heap_pressure_cooldowns[i] > 0)
+        {
+            state->heap_pressure_cooldowns[i]--;
+        }
+        else if((heap->usage > threshold) && (state->memory_pressure_callback_count > 0))
+        {
+            VkDeviceSize excess = heap->usage - threshold;
+            VkDeviceSize released = 0;
+
+            for(uint32_t j = 0; (j < state->memory_pressure_callback_count) && (released < excess); j++)
+            {
+                released += state->memory_pressure_callbacks[j].callback(state->memory_pressure_callbacks[j].user_data, i, excess - released);
+            }
+
+            LOG_DEBUG("Memory heap %u: %llu bytes above the pressure threshold, %llu released\n", i, (unsigned long long) excess, (unsigned long long) released);
+
+            state->heap_pressure_cooldowns[i] = VK_CTX_NUM_FRAMES + 1;
+        }
+    }
+}
+
+#ifdef DEBUG
+void set_vk_object_name(struct vk_context* ctx, VkObjectType type, uint64_t handle, const char* format, ...)
+{
+    enum { name_size = 128 };
+
+    char name[name_size];
+
+    va_list args;
+    va_start(args, format);
+    vsnprintf(name, name_size, format, args);
+    va_end(args);
+
+    VkDebugUtilsObjectNameInfoEXT info;
+    info.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+    info.pNext = NULL;
+    info.objectType = type;
+    info.objectHandle = handle;
+    info.pObjectName = name;
+
+    if(ctx->set_debug_object_name(ctx->device, &info) != VK_SUCCESS)
+    {
+        LOG_ERROR("Failed to name object %s\n", name);
+    }
+}
+
+void begin_vk_label(struct vk_context* ctx, VkCommandBuffer command_buffer, const char* name)
+{
+    // a color derived from the name, the same region has the same color in every frame of a capture
+    uint32_t hash = 2166136261u;
+
+    for(const char* c = name; *c != '\0'; c++)
+    {
+        hash = (hash ^ (uint8_t) *c) * 16777619u;
+    }
+
+    VkDebugUtilsLabelEXT label;
+    label.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_LABEL_EXT;
+    label.pNext = NULL;
+    label.pLabelName = name;
+    label.color[0] = 0.25f + 0.75f * (float) ((hash >> 0) & 0xFF) / 255.0f;
+    label.color[1] = 0.25f + 0.75f * (float) ((hash >> 8) & 0xFF) / 255.0f;
+    label.color[2] = 0.25f + 0.75f * (float) ((hash >> 16) & 0xFF) / 255.0f;
+    label.color[3] = 1.0f;
+
+    ctx->cmd_begin_debug_label(command_buffer, &label);
+}
+
+void end_vk_label(struct vk_context* ctx, VkCommandBuffer command_buffer)
+{
+    ctx->cmd_end_debug_label(command_buffer);
+}
+#endif
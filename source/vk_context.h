@@ -3,95 +3,339 @@
 
 #include <vulkan/vulkan.h>
 
-enum { VK_CTX_NUM_GRAPHICS_QUEUES   = 1 };
-enum { VK_CTX_NUM_SWAPCHAIN_BUFFERS = 2 };
+#include "debug_messenger.h"
 
+enum { VK_CTX_NUM_GRAPHICS_QUEUES   = 2 };
+enum { VK_CTX_NUM_SWAPCHAIN_BUFFERS = 2 }; // requested, the driver may create more
+enum { VK_CTX_MAX_SWAPCHAIN_IMAGES  = 8 };
+enum { VK_CTX_NUM_FRAMES            = 2 }; // frames in flight, per frame resources cycle through this many slots
+
+enum { VK_CTX_MAX_MEMORY_PRESSURE_CALLBACKS = 4 };
+enum { VK_CTX_MEMORY_PRESSURE_PERCENT       = 90 }; // of the budget of a heap, above it the callbacks are asked to shrink
+
+// the dispatch table of struct vk_context: X(name, member, gate, core_version, suffix). the type of the member is
+// PFN_name. gate is VK_CTX_REQUIRED, VK_CTX_OPTIONAL (NULL when the implementation does not expose it),
+// VK_CTX_IF(capability) (required when the capability of the context is set, skipped otherwise) or
+// VK_CTX_DEBUG_ONLY. functions promoted to core load by the name with suffix while the negotiated version is
+// below core_version. new functions only need a line here
+enum vk_ctx_function_kind { VK_CTX_FUNCTION_REQUIRED, VK_CTX_FUNCTION_OPTIONAL };
+
+#define VK_CTX_REQUIRED         VK_CTX_FUNCTION_REQUIRED, VK_TRUE
+#define VK_CTX_OPTIONAL         VK_CTX_FUNCTION_OPTIONAL, VK_TRUE
+#define VK_CTX_IF(capability)   VK_CTX_FUNCTION_REQUIRED, ctx->capability
+
+#ifdef DEBUG
+#define VK_CTX_DEBUG_ONLY       VK_CTX_FUNCTION_REQUIRED, VK_TRUE
+#else
+#define VK_CTX_DEBUG_ONLY       VK_CTX_FUNCTION_REQUIRED, VK_FALSE
+#endif
+
+// loaded from vkGetInstanceProcAddr without an instance
+#define VK_CTX_GLOBAL_FUNCTIONS(X)                                                                     \
+    X(vkCreateInstance,                       create_instance,               VK_CTX_REQUIRED, 0, NULL) \
+    X(vkEnumerateInstanceVersion,             enumerate_instance_version,    VK_CTX_OPTIONAL, 0, NULL) \
+    X(vkEnumerateInstanceLayerProperties,     enumerate_instance_layers,     VK_CTX_REQUIRED, 0, NULL) \
+    X(vkEnumerateInstanceExtensionProperties, enumerate_instance_extensions, VK_CTX_REQUIRED, 0, NULL)
+
+// loaded from vkGetInstanceProcAddr, the version is the one of the instance
+#define VK_CTX_INSTANCE_FUNCTIONS(X)                                                                                                                                     \
+    X(vkDestroyInstance,                         destroy_instance,                          VK_CTX_REQUIRED,                                  0,                  NULL)  \
+    X(vkEnumeratePhysicalDevices,                enumerate_physical_devices,                VK_CTX_REQUIRED,                                  0,                  NULL)  \
+    X(vkGetPhysicalDeviceProperties,             get_physical_device_properties,            VK_CTX_REQUIRED,                                  0,                  NULL)  \
+    X(vkGetPhysicalDeviceFeatures,               get_physical_device_features,              VK_CTX_REQUIRED,                                  0,                  NULL)  \
+    X(vkGetPhysicalDeviceQueueFamilyProperties,  get_physical_queue_group_properties,       VK_CTX_REQUIRED,                                  0,                  NULL)  \
+    X(vkGetPhysicalDeviceMemoryProperties,       get_physical_device_memory_properties,     VK_CTX_REQUIRED,                                  0,                  NULL)  \
+    X(vkGetPhysicalDeviceFormatProperties,       get_physical_device_format_properties,     VK_CTX_REQUIRED,                                  0,                  NULL)  \
+    X(vkCreateDevice,                            create_device,                             VK_CTX_REQUIRED,                                  0,                  NULL)  \
+    X(vkCreateDebugUtilsMessengerEXT,            create_debug_messenger,                    VK_CTX_DEBUG_ONLY,                                0,                  NULL)  \
+    X(vkDestroyDebugUtilsMessengerEXT,           destroy_debug_messenger,                   VK_CTX_DEBUG_ONLY,                                0,                  NULL)  \
+    X(vkSetDebugUtilsObjectNameEXT,              set_debug_object_name,                     VK_CTX_DEBUG_ONLY,                                0,                  NULL)  \
+    X(vkCmdBeginDebugUtilsLabelEXT,              cmd_begin_debug_label,                     VK_CTX_DEBUG_ONLY,                                0,                  NULL)  \
+    X(vkCmdEndDebugUtilsLabelEXT,                cmd_end_debug_label,                       VK_CTX_DEBUG_ONLY,                                0,                  NULL)  \
+    X(vkGetPhysicalDeviceSurfaceSupportKHR,      get_physical_device_surface_support,       VK_CTX_REQUIRED,                                  0,                  NULL)  \
+    X(vkGetPhysicalDeviceSurfaceCapabilitiesKHR, get_physical_device_surface_capabilities,  VK_CTX_REQUIRED,                                  0,                  NULL)  \
+    X(vkGetPhysicalDeviceSurfacePresentModesKHR, get_physical_device_surface_present_modes, VK_CTX_REQUIRED,                                  0,                  NULL)  \
+    X(vkGetPhysicalDeviceSurfaceFormatsKHR,      get_physical_device_surface_formats,       VK_CTX_REQUIRED,                                  0,                  NULL)  \
+    X(vkEnumerateDeviceLayerProperties,          enumerate_device_layers,                   VK_CTX_REQUIRED,                                  0,                  NULL)  \
+    X(vkEnumerateDeviceExtensionProperties,      enumerate_device_extensions,               VK_CTX_REQUIRED,                                  0,                  NULL)  \
+    X(vkDestroySurfaceKHR,                       destroy_surface,                           VK_CTX_REQUIRED,                                  0,                  NULL)  \
+    X(vkGetPhysicalDeviceFeatures2,              get_physical_device_features2,             VK_CTX_IF(physical_device_properties2_supported), VK_API_VERSION_1_1, "KHR") \
+    X(vkGetPhysicalDeviceProperties2,            get_physical_device_properties2,           VK_CTX_IF(physical_device_properties2_supported), VK_API_VERSION_1_1, "KHR") \
+    X(vkGetPhysicalDeviceMemoryProperties2,      get_physical_device_memory_properties2,    VK_CTX_IF(physical_device_properties2_supported), VK_API_VERSION_1_1, "KHR")
+
+// loaded from vkGetDeviceProcAddr so that calls go straight to the driver instead of through the dispatch
+// trampolines of the loader, the version is the one negotiated for the device
+#define VK_CTX_DEVICE_FUNCTIONS(X)                                                                                                            \
+    X(vkCreateSemaphore,             create_semaphore,                VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkDestroySemaphore,            destroy_semaphore,               VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCreateSwapchainKHR,          create_swapchain,                VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkDestroySwapchainKHR,         destroy_swapchain,               VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCreateCommandPool,           create_command_pool,             VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkDestroyCommandPool,          destroy_command_pool,            VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkAllocateCommandBuffers,      allocate_command_buffers,        VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkFreeCommandBuffers,          free_command_buffers,            VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkAcquireNextImageKHR,         acquire_next_image,              VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkDeviceWaitIdle,              wait_for_device_idle,            VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkDestroyDevice,               destroy_device,                  VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkGetSwapchainImagesKHR,       get_swapchain_images,            VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkBeginCommandBuffer,          begin_command_buffer,            VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkEndCommandBuffer,            end_command_buffer,              VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCmdPipelineBarrier,          cmd_pipeline_barrier,            VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCmdClearColorImage,          cmd_clear_color_image,           VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkQueueSubmit,                 queue_submit,                    VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkQueueSubmit2,                queue_submit2,                   VK_CTX_IF(synchronization2_supported),       VK_API_VERSION_1_3, "KHR") \
+    X(vkQueueWaitIdle,               queue_wait_idle,                 VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCreateFence,                 create_fence,                    VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkDestroyFence,                destroy_fence,                   VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkWaitForFences,               wait_for_fences,                 VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkResetFences,                 reset_fences,                    VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkWaitSemaphores,              wait_semaphores,                 VK_CTX_REQUIRED,                             VK_API_VERSION_1_2, "KHR") \
+    X(vkGetSemaphoreCounterValue,    get_semaphore_counter_value,     VK_CTX_REQUIRED,                             VK_API_VERSION_1_2, "KHR") \
+    X(vkQueuePresentKHR,             queue_present,                   VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkGetDeviceQueue,              get_device_queue,                VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCreateRenderPass,            create_render_pass,              VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkDestroyRenderPass,           destroy_render_pass,             VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCreateImageView,             create_image_view,               VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkDestroyImageView,            destroy_image_view,              VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCreateImage,                 create_image,                    VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkDestroyImage,                destroy_image,                   VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkGetImageMemoryRequirements,  get_image_memory_requirements,   VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkBindImageMemory,             bind_image_memory,               VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCreateFramebuffer,           create_framebuffer,              VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkDestroyFramebuffer,          destroy_framebuffer,             VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCreateShaderModule,          create_shader_module,            VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCreatePipelineLayout,        create_pipeline_layout,          VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCreateGraphicsPipelines,     create_graphics_pipelines,       VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCreatePipelineCache,         create_pipeline_cache,           VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkDestroyPipelineCache,        destroy_pipeline_cache,          VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkGetPipelineCacheData,        get_pipeline_cache_data,         VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCreateComputePipelines,      create_compute_pipelines,        VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkDestroyPipeline,             destroy_pipeline,                VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkDestroyPipelineLayout,       destroy_pipeline_layout,         VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkDestroyShaderModule,         destroy_shader_module,           VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCreateBuffer,                create_buffer,                   VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkDestroyBuffer,               destroy_buffer,                  VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkGetBufferMemoryRequirements, get_buffer_memory_requirements,  VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkBindBufferMemory,            bind_buffer_memory,              VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkAllocateMemory,              allocate_memory,                 VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkFreeMemory,                  free_memory,                     VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkMapMemory,                   map_memory,                      VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkUnmapMemory,                 unmap_memory,                    VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCreateDescriptorSetLayout,   create_descriptor_set_layout,    VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkDestroyDescriptorSetLayout,  destroy_descriptor_set_layout,   VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCreateDescriptorPool,        create_descriptor_pool,          VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkDestroyDescriptorPool,       destroy_descriptor_pool,         VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkResetDescriptorPool,         reset_descriptor_pool,           VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkAllocateDescriptorSets,      allocate_descriptor_sets,        VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkUpdateDescriptorSets,        update_descriptor_sets,          VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCreateSampler,               create_sampler,                  VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkDestroySampler,              destroy_sampler,                 VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCmdBindPipeline,             cmd_bind_pipeline,               VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCmdBindDescriptorSets,       cmd_bind_descriptor_sets,        VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCmdPushConstants,            cmd_push_constants,              VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCmdBindVertexBuffers,        cmd_bind_vertex_buffers,         VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCmdBindIndexBuffer,          cmd_bind_index_buffer,           VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCmdDraw,                     cmd_draw,                        VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCmdDrawIndexed,              cmd_draw_indexed,                VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCmdDispatch,                 cmd_dispatch,                    VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCmdFillBuffer,               cmd_fill_buffer,                 VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCmdCopyBufferToImage,        cmd_copy_buffer_to_image,        VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCmdBlitImage,                cmd_blit_image,                  VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCmdBeginRenderPass,          cmd_begin_render_pass,           VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCmdEndRenderPass,            cmd_end_render_pass,             VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCreateQueryPool,             create_query_pool,               VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkDestroyQueryPool,            destroy_query_pool,              VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkGetQueryPoolResults,         get_query_pool_results,          VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCmdResetQueryPool,           cmd_reset_query_pool,            VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCmdWriteTimestamp,           cmd_write_timestamp,             VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCmdBeginQuery,               cmd_begin_query,                 VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCmdEndQuery,                 cmd_end_query,                   VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCmdSetViewport,              cmd_set_viewport,                VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCmdSetScissor,               cmd_set_scissor,                 VK_CTX_REQUIRED,                             0,                  NULL)  \
+    X(vkCmdDrawIndexedIndirectCount, cmd_draw_indexed_indirect_count, VK_CTX_IF(draw_indirect_count_supported),    VK_API_VERSION_1_2, "KHR") \
+    X(vkCmdBeginRendering,           cmd_begin_rendering,             VK_CTX_IF(dynamic_rendering_supported),      VK_API_VERSION_1_3, "KHR") \
+    X(vkCmdEndRendering,             cmd_end_rendering,               VK_CTX_IF(dynamic_rendering_supported),      VK_API_VERSION_1_3, "KHR") \
+    X(vkCmdSetDepthWriteEnable,      cmd_set_depth_write_enable,      VK_CTX_IF(extended_dynamic_state_supported), VK_API_VERSION_1_3, "EXT") \
+    X(vkCmdSetDepthCompareOp,        cmd_set_depth_compare_op,        VK_CTX_IF(extended_dynamic_state_supported), VK_API_VERSION_1_3, "EXT")
+
+#define VK_CTX_DECLARE_FUNCTION(name, member, gate, core_version, suffix) PFN_##name member;
+
+struct vk_context_stats
+{
+    uint64_t host_memory_size;           // bytes currently allocated through the allocation callbacks
+    uint64_t host_memory_peak;
+    uint64_t host_allocation_count;      // allocations and reallocations
+    uint64_t deferred_destruction_count; // objects destroyed by collect_deferred_destructions
+    uint64_t memory_overrun_count;       // times a heap went over its budget
+};
+
+// with VK_EXT_memory_budget both values come from the driver and usage includes the other processes on the
+// device. without it budget is the size of the heap and usage is unknown (0)
+struct vk_memory_heap_budget
+{
+    VkDeviceSize usage;
+    VkDeviceSize budget;
+};
+
+// asked to release memory of heap_index while its usage is above VK_CTX_MEMORY_PRESSURE_PERCENT of the budget,
+// excess is the usage above that threshold. returns the bytes that are released, the memory may go away later
+// with the deferred destructions
+typedef VkDeviceSize (*vk_memory_pressure_callback)(void* user_data, uint32_t heap_index, VkDeviceSize excess);
+
+// private to vk_context.c: the allocator, the stats and the deferred destructions of one context
+struct vk_context_state;
+
+// all state of one instance and device. contexts share nothing, each one can be driven from its own thread
 struct vk_context
 {
     VkInstance                                       instance;
 
-    VkAllocationCallbacks*                           allocation_callbacks;
+    VkAllocationCallbacks*                           allocation_callbacks; // owned by the context
+    struct vk_context_state*                         state;
 
     VkDevice                                         device;
     VkPhysicalDevice                                 physical_device;
+    VkPhysicalDeviceMemoryProperties                 memory_properties;
+
+    // one entry per heap of memory_properties, refreshed by update_memory_budget
+    struct vk_memory_heap_budget                     heap_budgets[VK_MAX_MEMORY_HEAPS];
 
     VkSurfaceKHR                                     surface;
     VkFormat                                         surface_format;
-    
+    VkColorSpaceKHR                                  surface_color_space;
+    VkExtent2D                                       swapchain_extent;
+
     VkSwapchainKHR                                   swapchain;
-    VkImage                                          swapchain_images[VK_CTX_NUM_SWAPCHAIN_BUFFERS];
+    VkImage                                          swapchain_images[VK_CTX_MAX_SWAPCHAIN_IMAGES];
+    uint32_t                                         swapchain_image_count;
 
     VkCommandPool                                    command_pool;
-    VkCommandBuffer                                  command_buffer;
+    VkCommandBuffer                                  command_buffers[VK_CTX_NUM_FRAMES];
 
     VkQueue                                          graphics_queues[VK_CTX_NUM_GRAPHICS_QUEUES];
+    float                                            graphics_queue_priorities[VK_CTX_NUM_GRAPHICS_QUEUES];
+    uint32_t                                         graphics_queue_count;
 
-    VkSemaphore                                      image_available_semaphore;
-    VkSemaphore                                      rendering_finished_semaphore;
+    // a queue of a family with compute but without graphics support, NULL when the device has no such family
+    VkQueue                                          compute_queue;
+    uint32_t                                         compute_queue_family;
+
+    // binary semaphores for the swapchain, all other synchronization uses the timelines of the queue scheduler.
+    // acquire uses the semaphore of the frame slot, present the one of the swapchain image
+    VkSemaphore                                      image_available_semaphores[VK_CTX_NUM_FRAMES];
+    VkSemaphore                                      rendering_finished_semaphores[VK_CTX_MAX_SWAPCHAIN_IMAGES];
 
     uint32_t                                         graphics_queue_family;
 
-    VkDebugReportCallbackEXT                         debug_callback;
+    // the instance uses the highest version up to 1.3 that the loader supports, the device the lower of that and
+    // the version it reports. extensions promoted to the device version are used through the core features
+    uint32_t                                         instance_api_version;
+    uint32_t                                         api_version;
+
+    VkBool32                                         async_compute_supported;
+    VkBool32                                         draw_indirect_count_supported;
+    VkBool32                                         dynamic_rendering_supported;
+    VkBool32                                         extended_dynamic_state_supported;
+    VkBool32                                         physical_device_properties2_supported;
+    VkBool32                                         device_id_properties_supported;
+    VkBool32                                         timestamps_supported;
+    VkBool32                                         pipeline_statistics_supported;
+    VkBool32                                         fill_mode_non_solid_supported;
+    VkBool32                                         storage_buffer_array_dynamic_indexing_supported;
+    VkBool32                                         sampled_image_array_dynamic_indexing_supported;
+    VkBool32                                         texture_compression_bc_supported;
+    VkBool32                                         texture_compression_etc2_supported;
+    VkBool32                                         texture_compression_astc_ldr_supported;
+    VkBool32                                         descriptor_indexing_supported;
+    VkBool32                                         synchronization2_supported;
+    VkBool32                                         buffer_device_address_supported;
+    VkBool32                                         maintenance4_supported;
+    VkBool32                                         memory_budget_supported;
+
+    float                                            timestamp_period; // nanoseconds per timestamp tick
+
+    // sample counts supported by both color and depth attachments
+    VkSampleCountFlags                               framebuffer_sample_counts;
+
+    VkDebugUtilsMessengerEXT                         debug_messenger;
 
     PFN_vkGetInstanceProcAddr                        get_instance_proc_addr;
     PFN_vkGetDeviceProcAddr                          get_device_proc_addr;
 
-    // global functions
-    PFN_vkCreateInstance                             create_instance;
-    PFN_vkDestroyInstance                            destroy_instance;
-    PFN_vkEnumerateInstanceVersion                   enumerate_instance_version;
-    PFN_vkEnumerateInstanceLayerProperties           enumerate_instance_layers;
-    PFN_vkEnumerateInstanceExtensionProperties       enumerate_instance_extensions;
-
-    // instance level functions
-    PFN_vkEnumeratePhysicalDevices                   enumerate_physical_devices;
-    PFN_vkGetPhysicalDeviceProperties                get_physical_device_properties;
-    PFN_vkGetPhysicalDeviceFeatures                  get_physical_device_features;
-    PFN_vkGetPhysicalDeviceQueueFamilyProperties     get_physical_queue_group_properties;
-    PFN_vkCreateDevice                               create_device;
-    PFN_vkCreateDebugReportCallbackEXT               register_debug_callback;
-    PFN_vkDestroyDebugReportCallbackEXT              unregister_debug_callback;
-    PFN_vkGetPhysicalDeviceSurfaceSupportKHR         get_physical_device_surface_support;
-    PFN_vkGetPhysicalDeviceSurfaceCapabilitiesKHR    get_physical_device_surface_capabilities;
-    PFN_vkGetPhysicalDeviceSurfacePresentModesKHR    get_physical_device_surface_present_modes;
-    PFN_vkGetPhysicalDeviceSurfaceFormatsKHR         get_physical_device_surface_formats;
-    PFN_vkEnumerateDeviceLayerProperties             enumerate_device_layers;
-    PFN_vkEnumerateDeviceExtensionProperties         enumerate_device_extensions;
-    PFN_vkDestroySurfaceKHR                          destroy_surface;
-
-    // device level functions
-    PFN_vkCreateSemaphore                            create_semaphore;
-    PFN_vkDestroySemaphore                           destroy_semaphore;
-    PFN_vkCreateSwapchainKHR                         create_swapchain;
-    PFN_vkDestroySwapchainKHR                        destroy_swapchain;
-    PFN_vkCreateCommandPool                          create_command_pool;
-    PFN_vkDestroyCommandPool                         destroy_command_pool;
-    PFN_vkAllocateCommandBuffers                     allocate_command_buffers;
-    PFN_vkFreeCommandBuffers                         free_command_buffers;
-    PFN_vkAcquireNextImageKHR                        acquire_next_image;
-    PFN_vkDeviceWaitIdle                             wait_for_device_idle;
-    PFN_vkDestroyDevice                              destroy_device;
-    PFN_vkGetSwapchainImagesKHR                      get_swapchain_images;
-    PFN_vkBeginCommandBuffer                         begin_command_buffer;
-    PFN_vkEndCommandBuffer                           end_command_buffer;
-    PFN_vkCmdPipelineBarrier                         cmd_pipeline_barrier;
-    PFN_vkCmdClearColorImage                         cmd_clear_color_image;
-    PFN_vkQueueSubmit                                queue_submit;
-    PFN_vkQueuePresentKHR                            queue_present;
-    PFN_vkGetDeviceQueue                             get_device_queue;
-    PFN_vkCreateRenderPass                           create_render_pass;
-    PFN_vkCreateImageView                            create_image_view;
-    PFN_vkCreateFramebuffer                          create_framebuffer;
-    PFN_vkCreateShaderModule                         create_shader_module;
-    PFN_vkCreatePipelineLayout                       create_pipeline_layout;
-    PFN_vkCreateGraphicsPipelines                    create_graphics_pipelines;
+    VK_CTX_GLOBAL_FUNCTIONS(VK_CTX_DECLARE_FUNCTION)
+    VK_CTX_INSTANCE_FUNCTIONS(VK_CTX_DECLARE_FUNCTION)
+    VK_CTX_DEVICE_FUNCTIONS(VK_CTX_DECLARE_FUNCTION)
+};
+
+struct vk_context_options
+{
+    // index or device uuid (32 hex digits, dashes are ignored) of the physical device, NULL selects the device
+    // with the highest score
+    const char* device_selector;
+
+    // queues created in the graphics family, the count is clamped to what the family supports
+    uint32_t    graphics_queue_count;
+    float       graphics_queue_priorities[VK_CTX_NUM_GRAPHICS_QUEUES];
+
+    // filters and limits of the validation messages, only used in debug builds
+    struct debug_messenger_options debug_messenger;
 };
 
+// the context the renderer modules draw with, owned by the application
 extern struct vk_context* vk_ctx;
 
-bool initialize_vulkan_context(PFN_vkGetInstanceProcAddr pfn_get_instance_proc_addr, uint32_t ext_count, const char** ext_array);
-void uninitialize_vulkan_context(void);
+void init_vk_context_options(struct vk_context_options* options);
+
+// creates the instance and the device of ctx, the surface is optional and added by initialize_swapchain
+bool initialize_vulkan_context(struct vk_context* ctx, PFN_vkGetInstanceProcAddr pfn_get_instance_proc_addr, uint32_t ext_count, const char** ext_array, const struct vk_context_options* options);
+void uninitialize_vulkan_context(struct vk_context* ctx);
+
+void get_vk_context_stats(struct vk_context* ctx, struct vk_context_stats* stats);
+
+// extent is the drawable size of the window, it is used when the surface leaves the size to the application
+bool initialize_swapchain(struct vk_context* ctx, VkSurfaceKHR surface, VkExtent2D extent);
+
+// recreates the swapchain for the current surface size, or for extent when the surface leaves the size to the
+// application. the old swapchain is destroyed once timeline reached value, which has to cover the last submit
+// that rendered to one of its images. leaves the old swapchain in place and sets swapchain_extent to 0x0 while
+// the surface has no area (minimized window)
+bool recreate_swapchain(struct vk_context* ctx, VkExtent2D extent, VkSemaphore timeline, uint64_t value);
+
+// destroys the object once timeline reached value, the value of the last submit that used it. a NULL timeline
+// or the value 0 mean that the gpu is done with the object and it goes with the next collect. objects that are
+// reached together are destroyed in the order they were deferred. only called from the thread that renders
+// with ctx
+void defer_destruction(struct vk_context* ctx, VkObjectType type, uint64_t handle, VkSemaphore timeline, uint64_t value);
+
+// destroys the deferred objects whose values were reached without waiting, called once per frame. with
+// wait_all it waits for the device to idle and destroys everything
+void collect_deferred_destructions(struct vk_context* ctx, bool wait_all);
+
+// the callbacks are called from update_memory_budget, on the thread that renders with ctx. only caches whose
+// objects are backed by memory of the heaps subscribe, texture streaming for now. pipelines, framebuffers and
+// descriptor pools only hold driver internal memory that is not reported per heap
+bool add_memory_pressure_callback(struct vk_context* ctx, vk_memory_pressure_callback callback, void* user_data);
+void remove_memory_pressure_callback(struct vk_context* ctx, vk_memory_pressure_callback callback, void* user_data);
+
+// refreshes heap_budgets and logs the heaps that went over their budget. the heaps above the pressure threshold
+// are handed to the callbacks so that the caches shrink before the driver starts paging. called once per frame
+void update_memory_budget(struct vk_context* ctx);
+
+// names show up in validation messages and captures instead of raw handles, labels group the commands of a
+// command buffer into regions that captures and gpu timings can be matched against. the macros compile to
+// nothing in release builds and do not evaluate their arguments there
+#ifdef DEBUG
+void set_vk_object_name(struct vk_context* ctx, VkObjectType type, uint64_t handle, const char* format, ...);
+void begin_vk_label(struct vk_context* ctx, VkCommandBuffer command_buffer, const char* name);
+void end_vk_label(struct vk_context* ctx, VkCommandBuffer command_buffer);
 
-bool initialize_swapchain(VkSurfaceKHR surface);
+#define VK_CTX_NAME(ctx, type, handle, ...)           set_vk_object_name((ctx), (type), (uint64_t) (handle), __VA_ARGS__)
+#define VK_CTX_BEGIN_LABEL(ctx, command_buffer, name) begin_vk_label((ctx), (command_buffer), (name))
+#define VK_CTX_END_LABEL(ctx, command_buffer)         end_vk_label((ctx), (command_buffer))
+#else
+#define VK_CTX_NAME(ctx, type, handle, ...)           ((void) 0)
+#define VK_CTX_BEGIN_LABEL(ctx, command_buffer, name) ((void) 0)
+#define VK_CTX_END_LABEL(ctx, command_buffer)         ((void) 0)
+#endif
 
 #endif // VK_INTERFACE_H